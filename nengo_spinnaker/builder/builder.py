@@ -10,6 +10,8 @@ from six import iteritems, itervalues
 from . import model
 from nengo_spinnaker.netlist import NMNet, Netlist
 from nengo_spinnaker.utils import collections as collections_ext
+from nengo_spinnaker.utils.config import getconfig
+from nengo_spinnaker.utils.cost_model import CostModel
 from nengo_spinnaker.utils.keyspaces import KeyspaceContainer
 
 BuiltConnection = collections.namedtuple(
@@ -137,6 +139,19 @@ class Model(object):
         self.machine_timestep = machine_timestep
         self.decoder_cache = decoder_cache
 
+        # Policy applied by executables when a timestep overruns, see
+        # :py:class:`~nengo_spinnaker.regions.TickOverrunPolicy`
+        self.tick_overrun_policy = "count"
+
+        # Model of the cycles taken by ensemble cores and the fraction of each
+        # timestep that ensembles should be partitioned to use.
+        self.cost_model = CostModel()
+        self.cpu_target = 0.4
+
+        # Simulation time (in seconds) after which values which are only sent
+        # when they change are sent again, None if they never are.
+        self.transmit_refresh_time = 0.1
+
         self.params = dict()
         self.seeds = dict()
         self.rngs = dict()
@@ -267,7 +282,9 @@ class Model(object):
 
         if not (source is None or sink is None):
             # Construct the signal parameters
-            signal_params = _make_signal_parameters(source, sink, conn)
+            signal_params = _make_signal_parameters(
+                source, sink, conn,
+                getconfig(self.config, conn, "transmit_threshold"))
 
             # Add the connection to the connection map, this will automatically
             # merge connections which are equivalent.
@@ -332,8 +349,10 @@ class Model(object):
         after_simulation_functions = collections_ext.noneignoringlist()
         constraints = collections_ext.flatinsertionlist()
 
-        # Prepare to build a list of signal constraints
+        # Prepare to build a list of signal constraints and of the filters
+        # targeted by each signal.
         id_constraints = collections.defaultdict(set)
+        id_targets = collections.defaultdict(set)
 
         for op in itertools.chain(itervalues(self.object_operators),
                                   self.extra_operators):
@@ -371,6 +390,11 @@ class Model(object):
                         id_constraints[u].add(v)
                         id_constraints[v].add(u)
 
+            # Get the filters targeted by the signals
+            if hasattr(op, "get_signal_targets"):
+                for u, targets in iteritems(op.get_signal_targets()):
+                    id_targets[u].update((op, t) for t in targets)
+
         # Construct nets from the signals
         nets = dict()
         id_to_signal = dict()
@@ -423,6 +447,9 @@ class Model(object):
                 id_to_signal[v] for v in vs
             }
 
+        signal_targets = {id_to_signal[u]: targets
+                          for u, targets in iteritems(id_targets)}
+
         # Return a netlist
         return Netlist(
             nets=nets,
@@ -432,7 +459,8 @@ class Model(object):
             load_functions=load_functions,
             before_simulation_functions=before_simulation_functions,
             after_simulation_functions=after_simulation_functions,
-            signal_id_constraints=signal_id_constraints
+            signal_id_constraints=signal_id_constraints,
+            signal_targets=signal_targets
         )
 
 
@@ -466,7 +494,8 @@ class spec(collections.namedtuple("spec",
                                         weight, latching)
 
 
-def _make_signal_parameters(source_spec, sink_spec, connection):
+def _make_signal_parameters(source_spec, sink_spec, connection,
+                            threshold=None):
     """Create parameters for a signal using specifications provided by the
     source and sink.
 
@@ -478,6 +507,9 @@ def _make_signal_parameters(source_spec, sink_spec, connection):
         Signal specification parameters from the sink of the signal.
     connection : nengo.Connection
         The Connection for this signal
+    threshold : float or None
+        Change in value below which values are not transmitted, if given the
+        signal is latching.
 
     Returns
     -------
@@ -494,7 +526,9 @@ def _make_signal_parameters(source_spec, sink_spec, connection):
 
     # Create the signal parameters
     return model.SignalParameters(
-        latching=source_spec.latching or sink_spec.latching,
+        latching=(source_spec.latching or sink_spec.latching or
+                  threshold is not None),
         weight=weight,
         keyspace=source_spec.keyspace or sink_spec.keyspace,
+        threshold=threshold,
     )
@@ -139,6 +139,8 @@ def build_ensemble(model, ens):
 
 
 @ensemble_builders.register(nengo.neurons.LIF)
+@ensemble_builders.register(nengo.neurons.AdaptiveLIF)
+@ensemble_builders.register(nengo.neurons.RectifiedLinear)
 def build_lif(model, ens):
     # Create a random number generator
     rng = np.random.RandomState(model.seeds[ens])
@@ -184,10 +186,10 @@ def build_lif(model, ens):
         bias=bias
     )
 
-    # Create the object which will handle simulation of the LIF ensemble.  This
-    # object will be responsible for adding items to the netlist and providing
-    # functions to prepare the ensemble for simulation.  The object may be
-    # modified by later methods.
+    # Create the object which will handle simulation of the ensemble (of any
+    # supported neuron type).  This object will be responsible for adding
+    # items to the netlist and providing functions to prepare the ensemble for
+    # simulation.  The object may be modified by later methods.
     model.object_operators[ens] = operators.EnsembleLIF(ens)
 
 
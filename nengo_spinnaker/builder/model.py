@@ -178,6 +178,13 @@ class ConnectionMap(object):
         """Get a new connection map with the passthrough nodes removed and with
         interposers inserted into the network at appropriate places.
 
+        Only the earliest interposer in a chain of passthrough nodes is
+        inserted: the transforms of the connections which follow it are
+        combined into the transform applied by the interposer and their
+        synapses are combined (by multiplying the coefficients of linear
+        filters) into the synapse applied by each sink.  Consequently a chain
+        of passthrough nodes is simulated by a single filter operator.
+
         Returns
         -------
         ([Interposer, ...], ConnectionMap)
@@ -746,21 +753,28 @@ class SignalParameters(object):
         Number of packets expected to be sent every time-step.
     keyspace : :py:class:`~rig.bitfield.BitField` or None
         Keyspace which will be used to assign keys to packets.
+    threshold : float or None
+        If None (the default) every value is sent every time-step.  Otherwise
+        a value is only sent when it differs from the value last sent by more
+        than the threshold, receiving filters must then be latching.
     """
-    def __init__(self, latching=False, weight=0, keyspace=None):
+    def __init__(self, latching=False, weight=0, keyspace=None,
+                 threshold=None):
         # Store the parameters
         self.latching = latching
         self.weight = weight
         self.keyspace = keyspace
+        self.threshold = threshold
 
     def __hash__(self):
-        return hash((self.latching, self.weight))
+        return hash((self.latching, self.weight, self.threshold))
 
     def __eq__(self, other):
-        # Equivalent if the latching spec is the same, the weight is the same
-        # and the keyspaces are equivalent.
+        # Equivalent if the latching spec is the same, the weight is the same,
+        # the thresholds are the same and the keyspaces are equivalent.
         if ((self.latching is other.latching) and
                 (self.weight == other.weight) and
+                (self.threshold == other.threshold) and
                 (self.keyspace == other.keyspace)):
             return True
         else:
@@ -782,7 +796,8 @@ class SignalParameters(object):
         return SignalParameters(
             latching=a.latching or b.latching,
             weight=b.weight,
-            keyspace=a.keyspace if a.keyspace is not None else b.keyspace
+            keyspace=a.keyspace if a.keyspace is not None else b.keyspace,
+            threshold=b.threshold
         )
 
 
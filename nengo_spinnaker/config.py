@@ -1,10 +1,14 @@
 """Nengo/SpiNNaker specific configuration."""
 import nengo
-from nengo.params import BoolParam, DictParam, NumberParam, Parameter
+from nengo.params import (BoolParam, DictParam, IntParam, NumberParam,
+                          Parameter, StringParam)
 from rig import place_and_route as par
 
 from nengo_spinnaker.node_io import Ethernet
+from nengo_spinnaker.operators.lif import DecoderStorage
+from nengo_spinnaker.regions import TickOverrunPolicy
 from nengo_spinnaker.simulator import Simulator
+from nengo_spinnaker.utils.paths import net_id_cache_dir
 
 
 def _set_param(obj, name, ParamType, *args, **kwargs):
@@ -37,9 +41,41 @@ def add_spinnaker_params(config):
     _set_param(config[Simulator], "router_kwargs", DictParam,
                default=dict())
 
+    # Greatest number of processes with which to route large netlists (None
+    # for one per CPU), the router must route each net independently.
+    _set_param(config[Simulator], "router_processes", IntParam,
+               default=None, low=1, optional=True)
+
+    # Directory in which to cache the identifiers assigned to nets, None
+    # disables the cache.
+    _set_param(config[Simulator], "net_id_cache_dir", StringParam,
+               default=net_id_cache_dir, optional=True)
+
     _set_param(config[Simulator], "node_io", Parameter, default=Ethernet)
     _set_param(config[Simulator], "node_io_kwargs", DictParam, default={})
 
+    # Policy applied when a timestep overruns on the machine: "count" the
+    # overruns, "drop" timesteps to catch up or "abort" the simulation.
+    _set_param(config[Simulator], "tick_overrun_policy", ChoiceParameter,
+               default="count",
+               values=[policy.name for policy in TickOverrunPolicy])
+
+    # Model of the cycles taken by ensemble cores (a
+    # :py:class:`~nengo_spinnaker.utils.cost_model.CostModel`, None for the
+    # default model) and the fraction of each timestep that ensembles are
+    # partitioned to use.
+    _set_param(config[Simulator], "cost_model", Parameter, default=None,
+               optional=True)
+    _set_param(config[Simulator], "cpu_target", NumberParam, default=0.4,
+               low=0.0, high=1.0, low_open=True)
+
+    # Simulation time (in seconds) after which values transmitted with a
+    # threshold are sent again even if they have not changed, so that values
+    # lost in the network are eventually replaced. None means that they are
+    # only sent when they change.
+    _set_param(config[Simulator], "transmit_refresh_time", NumberParam,
+               default=0.1, low=0.0, low_open=True, optional=True)
+
     # Add function_of_time parameters to Nodes
     _set_param(config[nengo.Node], "function_of_time", BoolParam,
                default=False)
@@ -52,11 +88,52 @@ def add_spinnaker_params(config):
     _set_param(config[nengo.Node], "optimize_out", BoolParam,
                default=None, optional=True)
 
+    # Add delta transmission parameters to Connections. If given, a value is
+    # only transmitted when it has changed by more than this threshold since
+    # it was last sent and the receiving filters hold the last value received.
+    _set_param(config[nengo.Connection], "transmit_threshold", NumberParam,
+               default=None, optional=True)
+
     # Add profiling parameters to Ensembles
     _set_param(config[nengo.Ensemble], "profile", BoolParam, default=False)
     _set_param(config[nengo.Ensemble], "profile_num_samples",
                NumberParam, default=None, optional=True)
 
+    # Add encoder precision control parameters to Ensembles. True means that
+    # encoders (and the input they are applied to) will be stored as 16-bit
+    # values where possible, which reduces their memory and the time taken to
+    # apply them at the cost of their precision.
+    _set_param(config[nengo.Ensemble], "packed_encoders", BoolParam,
+               default=False)
+
+    # Add decoder storage control parameters to Ensembles. This is the name of
+    # the format in which the static decoders should be stored ("dense",
+    # "factored", "sparse" or "streamed" from SDRAM), None means that the
+    # format requiring the least memory (and not streamed) will be used.
+    _set_param(config[nengo.Ensemble], "decoder_storage", ChoiceParameter,
+               default=None, optional=True,
+               values=[storage.name for storage in DecoderStorage])
+
+    # Add spike recording control parameters to Ensembles. This is the mean
+    # firing rate (in Hz) expected of the neurons; if it is given spikes are
+    # recorded compressed and only enough memory for this rate is allocated.
+    _set_param(config[nengo.Ensemble], "spike_recording_rate", NumberParam,
+               default=None, optional=True)
+
+    # Add recording window parameters to Probes. These are the simulation
+    # times (in seconds, from the start of each run) at which to start and
+    # stop recording, None means from the start or until the end of the run.
+    _set_param(config[nengo.Probe], "record_start", NumberParam,
+               default=None, optional=True)
+    _set_param(config[nengo.Probe], "record_stop", NumberParam,
+               default=None, optional=True)
+
+    # Add ring recording parameters to Probes. If given, this is the number of
+    # samples of decoded values (or Node outputs) a probe may hold on the
+    # machine; samples are drained by the host while the simulation runs.
+    _set_param(config[nengo.Probe], "record_ring_frames", NumberParam,
+               default=None, optional=True)
+
 
 class CallableParameter(Parameter):
     """Parameter which only accepts callables."""
@@ -65,3 +142,20 @@ class CallableParameter(Parameter):
             raise ValueError(
                 "must be callable, got type {}".format(type(callable_obj))
             )
+
+
+class ChoiceParameter(Parameter):
+    """Parameter which only accepts one of a given collection of values."""
+    def __init__(self, *args, **kwargs):
+        self.values = tuple(kwargs.pop("values"))
+        super(ChoiceParameter, self).__init__(*args, **kwargs)
+
+    def validate(self, instance, value):
+        if value is None and self.optional:
+            return
+
+        if value not in self.values:
+            raise ValueError(
+                "must be one of {}, got {!r}".format(
+                    ", ".join(repr(v) for v in self.values), value)
+            )
@@ -1,4 +1,8 @@
+import errno
+import hashlib
+import json
 import logging
+import os
 from collections import defaultdict, deque
 from rig.place_and_route.routing_tree import RoutingTree
 from six import iteritems, iterkeys, itervalues
@@ -24,19 +28,46 @@ except ImportError:
 logger = logging.getLogger(__name__)
 
 
-def allocate_signal_keyspaces(signal_routes, signal_id_constraints, keyspaces):
+def allocate_signal_keyspaces(signal_routes, signal_id_constraints, keyspaces,
+                              cache=None, signal_targets=dict()):
+    """Assign keyspaces to the signals which do not yet have one.
+
+    Parameters
+    ----------
+    cache : :py:class:`~.NetIdCache` or None
+        If given, the identifiers assigned to signals which were routed
+        identically in an earlier build are reused rather than recomputed.
+    signal_targets : {signal: {target, ...}, ...}
+        Filters targeted by the signals, see :py:func:`~.order_net_ids`.
+    """
     # Filter signals and routes to be only those without a keyspace
     signal_routes = {signal: routes for signal, routes in
                      iteritems(signal_routes) if
                      signal.keyspace is None}
 
-    # Get unique identifiers for each signal
-    if not USE_CFFI:
-        signal_ids = assign_mn_net_ids(
-            signal_routes, signal_id_constraints)
-    else:
-        signal_ids = cffi_assign_mn_net_ids(
-            signal_routes, signal_id_constraints)
+    # Get unique identifiers for each signal, from the cache if possible
+    signal_ids = None
+    if cache is not None:
+        digest, signals = get_mn_nets_digest(
+            signal_routes, signal_id_constraints, signal_targets)
+        ids = cache.get(digest, len(signals))
+        if ids is not None:
+            logger.info("Reusing cached signal IDs")
+            signal_ids = dict(zip(signals, ids))
+
+    if signal_ids is None:
+        if not USE_CFFI:
+            signal_ids = assign_mn_net_ids(
+                signal_routes, signal_id_constraints)
+        else:
+            signal_ids = cffi_assign_mn_net_ids(
+                signal_routes, signal_id_constraints)
+
+        # Order the identifiers such that routing table entries may be merged
+        signal_ids = order_net_ids(signal_ids, signal_routes, signal_targets)
+
+        if cache is not None:
+            cache.put(digest, [signal_ids[s] for s in signals])
 
     # Assign keyspaces to the signals
     for signal, i in iteritems(signal_ids):
@@ -81,6 +112,136 @@ def assign_mn_net_ids(nets_routes, prior_constraints=None):
     )
 
 
+def order_net_ids(net_ids, nets_routes, nets_targets=dict(),
+                  max_entry_nets=64):
+    """Renumber the identifiers assigned to multiple-source nets such that the
+    identifiers of nets which share routes differ in few bits.
+
+    Routing table entries with the same route and keys which differ in few
+    bits can be merged into a single masked entry when the tables are
+    minimised.  Identifiers are paired so that the two identifiers in each
+    pair, which differ only in the lowest bit, share as many routes as
+    possible.  The pairs are then paired in the same way, and so on, so that
+    each aligned block of identifiers shares as many routes as possible.  The
+    filters that nets target are treated as routes, so that the entries in
+    the filter routing tables of cores may also be merged.
+
+    Parameters
+    ----------
+    net_ids : {net: int, ...}
+        Identifiers assigned to each net, e.g. by
+        :py:func:`~.assign_mn_net_ids`.
+    nets_routes : {net: [RoutingTree, ...], ...}
+        Dictionary mapping multi-source nets to the routing trees which
+        describe them.
+    nets_targets : {net: {target, ...}, ...}
+        Filters targeted by the nets.
+    max_entry_nets : int
+        Greatest number of identifiers sharing a route which are compared
+        against each other, limits the time taken for popular routes.
+
+    Returns
+    -------
+    {net: int}
+        Mapping from each net to a new identifier, nets which shared an
+        identifier still share an identifier and the number of bits required
+        to represent the identifiers is unchanged.
+    """
+    colours = sorted(set(itervalues(net_ids)))
+    if len(colours) < 3:
+        return dict(net_ids)  # Renumbering could not merge any more entries
+
+    # Get the routes taken from each chip, and the filters targeted, by the
+    # nets assigned each identifier.
+    colour_entries = {c: set() for c in colours}
+    for net, trees in iteritems(nets_routes):
+        entries = colour_entries[net_ids[net]]
+        for tree in trees:
+            for _, chip, routes in tree.traverse():
+                entries.add((chip, _get_route(routes)))
+
+    for net, targets in iteritems(nets_targets):
+        if net in net_ids:
+            colour_entries[net_ids[net]].update(
+                (None, target) for target in targets)
+
+    # Pad the identifiers to a power of two with unused identifiers; these
+    # have entries of None as, belonging to no nets, they may share any route.
+    n_padded = 1 << (len(colours) - 1).bit_length()
+    groups = [([c], colour_entries[c]) for c in colours]
+    groups.extend(([None], None) for _ in range(n_padded - len(colours)))
+
+    # Repeatedly pair the groups of identifiers, the entries of a group are
+    # those which are common to all of its identifiers.
+    while len(groups) > 1:
+        groups = [(groups[a][0] + groups[b][0],
+                   _intersect_entries(groups[a][1], groups[b][1]))
+                  for a, b in _pair_groups(groups, max_entry_nets)]
+
+    # The new identifier of each colour is its position in the final group
+    new_colours = {c: i for i, c in enumerate(groups[0][0]) if c is not None}
+    return {net: new_colours[c] for net, c in iteritems(net_ids)}
+
+
+def _intersect_entries(a, b):
+    """Get the entries shared by two groups of identifiers, entries of None
+    belong to unused identifiers and share every entry.
+    """
+    if a is None:
+        return b
+    elif b is None:
+        return a
+    else:
+        return a & b
+
+
+def _pair_groups(groups, max_entry_nets):
+    """Pair groups of identifiers, greedily pairing those which share the
+    most entries first.
+
+    Returns
+    -------
+    [(int, int), ...]
+        Pairs of indices into the list of groups.
+    """
+    # Count the entries shared by pairs of groups
+    entry_groups = defaultdict(list)
+    for i, (_, entries) in enumerate(groups):
+        for entry in (entries or ()):
+            entry_groups[entry].append(i)
+
+    shared = defaultdict(int)
+    for indices in itervalues(entry_groups):
+        for j, a in enumerate(indices):
+            for b in indices[j + 1:j + max_entry_nets]:
+                shared[(a, b)] += 1
+
+    # Pair the groups which share the most entries
+    pairs = list()
+    paired = set()
+    for (a, b), _ in sorted(iteritems(shared), key=lambda x: (-x[1], x[0])):
+        if a not in paired and b not in paired:
+            pairs.append((a, b))
+            paired.update((a, b))
+
+    # Pair the groups of unused identifiers with the remaining groups with
+    # the most entries, as pairing these does not reduce the entries shared
+    # by the group.  Then pair whatever remains.
+    unpaired = [i for i in range(len(groups)) if i not in paired]
+    unpaired.sort(key=lambda i: (groups[i][1] is not None,
+                                 -len(groups[i][1] or ())))
+    n_unused = sum(1 for i in unpaired if groups[i][1] is None)
+    n_used = len(unpaired) - n_unused
+    n_mixed = min(n_unused, n_used)
+    unused, used = unpaired[:n_unused], unpaired[n_unused:]
+
+    pairs.extend((used[i], unused[i]) for i in range(n_mixed))
+    rest = used[n_mixed:] + unused[n_mixed:]
+    pairs.extend((rest[i], rest[i + 1]) for i in range(0, len(rest), 2))
+
+    return pairs
+
+
 def build_mn_net_graph(nets_routes, prior_constraints=None):
     """Build a graph the nodes of which represent multicast nets and the edges
     of which represent constraints upon which nets may share keys.
@@ -100,39 +261,21 @@ def build_mn_net_graph(nets_routes, prior_constraints=None):
         An adjacency list representation of a graph where the presence of an
         edge indicates that two multicast nets may not share a routing key.
     """
-    # The different sets of routes from a chip indicate nets which cannot share
-    # a routing key, this is indicated by creating an edge between those `nets'
-    # in the net graph.
     net_graph = {net: set() for net in iterkeys(nets_routes)}
 
     # Construct a map from chips to unique sets of routes from that chip to
-    # nets which take that route whilst simultaneously using this data
-    # structure to fill in the above graph of which nets may not share a
-    # routing key.
-    chip_route_nets = defaultdict(lambda: defaultdict(deque))
+    # the nets which take that route.
+    chip_route_nets = defaultdict(lambda: defaultdict(set))
     for net, trees in iteritems(nets_routes):
         for tree in trees:
             for _, chip, routes in tree.traverse():
-                # Add this net to the set of nets who take this route at this
-                # point.
-                route = 0x0
-                for r in routes:
-                    route |= (1 << r)
-
-                chip_route_nets[chip][route].append(net)
-
-                # Add constraints to the net graph dependent on which nets take
-                # different routes at this point.
-                routes_from_chip = chip_route_nets[chip]
-                for other_route, nets in iteritems(routes_from_chip):
-                    if other_route != route:
-                        for other_net in nets:
-                            # This net cannot share an identifier with any of
-                            # the nets who take a different route at this
-                            # point.
-                            if net != other_net:
-                                net_graph[net].add(other_net)
-                                net_graph[other_net].add(net)
+                chip_route_nets[chip][_get_route(routes)].add(net)
+
+    # The different sets of routes from a chip indicate nets which cannot share
+    # a routing key, this is indicated by creating an edge between those `nets'
+    # in the net graph.
+    for route_nets in itervalues(chip_route_nets):
+        _add_route_constraints(net_graph, route_nets)
 
     # Add any prior constraints into the net graph (doing so in such a way that
     # ensures that the prior constraints are undirected).
@@ -195,11 +338,11 @@ def assign_cluster_ids(operator_vertices, signal_routes, placements):
             # at the same router.
             #
             # Build a graph identifying which clusters may or may not share
-            # identifiers.
-            graph = build_cluster_graph(operators_signal_routes[operator])
-
-            # Colour this graph to assign identifiers to the clusters
-            cluster_ids = colour_graph(graph)
+            # identifiers and colour it to assign identifiers to the clusters.
+            if not USE_CFFI:
+                cluster_ids = colour_graph(build_cluster_graph(signal_routes))
+            else:
+                cluster_ids = cffi_assign_cluster_ids(signal_routes)
 
             # Assign these colours to the vertices.
             for vertex in vertices:
@@ -243,30 +386,51 @@ def build_cluster_graph(signal_routes):
             # Traverse the multicast tree to build up the dictionary mapping
             # chips to routes and clusters.
             for _, chip, routes in tree.traverse():
-                # Get the key for the routes taken
-                route = 0x0
-                for r in routes:
-                    route |= (1 << r)
-
                 # Add this cluster to the set of clusters whose net takes this
                 # route at this point.
-                chips_routes_clusters[chip][route].add(source)
-
-                # Add constraints to the cluster graph dependent on which
-                # multicast nets take different routes at this point.
-                routes_from_chip = chips_routes_clusters[chip]
-                for other_route, clusters in iteritems(routes_from_chip):
-                    if other_route != route:  # We care about different routes
-                        for cluster in clusters:
-                            # This cluster cannot share an identifier with any
-                            # of the clusters whose nets take a different route
-                            # at this point.
-                            cluster_graph[source].add(cluster)
-                            cluster_graph[cluster].add(source)
+                chips_routes_clusters[chip][_get_route(routes)].add(source)
+
+        # A cluster cannot share an identifier with any of the clusters whose
+        # nets take a different route from the same chip.
+        for routes_clusters in itervalues(chips_routes_clusters):
+            _add_route_constraints(cluster_graph, routes_clusters)
 
     return cluster_graph
 
 
+def _get_route(routes):
+    """Get the integer representation of a set of routes."""
+    route = 0x0
+    for r in routes:
+        route |= (1 << r)
+    return route
+
+
+def _add_route_constraints(graph, route_nodes):
+    """Add edges to a graph between every pair of nodes which take different
+    routes from a chip.
+
+    Parameters
+    ----------
+    graph : {node: {node, ...}, ...}
+        Adjacency list to which edges will be added.
+    route_nodes : {route: {node, ...}, ...}
+        The nodes which take each of the routes from the chip.
+    """
+    if len(route_nodes) < 2:
+        return  # Every node takes the same route
+
+    groups = list(itervalues(route_nodes))
+    for i, group in enumerate(groups):
+        others = set().union(*(groups[:i] + groups[i+1:]))
+        for node in group:
+            graph[node].update(others)
+
+            # Nodes which take several routes from the chip (multiple source
+            # nets) do not conflict with themselves.
+            graph[node].discard(node)
+
+
 def colour_graph(graph):  # TODO: Migrate to Rig
     """Assign colours to each node in a graph such that connected nodes do not
     share a colour.
@@ -285,11 +449,9 @@ def colour_graph(graph):  # TODO: Migrate to Rig
     # This follows a heuristic of first assigning a colour to the node with the
     # highest degree and then progressing through other nodes in a
     # breadth-first search.
-    colours = deque()  # List of sets which contain vertices
-    unvisited = set(iterkeys(graph))  # Nodes which haven't been visited
-
-    # While there are still unvisited nodes -- note that this may be true more
-    # than once if there are disconnected cliques in the graph, e.g.:
+    #
+    # A search is started more than once if there are disconnected cliques in
+    # the graph, e.g.:
     #
     #           (c)  (d)
     #            |   /
@@ -308,42 +470,37 @@ def colour_graph(graph):  # TODO: Migrate to Rig
     #
     # Nodes might be visited in the order [(b) is always first]:
     #   (b), (a), (c), (d), (e) - new clique - (f), (g), (h) - again - (i)
-    while unvisited:
-        queue = deque()  # Queue of nodes to visit
+    colours = list()  # List of sets which contain vertices
+    colouring = dict()
 
-        # Add the node with the greatest degree to the queue
-        queue.append(max(unvisited, key=lambda vx: len(graph[vx])))
+    # Visiting the nodes in order of decreasing degree ensures that each
+    # breadth-first search starts at the uncoloured node of greatest degree.
+    for start in sorted(graph, key=lambda vx: len(graph[vx]), reverse=True):
+        if start in colouring:
+            continue
 
         # Perform a breadth-first search of the tree and colour nodes as we
         # touch them.
+        queue = deque([start])  # Queue of nodes to visit
         while queue:
             node = queue.popleft()  # Get the next node to process
 
-            if node in unvisited:
-                # If the node is unvisited then mark it as visited
-                unvisited.remove(node)
-
+            if node not in colouring:
                 # Colour the node, using the first legal colour or by creating
                 # a new colour for the node.
-                for group in colours:
+                for i, group in enumerate(colours):
                     if graph[node].isdisjoint(group):
                         group.add(node)
+                        colouring[node] = i
                         break
                 else:
                     # Cannot colour this node with any of the existing colours,
                     # so create a new colour.
+                    colouring[node] = len(colours)
                     colours.append({node})
 
-                # Add unvisited connected nodes to the queue
-                for vx in graph[node]:
-                    queue.append(vx)
-
-    # Reverse the data format to result in {node: colour, ...}, for each group
-    # of equivalently coloured nodes mark the colour on the node.
-    colouring = dict()
-    for i, group in enumerate(colours):
-        for vx in group:
-            colouring[vx] = i
+                # Add connected nodes to the queue
+                queue.extend(graph[node])
 
     return colouring
 
@@ -354,47 +511,192 @@ def cffi_assign_mn_net_ids(nets, additional_constraints=dict()):
     :py:mod:`rig_cpp_key_allocation` to reduce memory use and increase
     performance.
     """
-    # Give each key a unique ID which will be used when building the graph.
-    net_ids = {net: i for i, net in enumerate(iterkeys(nets))}
+    def get_routes():
+        for net, trees in iteritems(nets):
+            # Ensure that routes is iterable
+            if isinstance(trees, RoutingTree):
+                trees = [trees]
 
-    # Create a graph of the appropriate size
-    graph = cffi_new_graph(len(net_ids))
+            for tree in trees:
+                for _, (x, y), routes in tree.traverse():
+                    yield net, x, y, _get_route(routes)
 
-    # Add the prior constraints to the graph
-    for net, other_nets in iteritems(additional_constraints):
-        for other_net in other_nets:
-            net_id = net_ids[net]
-            other_net_id = net_ids[other_net]
+    return _cffi_colour_routes(list(iterkeys(nets)), get_routes(),
+                               additional_constraints)
 
-            # Add the constraint to the graph
-            cffi_add_graph_constraint(graph, net_id, other_net_id)
 
-    # Add the constraints resulting from the network connectivity to the graph.
-    for net, trees in iteritems(nets):
-        net_id = net_ids[net]  # Get the net index
+def cffi_assign_cluster_ids(signal_routes):
+    """Same as colouring the graph built by :py:meth:`~.build_cluster_graph`
+    but calls out to :py:mod:`rig_cpp_key_allocation`.
+    """
+    clusters = {tree.chip for trees in itervalues(signal_routes)
+                for tree in trees}
+    chip_ids = dict()
 
-        # Ensure that routes is iterable
-        if isinstance(trees, RoutingTree):
-            trees = [trees]
+    def get_routes():
+        # Only the routes taken by the nets of a single signal constrain the
+        # identifiers of the clusters, so the routes of each signal are added
+        # to the graph as if they were on a different set of chips.
+        for i, trees in enumerate(itervalues(signal_routes)):
+            for tree in trees:
+                for _, chip, routes in tree.traverse():
+                    chip_id = chip_ids.setdefault(chip, len(chip_ids))
+                    yield tree.chip, i, chip_id, _get_route(routes)
 
-        # Loop over the routes, traversing and adding the routes to the graph
-        # as we go.
-        for tree in trees:
-            for _, (x, y), routes in tree.traverse():
-                # Convert the route into an integer representation
-                route = 0x0
-                for r in routes:
-                    route |= (1 << r)
+    return _cffi_colour_routes(list(clusters), get_routes())
+
+
+def _cffi_colour_routes(nodes, nodes_routes, constraints=dict()):
+    """Colour nodes such that nodes which take different routes from the same
+    chip do not share a colour using :py:mod:`rig_cpp_key_allocation`.
 
-                # Add the route to the graph
-                cffi_add_route_to_graph(graph, net_id, x, y, route)
+    Parameters
+    ----------
+    nodes : [node, ...]
+        Nodes to colour.
+    nodes_routes : iterable of (node, x, y, route)
+        Integer representations of the routes taken from each chip by the
+        nodes.
+    constraints : {node: {node, ...}, ...}
+        Additional pairs of nodes which may not share a colour.
+
+    Returns
+    -------
+    {node: int}
+        Mapping from each node to an identifier (colour).
+    """
+    # Give each node a unique ID which will be used when building the graph.
+    node_ids = {node: i for i, node in enumerate(nodes)}
+
+    # Create a graph of the appropriate size
+    graph = cffi_new_graph(len(node_ids))
+
+    # Add the prior constraints to the graph
+    for node, other_nodes in iteritems(constraints):
+        for other_node in other_nodes:
+            cffi_add_graph_constraint(graph, node_ids[node],
+                                      node_ids[other_node])
+
+    # Add the constraints resulting from the routes to the graph.
+    for node, x, y, route in nodes_routes:
+        cffi_add_route_to_graph(graph, node_ids[node], x, y, route)
 
     # Colour the graph before deleting it (and removing the dangling pointer!)
-    colouring = ffi.new("unsigned int[]", len(net_ids))
+    colouring = ffi.new("unsigned int[]", len(node_ids))
     cffi_colour_graph(graph, colouring)
     cffi_delete_graph(graph)
     del graph  # Not required any more
 
     # Read the colouring out into a dictionary
-    net_colouring = {net: colouring[i] for net, i in iteritems(net_ids)}
-    return net_colouring
+    return {node: colouring[i] for node, i in iteritems(node_ids)}
+
+
+def get_mn_nets_digest(nets_routes, prior_constraints=None,
+                       nets_targets=dict()):
+    """Get a digest of the routes taken by multiple-source nets, of the
+    constraints between them and of the filters they target, for use with
+    :py:class:`~.NetIdCache`.
+
+    Nets are ordered by the routes they take so that the digest does not
+    depend on the order in which the nets were built.  Filters are described
+    by the nets which target them, as only which nets share a filter affects
+    the identifiers assigned by :py:func:`~.order_net_ids`.
+
+    Returns
+    -------
+    str
+        Digest of the routes and constraints.
+    [net, ...]
+        The nets in the order in which their identifiers should be cached.
+    """
+    # Describe each net by the routes it takes from each chip
+    signatures = {
+        net: tuple(sorted((chip, _get_route(routes)) for tree in trees
+                          for _, chip, routes in tree.traverse()))
+        for net, trees in iteritems(nets_routes)
+    }
+    nets = sorted(signatures, key=signatures.get)
+    net_indices = {net: i for i, net in enumerate(nets)}
+
+    # Describe the constraints in terms of the positions of the nets
+    constraints = sorted({
+        tuple(sorted((net_indices[u], net_indices[v])))
+        for u, vs in iteritems(prior_constraints or {}) for v in vs
+    })
+
+    # Describe the targets in terms of the positions of the nets which
+    # target them.
+    target_nets = defaultdict(set)
+    for net, targets in iteritems(nets_targets):
+        if net in net_indices:
+            for target in targets:
+                target_nets[target].add(net_indices[net])
+    shared_targets = sorted(tuple(sorted(ns)) for ns in
+                            itervalues(target_nets))
+
+    digest = hashlib.sha1()
+    for net in nets:
+        digest.update(repr(signatures[net]).encode("ascii"))
+    digest.update(repr(constraints).encode("ascii"))
+    digest.update(repr(shared_targets).encode("ascii"))
+    return digest.hexdigest(), nets
+
+
+class NetIdCache(object):
+    """Cache of the identifiers assigned to multiple-source nets, stored in a
+    directory.
+
+    Identifiers are stored against the digest of the routes and constraints
+    (see :py:func:`~.get_mn_nets_digest`) from which they were computed, a
+    netlist which is routed identically to an earlier one can reuse the
+    identifiers rather than colouring the net graph again.
+
+    Parameters
+    ----------
+    directory : str
+        Directory in which to store the identifiers, created if necessary.
+    max_entries : int
+        Number of sets of identifiers to keep, the least recently stored are
+        removed first.
+    """
+    def __init__(self, directory, max_entries=32):
+        self.directory = directory
+        self.max_entries = max_entries
+
+    def _get_path(self, digest):
+        return os.path.join(self.directory, digest + ".json")
+
+    def get(self, digest, n_nets):
+        """Get the identifiers stored against a digest, or None if there are
+        no (valid) identifiers for the digest.
+        """
+        try:
+            with open(self._get_path(digest)) as fp:
+                ids = json.load(fp)
+        except (IOError, OSError, ValueError):
+            return None
+
+        if not isinstance(ids, list) or len(ids) != n_nets:
+            return None
+        return ids
+
+    def put(self, digest, ids):
+        """Store a list of identifiers against a digest."""
+        try:
+            try:
+                os.makedirs(self.directory)
+            except OSError as e:
+                if e.errno != errno.EEXIST:
+                    raise
+
+            with open(self._get_path(digest), "w") as fp:
+                json.dump(list(ids), fp)
+
+            # Remove the oldest entries
+            entries = [os.path.join(self.directory, f) for f in
+                       os.listdir(self.directory) if f.endswith(".json")]
+            entries.sort(key=os.path.getmtime, reverse=True)
+            for path in entries[self.max_entries:]:
+                os.remove(path)
+        except (IOError, OSError) as e:
+            logger.warning("Could not cache net IDs: %s", e)
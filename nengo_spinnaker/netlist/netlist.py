@@ -14,6 +14,7 @@ from rig.machine_control.utils import sdram_alloc_for_vertices
 from six import iteritems, itervalues
 
 from nengo_spinnaker.netlist import key_allocation, utils
+from nengo_spinnaker.utils.application import check_application
 
 logger = logging.getLogger(__name__)
 
@@ -49,14 +50,23 @@ class Netlist(object):
         Map of vertices to the resources they have been assigned.
     routes : {net: routing tree, ...}
         Map of nets to the routes through the machine to which they correspond.
+    router_loads : {(x, y): packets, ...}
+        Estimate of the number of packets handled by the router of each chip
+        every simulation time-step.
+    routing_tables : {(x, y): [RoutingTableEntry, ...], ...}
+        Minimised routing tables for each chip, built when the netlist is
+        loaded.
     vertices_memory : {vertex: filelike, ...}
         Map of vertices to file-like views of the SDRAM they have been
         allocated.
+    signal_targets : {Signal: {target, ...}, ...}
+        Filters targeted by signals, signals which share targets are assigned
+        similar routing identifiers.
     """
     def __init__(self, nets, operator_vertices, keyspaces, constraints=list(),
                  load_functions=list(), before_simulation_functions=list(),
                  after_simulation_functions=list(),
-                 signal_id_constraints=dict()):
+                 signal_id_constraints=dict(), signal_targets=dict()):
         # Store given parameters
         self.nets = nets
         self.operator_vertices = operator_vertices
@@ -66,6 +76,7 @@ class Netlist(object):
         self.before_simulation_functions = list(before_simulation_functions)
         self.after_simulation_functions = list(after_simulation_functions)
         self.signal_id_constraints = signal_id_constraints
+        self.signal_targets = signal_targets
 
         # Create containers for the attributes that are filled in by place and
         # route.
@@ -73,6 +84,8 @@ class Netlist(object):
         self.allocations = dict()
         self.net_keyspaces = dict()
         self.routes = dict()
+        self.router_loads = dict()
+        self.routing_tables = dict()
         self.vertices_memory = dict()
 
     @property
@@ -91,7 +104,8 @@ class Netlist(object):
                         allocate=place_and_route.allocate,
                         allocate_kwargs={},
                         route=place_and_route.route,
-                        route_kwargs={}):
+                        route_kwargs={},
+                        net_id_cache=None):
         """Place and route the netlist onto the given SpiNNaker machine.
 
         Parameters
@@ -116,6 +130,9 @@ class Netlist(object):
             Router function. Must support the interface defined by Rig.
         route_kwargs : dict
             Keyword arguments for the router function.
+        net_id_cache : :py:class:`~.key_allocation.NetIdCache` or None
+            Cache of the identifiers assigned to nets, if given identifiers
+            computed for an identically routed netlist will be reused.
         """
         # Generate a Machine and set of core-reserving constraints to prevent
         # the use of non-idle cores.
@@ -149,6 +166,9 @@ class Netlist(object):
                             constraints, extended_placements,
                             extended_allocations, **route_kwargs)
 
+        # Estimate the load on each router from the routes
+        self.router_loads = utils.get_router_loads(self.routes)
+
         # Assign keyspaces based on the placement
         signal_routes = collections.defaultdict(collections.deque)
         for signal, nmnet in iteritems(self.nets):
@@ -157,7 +177,9 @@ class Netlist(object):
 
         key_allocation.allocate_signal_keyspaces(signal_routes,
                                                  self.signal_id_constraints,
-                                                 self.keyspaces)
+                                                 self.keyspaces,
+                                                 net_id_cache,
+                                                 self.signal_targets)
 
         # Assign cluster IDs based on the placement and the routing
         key_allocation.assign_cluster_ids(self.operator_vertices,
@@ -171,26 +193,65 @@ class Netlist(object):
         # Fix all keyspaces
         self.keyspaces.assign_fields()
 
-    def load_application(self, controller, system_info):
-        """Load the netlist to a SpiNNaker machine.
+    def build_routing_tables(self, target_lengths=None):
+        """Build minimised routing tables for the placed and routed netlist.
 
         Parameters
         ----------
-        controller : :py:class:`~rig.machine_control.MachineController`
-            Controller to use to communicate with the machine.
+        target_lengths : {(x, y): int, ...} or int or None
+            Number of entries available in the router of each chip. Tables
+            are minimised until they fit, if None then tables are minimised as
+            far as possible.
+
+        Returns
+        -------
+        {(x, y): [RoutingTableEntry, ...], ...}
+            Routing tables for each chip.
         """
-        # Build and load the routing tables, first by building a mapping from
-        # nets to keys and masks.
-        logger.debug("Loading routing tables")
+        # Build a mapping from nets to keys and masks and hence the tables
         net_keys = {n: (ks.get_value(tag=self.keyspaces.routing_tag),
                         ks.get_mask(tag=self.keyspaces.routing_tag))
                     for n, ks in iteritems(self.net_keyspaces)}
-
         routing_tables = routing_tree_to_tables(self.routes, net_keys)
-        target_lengths = build_routing_table_target_lengths(system_info)
-        routing_tables = minimise_tables(routing_tables, target_lengths)
 
-        controller.load_routing_tables(routing_tables)
+        # Minimise the tables, nets which share routes have been assigned keys
+        # which differ in few bits so many entries may be merged.
+        minimised_tables = minimise_tables(routing_tables, target_lengths)
+
+        if minimised_tables:
+            logger.info(
+                "Minimised routing tables from %u to %u entries "
+                "(largest table %u entries)",
+                sum(len(t) for t in itervalues(routing_tables)),
+                sum(len(t) for t in itervalues(minimised_tables)),
+                max(len(t) for t in itervalues(minimised_tables))
+            )
+
+        return minimised_tables
+
+    def load_application(self, controller, system_info):
+        """Load the netlist to a SpiNNaker machine.
+
+        Parameters
+        ----------
+        controller : :py:class:`~rig.machine_control.MachineController`
+            Controller to use to communicate with the machine.
+
+        Raises
+        ------
+        ~nengo_spinnaker.utils.application.ApplicationError
+            If an executable is missing or out of date.
+        """
+        # Check the executables before anything is loaded
+        for application in set(v.application for v in self.vertices
+                               if v.application is not None):
+            check_application(application)
+
+        # Build, minimise and load the routing tables
+        logger.debug("Loading routing tables")
+        self.routing_tables = self.build_routing_tables(
+            build_routing_table_target_lengths(system_info))
+        controller.load_routing_tables(self.routing_tables)
 
         # Assign memory to each vertex as required
         logger.debug("Assigning application memory")
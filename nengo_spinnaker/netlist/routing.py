@@ -0,0 +1,114 @@
+"""Routing of large netlists using several processes.
+
+Rig's router routes each net independently of every other net so the nets of
+a netlist may be divided amongst several processes and routed concurrently
+without changing the routes that are produced.
+"""
+import multiprocessing
+from rig.netlist import Net
+from rig.place_and_route import Cores, route as rig_route
+from rig.place_and_route.constraints import RouteEndpointConstraint
+from rig.place_and_route.machine import Machine
+from rig.place_and_route.routing_tree import RoutingTree
+from six import iteritems
+
+
+def route_in_parallel(vertices_resources, nets, machine, constraints,
+                      placements, allocations={}, core_resource=Cores,
+                      route=rig_route, n_processes=None,
+                      min_nets_per_process=1000, **route_kwargs):
+    """Route nets using several processes.
+
+    The arguments are the same as Rig's router with the following additions.
+
+    Parameters
+    ----------
+    route : function
+        Router with which to route each subset of the nets. The router *MUST*
+        route each net independently of the other nets.
+    n_processes : int or None
+        Greatest number of processes to use, if None then one process will be
+        used for every CPU.
+    min_nets_per_process : int
+        Least number of nets to route in each process, netlists with fewer
+        nets will be routed in the current process.
+    """
+    nets = list(nets)
+    if n_processes is None:
+        n_processes = multiprocessing.cpu_count()
+    n_processes = min(n_processes, len(nets) // min_nets_per_process)
+
+    if n_processes <= 1:
+        return route(vertices_resources, nets, machine, constraints,
+                     placements, allocations, core_resource=core_resource,
+                     **route_kwargs)
+
+    # Vertices are replaced with integers before being sent to the other
+    # processes: vertices need not be picklable and the routing trees that are
+    # returned must refer to the original vertices.  Similarly, only the parts
+    # of the machine, constraints and allocations used by the router are sent.
+    vertices = list(placements)
+    vertex_ids = {v: i for i, v in enumerate(vertices)}
+
+    machine = Machine(machine.width, machine.height, chip_resources={},
+                      chip_resource_exceptions={},
+                      dead_chips=set(machine.dead_chips),
+                      dead_links=set(machine.dead_links))
+    constraints = [RouteEndpointConstraint(vertex_ids[c.vertex], c.route)
+                   for c in constraints
+                   if isinstance(c, RouteEndpointConstraint)]
+    placements = {vertex_ids[v]: xy for v, xy in iteritems(placements)}
+    allocations = {vertex_ids[v]: {"cores": a[core_resource]}
+                   for v, a in iteritems(allocations) if core_resource in a}
+
+    # Route an interleaved share of the nets in each process
+    tasks = list()
+    for i in range(n_processes):
+        task_nets = [(vertex_ids[n.source], [vertex_ids[v] for v in n.sinks],
+                      n.weight) for n in nets[i::n_processes]]
+        tasks.append((route, task_nets, machine, constraints, placements,
+                      allocations, route_kwargs))
+
+    pool = multiprocessing.Pool(n_processes)
+    try:
+        task_trees = pool.map(_route_nets, tasks)
+    finally:
+        pool.close()
+        pool.join()
+
+    # Restore the vertices in the routing trees
+    routes = dict()
+    for i, trees in enumerate(task_trees):
+        for net, tree in zip(nets[i::n_processes], trees):
+            _restore_vertices(tree, vertices)
+            routes[net] = tree
+
+    return routes
+
+
+def _route_nets(task):
+    """Route a list of `(source, sinks, weight)` nets, returning the routing
+    tree of each.
+    """
+    (route, nets, machine, constraints, placements, allocations,
+     route_kwargs) = task
+
+    nets = [Net(source, sinks, weight) for source, sinks, weight in nets]
+    vertices_resources = {v: {} for v in placements}
+    routes = route(vertices_resources, nets, machine, constraints, placements,
+                   allocations, core_resource="cores", **route_kwargs)
+    return [routes[net] for net in nets]
+
+
+def _restore_vertices(tree, vertices):
+    """Replace the vertex indices in the leaves of a routing tree with the
+    vertices they refer to.
+    """
+    to_visit = [tree]
+    while to_visit:
+        node = to_visit.pop()
+        for i, (direction, child) in enumerate(node.children):
+            if isinstance(child, RoutingTree):
+                to_visit.append(child)
+            else:
+                node.children[i] = (direction, vertices[child])
@@ -134,3 +134,26 @@ def get_net_keyspaces(placements, nets, derived_nets):
                 net_keyspaces[net] = ks
 
     return net_keyspaces
+
+
+def get_router_loads(routes):
+    """Estimate the number of packets handled by the router of each chip
+    every simulation time-step.
+
+    Parameters
+    ----------
+    routes : {:py:class:`~rig.netlist.Net`: RoutingTree, ...}
+        Map from the nets used during routing to their routing trees.
+
+    Returns
+    -------
+    {(x, y): packets, ...}
+        Sum of the weights of the nets whose routes pass through each chip.
+    """
+    loads = collections.defaultdict(int)
+
+    for net, tree in iteritems(routes):
+        for _, chip, _ in tree.traverse():
+            loads[chip] += net.weight
+
+    return dict(loads)
@@ -3,6 +3,7 @@ import numpy as np
 from rig.machine_control.consts import SCP_PORT
 from rig.machine_control.packets import SCPPacket
 from rig.place_and_route import Cores
+import select
 from six import iteritems
 import socket
 import threading
@@ -13,6 +14,10 @@ from ..builder.node import NodeIOController
 from ..operators import SDPReceiver, SDPTransmitter
 from ..utils import type_casts as tp
 
+# Greatest number of values which may be carried by a single SDP message,
+# larger vectors are split over several messages (see `sdp_vector.h`).
+SDP_VECTOR_MAX_VALUES = 64
+
 
 class Ethernet(NodeIOController):
     """Ethernet implementation of SpiNNaker to host node communication."""
@@ -39,6 +44,14 @@ class Ethernet(NodeIOController):
         # (x, y, p) -> Node
         self._node_incoming = dict()
 
+        # (x, y, p) -> sequence number of the next vector to send
+        self._sequences = collections.defaultdict(int)
+
+        # (x, y, p, offset) -> packet waiting to be sent; only the most recent
+        # part of each vector is kept so that the host never falls behind.
+        self._pending = dict()
+        self._pending_lock = threading.Lock()
+
         # Sockets
         self._hostname = None
         self.in_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
@@ -114,23 +127,39 @@ class Ethernet(NodeIOController):
             self._node_incoming[(x, y, p)] = node
 
     def set_node_output(self, node, value):
-        """Transmit the value output by a Node."""
-        # Build an SDP packet to transmit for each outgoing connection for the
-        # node
+        """Queue the value output by a Node to be transmitted."""
+        # Build the SDP packets to transmit for each outgoing connection for
+        # the node
+        packets = dict()
         for (pre_slice, function, transform), (x, y, p) in \
                 self._node_outgoing[node]:
             # Apply the pre-slice, the connection function and the transform.
             c_value = value[pre_slice]
             if function is not None:
                 c_value = function(c_value)
-            c_value = np.dot(transform, c_value)
-
-            # Transmit the packet
-            data = bytes(tp.np_to_fix(c_value).data)
-            packet = SCPPacket(dest_port=1, dest_cpu=p, dest_x=x, dest_y=y,
-                               cmd_rc=0, arg1=0, arg2=0, arg3=0, data=data)
-            self.out_socket.sendto(packet.bytestring,
-                                   (self._hostname, SCP_PORT))
+            c_value = tp.np_to_fix(np.dot(transform, c_value))
+
+            # Split the vector over as many packets as are required
+            seq = self._sequences[(x, y, p)]
+            self._sequences[(x, y, p)] = (seq + 1) & 0xffff
+            for offset in range(0, len(c_value), SDP_VECTOR_MAX_VALUES):
+                data = bytes(
+                    c_value[offset:offset + SDP_VECTOR_MAX_VALUES].data)
+                packet = SCPPacket(dest_port=1, dest_cpu=p, dest_x=x,
+                                   dest_y=y, cmd_rc=0, seq=seq, arg1=offset,
+                                   arg2=len(data) // 4, arg3=0, data=data)
+                packets[(x, y, p, offset)] = packet.bytestring
+
+        # Replace any packets which have not yet been sent
+        with self._pending_lock:
+            self._pending.update(packets)
+
+    def get_pending_packets(self):
+        """Get and clear the packets waiting to be sent to the machine."""
+        with self._pending_lock:
+            packets = list(self._pending.values())
+            self._pending.clear()
+        return packets
 
     def spawn(self):
         """Get a new thread which will manage transmitting and receiving Node
@@ -154,30 +183,67 @@ class EthernetThread(threading.Thread):
         self.halt = False
         self.handler = ethernet_handler
         self.in_sock = ethernet_handler.in_socket
-        self.in_sock.settimeout(0.0001)
+        self.in_sock.setblocking(False)
+        self.out_sock = ethernet_handler.out_socket
+        self.out_address = (ethernet_handler._hostname, SCP_PORT)
+
+        # (x, y, p) -> vector being received and the sequence number of the
+        # last message received for each part of the vector.
+        self.vectors = dict()
 
     def run(self):
         while not self.halt:
-            # Read as many packets from the socket as we can
-            while True:
-                try:
-                    data = self.in_sock.recv(512)
-                except IOError:
-                    break  # No more to read
-
-                # Unpack the data, and store it as the input for the
-                # appropriate Node.
-                packet = SCPPacket.from_bytestring(data)
-                values = tp.fix_to_np(
-                    np.frombuffer(packet.data, dtype=np.int32)
-                )
-
-                # Get the Node
-                node = self.handler._node_incoming[(packet.src_x,
-                                                    packet.src_y,
-                                                    packet.src_cpu)]
-                with self.handler.node_input_lock:
-                    self.handler.node_input[node] = values[:]
+            # Wait (briefly) for packets to arrive, then read as many packets
+            # from the socket as we can.
+            readable, _, _ = select.select([self.in_sock], [], [], 0.0001)
+            if readable:
+                self.receive()
+
+            # Send the most recent values output by Nodes
+            for packet in self.handler.get_pending_packets():
+                self.out_sock.sendto(packet, self.out_address)
+
+    def receive(self):
+        """Read every packet waiting in the socket and store the received
+        values as the input for the appropriate Nodes.
+        """
+        updated = set()
+        while True:
+            try:
+                data = self.in_sock.recv(512)
+            except IOError:
+                break  # No more to read
+
+            # Unpack the data
+            packet = SCPPacket.from_bytestring(data)
+            values = tp.fix_to_np(np.frombuffer(packet.data, dtype=np.int32))
+
+            # Get the Node and the vector being received for it
+            node = self.handler._node_incoming[(packet.src_x,
+                                                packet.src_y,
+                                                packet.src_cpu)]
+            if node not in self.vectors:
+                n_parts = -(-node.size_in // SDP_VECTOR_MAX_VALUES)
+                self.vectors[node] = (np.zeros(node.size_in),
+                                      [None] * n_parts)
+            vector, last_seqs = self.vectors[node]
+
+            # Ignore parts of the vector which are older than those already
+            # received, allowing for the sequence number wrapping around.
+            part = packet.arg1 // SDP_VECTOR_MAX_VALUES
+            last_seq = last_seqs[part]
+            if (last_seq is not None and
+                    not 0 < (packet.seq - last_seq) & 0xffff < 0x8000):
+                continue
+
+            last_seqs[part] = packet.seq
+            vector[packet.arg1:packet.arg1 + len(values)] = values
+            updated.add(node)
+
+        # Store the new inputs
+        with self.handler.node_input_lock:
+            for node in updated:
+                self.handler.node_input[node] = self.vectors[node][0].copy()
 
     def stop(self):
         """Stop the thread from running."""
@@ -23,6 +23,9 @@ class Regions(enum.IntEnum):
     input_filters = 3
     input_routing = 4
     transform = 5
+    tick_status = 6
+    transmit_schedule = 7
+    transmit_threshold = 8
 
 
 class Filter(object):
@@ -79,6 +82,12 @@ class Filter(object):
     achieved at the cost of requiring any operator with input `c` to receive
     twice as many packets as previously (one set of packets for each
     column-wise division) and to perform some additions.
+
+    Transforms which are diagonal (e.g., identity transforms, common for
+    passthrough Nodes) or sparse are stored in more compact forms which are
+    cheaper to apply (see :py:class:`TransformFormat`), the rows are
+    partitioned between cores according to the cost of applying them so that
+    such transforms require fewer cores.
     """
     def __init__(self, size_in, max_cols=128, max_rows=64):
         """Create a new parallel Filter.
@@ -118,6 +127,15 @@ class Filter(object):
         )
         self._routing_region = filter_routing_region
 
+        # Get the region into which the cores report overrunning timesteps
+        tick_status_region = regions.TickStatusRegion(
+            regions.TickOverrunPolicy[model.tick_overrun_policy])
+
+        # Get the number of timesteps after which thresholded values are sent
+        # again
+        refresh_period = regions.get_transmit_refresh_period(
+            model.transmit_refresh_time, model.dt)
+
         # Generate the vertices
         vertices = flatinsertionlist()
 
@@ -126,12 +144,15 @@ class Filter(object):
                 group.make_vertices(out_signals,
                                     model.machine_timestep,
                                     filter_region,
-                                    filter_routing_region)
+                                    filter_routing_region,
+                                    tick_status_region,
+                                    refresh_period)
             )
 
         # Return the netlist specification
         return netlistspec(vertices=vertices,
-                           load_function=self.load_to_machine)
+                           load_function=self.load_to_machine,
+                           after_simulation_function=self.after_simulation)
 
     def get_signal_constraints(self):
         """Return a set of constraints on which signal parameters may share the
@@ -145,6 +166,15 @@ class Filter(object):
         """
         return self._routing_region.get_signal_constraints()
 
+    def get_signal_targets(self):
+        """Return the filters targeted by each signal parameters.
+
+        Returns
+        -------
+        {id(SignalParameters): {target, ...}}
+        """
+        return self._routing_region.get_signal_targets()
+
     def load_to_machine(self, netlist, controller):
         """Load the data to the machine."""
         # Prepare the filter routing region
@@ -154,12 +184,18 @@ class Filter(object):
         for g in self.groups:
             g.load_to_machine(netlist, controller)
 
+    def after_simulation(self, netlist, simulator, n_steps):
+        """Retrieve the status of the timesteps of each core."""
+        for g in self.groups:
+            for core in g.cores:
+                simulator.tick_status[core] = core.get_tick_status()
+
 
 class FilterGroup(object):
     """Portion of the columns of the transform applied by a filter, may extend
     across multiple chips.
     """
-    def __init__(self, column_slice, max_rows):
+    def __init__(self, column_slice, max_rows, max_packets=None):
         """Create a new group of filter cores.
 
         Parameters
@@ -167,13 +203,22 @@ class FilterGroup(object):
         column_slice : :py:class:`slice`
             Column-wise partition of the overall matrix that is assigned to
             this group of processing cores.
+        max_rows : int
+            Maximum number of dense rows which may be applied by a single
+            core, cheaper rows are limited by their cost.
+        max_packets : int or None
+            Maximum number of rows (and hence packets) which may be handled by
+            a single core, regardless of their cost.  Defaults to four times
+            `max_rows`.
         """
         self.column_slice = column_slice
         self.size_in = column_slice.stop - column_slice.start
         self.max_rows = max_rows
+        self.max_packets = max_packets or 4 * max_rows
 
     def make_vertices(self, output_signals, machine_timestep, filter_region,
-                      filter_routing_region):
+                      filter_routing_region, tick_status_region,
+                      refresh_period=0):
         """Partition the transform matrix into groups of rows and assign each
         group of rows to a core for computation.
 
@@ -192,17 +237,19 @@ class FilterGroup(object):
 
             size_out = transform.shape[0]
 
-            # Build as many vertices as required to keep the number of rows
-            # handled by each core below max_rows.
-            n_cores = (
-                (size_out // self.max_rows) +
-                (1 if size_out % self.max_rows else 0)
-            )
-
             # Build the transform region for these cores
-            transform_region = regions.MatrixRegion(
-                np_to_fix(transform),
-                sliced_dimension=regions.MatrixPartitioning.rows
+            transform_region = TransformRegion(np_to_fix(transform))
+
+            # Build as many vertices as required to keep the cost of applying
+            # the rows handled by each core below that of applying max_rows
+            # dense rows, and the number of rows handled by each core below
+            # max_packets.
+            costs = transform_region.row_costs()
+            max_cost = self.max_rows * (self.size_in + 1)
+            n_cores = max(
+                int(np.ceil(float(np.sum(costs)) / max_cost)),
+                (size_out // self.max_packets) +
+                (1 if size_out % self.max_packets else 0)
             )
 
             # Build all the vertices
@@ -210,8 +257,9 @@ class FilterGroup(object):
                 FilterCore(self.column_slice, out_slice,
                            transform_region, keys, output_slices,
                            machine_timestep,
-                           filter_region, filter_routing_region) for
-                out_slice in divide_slice(slice(0, size_out), n_cores)
+                           filter_region, filter_routing_region,
+                           tick_status_region, refresh_period) for
+                out_slice in divide_rows_by_cost(costs, n_cores)
             ]
 
         return self.cores
@@ -231,7 +279,8 @@ class FilterCore(Vertex):
     """
     def __init__(self, column_slice, output_slice,
                  transform_region, output_keys, output_slices,
-                 machine_timestep, filter_region, filter_routing_region):
+                 machine_timestep, filter_region, filter_routing_region,
+                 tick_status_region, refresh_period=0):
         """Allocate a portion of the overall matrix to a single processing
         core.
 
@@ -250,6 +299,9 @@ class FilterCore(Vertex):
             Pairs of transmission parameters and sets containing the row
             indices of the transform matrix corresponding to the transmission
             parameters.
+        refresh_period : int
+            Number of timesteps after which values transmitted with a threshold
+            are sent again.
         """
         # Check that the output slice is safe
         assert (output_slice.start is not None and
@@ -274,7 +326,9 @@ class FilterCore(Vertex):
         # Construct the regions
         self.regions = {
             Regions.system: SystemRegion(column_slice, output_slice,
-                                         machine_timestep),
+                                         machine_timestep,
+                                         transform_format=(
+                                             transform_region.format)),
             Regions.transform: transform_region,
             Regions.keys: regions.KeyspacesRegion(
                 output_keys,
@@ -283,6 +337,11 @@ class FilterCore(Vertex):
             ),
             Regions.input_filters: filter_region,
             Regions.input_routing: filter_routing_region,
+            Regions.tick_status: tick_status_region,
+            Regions.transmit_schedule: regions.TransmitScheduleRegion(),
+            Regions.transmit_threshold: regions.TransmitThresholdRegion(
+                regions.get_transmit_thresholds(output_keys),
+                refresh_period),
         }
 
         # Construct the region arguments
@@ -293,6 +352,9 @@ class FilterCore(Vertex):
             Regions.system: Args(),  # No arguments
             Regions.input_filters: Args(filter_width=w),  # No arguments
             Regions.input_routing: Args(),  # No arguments
+            Regions.tick_status: Args(),  # No arguments
+            Regions.transmit_schedule: Args(),  # Added when loading
+            Regions.transmit_threshold: Args(vertex_slice=self.output_slice),
         }
 
         # Determine the resource requirements and find the correct application
@@ -325,28 +387,47 @@ class FilterCore(Vertex):
         # Modify the region arguments
         self.region_arguments[Regions.keys].kwargs.update({
             "cluster": self.cluster})
+        n_packets = self.output_slice.stop - self.output_slice.start
+        self.region_arguments[Regions.transmit_schedule].kwargs.update(
+            regions.get_transmit_schedule(
+                netlist, self, n_packets,
+                self.regions[Regions.system].machine_timestep, stagger=3)
+        )
 
-        # Write the regions into memory
-        for key in Regions:
-            # Get the arguments
-            args, kwargs = self.region_arguments[key]
+        # Write each region into memory
+        regions.utils.write_regions_named(
+            self.region_memory, self.regions, self.region_arguments)
 
-            # Get the region
-            self.regions[key].write_subregion_to_file(
-                self.region_memory[key], *args, **kwargs
-            )
+    def get_tick_status(self):
+        """Retrieve the status of the timesteps from the simulation."""
+        mem = self.region_memory[Regions.tick_status]
+        mem.seek(0)
+        return self.regions[Regions.tick_status].read_from_mem(mem)
+
+
+class TransformFormat(enum.IntEnum):
+    """Formats in which the transform may be stored, these must match
+    `transform_format_t` in `filter.c`.
+    """
+    dense = 0  # Row-major matrix
+    diagonal = 1  # Every row has at most one non-zero element
+    sparse = 2  # Compressed sparse rows
 
 
 class SystemRegion(object):
     """The system region of the `filter_parallel` operator.
     """
-    def __init__(self, column_slice, output_slice, machine_timestep=1000):
+    def __init__(self, column_slice, output_slice, machine_timestep=1000,
+                 packet_queue_length=1024,
+                 transform_format=TransformFormat.dense):
         self.column_slice = column_slice
         self.output_slice = output_slice
         self.machine_timestep = machine_timestep
+        self.packet_queue_length = packet_queue_length
+        self.transform_format = transform_format
 
     def sizeof(self, *args, **kwargs):
-        return 4 * 4
+        return 6 * 4
 
     sizeof_padded = sizeof
 
@@ -355,14 +436,122 @@ class SystemRegion(object):
         subspaces.
         """
         # Pack the data
-        data = struct.pack("<4I",
+        data = struct.pack("<6I",
                            self.machine_timestep,
                            self.column_slice.stop - self.column_slice.start,
                            self.column_slice.start,
-                           self.output_slice.stop - self.output_slice.start)
+                           self.output_slice.stop - self.output_slice.start,
+                           self.packet_queue_length,
+                           self.transform_format)
         fp.write(data)
 
 
+class TransformRegion(regions.MatrixRegion):
+    """The transform applied by the filter, partitioned by rows.
+
+    The format is chosen for the whole transform.  If each row contains at
+    most one non-zero element then the transform is stored as the column index
+    of the non-zero element of each row followed by its value (an identity
+    transform is stored in this way).  If the transform is sufficiently
+    sparse then it is stored in compressed sparse row form: the index of the
+    first element of each row (and of the end of the final row) counted from
+    the first row of the slice, followed by the column index of each non-zero
+    element and then the values of the non-zero elements.  Otherwise the
+    matrix is stored densely.
+    """
+    # Greatest proportion of non-zero elements for a sparse format to be used
+    max_sparse_density = 1.0 / 3.0
+
+    def __init__(self, matrix):
+        super(TransformRegion, self).__init__(
+            matrix, sliced_dimension=regions.MatrixPartitioning.rows)
+
+        # Choose the format
+        self._nnz = np.count_nonzero(self.matrix, axis=1)
+        if np.all(self._nnz <= 1):
+            self.format = TransformFormat.diagonal
+        elif np.sum(self._nnz) <= self.max_sparse_density * self.matrix.size:
+            self.format = TransformFormat.sparse
+        else:
+            self.format = TransformFormat.dense
+
+    def row_costs(self):
+        """Get the cost of applying each row, measured in multiply-accumulates
+        including one for transmitting the result.
+        """
+        if self.format is TransformFormat.dense:
+            return np.full(self.matrix.shape[0], self.matrix.shape[1] + 1)
+        elif self.format is TransformFormat.diagonal:
+            return np.full(self.matrix.shape[0], 2)
+        else:
+            # Loading the column index doubles the cost of each element
+            return 2 * self._nnz + 1
+
+    def sizeof(self, vertex_slice):
+        n_rows = len(self._nnz[vertex_slice])
+
+        if self.format is TransformFormat.dense:
+            return super(TransformRegion, self).sizeof(vertex_slice)
+        elif self.format is TransformFormat.diagonal:
+            return 8 * n_rows
+        else:
+            return 4 * (n_rows + 1) + 8 * int(np.sum(self._nnz[vertex_slice]))
+
+    def write_subregion_to_file(self, fp, vertex_slice=slice(None),
+                                **formatter_args):
+        if self.format is TransformFormat.dense:
+            super(TransformRegion, self).write_subregion_to_file(
+                fp, vertex_slice, **formatter_args)
+            return
+
+        rows = self.matrix[vertex_slice]
+        if self.format is TransformFormat.diagonal:
+            # Column of the non-zero element of each row (or 0 for empty rows)
+            columns = np.argmax(rows != 0, axis=1).astype(np.uint32)
+            values = rows[np.arange(rows.shape[0]), columns]
+            fp.write(columns.tostring())
+            fp.write(values.astype(np.int32).tostring())
+        else:
+            row_starts, columns = np.nonzero(rows)
+            indptr = np.zeros(rows.shape[0] + 1, dtype=np.uint32)
+            indptr[1:] = np.cumsum(self._nnz[vertex_slice])
+            fp.write(indptr.tostring())
+            fp.write(columns.astype(np.uint32).tostring())
+            fp.write(rows[row_starts, columns].astype(np.int32).tostring())
+
+
+def divide_rows_by_cost(costs, n_slices):
+    """Divide rows into contiguous slices of roughly equal total cost.
+
+    Parameters
+    ----------
+    costs : array
+        Cost of each row.
+    n_slices : int
+        Number of slices to construct.
+
+    Yields
+    ------
+    :py:class:`slice`
+    """
+    cumulative = np.cumsum(costs)
+    total = cumulative[-1] if len(cumulative) else 0
+
+    start = 0
+    for i in range(1, n_slices + 1):
+        # Find the first row after which at least the target cost is reached,
+        # always leaving at least one row for each remaining slice.
+        if i == n_slices:
+            stop = len(costs)
+        else:
+            target = float(total) * i / n_slices
+            stop = int(np.searchsorted(cumulative, target)) + 1
+            stop = max(start + 1, min(stop, len(costs) - (n_slices - i)))
+
+        yield slice(start, stop)
+        start = stop
+
+
 def get_transforms_and_keys(signals_connections, columns):
     """Get a combined transform matrix and a list of keys to use to transmit
     elements transformed with the matrix.  This method also returns a list of
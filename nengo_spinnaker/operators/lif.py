@@ -13,6 +13,7 @@ import math
 from nengo.base import ObjView
 from nengo.connection import LearningRule
 from nengo.learning_rules import PES, Voja
+from nengo.neurons import AdaptiveLIF, LIF, RectifiedLinear
 import numpy as np
 from rig.place_and_route import Cores, SDRAM
 from rig.place_and_route.constraints import SameChipConstraint
@@ -25,14 +26,51 @@ from nengo_spinnaker.builder.ports import (
 )
 from nengo_spinnaker.regions.filters import (FilterRegion, FilterRoutingRegion,
                                              add_filters, make_filter_regions)
+from nengo_spinnaker.regions.recording import (
+    combine_windows, get_probe_window, get_window_slice
+)
 from nengo_spinnaker.regions.utils import Args
 from .. import regions
 from nengo_spinnaker.netlist import Vertex
 from nengo_spinnaker import partition
 from nengo_spinnaker.utils.application import get_application
 from nengo_spinnaker.utils.config import getconfig
+from nengo_spinnaker.utils.cost_model import CoreLoad, CostModel
 from nengo_spinnaker.utils import type_casts as tp
 from nengo_spinnaker.utils import neurons as neuron_utils
+from nengo_spinnaker.utils import profiling
+
+
+# Number of fractional bits used to represent the input to packed encoders,
+# this must match `PACKED_INPUT_FRAC_BITS` in `ensemble.h`.
+PACKED_INPUT_FRAC_BITS = 11
+
+# Largest acceptable error introduced by packing the encoders, as a fraction
+# of the largest encoder component.
+PACKED_ENCODER_MAX_ERROR = 2.0**-10
+
+# Largest acceptable sum of the singular values which are discarded when
+# factoring decoders, this is below the resolution of S16.15.
+DECODER_FACTOR_TOLERANCE = 2.0**-16
+
+# Largest number of words of decoders read from SDRAM at a time when decoders
+# are streamed, two blocks of this size are held in DTCM.
+DECODER_BLOCK_WORDS = 1024
+
+# Bytes of DTCM available for the data of an ensemble and the fraction of it
+# which the estimated data of a core may use.
+DTCM_BYTES = 56 * 2**10
+DTCM_USABLE_FRACTION = 0.75
+
+
+class DecoderStorage(enum.IntEnum):
+    """Formats in which the static decoders of an ensemble may be stored,
+    corresponding to `decoder_storage_t` in `ensemble.h`.
+    """
+    dense = 0  # Full matrix
+    factored = 1  # Transform applied to the output of a smaller decoder
+    sparse = 2  # Non-zero elements of the decoder of each neuron
+    streamed = 3  # Full matrix, read from SDRAM a block of rows at a time
 
 
 class Regions(enum.IntEnum):
@@ -42,8 +80,8 @@ class Regions(enum.IntEnum):
     encoders = 3  # Encoder matrix (for neurons on core)
     bias = 4  # Biases
     gain = 5  # Gains
-    decoders = 6  # Decoder matrix (for all neurons, only some rows)
-    learnt_decoders = 7  # Learnt decoder matrix (for all neurons, all rows)
+    decoders = 6  # Decoder matrix (for neurons in cluster, only some rows)
+    learnt_decoders = 7  # Learnt decoders (for neurons in cluster, some rows)
     keys = 8  # Output keys
     learnt_keys = 9  # Learnt output keys
     population_length = 10  # Information about the entire cluster
@@ -62,6 +100,10 @@ class Regions(enum.IntEnum):
     spike_recording = 23
     voltage_recording = 24
     encoder_recording = 25
+    profiler_counters = 26  # Profiler counters, always available
+    tick_status = 27  # Timesteps which overran
+    transmit_schedule = 28  # Pacing of the transmission of decoded values
+    transmit_threshold = 29  # Suppression of decoded values which barely vary
 
 
 RoutingRegions = (Regions.input_routing,
@@ -69,6 +111,16 @@ RoutingRegions = (Regions.input_routing,
                   Regions.modulatory_routing,
                   Regions.learnt_encoder_routing)
 
+# Regions which may be accessed in place in SDRAM rather than copied into
+# DTCM, in the order in which they are left in SDRAM if the data of a core
+# would not otherwise fit in DTCM.  The bias and gain are each read once per
+# neuron every timestep; the encoders are read once per neuron and dimension
+# and so are always copied into DTCM.
+SDRAM_RESIDENT_CANDIDATES = (Regions.bias, Regions.gain)
+
+# Words per neuron of all the regions in SDRAM_RESIDENT_CANDIDATES
+SDRAM_RESIDENT_WORDS_PER_NEURON = 2
+
 
 class EnsembleLIF(object):
     """Controller for an ensemble of LIF neurons."""
@@ -126,9 +178,13 @@ class EnsembleLIF(object):
 
         size_out = decoders.shape[0]
 
-        ens_regions[Regions.decoders] = regions.MatrixRegion(
-            tp.np_to_fix(decoders / model.dt),
-            sliced_dimension=regions.MatrixPartitioning.rows)
+        # The static decoders may be stored factored or sparse to reduce the
+        # amount of memory they require.
+        storage = getconfig(model.config, self.ensemble, "decoder_storage")
+        if storage is not None:
+            storage = DecoderStorage[storage]
+        ens_regions[Regions.decoders] = DecoderRegion(decoders / model.dt,
+                                                      storage)
 
         ens_regions[Regions.keys] = regions.KeyspacesRegion(
             output_keys,
@@ -195,10 +251,9 @@ class EnsembleLIF(object):
 
                     # Either add a new filter to the filtered activity
                     # region or get the index of the existing one
-                    # activity_filter_index = \
-                    #    ens_regions[Regions.filtered_activity].add_get_filter(
-                    #        l_rule_type.pre_tau)
-                    activity_filter_index = -1
+                    activity_filter_index = \
+                        ens_regions[Regions.filtered_activity].add_get_filter(
+                            l_rule_type.pre_tau)
 
                     # Add a new learning rule to the PES region
                     # **NOTE** divide learning rate by dt
@@ -225,9 +280,8 @@ class EnsembleLIF(object):
 
         size_learnt_out = learnt_decoders.shape[0]
 
-        ens_regions[Regions.learnt_decoders] = regions.MatrixRegion(
-            tp.np_to_fix(learnt_decoders / model.dt),
-            sliced_dimension=regions.MatrixPartitioning.rows)
+        ens_regions[Regions.learnt_decoders] = DecoderRegion(
+            learnt_decoders / model.dt, DecoderStorage.dense)
 
         ens_regions[Regions.learnt_keys] = regions.KeyspacesRegion(
             learnt_output_keys,
@@ -284,10 +338,9 @@ class EnsembleLIF(object):
 
                 # Either add a new filter to the filtered activity
                 # region or get the index of the existing one
-                # activity_filter_index = \
-                #    ens_regions[Regions.filtered_activity].add_get_filter(
-                #        l_rule_type.post_tau)
-                activity_filter_index = -1
+                activity_filter_index = \
+                    ens_regions[Regions.filtered_activity].add_get_filter(
+                        l_rule_type.post_tau)
 
                 # Add a new learning rule to the Voja region
                 # **NOTE** divide learning rate by dt
@@ -305,10 +358,28 @@ class EnsembleLIF(object):
                     % l_rule_type
                 )
 
-        # Create encoders region
-        ens_regions[Regions.encoders] = regions.MatrixRegion(
-            tp.np_to_fix(encoders_with_gain),
-            sliced_dimension=regions.MatrixPartitioning.rows)
+        # Create encoders region, the encoders are stored as pairs of 16-bit
+        # values if this was requested and there are no learnt encoders.
+        # Packing is opt-in as the input to the encoders is also quantised (to
+        # PACKED_INPUT_FRAC_BITS fractional bits), the error this introduces
+        # is not bounded by the error of the packed encoders.
+        packed_encoders = None
+        use_packed = getconfig(model.config, self.ensemble, "packed_encoders",
+                               False)
+        if len(learnt_encoder_filters) == 0 and use_packed:
+            packed_encoders = get_packed_encoders(
+                encoders_with_gain, 2 * self.ensemble.radius, max_error=None)
+
+        if packed_encoders is None:
+            encoder_frac_bits = 0
+            ens_regions[Regions.encoders] = regions.MatrixRegion(
+                tp.np_to_fix(encoders_with_gain),
+                sliced_dimension=regions.MatrixPartitioning.rows)
+        else:
+            packed_encoders, encoder_frac_bits = packed_encoders
+            ens_regions[Regions.encoders] = regions.MatrixRegion(
+                packed_encoders,
+                sliced_dimension=regions.MatrixPartitioning.rows)
 
         # Tile direct input across all encoder copies (used for learning)
         tiled_direct_input = np.tile(
@@ -351,13 +422,13 @@ class EnsembleLIF(object):
         n_learnt_input_signals = len(learnt_encoder_filters)
         ens_regions[Regions.ensemble] = EnsembleRegion(
             model.machine_timestep, self.ensemble.size_in,
-            encoders_with_gain.shape[1], n_learnt_input_signals)
+            encoders_with_gain.shape[1], n_learnt_input_signals,
+            packed_encoders=packed_encoders is not None,
+            encoder_frac_bits=encoder_frac_bits)
 
         # The neuron region contains information specific to the neuron type
-        ens_regions[Regions.neuron] = LIFRegion(
-            model.dt, self.ensemble.neuron_type.tau_rc,
-            self.ensemble.neuron_type.tau_ref
-        )
+        ens_regions[Regions.neuron] = make_neuron_region(
+            self.ensemble.neuron_type, model.dt)
 
         # Manage profiling
         n_profiler_samples = 0
@@ -376,20 +447,46 @@ class EnsembleLIF(object):
         # Create profiler region
         ens_regions[Regions.profiler] = regions.Profiler(n_profiler_samples)
         ens_regions[Regions.ensemble].n_profiler_samples = n_profiler_samples
-
-        # Manage probes
+        ens_regions[Regions.profiler_counters] = regions.ProfilerCounters()
+        ens_regions[Regions.tick_status] = regions.TickStatusRegion(
+            regions.TickOverrunPolicy[model.tick_overrun_policy])
+        ens_regions[Regions.transmit_schedule] = \
+            regions.TransmitScheduleRegion()
+        ens_regions[Regions.transmit_threshold] = \
+            regions.TransmitThresholdRegion(
+                regions.get_transmit_thresholds(output_keys),
+                regions.get_transmit_refresh_period(
+                    model.transmit_refresh_time, model.dt))
+
+        # Manage probes, each recording region records in a window which
+        # includes the windows of all the probes which read from it.
+        self.probe_windows = dict()
+        record_windows = collections.defaultdict(list)
         for probe in self.local_probes:
             if probe.attr in ("output", "spikes"):
                 self.record_spikes = True
+                region = Regions.spike_recording
             elif probe.attr == "voltage":
                 self.record_voltages = True
+                region = Regions.voltage_recording
             elif probe.attr == "scaled_encoders":
                 self.record_encoders = True
+                region = Regions.encoder_recording
             else:
                 raise NotImplementedError(
                     "Cannot probe {} on Ensembles".format(probe.attr)
                 )
 
+            window = get_probe_window(probe, model.dt, model.config)
+            self.probe_windows[probe] = (region, window)
+            record_windows[region].append(window)
+
+        self.record_windows = {
+            region: combine_windows(record_windows[region]) for region in
+            (Regions.spike_recording, Regions.voltage_recording,
+             Regions.encoder_recording)
+        }
+
         # Set the flags
         ens_regions[Regions.ensemble].record_spikes = self.record_spikes
         ens_regions[Regions.ensemble].record_voltages = self.record_voltages
@@ -398,28 +495,56 @@ class EnsembleLIF(object):
         # Create the probe recording regions
         self.learnt_enc_dims = (encoders_with_gain.shape[1] -
                                 self.ensemble.size_in)
-        ens_regions[Regions.spike_recording] =\
-            regions.SpikeRecordingRegion(n_steps if self.record_spikes
-                                         else 0)
+        spike_rate = getconfig(model.config, self.ensemble,
+                               "spike_recording_rate")
+        if self.record_spikes and spike_rate is not None:
+            ens_regions[Regions.spike_recording] =\
+                regions.CompressedSpikeRecordingRegion(
+                    n_steps, spike_rate, model.dt,
+                    *self.record_windows[Regions.spike_recording]
+                )
+            ens_regions[Regions.ensemble].compress_spikes = True
+        else:
+            ens_regions[Regions.spike_recording] =\
+                regions.SpikeRecordingRegion(
+                    n_steps if self.record_spikes else 0,
+                    *self.record_windows[Regions.spike_recording]
+                )
         ens_regions[Regions.voltage_recording] =\
-            regions.VoltageRecordingRegion(n_steps if self.record_voltages
-                                           else 0)
+            regions.VoltageRecordingRegion(
+                n_steps if self.record_voltages else 0,
+                *self.record_windows[Regions.voltage_recording]
+            )
         ens_regions[Regions.encoder_recording] =\
-            regions.EncoderRecordingRegion(n_steps if self.record_encoders
-                                           else 0, self.learnt_enc_dims)
+            regions.EncoderRecordingRegion(
+                n_steps if self.record_encoders else 0, self.learnt_enc_dims,
+                *self.record_windows[Regions.encoder_recording]
+            )
 
         # Create constraints against which to partition.
         # The number of cycles available is 200MHz * the machine timestep; or
-        # 200 * the machine timestep in microseconds.
+        # 200 * the machine timestep in microseconds.  The cycles used are
+        # estimated with the model's cost model and limited to the model's
+        # target fraction of the timestep.
         cycles = 200 * model.machine_timestep
-        cpu_constraint = partition.Constraint(cycles, 0.4)  # 40% of cycles
-        dtcm_constraint = partition.Constraint(56*2**10, 0.75)  # 75% DTCM
+        cpu_constraint = partition.Constraint(cycles, model.cpu_target)
+        dtcm_constraint = partition.Constraint(DTCM_BYTES,
+                                               DTCM_USABLE_FRACTION)
 
         cluster_usage = ClusterResourceUsage(
-            size_in, size_out, size_learnt_out
+            size_in, size_out, size_learnt_out,
+            packed_encoders=packed_encoders is not None,
+            decoders=ens_regions[Regions.decoders],
+            n_activity_filters=len(
+                ens_regions[Regions.filtered_activity].filter_propogators),
+            cost_model=model.cost_model,
+            filter_order=get_filter_order(ens_regions[Regions.input_filters]),
+            n_routes=len(ens_regions[Regions.input_routing].signal_routes)
         )
-        partition_constraints = {dtcm_constraint: cluster_usage.dtcm_usage,
-                                 cpu_constraint: cluster_usage.cpu_usage}
+        partition_constraints = {
+            dtcm_constraint: cluster_usage.min_dtcm_usage,
+            cpu_constraint: cluster_usage.cpu_usage,
+        }
 
         # Partition the ensemble to create clusters of co-operating cores
         self.clusters = list()
@@ -433,11 +558,13 @@ class EnsembleLIF(object):
             cluster = EnsembleCluster(sl, self.ensemble.size_in,
                                       encoders_with_gain.shape[1], size_out,
                                       size_learnt_out, n_learnt_input_signals,
-                                      ens_regions)
+                                      ens_regions,
+                                      packed_encoders is not None)
             self.clusters.append(cluster)
 
             # Get the vertices for the cluster
-            cluster_vertices = cluster.make_vertices(cycles)
+            cluster_vertices = cluster.make_vertices(
+                cycles, model.cpu_target, model.cost_model)
             vertices.extend(cluster_vertices)
 
             # Create a constraint which forces these vertices to be present on
@@ -495,6 +622,21 @@ class EnsembleLIF(object):
 
         return constraints
 
+    def get_signal_targets(self):
+        """Return the filters targeted by each signal parameters.
+
+        Returns
+        -------
+        {id(SignalParameters): {(region, target), ...}}
+        """
+        targets = collections.defaultdict(set)
+        for region in RoutingRegions:
+            r = self.regions[region]
+            for u, ts in iteritems(r.get_signal_targets()):
+                targets[u].update((region, t) for t in ts)
+
+        return targets
+
     def load_to_machine(self, netlist, controller):
         """Load the ensemble data into memory."""
         # Prepare the routing regions
@@ -538,11 +680,24 @@ class EnsembleLIF(object):
                     cl.get_profiler_data()
                 ))
 
+        # Get the profiler counters, mapped from (neurons.start, neurons.stop)
+        simulator.profiler_counters[self.ensemble] = dict()
+        for cl in self.clusters:
+            simulator.profiler_counters[self.ensemble].update(dict(
+                cl.get_profiler_counters()
+            ))
+
+        # Get the status of the timesteps of each core
+        for cl in self.clusters:
+            simulator.tick_status.update(dict(cl.get_tick_status()))
+
         # Retrieve probe data
         # If spikes were recorded then get the spikes
         if self.record_spikes:
             # Create an empty matrix of the correct size
-            spikes = np.zeros((n_steps, self.ensemble.n_neurons),
+            n_samples = self.regions[Regions.spike_recording].get_n_samples(
+                n_steps)
+            spikes = np.zeros((n_samples, self.ensemble.n_neurons),
                               dtype=np.bool)
 
             # For each cluster read back the spike data
@@ -553,13 +708,15 @@ class EnsembleLIF(object):
                     spikes[:, neurons.start:neurons_stop] = data
 
             # Recast the data as floats
-            spike_vals = np.zeros((n_steps, self.ensemble.n_neurons))
+            spike_vals = np.zeros((n_samples, self.ensemble.n_neurons))
             spike_vals[spikes] = 1.0 / simulator.dt
 
         # If voltages were recorded then get the voltages
         if self.record_voltages:
             # Create an empty matrix of the correct size
-            voltages = np.zeros((n_steps, self.ensemble.n_neurons))
+            n_samples = self.regions[Regions.voltage_recording].get_n_samples(
+                n_steps)
+            voltages = np.zeros((n_samples, self.ensemble.n_neurons))
 
             # For each cluster read back the voltage data
             for cl in self.clusters:
@@ -570,8 +727,10 @@ class EnsembleLIF(object):
         # If (learnt) encoders were recorded
         if self.record_encoders:
             # Create empty matrix to hold probed data
+            n_samples = self.regions[Regions.encoder_recording].get_n_samples(
+                n_steps)
             encoders = np.empty((
-                n_steps,
+                n_samples,
                 self.ensemble.n_neurons,
                 self.learnt_enc_dims))
 
@@ -588,20 +747,20 @@ class EnsembleLIF(object):
             if isinstance(p.target, ObjView):
                 neuron_slice = p.target.slice
 
-            # Get the temporal slicing applied by the probe
-            sample_every = 1
-            if p.sample_every is not None:
-                sample_every = int(p.sample_every / simulator.dt)
+            # Get the samples of the recorded data which were taken in the
+            # window of the probe
+            region, window = self.probe_windows[p]
+            samples = get_window_slice(window, self.record_windows[region])
 
             # Copy desired slice of recorded data into simulator
             if p.attr in ("output", "spikes"):
                 # Spike data
-                probe_data = spike_vals[::sample_every, neuron_slice]
+                probe_data = spike_vals[samples, neuron_slice]
             elif p.attr == "voltage":
                 # Voltage data
-                probe_data = voltages[::sample_every, neuron_slice]
+                probe_data = voltages[samples, neuron_slice]
             elif p.attr == "scaled_encoders":
-                probe_data = encoders[::sample_every, neuron_slice, :]
+                probe_data = encoders[samples, neuron_slice, :]
 
             # Store the probe data
             if p in simulator.data:
@@ -612,7 +771,8 @@ class EnsembleLIF(object):
 
 class EnsembleCluster(object):
     def __init__(self, neuron_slice, size_in, encoder_width, size_out,
-                 size_learnt_out, n_learnt_input_signals, regions):
+                 size_learnt_out, n_learnt_input_signals, regions,
+                 packed_encoders=False):
         """Create a new cluster of collaborating cores."""
         self.neuron_slice = neuron_slice
         self.regions = regions
@@ -623,16 +783,25 @@ class EnsembleCluster(object):
         self.size_out = size_out
         self.size_learnt_out = size_learnt_out
         self.n_learnt_input_signals = n_learnt_input_signals
+        self.packed_encoders = packed_encoders
 
-    def make_vertices(self, cycles):
+    def make_vertices(self, cycles, cpu_target=0.4, cost_model=None):
         """Partition the neurons onto multiple cores."""
-        dtcm_constraint = partition.Constraint(56 * 2**10, 0.75)  # 75% of DTCM
-        cpu_constraint = partition.Constraint(cycles, 0.4)  # 40% of compute
+        dtcm_constraint = partition.Constraint(DTCM_BYTES,
+                                               DTCM_USABLE_FRACTION)
+        cpu_constraint = partition.Constraint(cycles, cpu_target)
 
         # Get the number of neurons in this cluster
         n_neurons = self.neuron_slice.stop - self.neuron_slice.start
-        core_usage = CoreResouceUsage(self.encoder_width, n_neurons)
-        constraints = {dtcm_constraint: core_usage.dtcm_usage,
+        core_usage = CoreResouceUsage(
+            self.encoder_width, n_neurons, self.packed_encoders,
+            self.regions[Regions.decoders],
+            len(self.regions[Regions.filtered_activity].filter_propogators),
+            cost_model=cost_model,
+            filter_order=get_filter_order(self.regions[Regions.input_filters]),
+            n_routes=len(self.regions[Regions.input_routing].signal_routes)
+        )
+        constraints = {dtcm_constraint: core_usage.min_dtcm_usage,
                        cpu_constraint: core_usage.cpu_usage}
 
         # Partition the slice of neurons that we have
@@ -712,6 +881,18 @@ class EnsembleCluster(object):
             # Get the data and yield a new entry
             yield key, vertex.get_profiler_data()
 
+    def get_profiler_counters(self):
+        """Retrieve the profiler counters from the simulation."""
+        for vertex in self.vertices:
+            key = (vertex.neuron_slice.start,
+                   vertex.neuron_slice.stop)
+            yield key, vertex.get_profiler_counters()
+
+    def get_tick_status(self):
+        """Retrieve the status of the timesteps from the simulation."""
+        for vertex in self.vertices:
+            yield vertex, vertex.get_tick_status()
+
     def get_spike_data(self, n_steps):
         """Retrieve the spike data from the simulation."""
         for vertex in self.vertices:
@@ -737,9 +918,10 @@ class EnsembleSlice(Vertex):
     profiler_tag_names = {
         0:  "Input filter",
         1:  "Neuron update",
-        2:  "Decode and transmit output",
+        2:  "Decode output",
         3:  "PES",
         4:  "Voja",
+        5:  "Barrier wait",
     }
 
     def __init__(self, vertex_index, cluster_slices, input_slice, output_slice,
@@ -795,12 +977,32 @@ class EnsembleSlice(Vertex):
         self.region_arguments[Regions.learnt_encoder_filters].\
             kwargs["filter_width"] = input_width
 
+        # Leave regions in SDRAM if the data of the slice would not otherwise
+        # fit in DTCM; slices are partitioned such that it always fits once
+        # every candidate region is left in SDRAM.
+        ens_region = ens_regions[Regions.ensemble]
+        n_neurons = self.neuron_slice.stop - self.neuron_slice.start
+        core_usage = CoreResouceUsage(
+            ens_region.encoder_width, self.n_neurons_in_cluster,
+            ens_region.packed_encoders, ens_regions[Regions.decoders],
+            len(ens_regions[Regions.filtered_activity].filter_propogators)
+        )
+        self.sdram_regions = get_sdram_resident_regions(
+            core_usage.dtcm_usage(input_slice, self.neuron_slice,
+                                  output_slice, learnt_output_slice),
+            {Regions.bias: n_neurons * 4,
+             Regions.gain: n_neurons * 4}
+        )
+        self.region_arguments[Regions.ensemble].kwargs["sdram_regions"] = \
+            self.sdram_regions
+
         # Compute the SDRAM usage
         sdram_usage = regions.utils.sizeof_regions_named(self.regions,
                                                          self.region_arguments)
 
-        # Prepare the vertex
-        application = "ensemble"
+        # Prepare the vertex, the ensemble executable is specialised for the
+        # neuron model.
+        application = ens_regions[Regions.neuron].application
 
         if ens_regions[Regions.profiler].n_samples > 0:
             # If profiling then use the profiled version of the application
@@ -836,17 +1038,20 @@ class EnsembleSlice(Vertex):
         self.region_arguments[Regions.learnt_keys].kwargs["cluster"] = \
             self.cluster
 
-        # Write each region into memory
-        for key in Regions:
-            # Get the arguments and the memory
-            args, kwargs = self.region_arguments[key]
-            mem = self.region_memory[key]
-
-            # Get the region
-            region = self.regions[key]
+        # Schedule the transmission of the decoded values according to where
+        # the vertex was placed.
+        n_packets = ((self.output_slice.stop - self.output_slice.start) +
+                     (self.learnt_output_slice.stop -
+                      self.learnt_output_slice.start))
+        self.region_arguments[Regions.transmit_schedule].kwargs.update(
+            regions.get_transmit_schedule(
+                netlist, self, n_packets,
+                self.regions[Regions.ensemble].machine_timestep)
+        )
 
-            # Perform the write
-            region.write_subregion_to_file(mem, *args, **kwargs)
+        # Write each region into memory
+        regions.utils.write_regions_named(
+            self.region_memory, self.regions, self.region_arguments)
 
     def get_profiler_data(self):
         """Retrieve profiler data from the simulation."""
@@ -858,6 +1063,35 @@ class EnsembleSlice(Vertex):
         profiler = self.regions[Regions.profiler]
         return profiler.read_from_mem(mem, self.profiler_tag_names)
 
+    def get_profiler_counters(self):
+        """Retrieve the profiler counters from the simulation."""
+        mem = self.region_memory[Regions.profiler_counters]
+        mem.seek(0)
+
+        counters = self.regions[Regions.profiler_counters]
+        return profiling.decode_counters(counters.read_from_mem(mem),
+                                         self.profiler_tag_names)
+
+    def get_core_load(self):
+        """Get the work performed by the core in each timestep."""
+        return CoreLoad(
+            size_in=self.regions[Regions.ensemble].encoder_width,
+            filtered_dims=self.input_slice.stop - self.input_slice.start,
+            filter_order=get_filter_order(self.regions[Regions.input_filters]),
+            n_routes=len(self.regions[Regions.input_routing].signal_routes),
+            n_neurons=self.neuron_slice.stop - self.neuron_slice.start,
+            n_neurons_in_cluster=self.n_neurons_in_cluster,
+            size_out=self.output_slice.stop - self.output_slice.start,
+            size_learnt_out=(self.learnt_output_slice.stop -
+                             self.learnt_output_slice.start),
+        )
+
+    def get_tick_status(self):
+        """Retrieve the status of the timesteps from the simulation."""
+        mem = self.region_memory[Regions.tick_status]
+        mem.seek(0)
+        return self.regions[Regions.tick_status].read_from_mem(mem)
+
     def get_probe_data(self, region_name, n_steps):
         """Retrieve probed data from the simulation."""
         # Get the memory block
@@ -889,7 +1123,9 @@ class EnsembleRegion(regions.Region):
     def __init__(self, machine_timestep, size_in, encoder_width,
                  n_learnt_input_signals, n_profiler_samples=0,
                  record_spikes=False, record_voltages=False,
-                 record_encoders=False):
+                 record_encoders=False, packet_queue_length=1024,
+                 packed_encoders=False, encoder_frac_bits=0,
+                 compress_spikes=False):
         self.machine_timestep = machine_timestep
         self.size_in = size_in
         self.encoder_width = encoder_width
@@ -898,16 +1134,21 @@ class EnsembleRegion(regions.Region):
         self.record_spikes = record_spikes
         self.record_voltages = record_voltages
         self.record_encoders = record_encoders
+        self.packet_queue_length = packet_queue_length
+        self.packed_encoders = packed_encoders
+        self.encoder_frac_bits = encoder_frac_bits
+        self.compress_spikes = compress_spikes
 
     def sizeof(self, *args, **kwargs):
-        return (18 + self.n_learnt_input_signals) * 4
+        return (21 + self.n_learnt_input_signals) * 4
 
     def write_subregion_to_file(self, fp, n_populations, population_id,
                                 n_neurons_in_population, input_slice,
                                 neuron_slice, output_slice,
                                 learnt_output_slice, shared_input_vector,
                                 shared_learnt_input_vector,
-                                shared_spike_vector, sema_input, sema_spikes):
+                                shared_spike_vector, sema_input, sema_spikes,
+                                sdram_regions=()):
         """Write the region to a file-like.
 
         Parameters
@@ -938,6 +1179,9 @@ class EnsembleRegion(regions.Region):
         sema_spikes : int
             Address of a semaphore in shared memory for synchronising reading
             of spike vectors.
+        sdram_regions : [:py:class:`Regions`, ...]
+            Regions which should be accessed in place in SDRAM rather than
+            being copied into DTCM.
         """
         # Prepare all data for packing
         n_neurons = neuron_slice.stop - neuron_slice.start
@@ -953,13 +1197,20 @@ class EnsembleRegion(regions.Region):
         flags = 0x0
         for i, predicate in enumerate((self.record_spikes,
                                        self.record_voltages,
-                                       self.record_encoders)):
+                                       self.record_encoders,
+                                       self.packed_encoders,
+                                       self.compress_spikes)):
             if predicate:
                 flags |= 1 << i
 
+        # Build the mask of regions left in SDRAM
+        sdram_mask = 0x0
+        for region in sdram_regions:
+            sdram_mask |= 1 << region
+
         # Pack and write the data
         fp.write(struct.pack(
-            "<%uI" % (18 + self.n_learnt_input_signals),
+            "<%uI" % (21 + self.n_learnt_input_signals),
             self.machine_timestep,
             n_neurons,
             self.size_in,
@@ -974,6 +1225,9 @@ class EnsembleRegion(regions.Region):
             self.n_profiler_samples,
             self.n_learnt_input_signals,
             flags,
+            self.packet_queue_length,
+            self.encoder_frac_bits,
+            sdram_mask,
             shared_input_vector,
             shared_spike_vector,
             sema_input,
@@ -982,11 +1236,33 @@ class EnsembleRegion(regions.Region):
         ))
 
 
+def make_neuron_region(neuron_type, dt):
+    """Create the region containing parameters specific to the given type of
+    neuron.
+    """
+    # NOTE: AdaptiveLIF is a subclass of LIF so must be checked first
+    if isinstance(neuron_type, AdaptiveLIF):
+        return AdaptiveLIFRegion(dt, neuron_type.tau_rc, neuron_type.tau_ref,
+                                 neuron_type.tau_n, neuron_type.inc_n)
+    elif isinstance(neuron_type, LIF):
+        return LIFRegion(dt, neuron_type.tau_rc, neuron_type.tau_ref)
+    elif isinstance(neuron_type, RectifiedLinear):
+        return RectifiedLinearRegion(dt)
+    else:
+        raise NotImplementedError(
+            "SpiNNaker does not support {} neurons.".format(
+                neuron_type.__class__.__name__)
+        )
+
+
 class LIFRegion(regions.Region):
     """Region containing parameters specific to LIF neurons.
 
     This is the Python representation of `lif_parameters_t`.
     """
+    # Name of the ensemble executable built for this neuron model
+    application = "ensemble"
+
     def __init__(self, dt, tau_rc, tau_ref):
         self.dt = dt
         self.tau_rc = tau_rc
@@ -1022,6 +1298,192 @@ PESLearningRule = collections.namedtuple(
     "activity_filter_index")
 
 
+class AdaptiveLIFRegion(LIFRegion):
+    """Region containing parameters specific to adaptive LIF neurons.
+
+    This is the Python representation of `lif_parameters_t` followed by
+    `adaptive_lif_parameters_t`.
+    """
+    application = "ensemble_adaptive_lif"
+
+    def __init__(self, dt, tau_rc, tau_ref, tau_n, inc_n):
+        # The decay of the adaptation (dt / tau_n) is stored as an unsigned
+        # fraction and so must be less than 1.
+        if tau_n <= dt:
+            raise ValueError(
+                "The adaptation time constant of adaptive LIF neurons (tau_n="
+                "{}) must be greater than the simulation timestep (dt={})."
+                .format(tau_n, dt))
+
+        super(AdaptiveLIFRegion, self).__init__(dt, tau_rc, tau_ref)
+        self.tau_n = tau_n
+        self.inc_n = inc_n
+
+    def sizeof(self, *args, **kwargs):
+        """Get the size of the region in bytes."""
+        return 4*4  # 4 words
+
+    def write_subregion_to_file(self, fp):
+        """Write the region to the file-like object."""
+        # Write the LIF parameters and then the decay of the adaptation (as
+        # S0.31) and the increase in adaptation for each spike.
+        super(AdaptiveLIFRegion, self).write_subregion_to_file(fp)
+        fp.write(struct.pack(
+            "<Ii",
+            int(round(self.dt / self.tau_n * 2**31)),
+            tp.value_to_fix(self.inc_n / self.tau_n)
+        ))
+
+
+class RectifiedLinearRegion(regions.Region):
+    """Region containing parameters specific to rectified linear neurons.
+
+    This is the Python representation of `rectified_linear_parameters_t`.
+    """
+    application = "ensemble_rectified_linear"
+
+    def __init__(self, dt):
+        self.dt = dt
+
+    def sizeof(self, *args, **kwargs):
+        """Get the size of the region in bytes."""
+        return 1*4  # 1 word
+
+    def write_subregion_to_file(self, fp):
+        """Write the region to the file-like object."""
+        # The timestep is written as S0.31
+        fp.write(struct.pack("<I", int(round(self.dt * 2**31))))
+
+
+class DecoderRegion(regions.Region):
+    """Region containing decoders, sliced by output and by neuron.
+
+    The region starts with the format in which the decoders are stored and the
+    number of factors, non-zero elements or rows per block they contain.
+    Slices for which the preferred format would not reduce the memory (DTCM)
+    required are stored densely.
+    """
+    def __init__(self, decoders, storage=DecoderStorage.dense):
+        """Create a new decoder region.
+
+        Parameters
+        ----------
+        decoders : ndarray
+            Decoder matrix (outputs x neurons).
+        storage : :py:class:`DecoderStorage` or None
+            Preferred format of the decoders, if None the format which
+            requires the least memory to store the whole matrix is used.
+            Decoders are only streamed from SDRAM if this is requested.
+        """
+        if decoders.ndim < 2:
+            decoders = decoders.reshape(0, 0)  # No decoders
+        self.decoders = tp.np_to_fix(decoders)
+
+        # Factor the decoders if this may be required
+        self.factors = None
+        if storage in (None, DecoderStorage.factored):
+            self.factors = get_factored_decoders(decoders)
+
+        # Get the density of the decoders to estimate memory usage
+        self.density = (float(np.count_nonzero(self.decoders)) /
+                        max(self.decoders.size, 1))
+
+        if storage is None:
+            candidates = (s for s in DecoderStorage
+                          if s is not DecoderStorage.streamed)
+            storage = min(candidates, key=lambda s: self._get_words(
+                s, slice(None), slice(None)))
+        self.storage = storage
+
+    def _get_words(self, storage, output_slice, neuron_slice):
+        """Get the number of words required to store a slice of the decoders
+        in the given format.
+        """
+        decoders = self.decoders[output_slice, neuron_slice]
+        n_rows, n_neurons = decoders.shape
+
+        if storage is DecoderStorage.factored:
+            n_factors = self.factors[0].shape[1]
+            return n_factors * (n_neurons + n_rows)
+        elif storage is DecoderStorage.sparse:
+            n_elements = np.count_nonzero(decoders)
+            return n_neurons + 1 + iceil(n_elements / 2.0) + n_elements
+        else:
+            # Dense and streamed decoders are both stored as the full matrix
+            return n_rows * n_neurons
+
+    def _get_storage(self, output_slice, neuron_slice):
+        """Get the format in which to store a slice of the decoders."""
+        n_rows = len(range(*output_slice.indices(self.decoders.shape[0])))
+        if self.storage is DecoderStorage.streamed:
+            # Streamed decoders require less DTCM whenever there are any
+            return self.storage if n_rows > 0 else DecoderStorage.dense
+        elif (self._get_words(self.storage, output_slice, neuron_slice) <
+                self._get_words(DecoderStorage.dense,
+                                output_slice, neuron_slice)):
+            return self.storage
+        return DecoderStorage.dense
+
+    def estimate_words(self, n_rows, n_neurons):
+        """Estimate the number of words of memory required to store a slice of
+        the decoders of the given size.
+        """
+        dense = n_rows * n_neurons
+        if self.storage is DecoderStorage.factored:
+            n_factors = self.factors[0].shape[1]
+            words = n_factors * (n_neurons + n_rows)
+        elif self.storage is DecoderStorage.sparse:
+            words = n_neurons + 1 + 1.5 * self.density * dense
+        elif self.storage is DecoderStorage.streamed:
+            words = 2 * get_rows_per_block(n_rows, n_neurons) * n_neurons
+        else:
+            words = dense
+
+        return min(dense, iceil(words))
+
+    def sizeof(self, output_slice, neuron_slice):
+        """Get the size of a slice of the region in bytes."""
+        storage = self._get_storage(output_slice, neuron_slice)
+        return 4 * (2 + self._get_words(storage, output_slice, neuron_slice))
+
+    def write_subregion_to_file(self, fp, output_slice, neuron_slice):
+        """Write a slice of the region to the file-like object."""
+        storage = self._get_storage(output_slice, neuron_slice)
+        decoders = self.decoders[output_slice, neuron_slice]
+
+        if storage is DecoderStorage.factored:
+            # Write the smaller decoder neuron-major, followed by the
+            # transform.
+            transform, factored = self.factors
+            fp.write(struct.pack("<2I", storage, transform.shape[1]))
+            fp.write(factored[:, neuron_slice].T.tostring())
+            fp.write(transform[output_slice].tostring())
+        elif storage is DecoderStorage.sparse:
+            # Write the index of the first element of each column, the row of
+            # each element (as 16-bit values padded to a whole number of
+            # words) and then the value of each element.
+            columns, rows = np.nonzero(decoders.T)
+            fp.write(struct.pack("<2I", storage, rows.size))
+
+            starts = np.zeros(decoders.shape[1] + 1, dtype=np.uint32)
+            starts[1:] = np.cumsum(np.count_nonzero(decoders, axis=0))
+            fp.write(starts.tostring())
+
+            packed_rows = np.zeros(2 * iceil(rows.size / 2.0),
+                                   dtype=np.uint16)
+            packed_rows[:rows.size] = rows
+            fp.write(packed_rows.tostring())
+            fp.write(decoders.T[columns, rows].tostring())
+        elif storage is DecoderStorage.streamed:
+            # Write the number of rows in each block, followed by the matrix
+            fp.write(struct.pack("<2I", storage,
+                                 get_rows_per_block(*decoders.shape)))
+            fp.write(decoders.tostring())
+        else:
+            fp.write(struct.pack("<2I", storage, 0))
+            fp.write(decoders.tostring())
+
+
 class PESRegion(regions.Region):
     """Region representing parameters for PES learning rules.
     """
@@ -1116,6 +1578,13 @@ class VojaRegion(regions.Region):
 
 
 class FilteredActivityRegion(regions.Region):
+    """Region describing the filters applied to neuron activity for learning
+    rules, corresponding to `activity_filter_parameters_t`.
+
+    Each filter is written as its propogator and one minus its propogator as
+    U0.32 values, the latter rounded down so that filtered activities cannot
+    exceed 1.
+    """
     def __init__(self, dt):
         self.filter_propogators = []
         self.dt = dt
@@ -1130,8 +1599,9 @@ class FilteredActivityRegion(regions.Region):
             # Calculate propogator
             propogator = math.exp(-float(self.dt) / float(time_constant))
 
-            # Convert to fixed-point
-            propogator_fixed = tp.value_to_fix(propogator)
+            # Convert to U0.32
+            propogator_fixed = min(int(round(propogator * 2**32)),
+                                   2**32 - 1)
 
             # If there is already a filter with the same fixed-point
             # propogator in the list, return its index
@@ -1146,19 +1616,154 @@ class FilteredActivityRegion(regions.Region):
         return 4 + (8 * len(self.filter_propogators))
 
     def write_subregion_to_file(self, fp):
-        # Write number of learning rules
+        # Write number of filters
         fp.write(struct.pack("<I", len(self.filter_propogators)))
 
         # Write filters
         for f in self.filter_propogators:
             data = struct.pack(
-                "<ii",
+                "<2I",
                 f,
-                tp.value_to_fix(1.0) - f,
+                2**32 - 1 - f,
             )
             fp.write(data)
 
 
+def get_sdram_resident_regions(dtcm_usage, region_sizes,
+                               dtcm_bytes=DTCM_BYTES * DTCM_USABLE_FRACTION):
+    """Determine which regions should be accessed in place in SDRAM rather
+    than being copied into DTCM.
+
+    Regions are left in SDRAM, in the order given by
+    `SDRAM_RESIDENT_CANDIDATES`, until the remaining data would fit in DTCM.
+
+    Parameters
+    ----------
+    dtcm_usage : int
+        Estimated bytes of DTCM required if every region were copied into
+        DTCM.
+    region_sizes : {:py:class:`Regions`: int}
+        Bytes of DTCM required by each region which may be left in SDRAM.
+    dtcm_bytes : int
+        Bytes of DTCM which may be used.
+
+    Returns
+    -------
+    [:py:class:`Regions`, ...]
+        Regions which should be left in SDRAM.
+    """
+    sdram_regions = list()
+    for region in SDRAM_RESIDENT_CANDIDATES:
+        if dtcm_usage <= dtcm_bytes:
+            break
+
+        if region in region_sizes:
+            sdram_regions.append(region)
+            dtcm_usage -= region_sizes[region]
+
+    return sdram_regions
+
+
+def get_packed_encoders(encoders, max_input,
+                        max_error=PACKED_ENCODER_MAX_ERROR):
+    """Convert encoders into pairs of signed 16-bit values.
+
+    Parameters
+    ----------
+    encoders : ndarray
+        Encoder matrix (neurons x dimensions) including the neuron gains.
+    max_input : float
+        Largest magnitude of input value which should be represented without
+        saturation.
+    max_error : float or None
+        Largest acceptable quantisation error of a single encoder component,
+        expressed as a fraction of the largest encoder component.  If None then
+        any error is acceptable.
+
+    Returns
+    -------
+    (ndarray, int) or None
+        Matrix of 16-bit values, with the columns padded to an even number,
+        and the number of fractional bits in each value.  None is returned if
+        the encoders cannot be represented as 16-bit values.
+    """
+    # The input vector is represented with a fixed number of fractional bits,
+    # determine whether this can represent the expected range of inputs.
+    input_limit = 2.0**(15 - PACKED_INPUT_FRAC_BITS)
+    if max_input > input_limit:
+        return None
+
+    # Choose the largest number of fractional bits for which the encoders will
+    # fit into 16 bits and for which the product of an encoder and the
+    # largest input will fit into the 32-bit accumulator.  At least 4
+    # fractional bits are required to convert the product to S16.15.
+    max_encoder = np.max(np.abs(encoders))
+    max_l1 = np.max(np.sum(np.abs(encoders), axis=1))
+    for frac_bits in range(15, 3, -1):
+        scale = 2.0**frac_bits
+        if (max_encoder * scale < 2**15 - 1 and
+                max_l1 * input_limit * scale *
+                2**PACKED_INPUT_FRAC_BITS < 2**31 - 1):
+            break
+    else:
+        return None
+
+    # Quantise the encoders and determine whether the error is acceptable
+    quantised = np.round(encoders * scale)
+    error = np.max(np.abs(quantised / scale - encoders))
+    if max_error is not None and error > max_error * max_encoder:
+        return None
+
+    # Pad to an even number of columns so that each row is a whole number of
+    # words.
+    packed = np.zeros((encoders.shape[0], 2 * iceil(encoders.shape[1] / 2.0)),
+                      dtype=np.int16)
+    packed[:, :encoders.shape[1]] = quantised
+    return packed, frac_bits
+
+
+def get_factored_decoders(decoders, tolerance=DECODER_FACTOR_TOLERANCE):
+    """Factor a decoder matrix into a transform and a decoder with fewer rows.
+
+    Parameters
+    ----------
+    decoders : ndarray
+        Decoder matrix (outputs x neurons).
+    tolerance : float
+        Largest acceptable sum of the singular values of the decoder matrix
+        which are discarded.
+
+    Returns
+    -------
+    (ndarray, ndarray)
+        Transform (outputs x factors) and decoder (factors x neurons) as
+        S16.15.  The number of factors is the smallest for which the discarded
+        singular values sum to at most `tolerance`, but is at least one.
+    """
+    if decoders.size == 0:
+        transform = np.zeros((decoders.shape[0], 1))
+        factored = np.zeros((1, decoders.shape[1]))
+    else:
+        u, s, vt = np.linalg.svd(decoders, full_matrices=False)
+
+        # Count the singular values which must be kept, the sum of the values
+        # beyond each index is computed from the end.
+        tails = np.cumsum(s[::-1])[::-1]
+        n_factors = max(1, int(np.sum(tails > tolerance)))
+
+        transform = u[:, :n_factors]
+        factored = s[:n_factors, np.newaxis] * vt[:n_factors]
+
+    return tp.np_to_fix(transform), tp.np_to_fix(factored)
+
+
+def get_rows_per_block(n_rows, n_neurons):
+    """Get the number of rows of decoders read from SDRAM at a time when
+    streaming decoders.
+    """
+    return max(1, min(n_rows, DECODER_BLOCK_WORDS // max(n_neurons, 1)))
+
+
 def get_decoders_and_keys(signals_connections, minimise=False):
     """Get a combined decoder matrix and a list of keys to use to transmit
     elements decoded using the decoders.
@@ -1212,12 +1817,15 @@ def _get_basic_region_arguments(neuron_slice, output_slice,
         region_arguments[r] = Args(neuron_slice)
 
     # Regions sliced by output
-    for r in (Regions.decoders, Regions.keys):
-        region_arguments[r] = Args(output_slice)
+    region_arguments[Regions.keys] = Args(output_slice)
+    region_arguments[Regions.transmit_threshold] = Args(output_slice)
+    region_arguments[Regions.learnt_keys] = Args(learnt_output_slice)
 
-    # Regions sliced by learnt output
-    for r in (Regions.learnt_decoders, Regions.learnt_keys):
-        region_arguments[r] = Args(learnt_output_slice)
+    # Decoders are sliced by output and by the neurons in the cluster
+    cluster_neurons = slice(cluster_slices[0].start, cluster_slices[-1].stop)
+    region_arguments[Regions.decoders] = Args(output_slice, cluster_neurons)
+    region_arguments[Regions.learnt_decoders] = Args(learnt_output_slice,
+                                                     cluster_neurons)
 
     # Population lengths
     pop_lengths = [p.stop - p.start for p in cluster_slices]
@@ -1239,28 +1847,39 @@ def iceil(val):
     return int(math.ceil(val))
 
 
-def get_input_filtering_cycles(size_in):
-    """Cycles required to perform filtering of received values."""
-    # Based on thesis profiling
-    return 39*size_in + 135
+def get_filter_order(filter_region):
+    """Get the sum of the orders of the filters in a region, filters without
+    an order are first order.
+    """
+    return sum(getattr(f, "order", 1) for f in filter_region.filters)
 
 
-def get_neuron_update_cycles(size_in, n_neurons_on_core):
-    """Cycles required to simulate neurons."""
-    # Based on thesis profiling
-    return 9*n_neurons_on_core*size_in + 61*n_neurons_on_core + 174
+def get_encoder_words(size_in, packed_encoders):
+    """Words of memory required to store the encoder of a single neuron."""
+    return iceil(size_in / 2.0) if packed_encoders else size_in
 
 
-def get_decode_and_transmit_cycles(n_neurons_in_cluster, size_out):
-    """Cycles required to decode spikes and transmit packets."""
-    # Based on thesis profiling
-    return 2*n_neurons_in_cluster*size_out + 143*size_out + 173
+def get_decoder_words(decoders, n_rows, n_neurons):
+    """Words of memory required to store a slice of the static decoders, the
+    decoders are stored densely if no region is given.
+    """
+    if decoders is None:
+        return n_rows * n_neurons
+    return decoders.estimate_words(n_rows, n_neurons)
 
 
 class ClusterResourceUsage(object):
-    def __init__(self, size_in, size_out, size_learnt_out, n_cores=16):
+    def __init__(self, size_in, size_out, size_learnt_out, n_cores=16,
+                 packed_encoders=False, decoders=None, n_activity_filters=0,
+                 cost_model=None, filter_order=1, n_routes=0):
         self.n_cores = n_cores
+        self.cost_model = CostModel() if cost_model is None else cost_model
+        self.filter_order = filter_order
+        self.n_routes = n_routes
+        self.n_activity_filters = n_activity_filters
         self.size_in = size_in
+        self.packed_encoders = packed_encoders
+        self.decoders = decoders
         self.size_out = size_out
         self.size_learnt_out = size_learnt_out
 
@@ -1282,17 +1901,16 @@ class ClusterResourceUsage(object):
         neurons_per_core = iceil(float(n_neurons) / self.fn_cores)
 
         # Compute the loading
-        # TODO Profile PES and Voja
-        return (
-            get_input_filtering_cycles(
-                self.size_in_per_core) +
-            get_neuron_update_cycles(
-                self.size_in, neurons_per_core) +
-            get_decode_and_transmit_cycles(
-                n_neurons, self.size_out_per_core) +
-            get_decode_and_transmit_cycles(
-                n_neurons, self.size_learnt_out_per_core)
-        )
+        return self.cost_model.core_cycles(CoreLoad(
+            size_in=self.size_in,
+            filtered_dims=self.size_in_per_core,
+            filter_order=self.filter_order,
+            n_routes=self.n_routes,
+            n_neurons=neurons_per_core,
+            n_neurons_in_cluster=n_neurons,
+            size_out=self.size_out_per_core,
+            size_learnt_out=self.size_learnt_out_per_core,
+        ))
 
     def dtcm_usage(self, neuron_slice):
         """Get the amount of memory required by the most heavily loaded core in
@@ -1303,18 +1921,43 @@ class ClusterResourceUsage(object):
         n_neurons = neuron_slice.stop - neuron_slice.start
         neurons_per_core = iceil(float(n_neurons) / self.fn_cores)
 
-        encoder_cost = neurons_per_core * self.size_in
-        decoder_cost = n_neurons * (self.size_out_per_core +
-                                    self.size_learnt_out_per_core)
+        encoder_cost = neurons_per_core * get_encoder_words(
+            self.size_in, self.packed_encoders)
+        decoder_cost = (
+            get_decoder_words(self.decoders, self.size_out_per_core,
+                              n_neurons) +
+            n_neurons * self.size_learnt_out_per_core
+        )
         neurons_cost = neurons_per_core * 3
 
-        return (encoder_cost + decoder_cost + neurons_cost) * 4
+        # Each core filters the activity of every neuron in the cluster
+        activity_cost = n_neurons * self.n_activity_filters
+
+        return (encoder_cost + decoder_cost + neurons_cost +
+                activity_cost) * 4
+
+    def min_dtcm_usage(self, neuron_slice):
+        """Get the amount of memory required by the most heavily loaded core in
+        a cluster if every region which may be is left in SDRAM.
+        """
+        n_neurons = neuron_slice.stop - neuron_slice.start
+        neurons_per_core = iceil(float(n_neurons) / self.fn_cores)
+        return (self.dtcm_usage(neuron_slice) -
+                neurons_per_core * SDRAM_RESIDENT_WORDS_PER_NEURON * 4)
 
 
 class CoreResouceUsage(object):
-    def __init__(self, size_in, n_neurons_in_cluster):
+    def __init__(self, size_in, n_neurons_in_cluster, packed_encoders=False,
+                 decoders=None, n_activity_filters=0, cost_model=None,
+                 filter_order=1, n_routes=0):
         self.size_in = size_in
+        self.cost_model = CostModel() if cost_model is None else cost_model
+        self.filter_order = filter_order
+        self.n_routes = n_routes
+        self.n_activity_filters = n_activity_filters
         self.n_neurons_in_cluster = n_neurons_in_cluster
+        self.packed_encoders = packed_encoders
+        self.decoders = decoders
 
     def cpu_usage(self, input_slice, neuron_slice,
                   output_slice, learnt_output_slice):
@@ -1325,15 +1968,16 @@ class CoreResouceUsage(object):
         size_learnt_out = learnt_output_slice.stop - learnt_output_slice.start
 
         # Compute the loading
-        # TODO Profile PES and Voja
-        return (
-            get_input_filtering_cycles(filtered_dims) +
-            get_neuron_update_cycles(self.size_in, n_neurons) +
-            get_decode_and_transmit_cycles(
-                self.n_neurons_in_cluster, size_out) +
-            get_decode_and_transmit_cycles(
-                self.n_neurons_in_cluster, size_learnt_out)
-        )
+        return self.cost_model.core_cycles(CoreLoad(
+            size_in=self.size_in,
+            filtered_dims=filtered_dims,
+            filter_order=self.filter_order,
+            n_routes=self.n_routes,
+            n_neurons=n_neurons,
+            n_neurons_in_cluster=self.n_neurons_in_cluster,
+            size_out=size_out,
+            size_learnt_out=size_learnt_out,
+        ))
 
     def dtcm_usage(self, input_slice, neuron_slice,
                    output_slice, learnt_output_slice):
@@ -1343,8 +1987,27 @@ class CoreResouceUsage(object):
         size_out = output_slice.stop - output_slice.start
         size_learnt_out = learnt_output_slice.stop - learnt_output_slice.start
 
-        encoder_cost = n_neurons * self.size_in
-        decoder_cost = self.n_neurons_in_cluster * (size_out + size_learnt_out)
+        encoder_cost = n_neurons * get_encoder_words(self.size_in,
+                                                     self.packed_encoders)
+        decoder_cost = (
+            get_decoder_words(self.decoders, size_out,
+                              self.n_neurons_in_cluster) +
+            self.n_neurons_in_cluster * size_learnt_out
+        )
         neurons_cost = n_neurons * 3
 
-        return (encoder_cost + decoder_cost + neurons_cost) * 4
+        # The activity of every neuron in the cluster is filtered
+        activity_cost = self.n_neurons_in_cluster * self.n_activity_filters
+
+        return (encoder_cost + decoder_cost + neurons_cost +
+                activity_cost) * 4
+
+    def min_dtcm_usage(self, input_slice, neuron_slice,
+                       output_slice, learnt_output_slice):
+        """Get the amount of memory required if every region which may be is
+        left in SDRAM.
+        """
+        n_neurons = neuron_slice.stop - neuron_slice.start
+        return (self.dtcm_usage(input_slice, neuron_slice, output_slice,
+                                learnt_output_slice) -
+                n_neurons * SDRAM_RESIDENT_WORDS_PER_NEURON * 4)
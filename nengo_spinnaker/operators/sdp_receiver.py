@@ -5,7 +5,10 @@ import struct
 from nengo_spinnaker.builder.ports import OutputPort
 from nengo_spinnaker.builder.netlist import netlistspec
 from nengo_spinnaker.netlist import Vertex
-from nengo_spinnaker.regions import KeyspacesRegion, KeyField, Region
+from nengo_spinnaker.regions import (KeyspacesRegion, KeyField, Region,
+                                     TransmitThresholdRegion,
+                                     get_transmit_refresh_period,
+                                     get_transmit_thresholds)
 from nengo_spinnaker.regions import utils as region_utils
 from nengo_spinnaker.utils.application import get_application
 
@@ -19,6 +22,7 @@ class SDPReceiver(object):
         self.connection_vertices = dict()
         self._sys_regions = dict()
         self._key_regions = dict()
+        self._threshold_regions = dict()
 
     def make_vertices(self, model, *args, **kwargs):
         """Create vertices that will simulate the SDPReceiver."""
@@ -34,24 +38,21 @@ class SDPReceiver(object):
             keys = [(signal, {"index": i}) for i in
                     range(transform.shape[0])]
 
-            # Create a vertex for this connection (assuming its size out <= 64)
-            if len(keys) > 64:
-                raise NotImplementedError(
-                    "Connection is too wide to transmit to SpiNNaker. "
-                    "Consider breaking the connection up or making the "
-                    "originating node a function of time Node."
-                )
-
-            # Create the regions for the system
+            # Create the regions for the system, vectors which are too large
+            # for a single SDP packet are sent as several packets.
             sys_region = SystemRegion(model.machine_timestep, len(keys))
             keys_region = KeyspacesRegion(keys,
                                           [KeyField({"cluster": "cluster"})])
+            threshold_region = TransmitThresholdRegion(
+                get_transmit_thresholds(keys),
+                get_transmit_refresh_period(model.transmit_refresh_time,
+                                            model.dt))
 
             # Get the resources
             resources = {
                 Cores: 1,
-                SDRAM: region_utils.sizeof_regions([sys_region, keys_region],
-                                                   None)
+                SDRAM: region_utils.sizeof_regions(
+                    [sys_region, keys_region, threshold_region], None)
             }
 
             # Create the vertex
@@ -59,6 +60,7 @@ class SDPReceiver(object):
                 Vertex(get_application("rx"), resources)
             self._sys_regions[v] = sys_region
             self._key_regions[v] = keys_region
+            self._threshold_regions[v] = threshold_region
 
         # Return the netlist specification
         return netlistspec(list(self.connection_vertices.values()),
@@ -68,15 +70,19 @@ class SDPReceiver(object):
         """Load data to the machine."""
         # Write each vertex region to memory
         for vx in six.itervalues(self.connection_vertices):
-            sys_mem, key_mem = region_utils.create_app_ptr_and_region_files(
-                netlist.vertices_memory[vx],
-                [self._sys_regions[vx], self._key_regions[vx]],
-                None
-            )
+            sys_mem, key_mem, threshold_mem = \
+                region_utils.create_app_ptr_and_region_files(
+                    netlist.vertices_memory[vx],
+                    [self._sys_regions[vx], self._key_regions[vx],
+                     self._threshold_regions[vx]],
+                    None
+                )
 
             self._sys_regions[vx].write_region_to_file(sys_mem)
             self._key_regions[vx].write_subregion_to_file(
                 key_mem, cluster=vx.cluster)
+            region_utils.write_region(threshold_mem,
+                                      self._threshold_regions[vx])
 
 
 class SystemRegion(Region):
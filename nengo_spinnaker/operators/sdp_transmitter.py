@@ -4,7 +4,8 @@ import struct
 from nengo_spinnaker.builder.ports import InputPort
 from nengo_spinnaker.builder.netlist import netlistspec
 from nengo_spinnaker.netlist import Vertex
-from nengo_spinnaker.regions import Region
+from nengo_spinnaker.regions import (Region, TickOverrunPolicy,
+                                     TickStatusRegion)
 from nengo_spinnaker.regions.filters import make_filter_regions
 from nengo_spinnaker.regions import utils as region_utils
 from nengo_spinnaker.utils.application import get_application
@@ -20,6 +21,8 @@ class SDPTransmitter(object):
         self._sys_region = None
         self._filter_region = None
         self._routing_region = None
+        self._tick_status_region = None
+        self._tick_status_mem = None
 
     def make_vertices(self, model, *args, **kwargs):
         """Create vertices that will simulate the SDPTransmitter."""
@@ -32,11 +35,16 @@ class SDPTransmitter(object):
         self._filter_region, self._routing_region = make_filter_regions(
             in_sigs, model.dt, True, model.keyspaces.filter_routing_tag)
 
+        # Build the region into which overrunning timesteps are reported
+        self._tick_status_region = TickStatusRegion(
+            TickOverrunPolicy[model.tick_overrun_policy])
+
         # Get the resources
         resources = {
             Cores: 1,
             SDRAM: region_utils.sizeof_regions(
-                [self._sys_region, self._filter_region, self._routing_region],
+                [self._sys_region, self._filter_region, self._routing_region,
+                 self._tick_status_region],
                 None
             )
         }
@@ -46,7 +54,8 @@ class SDPTransmitter(object):
 
         # Return the netlist specification
         return netlistspec((self._vertex, ),  # Tuple is required
-                           load_function=self.load_to_machine)
+                           load_function=self.load_to_machine,
+                           after_simulation_function=self.after_simulation)
 
     def get_signal_constraints(self):
         """Return a set of constraints on which signal parameters may share the
@@ -60,18 +69,28 @@ class SDPTransmitter(object):
         """
         return self._routing_region.get_signal_constraints()
 
+    def get_signal_targets(self):
+        """Return the filters targeted by each signal parameters.
+
+        Returns
+        -------
+        {id(SignalParameters): {target, ...}}
+        """
+        return self._routing_region.get_signal_targets()
+
     def load_to_machine(self, netlist, controller):
         """Load data to the machine."""
         # Prepare the filter routing region
         self._routing_region.build_routes(minimise=True)
 
         # Get the memory
-        sys_mem, filter_mem, routing_mem = \
+        sys_mem, filter_mem, routing_mem, self._tick_status_mem = \
             region_utils.create_app_ptr_and_region_files(
                 netlist.vertices_memory[self._vertex],
                 [self._sys_region,
                  self._filter_region,
-                 self._routing_region],
+                 self._routing_region,
+                 self._tick_status_region],
                 None
             )
 
@@ -79,6 +98,14 @@ class SDPTransmitter(object):
         self._sys_region.write_region_to_file(sys_mem)
         self._filter_region.write_subregion_to_file(filter_mem)
         self._routing_region.write_subregion_to_file(routing_mem)
+        self._tick_status_region.write_subregion_to_file(
+            self._tick_status_mem)
+
+    def after_simulation(self, netlist, simulator, n_steps):
+        """Retrieve the status of the timesteps from the simulation."""
+        self._tick_status_mem.seek(0)
+        simulator.tick_status[self._vertex] = \
+            self._tick_status_region.read_from_mem(self._tick_status_mem)
 
 
 class SystemRegion(Region):
@@ -2,12 +2,17 @@ import enum
 import numpy as np
 from rig.place_and_route import Cores, SDRAM
 import struct
+import threading
+import time
+import warnings
 
 from nengo_spinnaker.builder.ports import InputPort
 from nengo_spinnaker.builder.netlist import netlistspec
 from nengo_spinnaker import regions
 from nengo_spinnaker.regions.utils import Args, sizeof_regions_named
 from nengo_spinnaker.regions.filters import make_filter_regions
+from nengo_spinnaker.regions.recording import get_probe_window
+from nengo_spinnaker.utils.config import getconfig
 from nengo_spinnaker.netlist import Vertex
 from nengo_spinnaker.partition import divide_slice
 from nengo_spinnaker.utils.application import get_application
@@ -18,6 +23,7 @@ class Regions(enum.IntEnum):
     system = 1
     filters = 2
     filter_routing = 3
+    tick_status = 4
     recording = 15
 
 
@@ -33,7 +39,16 @@ class ValueSink(object):
         Number of packets to receive and store per timestep.
     sample_every : int
         Number of machine timesteps between taking samples.
+    window : (sample_every, start, stop)
+        Window of timesteps in which samples are taken on the machine.
+    ring_frames : int or None
+        If not None samples are recorded into a ring of this many frames
+        which is drained while the simulation is running, this allows
+        simulations longer than could be recorded in memory.
     """
+    # Seconds between draining the rings of samples during a simulation
+    drain_period = 0.05
+
     def __init__(self, probe, dt, max_width=16):
         self.probe = probe
         self.size_in = probe.size_in
@@ -44,6 +59,9 @@ class ValueSink(object):
             self.sample_every = 1
         else:
             self.sample_every = int(np.round(probe.sample_every / dt))
+        self.window = (self.sample_every, 0, None)
+        self.ring_frames = None
+        self._drain_thread = None
 
     def make_vertices(self, model, n_steps):  # TODO remove n_steps
         """Construct the data which can be loaded into the memory of a
@@ -56,20 +74,32 @@ class ValueSink(object):
             signals_conns, model.dt, True, model.keyspaces.filter_routing_tag)
         self._routing_region = filter_routing_region
 
+        # Get the window in which to sample and determine whether to record
+        # into a ring.
+        self.window = get_probe_window(self.probe, model.dt, model.config)
+        self.ring_frames = getconfig(model.config, self.probe,
+                                     "record_ring_frames")
+        if self.ring_frames is not None:
+            self.ring_frames = int(self.ring_frames)
+
         # Make sufficient vertices to ensure that each has a size_in of less
         # than max_width.
         n_vertices = (
             (self.size_in // self.max_width) +
             (1 if self.size_in % self.max_width else 0)
         )
+        tick_status_region = regions.TickStatusRegion(
+            regions.TickOverrunPolicy[model.tick_overrun_policy])
         self.vertices = tuple(
             ValueSinkVertex(model.machine_timestep, n_steps, sl, filter_region,
-                            filter_routing_region) for sl in
+                            filter_routing_region, self.window,
+                            self.ring_frames, tick_status_region) for sl in
             divide_slice(slice(0, self.size_in), n_vertices)
         )
 
         # Return the spec
         return netlistspec(self.vertices, self.load_to_machine,
+                           before_simulation_function=self.before_simulation,
                            after_simulation_function=self.after_simulation)
 
     def get_signal_constraints(self):
@@ -84,6 +114,15 @@ class ValueSink(object):
         """
         return self._routing_region.get_signal_constraints()
 
+    def get_signal_targets(self):
+        """Return the filters targeted by each signal parameters.
+
+        Returns
+        -------
+        {id(SignalParameters): {target, ...}}
+        """
+        return self._routing_region.get_signal_targets()
+
     def load_to_machine(self, netlist, controller):
         """Load the ensemble data into memory."""
         # Prepare the filter routing region
@@ -93,17 +132,61 @@ class ValueSink(object):
         for v in self.vertices:
             v.load_to_machine(netlist)
 
+    def before_simulation(self, netlist, simulator, n_steps):
+        """Prepare for a simulation, starting to drain the rings of samples if
+        they are in use.
+        """
+        if self.ring_frames is not None:
+            # Stop any thread left draining by a simulation which failed
+            self.close()
+
+            for v in self.vertices:
+                v.reset_recording()
+
+            self._drain_thread = RecordingDrainThread(self.vertices,
+                                                      self.drain_period)
+            self._drain_thread.start()
+
     def after_simulation(self, netlist, simulator, n_steps):
         """Retrieve data from a simulation."""
-        # Create an array into which to read probed values
-        data = np.zeros((n_steps, self.size_in), dtype=np.float)
+        # Create an array into which to read probed values, only the sampled
+        # timesteps were recorded.
+        n_samples = self.vertices[0].regions[
+            Regions.recording].get_n_samples(n_steps)
+        data = np.zeros((n_samples, self.size_in), dtype=np.float)
 
         # Read in the recorded results
+        if self.ring_frames is None:
+            for v in self.vertices:
+                data[:, v.input_slice] = v.read_recording(n_steps)
+        else:
+            # Stop draining the rings, drain any remaining samples and then
+            # place the samples which were received.
+            self.close()
+
+            n_overflows = 0
+            for v in self.vertices:
+                v.drain_recording()
+                for samples, values in v.ring_samples:
+                    data[samples, v.input_slice] = values
+                n_overflows = max(n_overflows, v.ring_overflows)
+
+            if n_overflows:
+                warnings.warn(
+                    "{} samples of {} were dropped because the recording ring "
+                    "was full, increase record_ring_frames.".format(
+                        n_overflows, self.probe)
+                )
+
+        # Retrieve the status of the timesteps of each core
         for v in self.vertices:
-            data[:, v.input_slice] = v.read_recording(n_steps)
+            simulator.tick_status[v] = v.get_tick_status()
 
-        # Apply the sampling
-        data = data[::self.sample_every]
+    def close(self):
+        """Stop draining the rings of samples, if this is being done."""
+        if self._drain_thread is not None:
+            self._drain_thread.stop()
+            self._drain_thread = None
 
         # Store the probe data in the simulator
         if self.probe in simulator.data:
@@ -114,16 +197,30 @@ class ValueSink(object):
 
 class ValueSinkVertex(Vertex):
     def __init__(self, timestep, n_steps, input_slice,
-                 filter_region, filter_routing_region):
+                 filter_region, filter_routing_region, window=(1, 0, None),
+                 ring_frames=None, tick_status_region=None):
         """Create a new vertex for a portion of a value sink."""
         self.input_slice = input_slice
 
+        # Samples drained from the ring, if it is used
+        self.ring_samples = list()
+        self.ring_overflows = 0
+
         # Store the pre-existing regions and create new regions
+        if ring_frames is None:
+            recording_region = regions.WordRecordingRegion(n_steps, *window)
+        else:
+            recording_region = regions.RingRecordingRegion(
+                n_steps, ring_frames, *window)
+
         self.regions = {
-            Regions.system: SystemRegion(timestep, input_slice),
+            Regions.system: SystemRegion(timestep, input_slice,
+                                         record_ring=ring_frames is not None),
             Regions.filters: filter_region,
             Regions.filter_routing: filter_routing_region,
-            Regions.recording: regions.WordRecordingRegion(n_steps),
+            Regions.recording: recording_region,
+            Regions.tick_status: (tick_status_region or
+                                  regions.TickStatusRegion()),
         }
 
         # Store region arguments
@@ -133,6 +230,7 @@ class ValueSinkVertex(Vertex):
             Regions.filters: Args(filter_width=w),
             Regions.filter_routing: Args(),
             Regions.recording: Args(input_slice),
+            Regions.tick_status: Args(),
         }
 
         # Determine resources usage
@@ -155,15 +253,9 @@ class ValueSinkVertex(Vertex):
                 self.region_arguments
             )
 
-        # Write the regions into memory
-        for key in Regions:
-            # Get the arguments
-            args, kwargs = self.region_arguments[key]
-
-            # Get the region
-            self.regions[key].write_subregion_to_file(
-                self.region_memory[key], *args, **kwargs
-            )
+        # Write each region into memory
+        regions.utils.write_regions_named(
+            self.region_memory, self.regions, self.region_arguments)
 
     def read_recording(self, n_steps):
         """Read back the recorded values."""
@@ -176,17 +268,77 @@ class ValueSinkVertex(Vertex):
             mem, self.input_slice, n_steps
         )
 
+    def get_tick_status(self):
+        """Retrieve the status of the timesteps from the simulation."""
+        mem = self.region_memory[Regions.tick_status]
+        mem.seek(0)
+        return self.regions[Regions.tick_status].read_from_mem(mem)
+
+    def reset_recording(self):
+        """Empty the ring of samples before a simulation."""
+        self.ring_samples = list()
+        self.ring_overflows = 0
+        self.regions[Regions.recording].reset(
+            self.region_memory[Regions.recording])
+
+    def drain_recording(self):
+        """Read the samples which have been written into the ring."""
+        samples, values, self.ring_overflows = \
+            self.regions[Regions.recording].drain(
+                self.region_memory[Regions.recording], self.input_slice
+            )
+        if len(samples):
+            self.ring_samples.append((samples, values))
+
 
 class SystemRegion(regions.Region):
     """System region for a value sink."""
-    def __init__(self, timestep, input_slice):
+    def __init__(self, timestep, input_slice, packet_queue_length=1024,
+                 record_ring=False):
         self.timestep = timestep
         self.input_slice = input_slice
+        self.packet_queue_length = packet_queue_length
+        self.record_ring = record_ring
 
     def sizeof(self, *args):
-        return 12  # 3 words
+        return 20  # 5 words
 
     def write_subregion_to_file(self, fp, *args):
         size_in = self.input_slice.stop - self.input_slice.start
-        fp.write(struct.pack("<3I", self.timestep,
-                             size_in, self.input_slice.start))
+        flags = 0x1 if self.record_ring else 0x0
+        fp.write(struct.pack("<5I", self.timestep,
+                             size_in, self.input_slice.start,
+                             self.packet_queue_length, flags))
+
+
+class RecordingDrainThread(threading.Thread):
+    """Thread which periodically drains the rings of samples of value sink
+    vertices while a simulation is running.
+
+    The thread is a daemon so that it never prevents the interpreter from
+    exiting.  Any error while draining the rings is reported as a warning and
+    stops the thread; samples which were not drained are dropped.
+    """
+    def __init__(self, vertices, period):
+        # Initialise the thread
+        super(RecordingDrainThread, self).__init__(name="RecordingDrain")
+        self.daemon = True
+
+        self.halt = False
+        self.vertices = vertices
+        self.period = period
+
+    def run(self):
+        try:
+            while not self.halt:
+                for v in self.vertices:
+                    v.drain_recording()
+                time.sleep(self.period)
+        except Exception as e:
+            warnings.warn(
+                "Stopped draining the recording rings: {!r}".format(e))
+
+    def stop(self):
+        """Stop the thread from running."""
+        self.halt = True
+        self.join()
@@ -15,6 +15,10 @@ from nengo_spinnaker import regions
 from nengo_spinnaker.utils.application import get_application
 from nengo_spinnaker.utils.type_casts import np_to_fix
 
+# Bytes of DTCM used for each of the two slots into which the values are read,
+# a slot holds a block of as many frames as fit.
+SLOT_BYTES = 20 * 1024
+
 
 class ValueSource(object):
     """Operator which transmits values from a buffer."""
@@ -29,13 +33,19 @@ class ValueSource(object):
         # Vertices
         self.system_region = None
         self.keys_region = None
+        self.transmit_schedule_region = None
         self.vertices = list()
 
     def make_vertices(self, model, n_steps):
         """Create the vertices to be simulated on the machine."""
+        # Only a single period of a periodic function need be stored
+        n_frames = n_steps
+        if self.period is not None:
+            n_frames = min(n_steps, int(np.ceil(self.period / model.dt)))
+
         # Create the system region
         self.system_region = SystemRegion(model.machine_timestep,
-                                          self.period is not None, n_steps)
+                                          self.period is not None, n_frames)
 
         # Get all the outgoing signals to determine how big the size out is and
         # to build a list of keys.
@@ -61,12 +71,15 @@ class ValueSource(object):
 
         # Create the output region
         self.output_region = regions.MatrixRegion(
-            np.zeros((n_steps, size_out)),
+            np.zeros((n_frames, size_out)),
             sliced_dimension=regions.MatrixPartitioning.columns
         )
 
+        # Create the region describing when values should be transmitted
+        self.transmit_schedule_region = regions.TransmitScheduleRegion()
+
         self.regions = [self.system_region, self.keys_region,
-                        self.output_region]
+                        self.output_region, self.transmit_schedule_region]
 
         # Partition by output dimension to create vertices
         transmit_constraint = partition.Constraint(10)
@@ -94,6 +107,10 @@ class ValueSource(object):
         # For each slice
         self.vertices_region_memory = collections.defaultdict(dict)
 
+        # The system and output regions are rewritten before every run, this
+        # records what they contain so that unchanged regions are skipped.
+        self._write_cache = regions.utils.RegionWriteCache()
+
         for vertex in self.vertices:
             # Layout the slice of SDRAM we have been given
             region_memory = regions.utils.create_app_ptr_and_region_files(
@@ -104,15 +121,26 @@ class ValueSource(object):
                 self.vertices_region_memory[vertex][region] = mem
 
             # Write in some of the regions
-            self.vertices_region_memory[vertex][self.system_region].seek(0)
-            self.system_region.write_subregion_to_file(
+            self._write_cache.write(
                 self.vertices_region_memory[vertex][self.system_region],
-                vertex.slice
+                self.system_region, vertex.slice
             )
             self.vertices_region_memory[vertex][self.keys_region].seek(0)
-            self.keys_region.write_subregion_to_file(
+            regions.utils.write_region(
                 self.vertices_region_memory[vertex][self.keys_region],
-                vertex.slice, cluster=vertex.cluster
+                self.keys_region, vertex.slice, cluster=vertex.cluster
+            )
+
+            # Transmission starts some time after the timer tick so that, for
+            # shorter simulations, the effect of clock drift is hidden.
+            schedule = regions.get_transmit_schedule(
+                netlist, vertex, vertex.slice.stop - vertex.slice.start,
+                self.system_region.timestep, min_offset=100
+            )
+            regions.utils.write_region(
+                self.vertices_region_memory[vertex][
+                    self.transmit_schedule_region],
+                self.transmit_schedule_region, vertex.slice, **schedule
             )
 
     def before_simulation(self, netlist, simulator, n_steps):
@@ -169,29 +197,29 @@ class ValueSource(object):
             sliced_dimension=regions.MatrixPartitioning.columns
         )
 
-        # Write the simulation values into memory
+        # Write the simulation values into memory, regions which are unchanged
+        # since the last run (e.g., the values of a periodic or constant
+        # function) are not written again.
+        self.system_region.n_steps = max_n
         for vertex in self.vertices:
-            self.vertices_region_memory[vertex][self.system_region].seek(0)
-            self.system_region.n_steps = max_n
-            self.system_region.write_subregion_to_file(
+            self._write_cache.write(
                 self.vertices_region_memory[vertex][self.system_region],
-                vertex.slice
+                self.system_region, vertex.slice
             )
-
-            self.vertices_region_memory[vertex][self.output_region].seek(0)
-            new_output_region.write_subregion_to_file(
+            self._write_cache.write(
                 self.vertices_region_memory[vertex][self.output_region],
-                vertex.slice
+                new_output_region, vertex.slice
             )
 
 
 class SystemRegion(regions.Region):
     """System region for a value source."""
-    def __init__(self, timestep, periodic, n_steps):
+    def __init__(self, timestep, periodic, n_steps, slot_bytes=SLOT_BYTES):
         # Store all the parameters
         self.timestep = timestep
         self.periodic = periodic
         self.n_steps = n_steps
+        self.slot_bytes = slot_bytes
 
     def sizeof(self, *args, **kwargs):
         return 4 * 6
@@ -199,9 +227,12 @@ class SystemRegion(regions.Region):
     def write_subregion_to_file(self, fp, vertex_slice, **kwargs):
         """Write the region to a file-like."""
         # Determine the size out, frames per block, number of blocks and last
-        # block length.
+        # block length.  The length of a block does not depend on the number
+        # of steps so that the core need not reallocate its slots between
+        # runs.
         size_out = vertex_slice.stop - vertex_slice.start
-        frames_per_block = int(math.floor(20 * 1024 / (size_out * 4.0)))
+        frames_per_block = max(
+            1, int(math.floor(self.slot_bytes / (size_out * 4.0))))
         n_blocks = int(math.floor(self.n_steps / frames_per_block))
         last_block_length = self.n_steps % frames_per_block
 
@@ -11,9 +11,15 @@ their data out to files as necessary.
 from .list import ListRegion
 from .matrix import MatrixPartitioning, MatrixRegion
 from .keyspaces import KeyspacesRegion, KeyField, MaskField
-from .profiler import Profiler
+from .profiler import Profiler, ProfilerCounters
 from .region import Region
 from .recording import (RecordingRegion, WordRecordingRegion,
                         SpikeRecordingRegion, VoltageRecordingRegion,
-                        EncoderRecordingRegion)
+                        EncoderRecordingRegion,
+                        CompressedSpikeRecordingRegion, RingRecordingRegion)
+from .tick_status import TickOverrunPolicy, TickStatusRegion
+from .transmit_schedule import TransmitScheduleRegion, get_transmit_schedule
+from .transmit_threshold import (TransmitThresholdRegion,
+                                 get_transmit_refresh_period,
+                                 get_transmit_thresholds)
 from . import utils
@@ -36,9 +36,14 @@ def add_filters(filters, signal_routes, specs,
             signal, reception_params, width=width
         )
 
-        # Store the filter and add the route
+        # Store the filter and add the route.  Latching filters hold the
+        # value last received rather than summing their input so they may
+        # only be shared by routes of the same signal, otherwise the values
+        # of different signals would replace each other.
         for index, g in enumerate(filters):
-            if f == g and minimise:
+            if f == g and minimise and (
+                    not f.latching or
+                    all(s is signal for s, i in signal_routes if i == index)):
                 break
         else:
             index = len(filters)
@@ -353,6 +358,25 @@ class FilterRoutingRegion(Region):
 
         return constraints
 
+    def get_signal_targets(self):
+        """Return the filters targeted by each signal without a keyspace.
+
+        Signals which target the same filters should be assigned routing
+        identifiers which differ in few bits so that their entries in this
+        region may be merged by minimisation.
+
+        Returns
+        -------
+        {id(SignalParameters): {target, ...}}
+            The indices of the filters targeted by each signal parameters.
+        """
+        targets = collections.defaultdict(set)
+        for signal, target in self.signal_routes:
+            if signal.keyspace is None:
+                targets[id(signal)].add(target)
+
+        return targets
+
     def get_expected_keys_and_masks(self):
         """Extract the set of keys and masks which are expected to match
         against the filter routing region.
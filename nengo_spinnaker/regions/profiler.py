@@ -92,3 +92,27 @@ class Profiler(Region):
                     tag_entry_times_ms, tag_durations_ms)
 
         return tag_dictionary
+
+
+class ProfilerCounters(Region):
+    """Region into which the always-available profiler counters are written.
+
+    Python representation of `profiler_counters_t`: the number of tag
+    counters, the greatest length of the packet queue and then counters
+    (count, min, max and the 64-bit sum of T2 cycles) for processing each
+    timestep and for each tag.  Overrunning timesteps are reported in the
+    :py:class:`~nengo_spinnaker.regions.TickStatusRegion`.
+    """
+    # Number of tag counters, must match `PROFILER_N_COUNTERS`
+    n_counters = 8
+
+    def sizeof(self, *args, **kwargs):
+        return 4 * (2 + 5 * (1 + self.n_counters))
+
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        # Zero the region so that counters which aren't written read as empty
+        fp.write(b"\x00" * self.sizeof())
+
+    def read_from_mem(self, mem):
+        """Read the raw counters from memory."""
+        return np.fromstring(mem.read(self.sizeof()), dtype=np.uint32)
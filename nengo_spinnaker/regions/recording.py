@@ -1,34 +1,144 @@
 from bitarray import bitarray
 import numpy as np
+import struct
+import warnings
 
 from rig.type_casts import NumpyFixToFloatConverter
 
 from .region import Region
+from nengo_spinnaker.utils.config import getconfig
 from nengo_spinnaker.utils.type_casts import fix_to_np
 
+try:
+    from math import gcd
+except ImportError:  # pragma: no cover
+    from fractions import gcd
+
+
+def get_probe_window(probe, dt, config=None):
+    """Get the window of timesteps in which a probe should record.
+
+    Parameters
+    ----------
+    probe : :py:class:`nengo.Probe`
+    dt : float
+        Simulation timestep (in seconds).
+    config : :py:class:`nengo.Config`, optional
+        Config from which to read the `record_start` and `record_stop` times
+        of the probe (in seconds).
+
+    Returns
+    -------
+    (sample_every, start, stop)
+        Timesteps between samples, the first timestep to sample and the
+        timestep at which sampling stops (None if sampling never stops).
+    """
+    sample_every = 1
+    if probe.sample_every is not None:
+        sample_every = max(1, int(np.round(probe.sample_every / dt)))
+
+    start = getconfig(config, probe, "record_start") if config else None
+    start = 0 if start is None else int(np.round(start / dt))
+
+    stop = getconfig(config, probe, "record_stop") if config else None
+    stop = None if stop is None else int(np.round(stop / dt))
+
+    return sample_every, start, stop
+
+
+def combine_windows(windows):
+    """Get a window which samples every timestep sampled by any of the given
+    windows.
+    """
+    windows = list(windows)
+    if not windows:
+        return 1, 0, None
+
+    start = min(w_start for _, w_start, _ in windows)
+    stop = (None if any(w_stop is None for _, _, w_stop in windows) else
+            max(w_stop for _, _, w_stop in windows))
+
+    # The sample period must divide the period and offset of every window
+    sample_every = 0
+    for w_sample_every, w_start, _ in windows:
+        sample_every = gcd(sample_every, w_sample_every)
+        sample_every = gcd(sample_every, w_start - start)
+
+    return sample_every, start, stop
+
+
+def get_window_slice(window, recorded_window):
+    """Get the slice of the samples recorded with one window which contain the
+    samples of another (which must have been combined into the former).
+    """
+    sample_every, start, stop = window
+    rec_sample_every, rec_start, _ = recorded_window
+
+    first = (start - rec_start) // rec_sample_every
+    step = sample_every // rec_sample_every
+    if stop is not None:
+        stop = -(-(stop - rec_start) // rec_sample_every)
+
+    return slice(first, stop, step)
+
 
 class RecordingRegion(Region):
-    def __init__(self, n_steps):
+    """Region used to record data.
+
+    The region starts with the window of timesteps in which to record (3
+    words: the timesteps between samples, the first timestep to sample and
+    the timestep at which sampling stops), followed by a frame for every
+    sampled timestep.
+
+    Parameters
+    ----------
+    n_steps : int
+        Number of simulation steps which will be run.
+    sample_every : int
+        Number of timesteps between samples.
+    start : int
+        First timestep to sample.
+    stop : int or None
+        Timestep at which sampling stops, None to sample until the end of the
+        simulation.
+    """
+    window_bytes = 12
+
+    def __init__(self, n_steps, sample_every=1, start=0, stop=None):
         self.n_steps = n_steps
+        self.sample_every = sample_every
+        self.start = start
+        self.stop = stop
+
+    def get_stop(self, n_steps):
+        """Get the timestep at which sampling stops."""
+        return n_steps if self.stop is None else min(self.stop, n_steps)
+
+    def get_n_samples(self, n_steps):
+        """Get the number of timesteps which will be sampled."""
+        n_sampled_steps = self.get_stop(n_steps) - self.start
+        return max(0, -(-n_sampled_steps // self.sample_every))
 
     def sizeof(self, vertex_slice):
         # Get the number of words per frame
         n_atoms = vertex_slice.stop - vertex_slice.start
-        return self.bytes_per_frame(n_atoms) * self.n_steps
+        return (self.window_bytes + self.bytes_per_frame(n_atoms) *
+                self.get_n_samples(self.n_steps))
 
     def _read(self, mem, vertex_slice, n_steps):
         """Read a suitable amount of data out of the memory view."""
-        mem.seek(0)
+        mem.seek(self.window_bytes)
 
         # Determine how many bytes to read, then read
         width = vertex_slice.stop - vertex_slice.start
         framelength = self.bytes_per_frame(width)
-        data = mem.read(n_steps * framelength)
+        data = mem.read(self.get_n_samples(n_steps) * framelength)
 
         return data, framelength, width
 
-    def write_subregion_to_file(self, *args, **kwargs):  # pragma: no cover
-        pass  # Nothing to do
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        fp.write(struct.pack("<3I", self.sample_every, self.start,
+                             self.get_stop(self.n_steps)))
 
 
 class WordRecordingRegion(RecordingRegion):
@@ -42,12 +152,101 @@ class WordRecordingRegion(RecordingRegion):
 
         # Convert the data into the correct format
         data = np.fromstring(data, dtype=np.int32)
-        data.shape = (n_steps, -1)
+        data.shape = (self.get_n_samples(n_steps), -1)
 
         # Recast back to float and return
         return fix_to_np(data)
 
 
+class RingRecordingRegion(WordRecordingRegion):
+    """Record 1 word per atom per sample into a ring which is drained by the
+    host while the simulation is running.
+
+    The window is followed by a header of 4 words: the number of frames in
+    the ring (written by the host), the number of frames written (written by
+    the executable), the number of frames read (written by the host) and the
+    number of frames dropped because the ring was full.  Each frame starts
+    with the index of the sample it contains.
+
+    Parameters
+    ----------
+    n_steps : int
+        Number of simulation steps which will be run.
+    n_frames : int
+        Number of frames in the ring.
+
+    The timesteps to sample are given as for :py:class:`RecordingRegion`.
+    """
+    header_bytes = 16
+
+    def __init__(self, n_steps, n_frames, *args, **kwargs):
+        super(RingRecordingRegion, self).__init__(n_steps, *args, **kwargs)
+        self.n_frames = n_frames
+
+    def bytes_per_frame(self, n_atoms):
+        return 4 * (1 + n_atoms)
+
+    def sizeof(self, vertex_slice):
+        n_atoms = vertex_slice.stop - vertex_slice.start
+        return (self.window_bytes + self.header_bytes +
+                self.bytes_per_frame(n_atoms) * self.n_frames)
+
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        super(RingRecordingRegion, self).write_subregion_to_file(fp)
+        self.reset(fp)
+
+    def reset(self, mem):
+        """Empty the ring, this must be done before each period of
+        simulation.
+        """
+        mem.seek(self.window_bytes)
+        mem.write(struct.pack("<4I", self.n_frames, 0, 0, 0))
+
+    def drain(self, mem, vertex_slice):
+        """Read the frames which have been written into the ring since it was
+        last drained, and mark them as read.
+
+        Returns
+        -------
+        samples : ndarray
+            Indices of the samples which were read.
+        data : ndarray
+            Array with a row of data for each sample.
+        n_overflows : int
+            Number of samples which have been dropped in this period of
+            simulation because the ring was full.
+        """
+        width = vertex_slice.stop - vertex_slice.start
+        framelength = self.bytes_per_frame(width)
+
+        # Read the header
+        mem.seek(self.window_bytes + 4)
+        n_written, n_read, n_overflows = struct.unpack("<3I", mem.read(12))
+
+        # Read the new frames, wrapping around the end of the ring
+        data = b""
+        frame = n_read % self.n_frames if self.n_frames else 0
+        n_unread = (n_written - n_read) & 0xffffffff
+        while n_unread:
+            n_frames = min(n_unread, self.n_frames - frame)
+            mem.seek(self.window_bytes + self.header_bytes +
+                     frame * framelength)
+            data += mem.read(n_frames * framelength)
+
+            frame = 0
+            n_unread -= n_frames
+
+        # Mark the frames as read
+        mem.seek(self.window_bytes + 8)
+        mem.write(struct.pack("<I", n_written))
+
+        # Split the frames into the sample indices and the data
+        frames = np.fromstring(data, dtype=np.int32)
+        frames.shape = (-1, 1 + width)
+        return frames[:, 0].astype(np.uint32), fix_to_np(frames[:, 1:]), \
+            n_overflows
+
+
 class SpikeRecordingRegion(RecordingRegion):
     """Region used to record spikes.
 
@@ -71,7 +270,7 @@ class SpikeRecordingRegion(RecordingRegion):
 
         # Break this into timesteps
         steps = [spikes[i * framelength * 8:(i+1) * framelength * 8] for
-                 i in range(n_steps)]
+                 i in range(self.get_n_samples(n_steps))]
 
         # Convert this into a NumPy array
         array = np.array(
@@ -81,6 +280,107 @@ class SpikeRecordingRegion(RecordingRegion):
         return array
 
 
+class CompressedSpikeRecordingRegion(SpikeRecordingRegion):
+    """Region used to record spikes where few neurons are expected to spike in
+    each timestep.
+
+    The window is followed by a header of 3 words: the number of words
+    available for frames, the number of words of frames which were written
+    and the number of frames which were dropped because the region was full.
+    Each frame starts with a word which is either `FRAME_BITMAP`, in which
+    case the spike bitmap follows, or the number of 16-bit neuron indices
+    (padded to a whole number of words) which follow.
+    Once a frame has been dropped every later frame is also dropped, so the
+    frames which were written are those of the first samples.
+
+    Parameters
+    ----------
+    n_steps : int
+        Number of simulation steps to record.
+    expected_rate : float
+        Expected mean firing rate of the neurons (in Hz), used to determine
+        how much memory should be allocated to the region.
+    dt : float
+        Simulation timestep (in seconds).
+
+    The timesteps to sample are given as for :py:class:`RecordingRegion`.
+    """
+    FRAME_BITMAP = 1 << 31
+
+    # Factor by which the number of spikes expected in each frame is increased
+    # to leave room for bursts of activity.
+    headroom = 2.0
+
+    def __init__(self, n_steps, expected_rate, dt, *args, **kwargs):
+        super(CompressedSpikeRecordingRegion, self).__init__(n_steps, *args,
+                                                             **kwargs)
+        self.expected_rate = expected_rate
+        self.dt = dt
+
+    def capacity_words(self, n_neurons):
+        """Get the number of words of frames the region may contain."""
+        bitmap_words = self.bytes_per_frame(n_neurons) // 4
+        spikes_per_frame = (self.headroom * self.expected_rate * self.dt *
+                            n_neurons)
+        index_words = int(np.ceil(spikes_per_frame / 2.0))
+        n_samples = self.get_n_samples(self.n_steps)
+        return n_samples * (1 + min(bitmap_words, index_words))
+
+    def sizeof(self, vertex_slice):
+        n_neurons = vertex_slice.stop - vertex_slice.start
+        return self.window_bytes + 4 * (3 + self.capacity_words(n_neurons))
+
+    def write_subregion_to_file(self, fp, vertex_slice):
+        super(CompressedSpikeRecordingRegion, self).write_subregion_to_file(
+            fp, vertex_slice)
+
+        n_neurons = vertex_slice.stop - vertex_slice.start
+        fp.write(struct.pack("<3I", self.capacity_words(n_neurons), 0, 0))
+
+    def to_array(self, mem, vertex_slice, n_steps):
+        """Read the memory and return an appropriately formatted array of the
+        results.
+        """
+        n_neurons = vertex_slice.stop - vertex_slice.start
+        bitmap_words = self.bytes_per_frame(n_neurons) // 4
+
+        # Read the header and then the frames
+        mem.seek(self.window_bytes)
+        _, n_words, n_dropped = struct.unpack("<3I", mem.read(12))
+        data = np.fromstring(mem.read(4 * n_words), dtype=np.uint32)
+
+        # Decode each frame which was written, the frames of the final samples
+        # were dropped.
+        n_samples = self.get_n_samples(n_steps)
+        n_written = max(n_samples - n_dropped, 0)
+        array = np.zeros((n_samples, n_neurons), dtype=np.bool)
+        pos = 0
+        for step in range(n_written):
+            if pos >= len(data):
+                break  # The region is incomplete
+
+            header = data[pos]
+            if header == self.FRAME_BITMAP:
+                spikes = bitarray(endian="little")
+                spikes.frombytes(data[pos+1:pos+1+bitmap_words].tostring())
+                array[step] = spikes.tolist()[:n_neurons]
+                pos += 1 + bitmap_words
+            else:
+                n_index_words = (header + 1) // 2
+                indices = data[pos+1:pos+1+n_index_words].view(np.uint16)
+                array[step, indices[:header]] = True
+                pos += 1 + n_index_words
+
+        if n_dropped:
+            warnings.warn(
+                "{} frames of spikes (from sample {}) were dropped because "
+                "the recording region was full, increase "
+                "spike_recording_rate.".format(n_dropped, n_written)
+            )
+
+        return array
+
+
 class VoltageRecordingRegion(RecordingRegion):
     """Region used to record neuron input voltages.
 
@@ -97,7 +397,7 @@ class VoltageRecordingRegion(RecordingRegion):
 
         # Convert the data into the correct format
         data = np.fromstring(data, dtype=np.uint16)
-        data.shape = (n_steps, -1)
+        data.shape = (self.get_n_samples(n_steps), -1)
 
         # Recast back to float
         data_fp = NumpyFixToFloatConverter(15)(data[:, 0:n_neurons])
@@ -106,9 +406,9 @@ class VoltageRecordingRegion(RecordingRegion):
 
 class EncoderRecordingRegion(RecordingRegion):
     """Region used to record learnt encoders."""
-    def __init__(self, n_steps, n_dimensions):
+    def __init__(self, n_steps, n_dimensions, *args, **kwargs):
         # Superclass
-        super(EncoderRecordingRegion, self).__init__(n_steps)
+        super(EncoderRecordingRegion, self).__init__(n_steps, *args, **kwargs)
 
         self.n_dimensions = n_dimensions
 
@@ -130,7 +430,7 @@ class EncoderRecordingRegion(RecordingRegion):
         slice_encoders = np.reshape(
             slice_encoders,
             (
-                n_steps,
+                self.get_n_samples(n_steps),
                 n_neurons,
                 self.n_dimensions
             )
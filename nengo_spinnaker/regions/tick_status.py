@@ -0,0 +1,53 @@
+import enum
+import numpy as np
+
+from .profiler import MS_SCALE
+from .region import Region
+
+
+class TickOverrunPolicy(enum.IntEnum):
+    """Policies applied when a timestep starts before the previous timestep
+    has completed, these must match `tick_policy_t`.
+    """
+    count = 0  # Only count the overrunning timesteps
+    drop = 1  # Drop timesteps until the executable has caught up
+    abort = 2  # Abort the simulation
+
+
+class TickStatusRegion(Region):
+    """Region into which executables write the number of timesteps which
+    overran.
+
+    Python representation of `tick_status_region_t`: the policy to apply when
+    a timestep overruns, the number of timesteps started, the number which
+    overran, the greatest number of CPU cycles by which a timestep overran and
+    the number of timesteps dropped.
+    """
+    def __init__(self, policy=TickOverrunPolicy.count):
+        self.policy = TickOverrunPolicy(policy)
+
+    def sizeof(self, *args, **kwargs):
+        return 20  # 5 words
+
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        data = np.array([self.policy, 0, 0, 0, 0], dtype=np.uint32)
+        fp.write(data.tostring())
+
+    def read_from_mem(self, mem):
+        """Read the status of the timesteps from memory.
+
+        Returns
+        -------
+        dict
+            The number of "ticks", "overruns" and "dropped" timesteps and the
+            "max lateness" (in ms) of any overrunning timestep.
+        """
+        _, n_ticks, n_overruns, max_lateness, n_dropped = \
+            np.fromstring(mem.read(self.sizeof()), dtype=np.uint32)
+
+        return {
+            "ticks": int(n_ticks),
+            "overruns": int(n_overruns),
+            "max lateness": float(max_lateness) * MS_SCALE,
+            "dropped": int(n_dropped),
+        }
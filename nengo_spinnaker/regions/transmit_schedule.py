@@ -0,0 +1,76 @@
+from rig.place_and_route import Cores
+import struct
+
+from .region import Region
+
+# Packets the router of a chip is expected to handle every microsecond
+# without the cores to which they are delivered dropping any.
+ROUTER_PACKETS_PER_US = 1.0
+
+
+class TransmitScheduleRegion(Region):
+    """Region describing when a core may transmit multicast packets.
+
+    Python representation of `transmit_schedule_t`: the offset (in
+    microseconds) from the start of each timestep before which no packets are
+    sent, the length of a slot (in microseconds) and the number of packets
+    which may be sent in each slot (0 indicates that transmission is not
+    paced).  The schedule depends on where the core is placed so it is given
+    when the region is written, see :py:func:`get_transmit_schedule`.
+    """
+    def sizeof(self, *args, **kwargs):
+        return 12  # 3 words
+
+    def write_subregion_to_file(self, fp, vertex_slice=None, offset=0, slot=0,
+                                packets_per_slot=0, **kwargs):
+        fp.write(struct.pack("<3I", offset, slot, packets_per_slot))
+
+
+def get_transmit_schedule(netlist, vertex, n_packets, machine_timestep,
+                          stagger=5, min_offset=0, slot=10):
+    """Get the schedule with which a vertex should transmit packets.
+
+    The first transmission of each core is offset by `stagger` microseconds
+    for every core which precedes it on its chip, and further for chips
+    neighbouring each other.  If the router of the chip is expected to be
+    congested then the packets are paced so that the vertex transmits its
+    proportion of the packets the router can handle.  Packets are never paced
+    so slowly that they would not be sent within the first half of the
+    timestep.
+
+    Parameters
+    ----------
+    netlist : :py:class:`~nengo_spinnaker.netlist.Netlist`
+        Placed and routed netlist containing the vertex.
+    vertex :
+        Vertex for which to build the schedule.
+    n_packets : int
+        Number of packets the vertex transmits every timestep.
+    machine_timestep : int
+        Length of the timestep in microseconds.
+
+    Returns
+    -------
+    dict
+        Keyword arguments for
+        :py:meth:`TransmitScheduleRegion.write_subregion_to_file`.
+    """
+    x, y = netlist.placements[vertex]
+    core = netlist.allocations[vertex][Cores].start
+    offset = min_offset + stagger * ((core - 1) + (y & 1) + ((x & 1) << 1))
+
+    # Determine how many slots the packets may be spread over and how many
+    # packets the router can handle in each slot.
+    n_slots = max(1, (machine_timestep // 2 - offset) // slot)
+    router_packets = max(1, int(ROUTER_PACKETS_PER_US * slot))
+    load = max(n_packets, netlist.router_loads.get((x, y), 0))
+
+    # The vertex is given its share of the router, but must be able to send
+    # all of its packets in the available slots.
+    packets_per_slot = max(router_packets * n_packets // max(load, 1),
+                           -(-n_packets // n_slots), 1)
+    if packets_per_slot >= n_packets:
+        packets_per_slot = 0  # No pacing is necessary
+
+    return {"offset": offset, "slot": slot,
+            "packets_per_slot": packets_per_slot}
@@ -0,0 +1,84 @@
+import struct
+
+from .region import Region
+from nengo_spinnaker.utils import type_casts as tp
+
+
+class TransmitThresholdRegion(Region):
+    """Region describing which changes in transmitted values are too small to
+    be sent.
+
+    Python representation of `delta_transmit_region_t`: the number of values
+    described by the region (0 if every value is always sent), the number of
+    timesteps after which every value is sent regardless of whether it changed
+    (0 if values are never sent again unless they change) and an S16.15
+    threshold for each value.  A value is only sent if it differs from the
+    value last sent by more than its threshold, negative thresholds are
+    written for values which should always be sent.
+
+    Parameters
+    ----------
+    thresholds : [float or None, ...]
+        Threshold for each value, or None if the value should always be sent.
+    refresh_period : int
+        Number of timesteps after which every value is sent again, even if it
+        has not changed, so that values lost in the network are eventually
+        replaced.  0 if values are only sent when they change.
+    """
+    def __init__(self, thresholds, refresh_period=0):
+        self.thresholds = list(thresholds)
+        self.refresh_period = refresh_period
+
+    def _get_thresholds(self, vertex_slice):
+        """Get the thresholds for the slice, or an empty list if every value
+        in the slice is always sent.
+        """
+        thresholds = self.thresholds[vertex_slice]
+        if all(t is None for t in thresholds):
+            return list()
+        return thresholds
+
+    def sizeof(self, vertex_slice=slice(None), **kwargs):
+        if vertex_slice is None:
+            vertex_slice = slice(None)
+        return 4 * (2 + len(self._get_thresholds(vertex_slice)))
+
+    def write_subregion_to_file(self, fp, vertex_slice=slice(None),
+                                **kwargs):
+        if vertex_slice is None:
+            vertex_slice = slice(None)
+        thresholds = self._get_thresholds(vertex_slice)
+
+        fp.write(struct.pack("<2I", len(thresholds), self.refresh_period))
+        fp.write(struct.pack(
+            "<{}i".format(len(thresholds)),
+            *(-1 if t is None else tp.value_to_fix(t) for t in thresholds)
+        ))
+
+
+def get_transmit_thresholds(keys):
+    """Get the threshold for each value transmitted with the given keys.
+
+    Parameters
+    ----------
+    keys : [(:py:class:`~nengo_spinnaker.builder.model.SignalParameters`, \
+            {field: value, ...}), ...]
+        Signal and fields of the key used to transmit each value.
+    """
+    return [signal.threshold for signal, _ in keys]
+
+
+def get_transmit_refresh_period(refresh_time, dt):
+    """Get the number of timesteps after which every value is sent again.
+
+    Parameters
+    ----------
+    refresh_time : float or None
+        Simulation time (in seconds) after which every value is sent again, or
+        None if values should only be sent when they change.
+    dt : float
+        Simulation timestep.
+    """
+    if refresh_time is None:
+        return 0
+    return max(int(round(refresh_time / dt)), 1)
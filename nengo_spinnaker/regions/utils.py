@@ -1,6 +1,8 @@
 """Region utilities.
 """
 import collections
+import hashlib
+import io
 from six import iteritems, iterkeys
 import struct
 
@@ -86,6 +88,95 @@ def create_app_ptr_and_region_files(fp, regions, vertex_slice):
     return filelikes
 
 
+def write_region(fp, region, *args, **kwargs):
+    """Write a region (or a slice of a region) into a file-like view of memory
+    with a single write.
+
+    Regions are typically written as many small pieces; rendering them into a
+    local buffer first means that the data is sent to the machine as one large
+    (burst) write rather than as many small ones.
+
+    Returns
+    -------
+    bytes
+        The data that was written.
+    """
+    buf = io.BytesIO()
+    region.write_subregion_to_file(buf, *args, **kwargs)
+    data = buf.getvalue()
+
+    fp.write(data)
+    return data
+
+
+def write_regions_named(region_memory, regions, region_args, cache=None):
+    """Write each region into its file-like view of memory.
+
+    Parameters
+    ----------
+    region_memory : {name: file-like}
+        Map from keys to file-like views of memory, as returned by
+        :py:func:`create_app_ptr_and_region_files_named`.
+    regions : {name: Region, ...}
+        Map from keys to region objects.
+    region_args : {name: (*args, **kwargs)}
+        Map from keys to the arguments and keyword-arguments that should be
+        used when writing a region.
+    cache : :py:class:`RegionWriteCache` or None
+        If given, regions whose data is unchanged since it was last written
+        into the same view of memory are not written again.
+    """
+    for key, region in iteritems(regions):
+        args, kwargs = region_args[key]
+        if cache is None:
+            write_region(region_memory[key], region, *args, **kwargs)
+        else:
+            cache.write(region_memory[key], region, *args, **kwargs)
+
+
+class RegionWriteCache(object):
+    """Record a digest of the data written into views of memory so that
+    regions which have not changed need not be written again.
+
+    Writes are always made from the start of the view of memory, so a cache
+    should only be used for views of memory which hold a single region.
+    """
+    def __init__(self):
+        self._digests = dict()
+
+    def write(self, fp, region, *args, **kwargs):
+        """Write a region into a file-like view of memory unless exactly the
+        same data was last written into it.
+
+        Returns
+        -------
+        bool
+            True if the region was written, False if it was unchanged.
+        """
+        buf = io.BytesIO()
+        region.write_subregion_to_file(buf, *args, **kwargs)
+        data = buf.getvalue()
+
+        # Skip the write if the memory already contains this data
+        digest = hashlib.sha1(data).digest()
+        if self._digests.get(fp) == digest:
+            return False
+
+        fp.seek(0)
+        fp.write(data)
+        self._digests[fp] = digest
+        return True
+
+    def invalidate(self, fp=None):
+        """Forget the data written into a view of memory (or into all views
+        of memory) so that it is written again.
+        """
+        if fp is None:
+            self._digests.clear()
+        else:
+            self._digests.pop(fp, None)
+
+
 def sizeof_regions_named(regions, region_args, include_app_ptr=True):
     """Return the total amount of memory required to represent all regions when
     padded to a whole number of words each.
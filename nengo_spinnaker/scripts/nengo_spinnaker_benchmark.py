@@ -0,0 +1,88 @@
+"""A script which benchmarks the kernels of the nengo_spinnaker executables on
+a SpiNNaker machine and prints a table of the cycles they take.
+"""
+
+import argparse
+
+from rig.machine_control import MachineController
+
+from nengo_spinnaker.rc import rc
+from nengo_spinnaker.utils import benchmark
+from nengo_spinnaker.utils.cost_model import CostModel
+
+
+# Sizes and parameters with which each kernel is benchmarked by default
+DEFAULT_SIZES = {
+    benchmark.Kernels.dot_product: ([1, 2, 4, 8, 16, 32, 64], [0]),
+    benchmark.Kernels.lti_filter_step: ([1, 4, 16, 64], [1, 2, 3, 4]),
+    benchmark.Kernels.decode_spike_train: ([32, 128, 512], [0, 10, 1]),
+    benchmark.Kernels.neuron_update: ([32, 128, 512], [0]),
+    benchmark.Kernels.input_filtering_input: ([1, 4, 16, 64], [1, 16]),
+}
+
+
+def get_cases(kernels, sizes=None, params=None, n_repeats=100):
+    """Get the cases with which to benchmark the given kernels, sizes and
+    parameters not given are taken from `DEFAULT_SIZES`.
+    """
+    cases = list()
+    for kernel in kernels:
+        default_sizes, default_params = DEFAULT_SIZES[kernel]
+        for size in (sizes or default_sizes):
+            for param in (params or default_params):
+                cases.append(benchmark.BenchmarkCase(kernel, size, param,
+                                                     n_repeats))
+    return cases
+
+
+def main(args=None):
+    parser = argparse.ArgumentParser(
+        description="Benchmark the kernels used by nengo_spinnaker "
+                    "executables.")
+    parser.add_argument("hostname", nargs="?", default=None,
+                        help="Hostname of the SpiNNaker machine (default: "
+                             "the hostname in the config file).")
+    parser.add_argument("--kernel", "-k", action="append",
+                        choices=[k.name for k in benchmark.Kernels],
+                        help="Kernel to benchmark (default: all kernels), "
+                             "may be given several times.")
+    parser.add_argument("--size", "-s", type=int, action="append",
+                        help="Size with which to benchmark the kernels, may "
+                             "be given several times.")
+    parser.add_argument("--param", "-p", type=int, action="append",
+                        help="Parameter with which to benchmark the kernels, "
+                             "may be given several times.")
+    parser.add_argument("--repeats", "-r", type=int, default=100,
+                        help="Number of times to time each case.")
+    parser.add_argument("--chip", type=int, nargs=2, default=(0, 0),
+                        metavar=("X", "Y"),
+                        help="Chip on which to run the benchmarks.")
+    parser.add_argument("--fit", metavar="FILE",
+                        help="Fit a cost model to the results and write it "
+                             "to FILE, see CostModel.load.")
+
+    args = parser.parse_args(args)
+
+    kernels = ([benchmark.Kernels[k] for k in args.kernel] if args.kernel
+               else list(benchmark.Kernels))
+    cases = get_cases(kernels, args.size, args.param, args.repeats)
+
+    hostname = args.hostname or rc.get("spinnaker_machine", "hostname")
+    controller = MachineController(hostname)
+    controller.boot()
+
+    x, y = args.chip
+    results = benchmark.run_benchmarks(controller, cases, x, y)
+    cpu_clock_mhz = controller.read_struct_field("sv", "cpu_clk", x, y)
+
+    print(benchmark.format_table(cases, results, cpu_clock_mhz))
+
+    if args.fit:
+        with open(args.fit, "w") as fp:
+            CostModel.from_benchmarks(cases, results).save(fp)
+    return 0
+
+
+if __name__ == "__main__":  # pragma: no cover
+    import sys
+    sys.exit(main())
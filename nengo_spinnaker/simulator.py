@@ -1,4 +1,5 @@
 import atexit
+import itertools
 import logging
 import nengo
 from nengo.cache import get_default_decoder_cache
@@ -11,9 +12,12 @@ import six
 import time
 
 from .builder import Model
+from .netlist.key_allocation import NetIdCache
+from .netlist.routing import route_in_parallel
 from .node_io import Ethernet
 from .rc import rc
 from .utils.config import getconfig
+from .utils.paths import net_id_cache_dir
 
 logger = logging.getLogger(__name__)
 
@@ -109,6 +113,16 @@ class Simulator(object):
         start_build = time.time()
         self.model = Model(dt=dt, machine_timestep=machine_timestep,
                            decoder_cache=get_default_decoder_cache())
+        self.model.tick_overrun_policy = getconfig(
+            network.config, Simulator, "tick_overrun_policy", "count")
+        self.model.cpu_target = getconfig(
+            network.config, Simulator, "cpu_target", self.model.cpu_target)
+        self.model.transmit_refresh_time = getconfig(
+            network.config, Simulator, "transmit_refresh_time",
+            self.model.transmit_refresh_time)
+        cost_model = getconfig(network.config, Simulator, "cost_model")
+        if cost_model is not None:
+            self.model.cost_model = cost_model
         self.model.build(network, **builder_kwargs)
 
         logger.info("Build took {:.3f} seconds".format(time.time() -
@@ -126,6 +140,12 @@ class Simulator(object):
         # Holder for profiling data
         self.profiler_data = {}
 
+        # Holder for the profiler counters, which are always available
+        self.profiler_counters = {}
+
+        # Holder for the number of timesteps which overran on each core
+        self.tick_status = {}
+
         # Convert the model into a netlist
         logger.info("Building netlist")
         start = time.time()
@@ -181,14 +201,33 @@ class Simulator(object):
         logger.info("Getting SpiNNaker machine specification")
         system_info = self.controller.get_system_info()
 
-        # Place & Route
+        # Place & Route, routing using several processes and reusing the
+        # identifiers assigned to nets in previous builds when possible.
         logger.info("Placing and routing")
+        route_kwargs = dict(getconfig(network.config, Simulator,
+                                      'router_kwargs', {}))
+        route_kwargs["route"] = getconfig(network.config, Simulator,
+                                          'router', rig.place_and_route.route)
+        route_kwargs["n_processes"] = getconfig(network.config, Simulator,
+                                                'router_processes', None)
+
+        cache_dir = getconfig(network.config, Simulator, 'net_id_cache_dir',
+                              net_id_cache_dir)
+        net_id_cache = None if cache_dir is None else NetIdCache(cache_dir)
+
         self.netlist.place_and_route(
             system_info,
             place=getconfig(network.config, Simulator,
                             'placer', rig.place_and_route.place),
             place_kwargs=getconfig(network.config, Simulator,
                                    'placer_kwargs', {}),
+            allocate=getconfig(network.config, Simulator,
+                               'allocator', rig.place_and_route.allocate),
+            allocate_kwargs=getconfig(network.config, Simulator,
+                                      'allocator_kwargs', {}),
+            route=route_in_parallel,
+            route_kwargs=route_kwargs,
+            net_id_cache=net_id_cache,
         )
 
         logger.info("{} cores in use".format(len(self.netlist.placements)))
@@ -321,6 +360,17 @@ class Simulator(object):
             time.time() - start
         ))
 
+        # Report any timesteps which overran
+        n_overruns = sum(status["overruns"] for status in
+                         self.tick_status.values())
+        if n_overruns:
+            logger.warning(
+                "{} timesteps overran on {} cores, see "
+                "Simulator.tick_status".format(
+                    n_overruns, sum(1 for status in self.tick_status.values()
+                                    if status["overruns"]))
+            )
+
         # Increase the steps count
         self.steps += steps
 
@@ -393,6 +443,13 @@ class Simulator(object):
             # Stop the application
             self._closed = True
             self.io_controller.close()
+
+            # Stop any threads the operators may have left running
+            for op in itertools.chain(
+                    six.itervalues(self.model.object_operators),
+                    self.model.extra_operators):
+                if hasattr(op, "close"):
+                    op.close()
             self.controller.send_signal("stop")
 
             # Destroy the job if we allocated one
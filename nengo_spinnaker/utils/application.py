@@ -1,6 +1,92 @@
+import glob
+import hashlib
+import os
 import pkg_resources
 
+# File, stored alongside the executables, which contains the digest of the
+# sources from which they were built.  It is written by
+# `spinnaker_components/Makefile`.
+SOURCES_DIGEST_FILENAME = "sources.sha1"
+
+
+class ApplicationError(Exception):
+    """Raised when an executable is missing or out of date."""
+
 
 def get_application(app_name):
     app_name = "binaries/nengo_{}.aplx".format(app_name)
     return pkg_resources.resource_filename("nengo_spinnaker", app_name)
+
+
+def get_sources_dir():
+    """Get the directory containing the sources of the executables, or None if
+    they are not available (e.g., the package is not installed from a
+    checkout of the repository).
+    """
+    package_dir = pkg_resources.resource_filename("nengo_spinnaker", "")
+    sources_dir = os.path.join(os.path.dirname(os.path.normpath(package_dir)),
+                               "spinnaker_components")
+    return sources_dir if os.path.isdir(sources_dir) else None
+
+
+def get_sources_digest(sources_dir):
+    """Get the SHA-1 digest of the C sources and headers of the executables.
+
+    The digest is that of the concatenation of the files in the order of their
+    paths (relative to `sources_dir`), it is the same as that written by
+    `spinnaker_components/Makefile`.
+    """
+    paths = sorted(
+        os.path.relpath(path, sources_dir).replace(os.sep, "/")
+        for pattern in ("*/*.c", "*/*.h")
+        for path in glob.glob(os.path.join(sources_dir, pattern))
+    )
+
+    digest = hashlib.sha1()
+    for path in paths:
+        with open(os.path.join(sources_dir, path), "rb") as f:
+            digest.update(f.read())
+    return digest.hexdigest()
+
+
+def check_application(filename, sources_dir=None):
+    """Check that an executable exists and, if the sources of the executables
+    are available, that it was built from them.
+
+    Parameters
+    ----------
+    filename : str
+        Path of the executable.
+    sources_dir : str or None
+        Directory containing the sources of the executables, if None then
+        :py:func:`get_sources_dir` is used.
+
+    Raises
+    ------
+    ApplicationError
+        If the executable does not exist or was built from other sources.
+    """
+    rebuild = "build the executables with `make -C spinnaker_components`"
+
+    if not os.path.isfile(filename):
+        raise ApplicationError(
+            "The executable {} does not exist, {}.".format(filename, rebuild))
+
+    if sources_dir is None:
+        sources_dir = get_sources_dir()
+        if sources_dir is None:
+            return  # No sources to compare against
+
+    # Read the digest of the sources from which the executable was built
+    digest_path = os.path.join(os.path.dirname(filename),
+                               SOURCES_DIGEST_FILENAME)
+    try:
+        with open(digest_path) as f:
+            built_digest = f.read().split()[0]
+    except (IOError, IndexError):
+        built_digest = None
+
+    if built_digest != get_sources_digest(sources_dir):
+        raise ApplicationError(
+            "The executable {} is out of date with the sources in {}, "
+            "{}.".format(filename, sources_dir, rebuild))
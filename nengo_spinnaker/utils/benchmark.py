@@ -0,0 +1,240 @@
+"""Benchmarking of the kernels used by the nengo_spinnaker executables.
+
+Each :py:class:`BenchmarkCase` is run on its own core by the benchmark
+executable, which times repeated runs of a kernel with the core's timer and
+reports the least, greatest and mean number of cycles taken by a run.
+"""
+import collections
+import enum
+import struct
+
+from rig.machine_control.consts import AppState
+from six import iteritems, string_types
+
+from nengo_spinnaker.regions.region import Region
+from nengo_spinnaker.regions import utils as region_utils
+from nengo_spinnaker.utils.application import (check_application,
+                                                get_application)
+
+
+class Kernels(enum.IntEnum):
+    """Kernels which may be benchmarked.
+
+    The meaning of the `size` and `param` of a case depend on the kernel:
+
+    ===================== ===================== ==========================
+    Kernel                `size`                `param`
+    ===================== ===================== ==========================
+    dot_product           Length of the vectors (unused)
+    lti_filter_step       Dimensions            Order of the filter
+    decode_spike_train    Neurons               Every `param` th neuron
+                                                fires (none if 0)
+    neuron_update         Neurons (LIF)         (unused)
+    input_filtering_input Routes                Dimensions of each filter
+    ===================== ===================== ==========================
+    """
+    dot_product = 0
+    lti_filter_step = 1
+    decode_spike_train = 2
+    neuron_update = 3
+    input_filtering_input = 4
+
+
+class BenchmarkCase(collections.namedtuple("BenchmarkCase",
+                                           "kernel, size, param, n_repeats")):
+    """A kernel to benchmark and the sizes with which to benchmark it."""
+    def __new__(cls, kernel, size, param=0, n_repeats=100):
+        if isinstance(kernel, string_types):
+            kernel = Kernels[kernel]
+        else:
+            kernel = Kernels(kernel)
+
+        if size < 1:
+            raise ValueError("Benchmarks must have a size of at least 1")
+        if n_repeats < 1:
+            raise ValueError("Benchmarks must be repeated at least once")
+        if kernel is Kernels.lti_filter_step and param < 1:
+            raise ValueError("LTI filters must be of at least order 1")
+        if (kernel is Kernels.input_filtering_input and
+                not 1 <= param <= 256):
+            raise ValueError(
+                "Filters must have between 1 and 256 dimensions")
+
+        return super(BenchmarkCase, cls).__new__(cls, kernel, size, param,
+                                                 n_repeats)
+
+
+class BenchmarkResult(collections.namedtuple(
+        "BenchmarkResult", "min_cycles, max_cycles, mean_cycles")):
+    """Cycles taken by the runs of a kernel."""
+
+
+class Regions(enum.IntEnum):
+    """Region names, corresponding to those defined in `benchmark.c`"""
+    case = 1
+    results = 2
+
+
+class BenchmarkCaseRegion(Region):
+    """Region describing the case to run: `benchmark_case_t`."""
+    def __init__(self, case):
+        self.case = case
+
+    def sizeof(self, *args, **kwargs):
+        return 4 * 4
+
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        fp.write(struct.pack("<4I", int(self.case.kernel), self.case.size,
+                             self.case.param, self.case.n_repeats))
+
+
+class BenchmarkResultsRegion(Region):
+    """Region into which the results of a case are written:
+    `benchmark_results_t`.
+    """
+    def sizeof(self, *args, **kwargs):
+        return 3 * 4
+
+    def write_subregion_to_file(self, fp, *args, **kwargs):
+        fp.write(b"\x00" * self.sizeof())
+
+    def read_results(self, fp):
+        """Read the results of a case from memory."""
+        return BenchmarkResult(*struct.unpack("<3I", fp.read(self.sizeof())))
+
+
+def run_benchmarks(controller, cases, x=0, y=0, cores=range(1, 17),
+                   app_id=66, timeout=10.0):
+    """Run benchmark cases on a chip of a booted SpiNNaker machine.
+
+    Each case is run on a separate core, if there are more cases than cores
+    then the cases are run in several batches.
+
+    Parameters
+    ----------
+    controller : :py:class:`~rig.machine_control.MachineController`
+        Controller for the machine.
+    cases : [:py:class:`BenchmarkCase`, ...]
+        Cases to run.
+    x, y : int
+        Chip on which to run the cases.
+    cores : [int, ...]
+        Application cores of the chip which may be used.
+    timeout : float
+        Seconds to wait for a batch of cases to complete.
+
+    Returns
+    -------
+    [:py:class:`BenchmarkResult`, ...]
+        Results, in the same order as the cases.
+    """
+    cases = list(cases)
+    cores = list(cores)
+    results = list()
+
+    for start in range(0, len(cases), len(cores)):
+        batch = cases[start:start + len(cores)]
+        with controller.application(app_id):
+            results.extend(_run_batch(controller, batch, x, y, cores,
+                                      timeout))
+            controller.send_signal("stop")
+
+    return results
+
+
+def _run_batch(controller, cases, x, y, cores, timeout):
+    """Run at most one case on each of the given cores."""
+    result_regions = dict()
+    for case, p in zip(cases, cores):
+        regions = {Regions.case: BenchmarkCaseRegion(case),
+                   Regions.results: BenchmarkResultsRegion()}
+        region_args = {k: region_utils.Args() for k in regions}
+
+        # Allocate memory tagged as that of the core, as expected by
+        # `system_load_sram`.
+        size = region_utils.sizeof_regions_named(regions, region_args)
+        mem = controller.sdram_alloc_as_filelike(size, tag=p, x=x, y=y)
+        region_memory = region_utils.create_app_ptr_and_region_files_named(
+            mem, regions, region_args)
+        region_utils.write_regions_named(region_memory, regions, region_args)
+
+        result_regions[p] = (regions[Regions.results],
+                             region_memory[Regions.results])
+
+    # Run the cases
+    used_cores = cores[:len(cases)]
+    application = get_application("benchmark")
+    check_application(application)
+    controller.load_application(application, {(x, y): set(used_cores)})
+    n_done = controller.wait_for_cores_to_reach_state(
+        AppState.exit, len(used_cores), timeout=timeout)
+
+    if n_done != len(used_cores):
+        for p in used_cores:
+            status = controller.get_processor_status(p, x, y)
+            if status.cpu_state is not AppState.exit:
+                print("Core ({}, {}, {}) in state {!s}".format(
+                    x, y, p, status.cpu_state))
+                print(controller.get_iobuf(p, x, y))
+        raise Exception("Unexpected core failures while benchmarking.")
+
+    results = list()
+    for p in used_cores:
+        region, mem = result_regions[p]
+        mem.seek(0)
+        results.append(region.read_results(mem))
+    return results
+
+
+def format_table(cases, results, cpu_clock_mhz=None):
+    """Format the results of benchmark cases as a table.
+
+    Parameters
+    ----------
+    cases : [:py:class:`BenchmarkCase`, ...]
+    results : [:py:class:`BenchmarkResult`, ...]
+    cpu_clock_mhz : int or None
+        If given the mean time taken by each case is also included.
+    """
+    header = ["kernel", "size", "param", "repeats",
+              "min", "mean", "max", "mean/size"]
+    if cpu_clock_mhz is not None:
+        header.append("mean (us)")
+
+    rows = list()
+    for case, result in zip(cases, results):
+        row = [case.kernel.name, str(case.size), str(case.param),
+               str(case.n_repeats), str(result.min_cycles),
+               str(result.mean_cycles), str(result.max_cycles),
+               "{:.2f}".format(float(result.mean_cycles) / case.size)]
+        if cpu_clock_mhz is not None:
+            row.append("{:.2f}".format(
+                float(result.mean_cycles) / cpu_clock_mhz))
+        rows.append(row)
+
+    # Left-align the kernel names and right-align the numbers
+    widths = [max(len(r[i]) for r in [header] + rows)
+              for i in range(len(header))]
+    lines = list()
+    for row in [header] + rows:
+        lines.append("  ".join(
+            (c.ljust(w) if i == 0 else c.rjust(w))
+            for i, (c, w) in enumerate(zip(row, widths))
+        ).rstrip())
+    lines.insert(1, "  ".join("-" * w for w in widths))
+    return "\n".join(lines)
+
+
+def group_results(cases, results):
+    """Group the results of benchmark cases by kernel.
+
+    Returns
+    -------
+    {:py:class:`Kernels`: [(:py:class:`BenchmarkCase`, \
+            :py:class:`BenchmarkResult`), ...], ...}
+    """
+    groups = collections.defaultdict(list)
+    for case, result in zip(cases, results):
+        groups[case.kernel].append((case, result))
+    return {k: sorted(v, key=lambda cr: (cr[0].size, cr[0].param))
+            for k, v in iteritems(groups)}
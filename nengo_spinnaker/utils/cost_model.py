@@ -0,0 +1,345 @@
+"""Model of the number of cycles taken by a core to simulate a timestep.
+
+The model is linear in the sizes of the work performed by an ensemble core:
+the dimensions and order of its input filters, the packets it receives, the
+neurons it simulates and the values it decodes.  The default coefficients are
+those of the original hand-profiled estimates; better coefficients may be
+fitted from the results of the benchmark executable (see
+:py:mod:`nengo_spinnaker.utils.benchmark`) or from the profiler counters
+recorded by every ensemble core during a simulation.
+"""
+import collections
+import json
+import numpy as np
+from six import iteritems
+
+from nengo_spinnaker.regions.profiler import MS_SCALE
+from nengo_spinnaker.utils.benchmark import Kernels
+
+
+class CoreLoad(collections.namedtuple(
+        "CoreLoad", "size_in, filtered_dims, filter_order, n_routes, "
+                    "n_neurons, n_neurons_in_cluster, size_out, "
+                    "size_learnt_out")):
+    """Work performed by an ensemble core in a timestep.
+
+    Attributes
+    ----------
+    size_in : int
+        Dimensionality of the encoders.
+    filtered_dims : int
+        Dimensions of input filtered by the core.
+    filter_order : int
+        Sum of the orders of the input filters.
+    n_routes : int
+        Number of input routing entries.
+    n_neurons : int
+        Neurons simulated by the core.
+    n_neurons_in_cluster : int
+        Neurons whose spikes are decoded by the core.
+    size_out, size_learnt_out : int
+        Static and learnt values decoded by the core.
+    """
+
+
+class CostModel(object):
+    """Linear model of the cycles taken by the kernels of an ensemble core.
+
+    Parameters
+    ----------
+    encode_per_neuron_dimension : float
+        Cycles to encode a single dimension of input for a single neuron.
+    neuron : float
+        Cycles to update a neuron (excluding encoding).
+    neuron_constant : float
+        Fixed cycles to update the neurons of a core.
+    filter_per_dimension_order : float
+        Cycles to filter a single dimension with a first order filter.
+    filter_constant : float
+        Fixed cycles to filter the input of a core.
+    packet_per_route : float
+        Cycles added to the handling of a packet by each input route.
+    packet_constant : float
+        Cycles to handle a packet regardless of the number of routes.
+    decode_per_row_neuron : float
+        Cycles to decode a single neuron for a single output value.
+    decode_per_row : float
+        Cycles to decode an output value (excluding transmission).
+    decode_constant : float
+        Fixed cycles to decode the output of a core.
+    transmit_per_row : float
+        Cycles to transmit an output value.
+    """
+    coefficients = ("encode_per_neuron_dimension", "neuron",
+                    "neuron_constant", "filter_per_dimension_order",
+                    "filter_constant", "packet_per_route", "packet_constant",
+                    "decode_per_row_neuron", "decode_per_row",
+                    "decode_constant", "transmit_per_row")
+
+    def __init__(self, encode_per_neuron_dimension=9, neuron=61,
+                 neuron_constant=174, filter_per_dimension_order=39,
+                 filter_constant=135, packet_per_route=0, packet_constant=0,
+                 decode_per_row_neuron=2, decode_per_row=143,
+                 decode_constant=173, transmit_per_row=0):
+        # The default costs of handling packets are zero as they are included
+        # in the default cost of filtering; similarly the default cost of
+        # transmitting a value is included in the default cost of decoding.
+        self.encode_per_neuron_dimension = encode_per_neuron_dimension
+        self.neuron = neuron
+        self.neuron_constant = neuron_constant
+        self.filter_per_dimension_order = filter_per_dimension_order
+        self.filter_constant = filter_constant
+        self.packet_per_route = packet_per_route
+        self.packet_constant = packet_constant
+        self.decode_per_row_neuron = decode_per_row_neuron
+        self.decode_per_row = decode_per_row
+        self.decode_constant = decode_constant
+        self.transmit_per_row = transmit_per_row
+
+    def as_dict(self):
+        """Get the coefficients of the model."""
+        return {c: getattr(self, c) for c in self.coefficients}
+
+    def copy(self, **coefficients):
+        """Get a copy of the model with some coefficients replaced."""
+        kwargs = self.as_dict()
+        kwargs.update(coefficients)
+        return type(self)(**kwargs)
+
+    def __eq__(self, other):
+        return (type(self) is type(other) and
+                self.as_dict() == other.as_dict())
+
+    def __ne__(self, other):
+        return not self == other
+
+    def __repr__(self):
+        return "{}({})".format(type(self).__name__, ", ".join(
+            "{}={!r}".format(c, getattr(self, c)) for c in self.coefficients))
+
+    def save(self, fp):
+        """Write the model to a file-like object as JSON."""
+        json.dump(self.as_dict(), fp, indent=2, sort_keys=True)
+
+    @classmethod
+    def load(cls, fp):
+        """Read a model written by :py:meth:`~.save`."""
+        return cls(**json.load(fp))
+
+    def input_filtering_cycles(self, n_dims, filter_order=1):
+        """Cycles required to filter received values."""
+        return (self.filter_per_dimension_order * n_dims * filter_order +
+                self.filter_constant)
+
+    def packet_cycles(self, n_packets, n_routes):
+        """Cycles required to include received packets in the input."""
+        return n_packets * (self.packet_per_route * n_routes +
+                            self.packet_constant)
+
+    def neuron_update_cycles(self, size_in, n_neurons):
+        """Cycles required to encode input and simulate neurons."""
+        return (self.encode_per_neuron_dimension * n_neurons * size_in +
+                self.neuron * n_neurons + self.neuron_constant)
+
+    def decode_cycles(self, n_neurons_in_cluster, size_out):
+        """Cycles required to decode spikes."""
+        return (self.decode_per_row_neuron * n_neurons_in_cluster * size_out +
+                self.decode_per_row * size_out + self.decode_constant)
+
+    def transmit_cycles(self, size_out):
+        """Cycles required to transmit decoded values."""
+        return self.transmit_per_row * size_out
+
+    def decode_and_transmit_cycles(self, n_neurons_in_cluster, size_out):
+        """Cycles required to decode spikes and transmit packets."""
+        return (self.decode_cycles(n_neurons_in_cluster, size_out) +
+                self.transmit_cycles(size_out))
+
+    def core_cycles(self, load):
+        """Cycles required by a core to simulate a timestep.
+
+        Parameters
+        ----------
+        load : :py:class:`~.CoreLoad`
+        """
+        # TODO Profile PES and Voja
+        return (
+            self.input_filtering_cycles(load.filtered_dims,
+                                        max(1, load.filter_order)) +
+            self.packet_cycles(load.filtered_dims, load.n_routes) +
+            self.neuron_update_cycles(load.size_in, load.n_neurons) +
+            self.decode_and_transmit_cycles(load.n_neurons_in_cluster,
+                                            load.size_out) +
+            self.decode_and_transmit_cycles(load.n_neurons_in_cluster,
+                                            load.size_learnt_out)
+        )
+
+    @classmethod
+    def from_benchmarks(cls, cases, results, base=None):
+        """Fit a model to the results of the benchmark executable.
+
+        The cost per unit of work of each kernel is fitted from the mean
+        cycles taken by cases of different sizes.  Kernels with fewer than two
+        distinct sizes are not fitted.  The constant costs (other than those
+        of handling packets) keep the values of `base`: they include work
+        which is done once per timestep, outside of the benchmarked kernels.
+
+        Parameters
+        ----------
+        cases : [:py:class:`~nengo_spinnaker.utils.benchmark.BenchmarkCase`]
+        results : [:py:class:`~.benchmark.BenchmarkResult`, ...]
+        base : :py:class:`~.CostModel` or None
+            Model providing the coefficients which are not fitted.
+        """
+        base = cls() if base is None else base
+        samples = collections.defaultdict(list)
+        for case, result in zip(cases, results):
+            # Get the size of the work with which costs scale
+            if case.kernel is Kernels.lti_filter_step:
+                work = case.size * case.param
+            else:
+                work = case.size
+            samples[case.kernel].append((work, result.mean_cycles))
+
+        fits = {k: _fit_line(v) for k, v in iteritems(samples)}
+        fits = {k: v for k, v in iteritems(fits) if v is not None}
+        coefficients = dict()
+
+        if Kernels.dot_product in fits:
+            coefficients["encode_per_neuron_dimension"] = \
+                fits[Kernels.dot_product][0]
+        if Kernels.neuron_update in fits:
+            # Neurons are encoded individually, so the fixed cost of encoding
+            # is a cost of each neuron.
+            encode_constant = fits.get(Kernels.dot_product, (0, 0))[1]
+            coefficients["neuron"] = (fits[Kernels.neuron_update][0] +
+                                      encode_constant)
+        if Kernels.lti_filter_step in fits:
+            coefficients["filter_per_dimension_order"] = \
+                fits[Kernels.lti_filter_step][0]
+        if Kernels.input_filtering_input in fits:
+            (coefficients["packet_per_route"],
+             coefficients["packet_constant"]) = \
+                fits[Kernels.input_filtering_input]
+        if Kernels.decode_spike_train in fits:
+            coefficients["decode_per_row_neuron"] = \
+                fits[Kernels.decode_spike_train][0]
+
+        return base.copy(**coefficients)
+
+    @classmethod
+    def from_profiler_counters(cls, samples, base=None):
+        """Fit a model to the profiler counters recorded by ensemble cores.
+
+        Each stage of simulating a timestep is fitted separately from the
+        total time spent in its tag in each timestep (a tag may be entered
+        several times in a timestep).  Transmission is not profiled by a tag
+        of its own; its cost is fitted from the time of each timestep not
+        spent in the profiled stages, using only the cores which neither
+        learn nor wait at barriers.  Stages for which the samples do not vary
+        enough to determine every coefficient keep the values of `base`.  The
+        costs of handling packets are not recorded by the profiler and always
+        keep the values of `base`.
+
+        Parameters
+        ----------
+        samples : [(:py:class:`~.CoreLoad`, {tag: {"mean": ms, ...}}), ...]
+            The load of each core and the counters it recorded (see
+            :py:func:`~nengo_spinnaker.utils.profiling.decode_counters`).
+        base : :py:class:`~.CostModel` or None
+            Model providing the coefficients which are not fitted.
+        """
+        base = cls() if base is None else base
+        stages = {
+            "Input filter": (
+                ("filter_per_dimension_order", "filter_constant"),
+                lambda l: (l.filtered_dims * max(1, l.filter_order), 1)
+            ),
+            "Neuron update": (
+                ("encode_per_neuron_dimension", "neuron", "neuron_constant"),
+                lambda l: (l.n_neurons * l.size_in, l.n_neurons, 1)
+            ),
+            "Decode output": (
+                ("decode_per_row_neuron", "decode_per_row",
+                 "decode_constant"),
+                # The static and learnt outputs are decoded separately, so the
+                # fixed cost is incurred twice.
+                lambda l: (l.n_neurons_in_cluster * (l.size_out +
+                                                     l.size_learnt_out),
+                           l.size_out + l.size_learnt_out, 2)
+            ),
+        }
+
+        unmodelled_tags = ("PES", "Voja", "Barrier wait")
+
+        def get_cycles(counters, tag):
+            """Get the mean cycles spent in a tag in each timestep."""
+            return (counters[tag]["mean"] * counters[tag]["count"] /
+                    counters["Timestep"]["count"] / MS_SCALE)
+
+        samples = [(load, counters) for load, counters in samples
+                   if "Timestep" in counters]
+
+        coefficients = dict()
+        for tag, (names, get_work) in iteritems(stages):
+            xs, ys = list(), list()
+            for load, counters in samples:
+                if tag in counters:
+                    xs.append(get_work(load))
+                    ys.append(get_cycles(counters, tag))
+
+            fit = _fit_linear(xs, ys)
+            if fit is not None:
+                coefficients.update(zip(names, fit))
+
+        # The time remaining in each timestep is that of transmitting the
+        # output and of fixed work which isn't part of the model.
+        xs, ys = list(), list()
+        for load, counters in samples:
+            if (all(tag in counters for tag in stages) and
+                    not any(tag in counters for tag in unmodelled_tags)):
+                xs.append((load.size_out + load.size_learnt_out, 1))
+                ys.append(counters["Timestep"]["mean"] / MS_SCALE -
+                          sum(get_cycles(counters, tag) for tag in stages))
+
+        fit = _fit_linear(xs, ys)
+        if fit is not None:
+            coefficients["transmit_per_row"] = fit[0]
+
+        return base.copy(**coefficients)
+
+
+def _fit_linear(xs, ys):
+    """Least-squares fit of `y = sum(c*x)`, returns the (non-negative)
+    coefficients or None if they are not all determined by the samples.
+    """
+    if not xs:
+        return None
+
+    xs = np.array(xs, dtype=float)
+    if np.linalg.matrix_rank(xs) < xs.shape[1]:
+        return None
+
+    coefficients = np.linalg.lstsq(xs, np.array(ys, dtype=float),
+                                   rcond=-1)[0]
+    return tuple(float(max(c, 0.0)) for c in coefficients)
+
+
+def _fit_line(samples):
+    """Fit `y = a*x + b` to a list of `(x, y)`."""
+    return _fit_linear([(x, 1) for x, _ in samples], [y for _, y in samples])
+
+
+def get_profiler_samples(simulator):
+    """Get the load of every ensemble core of a simulation and the profiler
+    counters it recorded, for use with
+    :py:meth:`~.CostModel.from_profiler_counters`.
+    """
+    samples = list()
+    for ensemble, counters in iteritems(simulator.profiler_counters):
+        operator = simulator.model.object_operators[ensemble]
+        for cluster in operator.clusters:
+            for vertex in cluster.vertices:
+                key = (vertex.neuron_slice.start, vertex.neuron_slice.stop)
+                samples.append((vertex.get_core_load(), counters[key]))
+    return samples
@@ -1,5 +1,7 @@
 import numpy as np
-from six import iterkeys, itervalues
+from six import iteritems, iterkeys, itervalues
+
+from nengo_spinnaker.regions.profiler import MS_SCALE
 
 
 def print_summary(profiling_data, duration):
@@ -64,3 +66,50 @@ def write_csv_row(profiling_data, duration_s, dt_s, csv_writer,
 
     # Write extra column followed by means
     csv_writer.writerow(extra_column_values + mean_times)
+
+
+def decode_counters(words, tag_names):
+    """Decode the raw words of the always-available profiler counters.
+
+    Parameters
+    ----------
+    words : ndarray
+        Words read from a :py:class:`~nengo_spinnaker.regions.ProfilerCounters`
+        region.
+    tag_names : {int: str}
+        Names of the profiler tags.
+
+    Returns
+    -------
+    dict
+        The greatest length of the packet queue ("max queue length"), and for
+        processing each timestep ("Timestep") and for each tag which was
+        entered a dictionary of the "count" and the "min", "max" and "mean"
+        time spent (in ms).
+    """
+    n_counters, max_queue_length = (int(w) for w in words[:2])
+    counters = words[2:2 + 5*(1 + n_counters)].reshape(-1, 5)
+
+    def decode_counter(counter):
+        count, min_cycles, max_cycles, sum_lo, sum_hi = (int(w) for w in
+                                                         counter)
+        total = (sum_hi << 32) | sum_lo
+        return {
+            "count": count,
+            "min": min_cycles * MS_SCALE,
+            "max": max_cycles * MS_SCALE,
+            "mean": total * MS_SCALE / count,
+        }
+
+    data = {
+        "max queue length": max_queue_length,
+    }
+
+    if counters[0][0]:
+        data["Timestep"] = decode_counter(counters[0])
+
+    for tag, name in iteritems(tag_names):
+        if tag < n_counters and counters[1 + tag][0]:
+            data[name] = decode_counter(counters[1 + tag])
+
+    return data
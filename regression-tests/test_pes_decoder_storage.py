@@ -0,0 +1,54 @@
+import nengo
+import nengo_spinnaker
+import numpy as np
+import pytest
+
+
+@pytest.mark.parametrize("storage", ("factored", "streamed"))
+def test_pes_with_compressed_static_decoders(storage):
+    """Check that PES learns the decoders of a connection from an ensemble
+    whose static decoders are not stored densely.
+    """
+    with nengo.Network("Test Network") as network:
+        # Create an ensemble representing a constant value
+        stim = nengo.Node(0.5)
+        pre = nengo.Ensemble(100, 1)
+        nengo.Connection(stim, pre)
+
+        # Create a static connection whose decoders may be factored (they are
+        # of rank 1) or streamed.
+        static_out = nengo.Node(size_in=8)
+        nengo.Connection(pre, static_out, transform=[[1.0]] * 8)
+        p_static = nengo.Probe(static_out, synapse=0.05)
+
+        # Learn to represent the negative of the value
+        post = nengo.Node(size_in=1)
+        learnt = nengo.Connection(pre, post, function=lambda x: 0.0,
+                                  learning_rule_type=nengo.PES())
+        p_post = nengo.Probe(post, synapse=0.05)
+
+        error = nengo.Ensemble(100, 1)
+        nengo.Connection(post, error)
+        nengo.Connection(stim, error)
+        nengo.Connection(error, learnt.learning_rule)
+
+    # Store the static decoders in the given format
+    nengo_spinnaker.add_spinnaker_params(network.config)
+    network.config[pre].decoder_storage = storage
+    network.config[stim].function_of_time = True
+
+    # Create the simulator and simulate
+    sim = nengo_spinnaker.Simulator(network)
+    with sim:
+        sim.run(5.0)
+
+    # The static output should be unaffected by learning and the learnt
+    # output should have converged.
+    index = int(4.0 / sim.dt)
+    assert np.all(np.abs(sim.data[p_static][index:] - 0.5) < 0.1)
+    assert np.all(np.abs(sim.data[p_post][index:] + 0.5) < 0.1)
+
+
+if __name__ == "__main__":
+    test_pes_with_compressed_static_decoders("factored")
+    test_pes_with_compressed_static_decoders("streamed")
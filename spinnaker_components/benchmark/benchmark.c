@@ -0,0 +1,363 @@
+/* Benchmarks of the kernels used by the nengo_spinnaker executables.
+ *
+ * Each core runs a single benchmark case described by the host: a kernel is
+ * set up with the given sizes and then timed, with timer 2, for the given
+ * number of repeats.  The least, greatest and mean number of cycles taken by
+ * the kernel are written into the results region and the core then exits.
+ * Each case is run on a fresh core so the memory allocated to set up a kernel
+ * need never be freed.
+ *
+ * The kernels, and the meaning of their sizes, are:
+ *
+ *  - BENCHMARK_DOT_PRODUCT: `dot_product` of two vectors of `size` values.
+ *  - BENCHMARK_LTI_FILTER_STEP: one step of an LTI filter of `size`
+ *    dimensions and order `param` (orders 2 and 3 use the specialised steps
+ *    selected by `_lti_filter_init`).
+ *  - BENCHMARK_DECODE_SPIKE_TRAIN: `decode_spike_train` of `size` neurons in
+ *    which every `param`th neuron fired (no neurons fire if `param` is 0).
+ *  - BENCHMARK_NEURON_UPDATE: `lif_update` of `size` neurons.
+ *  - BENCHMARK_INPUT_FILTERING_INPUT: `input_filtering_input` of a packet
+ *    with a collection of `size` routes, each to a filter of `param`
+ *    dimensions.  Successive repeats address successive routes.
+ */
+
+#include <string.h>
+
+#include "spin1_api.h"
+#include "nengo-common.h"
+#include "nengo_typedefs.h"
+#include "common-impl.h"
+#include "fixed_point.h"
+#include "input_filtering.h"
+
+#include "decode.h"
+#include "neuron_lif.h"
+
+/*****************************************************************************/
+// Region indices
+#define CASE_REGION     1
+#define RESULTS_REGION  2
+
+// Kernels which may be benchmarked
+typedef enum _benchmark_kernel_id_t
+{
+  BENCHMARK_DOT_PRODUCT = 0,
+  BENCHMARK_LTI_FILTER_STEP = 1,
+  BENCHMARK_DECODE_SPIKE_TRAIN = 2,
+  BENCHMARK_NEURON_UPDATE = 3,
+  BENCHMARK_INPUT_FILTERING_INPUT = 4,
+} benchmark_kernel_id_t;
+
+// Benchmark case (written by the host)
+typedef struct _benchmark_case_t
+{
+  uint32_t kernel;     // Kernel to benchmark (`benchmark_kernel_id_t`)
+  uint32_t size;       // Primary size of the kernel
+  uint32_t param;      // Secondary size of the kernel
+  uint32_t n_repeats;  // Number of times to time the kernel
+} benchmark_case_t;
+
+// Benchmark results (read by the host)
+typedef struct _benchmark_results_t
+{
+  uint32_t min_cycles;   // Least cycles taken by a repeat
+  uint32_t max_cycles;   // Greatest cycles taken by a repeat
+  uint32_t mean_cycles;  // Mean cycles taken by a repeat
+} benchmark_results_t;
+
+// Number of times the cost of taking a measurement is measured
+#define N_CALIBRATION_REPEATS 32
+
+// A kernel, one repeat of which is timed by each call
+typedef void (*benchmark_kernel_t)(uint32_t repeat);
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Global variables
+benchmark_case_t bench;  // The case being benchmarked
+
+// The result of each kernel is written here so that it may not be optimised
+// away.
+volatile uint32_t sink;
+
+uint32_t random_state = 1;  // State of the pseudo-random number generator
+
+// State of the kernels
+value_t *values_a, *values_b;  // Operands (vectors, decoders, inputs)
+uint32_t *spikes;              // Spike vector
+uint32_t population_length;    // Neurons covered by the spike vector
+if_collection_t filters;       // Filters and routes
+lif_states_t lif;              // LIF neuron state
+recording_buffer_t rec_voltages;  // Unused voltage recording
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Get a pseudo-random word
+static inline uint32_t random_word(void)
+{
+  // Numerical Recipes LCG, ample for filling benchmark operands
+  random_state = random_state * 1664525 + 1013904223;
+  return random_state;
+}
+
+// Get a pseudo-random value in the range [-1, 1)
+static inline value_t random_value(void)
+{
+  return kbits(((int32_t) (random_word() >> 16)) - bitsk(1.0k));
+}
+
+// Allocate and fill a vector of pseudo-random values
+static value_t *random_vector(uint32_t n_values)
+{
+  value_t *vector;
+  MALLOC_OR_DIE(vector, n_values * sizeof(value_t));
+  for (uint32_t i = 0; i < n_values; i++)
+  {
+    vector[i] = random_value();
+  }
+  return vector;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Kernels and their set-up
+static void kernel_none(uint32_t repeat)
+{
+  use(repeat);
+}
+
+static void kernel_dot_product(uint32_t repeat)
+{
+  use(repeat);
+  sink = bitsk(dot_product(bench.size, values_a, values_b));
+}
+
+static void setup_dot_product(void)
+{
+  values_a = random_vector(bench.size);
+  values_b = random_vector(bench.size);
+}
+
+static void kernel_lti_filter_step(uint32_t repeat)
+{
+  use(repeat);
+  _if_filter_step(&filters.filters[0], NULL);
+  sink = bitsk(filters.filters[0].output[0]);
+}
+
+static void setup_lti_filter_step(void)
+{
+  // Construct the parameters of a single LTI filter, the coefficients are
+  // chosen such that the filter is stable.
+  const uint32_t order = bench.param;
+  const uint32_t n_words = 1 + 2*order;
+  uint32_t *data;
+  MALLOC_OR_DIE(data, (5 + n_words) * sizeof(uint32_t));
+  data[0] = 1;             // Number of filters
+  data[1] = n_words;       // Words of filter specific parameters
+  data[2] = 2;             // LTI filter
+  data[3] = bench.size;    // Width of the filter
+  data[4] = 0;             // Not latching
+  data[5] = order;         // Order of the filter
+  for (uint32_t k = 0; k < 2*order; k++)
+  {
+    data[6 + k] = bitsk(0.5k) / order;
+  }
+  input_filtering_get_filters(&filters, data, NULL);
+
+  // Provide some input to the filter, it is cleared by the first step
+  if_accumulator_t *input = filters.filters[0].input;
+  for (uint32_t d = 0; d < bench.size; d++)
+  {
+    input->value[d] = input->retired[d] = random_value();
+  }
+}
+
+static void kernel_decode_spike_train(uint32_t repeat)
+{
+  use(repeat);
+  sink = bitsk(decode_spike_train(1, &population_length, values_a, spikes));
+}
+
+static void setup_decode_spike_train(void)
+{
+  population_length = bench.size;
+  values_a = random_vector(bench.size);
+
+  const uint32_t n_words = (bench.size + 31) / 32;
+  MALLOC_OR_DIE(spikes, n_words * sizeof(uint32_t));
+  memset(spikes, 0, n_words * sizeof(uint32_t));
+  for (uint32_t n = 0; bench.param && n < bench.size; n += bench.param)
+  {
+    spikes[n / 32] |= 1 << (31 - (n % 32));
+  }
+}
+
+static void kernel_neuron_update(uint32_t repeat)
+{
+  use(repeat);
+
+  uint32_t spiked = 0;
+  for (uint32_t n = 0; n < bench.size; n += 32)
+  {
+    const uint32_t n_neurons = (bench.size - n < 32) ? bench.size - n : 32;
+    spiked ^= lif_update(n, n_neurons, &values_a[n], &lif, &rec_voltages);
+  }
+  sink = spiked;
+}
+
+static void setup_neuron_update(void)
+{
+  // Parameters for a timestep of 1ms, tau_rc of 20ms and tau_ref of 2ms
+  lif_parameters_t parameters = {0.048771k, 2};
+  lif_initialise_state(&lif, bench.size, (uint32_t *) &parameters);
+
+  // Inputs in the range [0, 2) so that some neurons fire
+  MALLOC_OR_DIE(values_a, bench.size * sizeof(value_t));
+  for (uint32_t n = 0; n < bench.size; n++)
+  {
+    values_a[n] = kbits(random_word() >> 16);
+  }
+
+  // Voltages are written into the buffer regardless of whether they are
+  // recorded.
+  MALLOC_OR_DIE(rec_voltages.buffer,
+                ((bench.size + 1) / 2) * sizeof(uint32_t));
+}
+
+static void kernel_input_filtering_input(uint32_t repeat)
+{
+  const uint32_t key = ((repeat % bench.size) << 8) | (repeat % bench.param);
+  sink = input_filtering_input(&filters, key, bitsk(0.5k));
+}
+
+static void setup_input_filtering_input(void)
+{
+  // Construct one filter per route, each passes its input straight through
+  uint32_t *data;
+  MALLOC_OR_DIE(data, (1 + 4*bench.size) * sizeof(uint32_t));
+  data[0] = bench.size;
+  for (uint32_t f = 0; f < bench.size; f++)
+  {
+    data[1 + 4*f + 0] = 0;            // No filter specific parameters
+    data[1 + 4*f + 1] = 0;            // None filter
+    data[1 + 4*f + 2] = bench.param;  // Width of the filter
+    data[1 + 4*f + 3] = 0;            // Not latching
+  }
+  input_filtering_get_filters(&filters, data, NULL);
+
+  // Construct the routes, the bottom byte of each key is the dimension
+  uint32_t *routes;
+  MALLOC_OR_DIE(routes, (1 + 4*bench.size) * sizeof(uint32_t));
+  routes[0] = bench.size;
+  for (uint32_t r = 0; r < bench.size; r++)
+  {
+    routes[1 + 4*r + 0] = r << 8;       // Key
+    routes[1 + 4*r + 1] = 0xffffff00;   // Mask
+    routes[1 + 4*r + 2] = 0x000000ff;   // Dimension mask
+    routes[1 + 4*r + 3] = r;            // Filter
+  }
+  input_filtering_get_routes(&filters, routes);
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Get the number of cycles taken by a repeat of a kernel
+static inline uint32_t time_kernel(benchmark_kernel_t kernel, uint32_t repeat)
+{
+  // Timer 2 counts down
+  const uint32_t start = tc[T2_COUNT];
+  kernel(repeat);
+  return start - tc[T2_COUNT];
+}
+
+// Prepare the kernel for the case, returning NULL if the case is invalid.
+static benchmark_kernel_t setup_kernel(void)
+{
+  switch (bench.kernel)
+  {
+    case BENCHMARK_DOT_PRODUCT:
+      if (bench.size == 0) return NULL;
+      setup_dot_product();
+      return kernel_dot_product;
+
+    case BENCHMARK_LTI_FILTER_STEP:
+      if (bench.size == 0 || bench.param == 0) return NULL;
+      setup_lti_filter_step();
+      return kernel_lti_filter_step;
+
+    case BENCHMARK_DECODE_SPIKE_TRAIN:
+      if (bench.size == 0) return NULL;
+      setup_decode_spike_train();
+      return kernel_decode_spike_train;
+
+    case BENCHMARK_NEURON_UPDATE:
+      if (bench.size == 0) return NULL;
+      setup_neuron_update();
+      return kernel_neuron_update;
+
+    case BENCHMARK_INPUT_FILTERING_INPUT:
+      if (bench.size == 0 || bench.param == 0 || bench.param > 256)
+        return NULL;
+      setup_input_filtering_input();
+      return kernel_input_filtering_input;
+
+    default:
+      return NULL;
+  }
+}
+
+void c_main(void)
+{
+  address_t address = system_load_sram();
+  spin1_memcpy(&bench, region_start(CASE_REGION, address),
+               sizeof(benchmark_case_t));
+  benchmark_results_t *results =
+    (benchmark_results_t *) region_start(RESULTS_REGION, address);
+
+  // Prepare the kernel
+  benchmark_kernel_t kernel = setup_kernel();
+  if (kernel == NULL || bench.n_repeats == 0)
+  {
+    io_printf(IO_BUF, "[Benchmark] Invalid case: kernel %d (%d, %d) x %d\n",
+              bench.kernel, bench.size, bench.param, bench.n_repeats);
+    rt_error(RTE_ABORT);
+    return;
+  }
+
+  // Start timer 2 with no clock divider
+  tc[T2_CONTROL] = 0x82;
+  tc[T2_LOAD] = 0;
+
+  // Determine the cost of taking a measurement (the call to the kernel and
+  // reading the timer) so that it can be removed from each measurement.
+  uint32_t overhead = UINT32_MAX;
+  for (uint32_t i = 0; i < N_CALIBRATION_REPEATS; i++)
+  {
+    const uint32_t cycles = time_kernel(kernel_none, i);
+    overhead = (cycles < overhead) ? cycles : overhead;
+  }
+
+  // Time each repeat of the kernel
+  uint32_t min_cycles = UINT32_MAX, max_cycles = 0;
+  uint64_t total_cycles = 0;
+  for (uint32_t i = 0; i < bench.n_repeats; i++)
+  {
+    uint32_t cycles = time_kernel(kernel, i);
+    cycles = (cycles > overhead) ? cycles - overhead : 0;
+
+    min_cycles = (cycles < min_cycles) ? cycles : min_cycles;
+    max_cycles = (cycles > max_cycles) ? cycles : max_cycles;
+    total_cycles += cycles;
+  }
+
+  // Write out the results
+  results->min_cycles = min_cycles;
+  results->max_cycles = max_cycles;
+  results->mean_cycles = (uint32_t) (total_cycles / bench.n_repeats);
+
+  io_printf(IO_BUF, "[Benchmark] kernel %d (%d, %d): %d/%d/%d cycles\n",
+            bench.kernel, bench.size, bench.param,
+            results->min_cycles, results->mean_cycles, results->max_cycles);
+}
+/*****************************************************************************/
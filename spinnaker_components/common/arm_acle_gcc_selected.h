@@ -40,5 +40,37 @@ static inline int64_t __smlal(int64_t acc, int32_t x, int32_t y)
   return result.val;
 }
 
+// This instruction multiplies the bottom signed 16-bit halves of two words and
+// accumulates the result into a 32-bit value.
+static inline int32_t __smlabb(int32_t x, int32_t y, int32_t acc)
+{
+  register int32_t result;
+
+  __asm__ __volatile__("smlabb %[r], %[x], %[y], %[a]"
+                       : [r] "=r" (result)
+                       : [x] "r" (x),
+                         [y] "r" (y),
+                         [a] "r" (acc)
+                       :);
+
+  return result;
+}
+
+// This instruction multiplies the top signed 16-bit halves of two words and
+// accumulates the result into a 32-bit value.
+static inline int32_t __smlatt(int32_t x, int32_t y, int32_t acc)
+{
+  register int32_t result;
+
+  __asm__ __volatile__("smlatt %[r], %[x], %[y], %[a]"
+                       : [r] "=r" (result)
+                       : [x] "r" (x),
+                         [y] "r" (y),
+                         [a] "r" (acc)
+                       :);
+
+  return result;
+}
+
 
 #endif  // __ARM_ACLE_GCC_SELECTED_H__
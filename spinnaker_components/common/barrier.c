@@ -0,0 +1,50 @@
+#include "barrier.h"
+#include "profiler.h"
+
+/*****************************************************************************/
+// Check whether all cores have arrived at a barrier and either call the
+// barrier callback or schedule checking again.
+static void _barrier_poll(uint arg0, uint arg1)
+{
+  use(arg1);
+  barrier_t *barrier = (barrier_t *) arg0;
+
+  if (*barrier->sema)
+  {
+    // Not all cores have arrived, check again once any other queued work has
+    // been processed.  If the check can't be scheduled then fall back to
+    // waiting here.
+    if (spin1_schedule_callback(_barrier_poll, arg0, 0, BARRIER_POLL_PRIORITY))
+    {
+      return;
+    }
+
+    while (*barrier->sema) ;
+  }
+
+  profiler_write_entry(PROFILER_EXIT | barrier->profiler_tag);
+  barrier->callback();
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+void barrier_init(barrier_t *barrier, volatile uint8_t *sema,
+                  barrier_callback_t callback, uint32_t profiler_tag)
+{
+  barrier->sema = sema;
+  barrier->callback = callback;
+  barrier->profiler_tag = profiler_tag;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+void barrier_wait(barrier_t *barrier)
+{
+  profiler_write_entry(PROFILER_ENTER | barrier->profiler_tag);
+
+  // Indicate that we have arrived and then check whether all other cores
+  // have already done so.
+  sark_sema_lower((uchar *) barrier->sema);
+  _barrier_poll((uint) barrier, 0);
+}
+/*****************************************************************************/
@@ -0,0 +1,51 @@
+/* Synchronisation barrier between the cores of a chip.
+ *
+ * Each core participating in the barrier raises a semaphore in shared memory
+ * at the start of a step (`barrier_raise`) and lowers it again when it reaches
+ * the barrier (`barrier_wait`).  Rather than spinning until the semaphore
+ * reaches zero, waiting cores poll it from a low priority queued callback so
+ * that packets, packet queue processing and any other queued work continue to
+ * be serviced.  Once every core has arrived the barrier callback is called.
+ *
+ * The time spent waiting at the barrier is recorded by the profiler using the
+ * tag given when the barrier is initialised.
+ */
+
+#ifndef __BARRIER_H__
+#define __BARRIER_H__
+
+#include <stdint.h>
+#include "spin1_api.h"
+
+// Priority of the callback used to poll the barrier semaphore, this must be
+// lower than that of any other queued callback which should continue to be
+// serviced while waiting.
+#define BARRIER_POLL_PRIORITY 2
+
+// Function called once all cores have arrived at a barrier
+typedef void (*barrier_callback_t)(void);
+
+typedef struct _barrier_t
+{
+  volatile uint8_t *sema;       // Semaphore in shared memory
+  barrier_callback_t callback;  // Called once all cores have arrived
+  uint32_t profiler_tag;        // Profiler tag for time spent waiting
+} barrier_t;
+
+// Initialise a barrier
+void barrier_init(barrier_t *barrier, volatile uint8_t *sema,
+                  barrier_callback_t callback, uint32_t profiler_tag);
+
+// Indicate that this core will be participating in the next use of the
+// barrier, this must be called by every participating core before any core
+// calls `barrier_wait`.
+static inline void barrier_raise(barrier_t *barrier)
+{
+  sark_sema_raise((uchar *) barrier->sema);
+}
+
+// Arrive at the barrier, the barrier callback will be called (possibly before
+// this returns) once all participating cores have arrived.
+void barrier_wait(barrier_t *barrier);
+
+#endif  // __BARRIER_H__
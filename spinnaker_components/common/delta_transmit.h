@@ -0,0 +1,115 @@
+/* Suppression of the transmission of values which have barely changed.
+ *
+ * Values sent along latching signals are held by the receiving filters until
+ * a new value arrives, so a value need only be sent when it differs from the
+ * value last sent by more than some threshold.  The host describes the
+ * threshold of each value with a `delta_transmit_region_t`; values with a
+ * negative threshold are always sent, as are values beyond those described by
+ * the region.  If no value has a threshold the region describes no values and
+ * every value is always sent at the cost of a single comparison.
+ *
+ * Every value is sent on the first timestep after `delta_transmit_reset` and,
+ * if `refresh_period` is not 0, every `refresh_period` timesteps thereafter
+ * so that values lost in the network are eventually replaced.  Executables
+ * call `delta_transmit_changed` for each value they may send and should call
+ * `delta_transmit_step` once all the values of a timestep have been
+ * considered.
+ */
+
+#ifndef __DELTA_TRANSMIT_H__
+#define __DELTA_TRANSMIT_H__
+
+#include <stdbool.h>
+#include <string.h>
+#include "nengo-common.h"
+#include "nengo_typedefs.h"
+
+typedef struct _delta_transmit_region_t
+{
+  uint32_t n_values;        // Number of values with thresholds
+  uint32_t refresh_period;  // Timesteps between sending every value (0 = none)
+  value_t thresholds[];     // Threshold for each value
+} delta_transmit_region_t;
+
+typedef struct _delta_transmit_t
+{
+  uint32_t n_values;        // Number of values with thresholds
+  uint32_t refresh_period;  // Timesteps between sending every value (0 = none)
+  value_t *thresholds;      // Threshold for each value
+  value_t *last_sent;       // Value last sent for each value
+
+  bool _send_all;           // Send every value in this timestep
+  uint32_t _until_refresh;  // Timesteps until every value is sent again
+} delta_transmit_t;
+
+/* Copy in the thresholds, which must be a `delta_transmit_region_t`.
+ */
+static inline void delta_transmit_initialise(delta_transmit_t *delta,
+                                             address_t region)
+{
+  const delta_transmit_region_t *params =
+    (const delta_transmit_region_t *) region;
+  delta->n_values = params->n_values;
+  delta->refresh_period = params->refresh_period;
+
+  if (delta->n_values)
+  {
+    MALLOC_OR_DIE(delta->thresholds, delta->n_values * sizeof(value_t));
+    MALLOC_OR_DIE(delta->last_sent, delta->n_values * sizeof(value_t));
+    spin1_memcpy(delta->thresholds, params->thresholds,
+                 delta->n_values * sizeof(value_t));
+
+    // Receiving filters hold 0 until the first value is received
+    memset(delta->last_sent, 0, delta->n_values * sizeof(value_t));
+  }
+}
+
+/* Ensure that every value is sent in the next timestep.
+ */
+static inline void delta_transmit_reset(delta_transmit_t *delta)
+{
+  delta->_send_all = true;
+  delta->_until_refresh = delta->refresh_period;
+}
+
+/* Determine whether the value with the given index should be sent, if it
+ * should then it is recorded as the value last sent.
+ */
+static inline bool delta_transmit_changed(delta_transmit_t *delta,
+                                          uint32_t index, value_t value)
+{
+  if (index >= delta->n_values)
+  {
+    return true;
+  }
+
+  // Compare the magnitude of the change with the threshold, the change is
+  // computed with 64 bits as it may not fit in a value_t.
+  int64_t change = (int64_t) bitsk(value) - bitsk(delta->last_sent[index]);
+  if (change < 0)
+  {
+    change = -change;
+  }
+
+  if (delta->_send_all || change > bitsk(delta->thresholds[index]))
+  {
+    delta->last_sent[index] = value;
+    return true;
+  }
+  return false;
+}
+
+/* Indicate that every value in the current timestep has been considered.
+ */
+static inline void delta_transmit_step(delta_transmit_t *delta)
+{
+  delta->_send_all = false;
+
+  if (delta->refresh_period && --delta->_until_refresh == 0)
+  {
+    delta->_send_all = true;
+    delta->_until_refresh = delta->refresh_period;
+  }
+}
+
+#endif  // __DELTA_TRANSMIT_H__
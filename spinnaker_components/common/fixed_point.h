@@ -15,6 +15,15 @@ static inline int32_t convert_s32_30_s16_15(int64_t value)
   return (int32_t) (value >> 15);
 }
 
+/*****************************************************************************/
+// Multiply a S16.15 value by a S0.31 value, the latter allows small constants
+// (e.g., functions of the simulation timestep) to be represented precisely.
+
+static inline value_t mul_s16_15_s0_31(value_t x, int32_t y)
+{
+  return kbits((int32_t) (__smull(bitsk(x), y) >> 31));
+}
+
 /*****************************************************************************/
 // Optimised dot product
 // Returns the dot product of two vectors of fixed point values.
@@ -43,6 +52,58 @@ static inline value_t dot_product(uint32_t order, const value_t *a, const value_
   return kbits(convert_s32_30_s16_15(acc));
 }
 
+/*****************************************************************************/
+// Optimised dot product of packed 16-bit values
+// Returns the dot product of two vectors of signed 16-bit values, each word of
+// which contains a pair of values (the first value of the pair in the bottom
+// half of the word).  The result has as many fractional bits as the two
+// operands combined.
+// NOTE: This dot product is not saturating at all!
+
+static inline int32_t dot_product_s16_pairs(uint32_t n_words,
+                                            const int32_t *a, const int32_t *b)
+{
+  register int32_t acc = 0;
+
+  for (uint32_t i = 0; i < n_words; i++)
+  {
+    // Get the pairs of components to multiply
+    register int32_t x = a[i];
+    register int32_t y = b[i];
+
+    // Perform a signed multiply with accumulate of each pair
+    //   acc = acc + x.bottom * y.bottom + x.top * y.top;
+    acc = __smlabb(x, y, acc);
+    acc = __smlatt(x, y, acc);
+  }
+
+  return acc;
+}
+
+/*****************************************************************************/
+// Optimised sparse dot product
+// Returns the dot product of the `order` non-zero elements of a sparse vector,
+// stored as their indices and values, with a dense vector.
+// NOTE: This dot product is not saturating at all!
+
+static inline value_t sparse_dot_product(uint32_t order,
+                                         const uint32_t *indices,
+                                         const value_t *values,
+                                         const value_t *b)
+{
+  register int64_t acc = 0;
+
+  for (uint32_t i = 0; i < order; i++)
+  {
+    // Perform a signed multiply with accumulate
+    //   acc = acc + values[i] * b[indices[i]];
+    acc = __smlal(acc, bitsk(values[i]), bitsk(b[indices[i]]));
+  }
+
+  // Convert from the S32.30 value back to S16.15 before returning
+  return kbits(convert_s32_30_s16_15(acc));
+}
+
 /*****************************************************************************/
 
 
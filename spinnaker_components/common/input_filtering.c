@@ -13,15 +13,18 @@ typedef struct _value_t_pair_t
 
 /* FILTER IMPLEMENTATIONS ****************************************************/
 /* None filter : output = input **********************************************/
-void _none_filter_step(uint32_t n_dims, value_t *input,
-                       value_t *output, void *params)
+void _none_filter_step(uint32_t n_dims, if_accumulator_t *input,
+                       value_t *output, value_t *accumulator, void *params)
 {
   use(params);
+  value_t *in = input->retired;
+  const uint32_t clear = input->mask;
 
   // The None filter just copies its input to the output
   for (uint32_t d = 0; d < n_dims; d++)
   {
-    output[d] = input[d];
+    output[d] = _if_accumulator_take(&in[d], clear);
+    _if_accumulate(accumulator, d, output[d]);
   }
 }
 
@@ -39,13 +42,15 @@ void _none_filter_init(void *params, if_filter_t *filter, uint32_t size)
 /* 1st Order Low-Pass ********************************************************/
 typedef value_t_pair_t lowpass_state_t;
 
-void _lowpass_filter_step(uint32_t n_dims, value_t *input,
-                          value_t *output, void *pars)
+void _lowpass_filter_step(uint32_t n_dims, if_accumulator_t *input,
+                          value_t *output, value_t *accumulator, void *pars)
 {
   // Cast the params
   lowpass_state_t *params = (lowpass_state_t *) pars;
   register int32_t a = bitsk(params->a);
   register int32_t b = bitsk(params->b);
+  value_t *in = input->retired;
+  const uint32_t clear = input->mask;
 
   // Apply the filter to every dimension (realised as a Direct Form I digital
   // filter).
@@ -64,11 +69,12 @@ void _lowpass_filter_step(uint32_t n_dims, value_t *input,
     next_output = __smull(current_output, a);
 
     // Perform the multiply accumulate
-    int32_t current_input = bitsk(input[d]);
+    int32_t current_input = bitsk(_if_accumulator_take(&in[d], clear));
     next_output = __smlal(next_output, current_input, b);
 
     // Scale the result back down to store it
     output[d] = kbits(convert_s32_30_s16_15(next_output));
+    _if_accumulate(accumulator, d, output[d]);
   }
 }
 
@@ -115,11 +121,13 @@ typedef struct _lti_state_t
   uint32_t n;
 } lti_state_t;
 
-void _lti_filter_step(uint32_t n_dims, value_t *input,
-                      value_t *output, void *s)
+void _lti_filter_step(uint32_t n_dims, if_accumulator_t *input,
+                      value_t *output, value_t *accumulator, void *s)
 {
   // Cast the state
   lti_state_t *state = (lti_state_t *) s;
+  value_t *in = input->retired;
+  const uint32_t clear = input->mask;
 
   // Apply the filter to every dimension (realised as a Direct Form I digital
   // filter).
@@ -154,11 +162,12 @@ void _lti_filter_step(uint32_t n_dims, value_t *input,
     }
 
     // Include the initial new input
-    xy[state->n].b = input[dd];
+    xy[state->n].b = _if_accumulator_take(&in[dd], clear);
 
     // Save the current output for later steps
     output[dd] = kbits(convert_s32_30_s16_15(output_val));
     xy[state->n].a = output[dd];
+    _if_accumulate(accumulator, dd, output[dd]);
   }
 
   // Rotate the ring buffer by moving the starting pointer, if the starting
@@ -169,18 +178,222 @@ void _lti_filter_step(uint32_t n_dims, value_t *input,
   }
 }
 
+/* Fixed order LTI implementations ******************************************/
+/* Direct Form I implementations for second and third order linear filters
+ * (e.g., alpha and double-exponential synapses).  The coefficients are held in
+ * registers and the historic values are stored as separate arrays (one per
+ * delay) rather than as a ring buffer, so the inner loop contains no branches
+ * or modulo arithmetic.  Two dimensions are processed on each iteration of the
+ * loop.
+ */
+typedef struct _lti2_state_t
+{
+  ab_t abs[2];    // Filter coefficients (as for `lti_state_t`)
+  value_t *y[2];  // Outputs from 1 and 2 steps ago
+  value_t *x[2];  // Inputs from 1 and 2 steps ago
+} lti2_state_t;
+
+void _lti2_filter_step(uint32_t n_dims, if_accumulator_t *input,
+                       value_t *output, value_t *accumulator, void *s)
+{
+  // Cast the state
+  lti2_state_t *state = (lti2_state_t *) s;
+  value_t *in = input->retired;
+  const uint32_t clear = input->mask;
+  value_t *y1 = state->y[0], *y2 = state->y[1];
+  value_t *x1 = state->x[0], *x2 = state->x[1];
+
+  // Load the coefficients into registers
+  register int32_t a1 = bitsk(state->abs[0].a);
+  register int32_t b1 = bitsk(state->abs[0].b);
+  register int32_t a2 = bitsk(state->abs[1].a);
+  register int32_t b2 = bitsk(state->abs[1].b);
+
+  // Apply the filter to pairs of dimensions
+  uint32_t d = 0;
+  for (; d + 1 < n_dims; d += 2)
+  {
+    // Equivalent to:
+    //     output[d] = a1*y1[d] + a2*y2[d] + b1*x1[d] + b2*x2[d];
+    register int64_t p = __smull(a1, bitsk(y1[d]));
+    register int64_t q = __smull(a1, bitsk(y1[d + 1]));
+    p = __smlal(p, a2, bitsk(y2[d]));
+    q = __smlal(q, a2, bitsk(y2[d + 1]));
+    p = __smlal(p, b1, bitsk(x1[d]));
+    q = __smlal(q, b1, bitsk(x1[d + 1]));
+    p = __smlal(p, b2, bitsk(x2[d]));
+    q = __smlal(q, b2, bitsk(x2[d + 1]));
+
+    // Shift the historic values along
+    y2[d] = y1[d];
+    y2[d + 1] = y1[d + 1];
+    x2[d] = x1[d];
+    x2[d + 1] = x1[d + 1];
+    x1[d] = _if_accumulator_take(&in[d], clear);
+    x1[d + 1] = _if_accumulator_take(&in[d + 1], clear);
+
+    // Save the outputs
+    output[d] = y1[d] = kbits(convert_s32_30_s16_15(p));
+    output[d + 1] = y1[d + 1] = kbits(convert_s32_30_s16_15(q));
+    _if_accumulate(accumulator, d, output[d]);
+    _if_accumulate(accumulator, d + 1, output[d + 1]);
+  }
+
+  // Apply the filter to the final dimension, if there is one
+  if (d < n_dims)
+  {
+    register int64_t p = __smull(a1, bitsk(y1[d]));
+    p = __smlal(p, a2, bitsk(y2[d]));
+    p = __smlal(p, b1, bitsk(x1[d]));
+    p = __smlal(p, b2, bitsk(x2[d]));
+
+    y2[d] = y1[d];
+    x2[d] = x1[d];
+    x1[d] = _if_accumulator_take(&in[d], clear);
+    output[d] = y1[d] = kbits(convert_s32_30_s16_15(p));
+    _if_accumulate(accumulator, d, output[d]);
+  }
+}
+
+typedef struct _lti3_state_t
+{
+  ab_t abs[3];    // Filter coefficients (as for `lti_state_t`)
+  value_t *y[3];  // Outputs from 1, 2 and 3 steps ago
+  value_t *x[3];  // Inputs from 1, 2 and 3 steps ago
+} lti3_state_t;
+
+void _lti3_filter_step(uint32_t n_dims, if_accumulator_t *input,
+                       value_t *output, value_t *accumulator, void *s)
+{
+  // Cast the state
+  lti3_state_t *state = (lti3_state_t *) s;
+  value_t *in = input->retired;
+  const uint32_t clear = input->mask;
+  value_t *y1 = state->y[0], *y2 = state->y[1], *y3 = state->y[2];
+  value_t *x1 = state->x[0], *x2 = state->x[1], *x3 = state->x[2];
+
+  // Load the coefficients into registers
+  register int32_t a1 = bitsk(state->abs[0].a);
+  register int32_t b1 = bitsk(state->abs[0].b);
+  register int32_t a2 = bitsk(state->abs[1].a);
+  register int32_t b2 = bitsk(state->abs[1].b);
+  register int32_t a3 = bitsk(state->abs[2].a);
+  register int32_t b3 = bitsk(state->abs[2].b);
+
+  // Apply the filter to pairs of dimensions
+  uint32_t d = 0;
+  for (; d + 1 < n_dims; d += 2)
+  {
+    register int64_t p = __smull(a1, bitsk(y1[d]));
+    register int64_t q = __smull(a1, bitsk(y1[d + 1]));
+    p = __smlal(p, a2, bitsk(y2[d]));
+    q = __smlal(q, a2, bitsk(y2[d + 1]));
+    p = __smlal(p, a3, bitsk(y3[d]));
+    q = __smlal(q, a3, bitsk(y3[d + 1]));
+    p = __smlal(p, b1, bitsk(x1[d]));
+    q = __smlal(q, b1, bitsk(x1[d + 1]));
+    p = __smlal(p, b2, bitsk(x2[d]));
+    q = __smlal(q, b2, bitsk(x2[d + 1]));
+    p = __smlal(p, b3, bitsk(x3[d]));
+    q = __smlal(q, b3, bitsk(x3[d + 1]));
+
+    // Shift the historic values along
+    y3[d] = y2[d];
+    y3[d + 1] = y2[d + 1];
+    y2[d] = y1[d];
+    y2[d + 1] = y1[d + 1];
+    x3[d] = x2[d];
+    x3[d + 1] = x2[d + 1];
+    x2[d] = x1[d];
+    x2[d + 1] = x1[d + 1];
+    x1[d] = _if_accumulator_take(&in[d], clear);
+    x1[d + 1] = _if_accumulator_take(&in[d + 1], clear);
+
+    // Save the outputs
+    output[d] = y1[d] = kbits(convert_s32_30_s16_15(p));
+    output[d + 1] = y1[d + 1] = kbits(convert_s32_30_s16_15(q));
+    _if_accumulate(accumulator, d, output[d]);
+    _if_accumulate(accumulator, d + 1, output[d + 1]);
+  }
+
+  // Apply the filter to the final dimension, if there is one
+  if (d < n_dims)
+  {
+    register int64_t p = __smull(a1, bitsk(y1[d]));
+    p = __smlal(p, a2, bitsk(y2[d]));
+    p = __smlal(p, a3, bitsk(y3[d]));
+    p = __smlal(p, b1, bitsk(x1[d]));
+    p = __smlal(p, b2, bitsk(x2[d]));
+    p = __smlal(p, b3, bitsk(x3[d]));
+
+    y3[d] = y2[d];
+    y2[d] = y1[d];
+    x3[d] = x2[d];
+    x2[d] = x1[d];
+    x1[d] = _if_accumulator_take(&in[d], clear);
+    output[d] = y1[d] = kbits(convert_s32_30_s16_15(p));
+    _if_accumulate(accumulator, d, output[d]);
+  }
+}
+
 struct _lti_filter_init_params
 {
   uint32_t order;
   value_t data;  // Array of parameters 2*order longer (a[...] || b[...])
 };
 
+/* Initialise the state of a fixed order LTI filter.  `abs` should point to
+ * storage for `order` coefficient pairs, `y` and `x` to `order` pointers which
+ * will be set to zeroed arrays of `size` elements.
+ */
+static void _lti_fixed_filter_init(struct _lti_filter_init_params *params,
+                                   uint32_t size, ab_t *abs,
+                                   value_t **y, value_t **x)
+{
+  debug(">> LTI Filter of fixed order %d", params->order);
+
+  // Copy the parameters across
+  spin1_memcpy(abs, &params->data, sizeof(ab_t) * params->order);
+
+  // Malloc space for all of the historic values and zero it
+  value_t *values;
+  MALLOC_OR_DIE(values, sizeof(value_t) * 2 * params->order * size);
+  memset(values, 0, sizeof(value_t) * 2 * params->order * size);
+
+  // Split the space between the arrays of historic values
+  for (uint32_t k = 0; k < params->order; k++)
+  {
+    y[k] = &values[k * size];
+    x[k] = &values[(params->order + k) * size];
+  }
+}
+
 void _lti_filter_init(void *p, if_filter_t *filter, uint32_t size)
 {
   // Cast the parameters block
   struct _lti_filter_init_params *params = \
     (struct _lti_filter_init_params *) p;
 
+  // Use a specially optimised filter if one exists for this order
+  if (params->order == 2)
+  {
+    MALLOC_OR_DIE(filter->state, sizeof(lti2_state_t));
+    lti2_state_t *state = (lti2_state_t *) filter->state;
+    _lti_fixed_filter_init(params, size, state->abs, state->y, state->x);
+
+    filter->step = _lti2_filter_step;
+    return;
+  }
+  else if (params->order == 3)
+  {
+    MALLOC_OR_DIE(filter->state, sizeof(lti3_state_t));
+    lti3_state_t *state = (lti3_state_t *) filter->state;
+    _lti_fixed_filter_init(params, size, state->abs, state->y, state->x);
+
+    filter->step = _lti3_filter_step;
+    return;
+  }
+
   // Malloc space for the parameters
   MALLOC_OR_DIE(filter->state, sizeof(lti_state_t));
 
@@ -210,8 +423,8 @@ void _lti_filter_init(void *p, if_filter_t *filter, uint32_t size)
   state->n = 0;
   memset(state->xyz, 0, sizeof(ab_t) * size * state->order);
 
-  // Store a reference to the correct step function for the filter.  Insert any
-  // specially optimised filters here.
+  // Store a reference to the step function for the filter.  Specially
+  // optimised filters are selected at the start of this function.
   filter->step = _lti_filter_step;
 }
 
@@ -253,6 +466,90 @@ void input_filtering_get_routes(if_collection_t *filters, uint32_t *routes)
               filters->routes[n].input_index);
   }
 #endif
+
+  // Build the lookup table for the collection on its own
+  if_lookup_source_t source = {filters, 0, UINT32_MAX};
+  input_filtering_build_lookup(&filters->lookup, 1, &source);
+}
+
+/* Build a lookup table from the routes of several collections.
+ */
+void input_filtering_build_lookup(if_lookup_t *lookup, uint32_t n_sources,
+                                  const if_lookup_source_t *sources)
+{
+  // Count the total number of routes
+  uint32_t n_routes = 0;
+  for (uint32_t s = 0; s < n_sources; s++)
+  {
+    n_routes += sources[s].collection->n_routes;
+  }
+
+  // Malloc sufficient room for the entries
+  MALLOC_OR_DIE(lookup->routes, n_routes * sizeof(if_lookup_route_t));
+
+  // Resolve each route to the filter it targets and insert it into the table
+  // such that the table is sorted by mask and then by key.  Insertion sort is
+  // sufficient as this is performed once at load time and tables are small.
+  uint32_t n = 0;
+  for (uint32_t s = 0; s < n_sources; s++)
+  {
+    if_collection_t *collection = sources[s].collection;
+
+    for (uint32_t r = 0; r < collection->n_routes; r++)
+    {
+      if_route_t route = collection->routes[r];
+      if_lookup_route_t entry = {
+        route.key, route.mask, route.dimension_mask,
+        sources[s].dim_offset, sources[s].max_dim_sub_one,
+        &collection->filters[route.input_index],
+      };
+
+      // Shift along any entries which should follow the new one
+      uint32_t i = n++;
+      for (; i > 0; i--)
+      {
+        if_lookup_route_t *prev = &lookup->routes[i - 1];
+        if (prev->mask < entry.mask ||
+            (prev->mask == entry.mask && prev->key <= entry.key))
+        {
+          break;
+        }
+        lookup->routes[i] = *prev;
+      }
+      lookup->routes[i] = entry;
+    }
+  }
+
+  // Count the number of distinct masks
+  lookup->n_groups = 0;
+  for (uint32_t r = 0; r < n_routes; r++)
+  {
+    if (r == 0 || lookup->routes[r].mask != lookup->routes[r - 1].mask)
+    {
+      lookup->n_groups++;
+    }
+  }
+
+  // Build the groups of routes which share a mask
+  MALLOC_OR_DIE(lookup->groups, lookup->n_groups * sizeof(if_lookup_group_t));
+  for (uint32_t r = 0, g = 0; r < n_routes; r++)
+  {
+    if (r == 0 || lookup->routes[r].mask != lookup->routes[r - 1].mask)
+    {
+      lookup->groups[g].mask = lookup->routes[r].mask;
+      lookup->groups[g].n_routes = 0;
+      lookup->groups[g].routes = &lookup->routes[r];
+
+      // The first entry is trivially the result of searching for its key
+      lookup->groups[g].cached_key = lookup->routes[r].key;
+      lookup->groups[g].cached_index = 0;
+      g++;
+    }
+    lookup->groups[g - 1].n_routes++;
+  }
+
+  debug("Built lookup of %d routes in %d groups\n",
+        n_routes, lookup->n_groups);
 }
 
 // Filter specification flags
@@ -304,12 +601,22 @@ void input_filtering_get_filters(if_collection_t *filters, uint32_t *data,
 
     debug("> Filter [%d] size = %d\n", f, params->size);
 
-    // Initialise the input accumulator
-    MALLOC_OR_DIE(filters->filters[f].input, sizeof(if_accumulator_t));
-    MALLOC_OR_DIE(filters->filters[f].input->value,
-                  sizeof(value_t)*params->size);
-    filters->filters[f].input->mask = (params->flags & (1 << LATCHING)) ?
-                                      0x00000000 : 0xffffffff;
+    // Initialise the input accumulator, latching accumulators are never
+    // cleared so they may share a single buffer.
+    if_accumulator_t *input;
+    MALLOC_OR_DIE(input, sizeof(if_accumulator_t));
+    filters->filters[f].input = input;
+    MALLOC_OR_DIE(input->value, sizeof(value_t)*params->size);
+    if (params->flags & (1 << LATCHING))
+    {
+      input->mask = 0x00000000;
+      input->retired = input->value;
+    }
+    else
+    {
+      input->mask = 0xffffffff;
+      MALLOC_OR_DIE(input->retired, sizeof(value_t)*params->size);
+    }
 
     // If no filter output array is specified, allocate new vector
     if(filter_output_array == NULL)
@@ -324,8 +631,8 @@ void input_filtering_get_filters(if_collection_t *filters, uint32_t *data,
     }
 
     // Zero the input and the output
-    memset(filters->filters[f].input->value, 0,
-           sizeof(value_t) * params->size);
+    memset(input->value, 0, sizeof(value_t) * params->size);
+    memset(input->retired, 0, sizeof(value_t) * params->size);
     memset(filters->filters[f].output, 0, sizeof(value_t) * params->size);
 
     // Initialise the filter itself
@@ -351,7 +658,8 @@ void input_filtering_initialise_output(if_collection_t *filters,
   filters->output_size = n_dimensions;
 
   // If the output size is zero then don't allocate an accumulator, otherwise
-  // malloc sufficient space.
+  // malloc sufficient space.  The accumulator is zeroed here as it is not
+  // zeroed on every step (see `input_filtering_step`).
   if (n_dimensions == 0)
   {
     filters->output = NULL;
@@ -359,5 +667,6 @@ void input_filtering_initialise_output(if_collection_t *filters,
   else
   {
     MALLOC_OR_DIE(filters->output, sizeof(value_t) * n_dimensions);
+    memset(filters->output, 0, sizeof(value_t) * n_dimensions);
   }
 }
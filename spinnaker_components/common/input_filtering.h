@@ -23,7 +23,9 @@
  * packets are received their keys are used to determine to which input buffer
  * they should be added and to which component of these buffers.  This routing
  * is performed by accessing a list of `if_route_t`s and from this extracting
- * the index of the input vector and component.
+ * the index of the input vector and component.  At load time the routes are
+ * grouped by mask and sorted by key (`if_lookup_t`) so that this search may
+ * be performed with a binary search rather than a linear scan.
  *
  * (2) Applying filters
  * --------------------
@@ -31,9 +33,10 @@
  * Each filter has an input vector, an output vector and some filter-specific
  * state.  This is encapsulated in `if_filter_t`.  A filter can be simulated by
  * calling `_if_filter_step`, this will update the output vector and (if
- * necessary) reset the input vector so that it can accumulate new values.  The
- * specific function called to apply the filter is stored internally in the
- * filter.
+ * necessary) reset the input vector so that it can accumulate new values.
+ * Input vectors are double-buffered so that interrupts need only be disabled
+ * while the buffers are swapped.  The specific function called to apply the
+ * filter is stored internally in the filter.
  *
  * (3) Combining the output of multiple filters
  * --------------------------------------------
@@ -47,27 +50,75 @@
  *  - `input_filtering_step_no_accumulate` can be used to apply all input
  *     filters but to not combine their outputs into a single vector.
  *
+ *  - `input_filtering_input_lookup` can be used to include the value of a
+ *     packet in the filters of several collections at once.
+ *  - `input_filtering_input_batch` (and `input_filtering_input_lookup_batch`)
+ *     can be used to include the values of many packets at once.
+ *
  *  - `input_filtering_get_routes` will instantiate a filter routing table
+ *  - `input_filtering_build_lookup` will merge the routing tables of several
+ *     collections
  *  - `input_filtering_get_filters` will instantiate the filters
  */
 
 #include "common-typedefs.h"
 #include "nengo-common.h"
 #include "nengo_typedefs.h"
+#include "packet_queue.h"
 
 #ifndef __INPUT_FILTERING_H__
 #define __INPUT_FILTERING_H__
 
-typedef void (*FilterStep)(uint32_t, value_t*, value_t*, void*);
-
 /* An input accumulator.
+ *
+ * Non-latching accumulators are double-buffered: packets are accumulated into
+ * `value` while the filter reads (and clears) `retired`, the buffers are
+ * swapped at the start of every filter step.  Latching accumulators are never
+ * cleared so both pointers refer to the same buffer.
  */
 typedef struct _if_accumulator_t
 {
-  value_t *value;  // Value of the accumulator
-  uint32_t mask;   // Mask used to make the accumulator latching or otherwise
+  value_t *value;    // Buffer into which input is accumulated
+  value_t *retired;  // Buffer read by the filter (may be the same as `value`)
+  uint32_t mask;     // Mask used to make the accumulator latching or otherwise
 } if_accumulator_t;
 
+/* A filter step function.
+ *
+ * Filters the given number of dimensions of the retired buffer of the input
+ * accumulator into the output vector, clearing the buffer (as indicated by
+ * the mask) as it is read.  If the accumulator is not NULL then the output of
+ * the filter is also added to it.
+ */
+typedef void (*FilterStep)(uint32_t n_dims, if_accumulator_t *input,
+                           value_t *output, value_t *accumulator,
+                           void *state);
+
+/* Read an element of the retired buffer of an input accumulator and clear it
+ * if the accumulator is not latching.  `clear` should be the accumulator's
+ * mask.  Latching buffers are left untouched as they may be receiving packets
+ * while they are read.
+ */
+static inline value_t _if_accumulator_take(value_t *value, uint32_t clear)
+{
+  value_t current = *value;
+  if (clear)
+  {
+    *value = 0.0k;
+  }
+  return current;
+}
+
+/* Add an element of a filter's output to an (optional) accumulator. */
+static inline void _if_accumulate(value_t *accumulator, uint32_t dimension,
+                                  value_t value)
+{
+  if (accumulator != NULL)
+  {
+    accumulator[dimension] += value;
+  }
+}
+
 /* A pair of input and output which are are joined by a filter function. */
 typedef struct _if_filter_t
 {
@@ -93,26 +144,26 @@ static inline void _if_filter_input(if_filter_t *filter,
     value;
 }
 
-/* Simulate one step of a filter and reset its accumulator if necessary */
-static inline void _if_filter_step(if_filter_t* filter)
+/* Simulate one step of a filter and reset its accumulator if necessary.  If
+ * `accumulator` is not NULL the output of the filter is added to it.
+ */
+static inline void _if_filter_step(if_filter_t* filter, value_t *accumulator)
 {
-  // Disable interrupts to avoid a race condition
-  uint32_t cpsr = spin1_fiq_disable();
-
-  // Apply the simulation step
-  filter->step(filter->size, filter->input->value,
-               filter->output, filter->state);
+  if_accumulator_t *input = filter->input;
 
-  // Apply the input accumulator step.  The mask will either set the
-  // accumulator to zero or will leave it at its current value.
-  for (uint32_t n = 0; n < filter->size; n++)
-  {
-    filter->input->value[n] = kbits(bitsk(filter->input->value[n]) &
-                                    ~filter->input->mask);
-  }
-
-  // Re-enable interrupts
+  // Swap the input buffers so that packets may continue to be accumulated
+  // while the filter is applied, interrupts are disabled only for the swap to
+  // avoid a race condition.
+  uint32_t cpsr = spin1_fiq_disable();
+  value_t *retired = input->value;
+  input->value = input->retired;
+  input->retired = retired;
   spin1_mode_restore(cpsr);
+
+  // Apply the simulation step, this also clears the retired buffer if the
+  // input is not latching.
+  filter->step(filter->size, input, filter->output, accumulator,
+               filter->state);
 }
 
 /* A pseudo routing table entry which can be used to determine which input a
@@ -128,6 +179,50 @@ typedef struct _if_route_t
   uint32_t input_index; // Index of the input add the packet to
 } if_route_t;
 
+/* A routing entry which has been resolved to the filter it targets.  Entries
+ * of this type are built once at load time so that the routes of one or more
+ * collections can be searched without walking every `if_route_t`.
+ */
+typedef struct _if_lookup_route_t
+{
+  uint32_t key;             // Key against which to compare the received packet
+  uint32_t mask;            // Mask against which to compare the received packet
+  uint32_t dimension_mask;  // Mask to extract the index of the component
+
+  uint32_t dim_offset;       // Subtracted from the index of the component
+  uint32_t max_dim_sub_one;  // Largest (offset) index accepted by the route
+
+  if_filter_t *filter;  // Filter to which the packet should be added
+} if_lookup_route_t;
+
+/* A run of lookup entries which share the same mask, sorted by key. */
+typedef struct _if_lookup_group_t
+{
+  uint32_t mask;              // Mask shared by all entries in the group
+  uint32_t n_routes;          // Number of entries in the group
+  if_lookup_route_t *routes;  // Entries, in ascending order of key
+
+  // Result of the last search of the group.  Consecutive packets commonly
+  // share a routing key (differing only in dimension) so this allows most
+  // searches to be skipped.
+  uint32_t cached_key;    // Last masked key searched for
+  uint32_t cached_index;  // Index of the first entry not less than the key
+} if_lookup_group_t;
+
+/* A lookup table built from the routes of one or more collections.
+ *
+ * Routes are grouped by mask and each group is sorted by key, so a packet may
+ * be matched against a group with a binary search.  There are typically very
+ * few distinct masks so this reduces the cost of routing a packet from
+ * O(n_routes) to O(n_masks * log(n_routes)).
+ */
+typedef struct _if_lookup_t
+{
+  uint32_t n_groups;          // Number of distinct masks
+  if_lookup_group_t *groups;  // Groups of routes sharing a mask
+  if_lookup_route_t *routes;  // Storage for all entries (grouped, sorted)
+} if_lookup_t;
+
 /* A collection of filters which share routing information (and possibly an
  * accumulated output value).
  */
@@ -138,50 +233,95 @@ typedef struct _if_collection_t
   uint32_t n_routes;   // Number of routing entries
   if_filter_t *filters;  // Filters
   if_route_t *routes;    // Packet to filter routes
+  if_lookup_t lookup;    // Sorted form of the routes
 
   // Optional components
   uint32_t output_size;  // Size of output vector (may be 0)
   value_t *output;       // Output vector (may be NULL)
 } if_collection_t;
 
-/* Include the value of a packet in a filter's input after first subtracting an
- * offset from the packet's index and ensuring that the packet is within a
- * certain range of dimensions.  Returns true if the packet matched any routing
- * entries, otherwise returns false.
+/* Description of a collection to include in a (merged) lookup table. */
+typedef struct _if_lookup_source_t
+{
+  if_collection_t *collection;  // Collection whose routes should be included
+  uint32_t dim_offset;          // Offset to subtract from packet dimensions
+  uint32_t max_dim_sub_one;     // Largest offset dimension to accept
+} if_lookup_source_t;
+
+/* Get the index of the first entry in a group whose key is not less than the
+ * given masked key.
+ */
+static inline uint32_t _if_lookup_group_find(if_lookup_group_t *group,
+                                             uint32_t masked_key)
+{
+  if (masked_key != group->cached_key)
+  {
+    // Binary search for the first entry whose key is not less than the masked
+    // key.
+    uint32_t lo = 0, hi = group->n_routes;
+    while (lo < hi)
+    {
+      const uint32_t mid = (lo + hi) >> 1;
+      if (group->routes[mid].key < masked_key)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+
+    // Store the result for subsequent packets
+    group->cached_key = masked_key;
+    group->cached_index = lo;
+  }
+
+  return group->cached_index;
+}
+
+/* Include the value of a packet in the inputs of all filters indicated by a
+ * lookup table after first subtracting an offset from the packet's index and
+ * ensuring that the packet is within a certain range of dimensions.  Returns
+ * true if the packet matched any routing entries, otherwise returns false.
  *
- * `dim_offset` is subtracted from the dimension reported by the packet.  If
- * the result is less than or equal to `max_dim_sub_one` then the packet is
- * handled as normal, otherwise it is deemed to have not matched the route.
+ * The offset and range given here are applied in addition to those stored in
+ * each entry of the lookup table.
  */
-static inline bool input_filtering_input_with_dimension_offset(
-    if_collection_t* filters, uint32_t key, uint32_t payload,
+static inline bool _if_lookup_input(
+    if_lookup_t *lookup, uint32_t key, uint32_t payload,
     uint32_t dim_offset, uint32_t max_dim_sub_one
 )
 {
   bool handled = false;
 
-  // Look at all the routing entries, if we match an entry then include the
-  // packet in the indicated input vector.
-  for (uint32_t n = 0; n < filters->n_routes; n++)
+  // Search each group of routes which share a mask in turn
+  for (uint32_t g = 0; g < lookup->n_groups; g++)
   {
-    // Get the routing entry and the filter referred to by the entry
-    if_route_t route = filters->routes[n];
-    if_filter_t *filter = &filters->filters[route.input_index];
+    if_lookup_group_t *group = &lookup->groups[g];
+    const uint32_t masked_key = key & group->mask;
 
-    if ((key & route.mask) == route.key)
+    // Several filters may receive the same packet, so include the packet in
+    // every entry with a matching key.
+    for (uint32_t r = _if_lookup_group_find(group, masked_key);
+         r < group->n_routes && group->routes[r].key == masked_key; r++)
     {
+      const if_lookup_route_t *route = &group->routes[r];
+
       // Get the dimension of the packet
-      // NOTE: if offset is 0 then the subtraction will be optimised out.
-      const uint32_t dim = (key & route.dimension_mask) - dim_offset;
+      // NOTE: if the offsets are 0 then the subtractions will be optimised
+      // out.
+      const uint32_t dim = (key & route->dimension_mask) -
+                           route->dim_offset - dim_offset;
 
       // NOTE: If max_dim_sub_one is UINT32_MAX then the CMP is optimised out
       // as all packets will match.
-      if (dim <= max_dim_sub_one)
+      if (dim <= route->max_dim_sub_one && dim <= max_dim_sub_one)
       {
         // The packet matches this entry and is in the range of dimensions
         // expected; include the contribution from the packet and indicate that
         // we have handled the packet.
-        _if_filter_input(filter, dim, kbits(payload));
+        _if_filter_input(route->filter, dim, kbits(payload));
         handled = true;
       }
     }
@@ -190,6 +330,125 @@ static inline bool input_filtering_input_with_dimension_offset(
   return handled;
 }
 
+/* Maximum number of resolved accumulator updates held by a batch. */
+#define IF_INPUT_BATCH_LENGTH 32
+
+/* An accumulator update which has been resolved from a received packet. */
+typedef struct _if_input_t
+{
+  value_t *value;        // Accumulator element to update
+  uint32_t mask;         // Mask of the accumulator
+  value_t contribution;  // Value to include in the accumulator
+} if_input_t;
+
+/* Apply a set of resolved accumulator updates. */
+static inline void _if_inputs_apply(uint32_t n_inputs, if_input_t *inputs)
+{
+  for (uint32_t i = 0; i < n_inputs; i++)
+  {
+    *inputs[i].value = kbits(bitsk(*inputs[i].value) & inputs[i].mask) +
+                       inputs[i].contribution;
+  }
+}
+
+/* Include the values of a batch of packets in the inputs of all filters
+ * indicated by a lookup table.  Returns the number of packets which matched
+ * any routing entries.
+ *
+ * Every packet is first resolved to the accumulator elements it should update
+ * (updates to the same element by consecutive packets are combined) and then
+ * all the updates are applied in a single tight loop.  The offset and range
+ * are as for `_if_lookup_input`.
+ */
+static inline uint32_t _if_lookup_input_batch(
+    if_lookup_t *lookup, uint32_t n_packets, const packet_t *packets,
+    uint32_t dim_offset, uint32_t max_dim_sub_one
+)
+{
+  if_input_t inputs[IF_INPUT_BATCH_LENGTH];
+  uint32_t n_inputs = 0;
+  uint32_t n_handled = 0;
+
+  for (uint32_t p = 0; p < n_packets; p++)
+  {
+    const uint32_t key = packets[p].key;
+    const value_t contribution = kbits(packets[p].payload);
+    bool handled = false;
+
+    // Search each group of routes which share a mask in turn
+    for (uint32_t g = 0; g < lookup->n_groups; g++)
+    {
+      if_lookup_group_t *group = &lookup->groups[g];
+      const uint32_t masked_key = key & group->mask;
+
+      for (uint32_t r = _if_lookup_group_find(group, masked_key);
+           r < group->n_routes && group->routes[r].key == masked_key; r++)
+      {
+        const if_lookup_route_t *route = &group->routes[r];
+        const uint32_t dim = (key & route->dimension_mask) -
+                             route->dim_offset - dim_offset;
+
+        if (dim <= route->max_dim_sub_one && dim <= max_dim_sub_one)
+        {
+          if_accumulator_t *input = route->filter->input;
+          value_t *value = &input->value[dim];
+          handled = true;
+
+          if (n_inputs > 0 && inputs[n_inputs - 1].value == value)
+          {
+            // Combine with the previous update of the same element, the mask
+            // ensures that latching inputs retain only the newest value.
+            if_input_t *last = &inputs[n_inputs - 1];
+            last->contribution = kbits(bitsk(last->contribution) &
+                                       input->mask) + contribution;
+            continue;
+          }
+
+          // Apply the pending updates if there is no more room
+          if (n_inputs == IF_INPUT_BATCH_LENGTH)
+          {
+            _if_inputs_apply(n_inputs, inputs);
+            n_inputs = 0;
+          }
+
+          inputs[n_inputs].value = value;
+          inputs[n_inputs].mask = input->mask;
+          inputs[n_inputs].contribution = contribution;
+          n_inputs++;
+        }
+      }
+    }
+
+    if (handled)
+    {
+      n_handled++;
+    }
+  }
+
+  // Apply any remaining updates
+  _if_inputs_apply(n_inputs, inputs);
+
+  return n_handled;
+}
+
+/* Include the value of a packet in a filter's input after first subtracting an
+ * offset from the packet's index and ensuring that the packet is within a
+ * certain range of dimensions.  Returns true if the packet matched any routing
+ * entries, otherwise returns false.
+ *
+ * `dim_offset` is subtracted from the dimension reported by the packet.  If
+ * the result is less than or equal to `max_dim_sub_one` then the packet is
+ * handled as normal, otherwise it is deemed to have not matched the route.
+ */
+static inline bool input_filtering_input_with_dimension_offset(
+    if_collection_t* filters, uint32_t key, uint32_t payload,
+    uint32_t dim_offset, uint32_t max_dim_sub_one
+)
+{
+  return _if_lookup_input(&filters->lookup, key, payload,
+                          dim_offset, max_dim_sub_one);
+}
+
 /* Include the value of a packet in a filter's input.  Returns true if the
  * packet matched any routing entries, otherwise returns false.
  */
@@ -204,6 +463,55 @@ static inline bool input_filtering_input(
   );
 }
 
+/* Include the values of a batch of packets in filters' inputs after first
+ * subtracting an offset from each packet's index and ensuring that the packet
+ * is within a certain range of dimensions.  Returns the number of packets
+ * which matched any routing entries.
+ */
+static inline uint32_t input_filtering_input_batch_with_dimension_offset(
+    if_collection_t* filters, uint32_t n_packets, const packet_t *packets,
+    uint32_t dim_offset, uint32_t max_dim_sub_one
+)
+{
+  return _if_lookup_input_batch(&filters->lookup, n_packets, packets,
+                                dim_offset, max_dim_sub_one);
+}
+
+/* Include the values of a batch of packets in filters' inputs.  Returns the
+ * number of packets which matched any routing entries.
+ */
+static inline uint32_t input_filtering_input_batch(
+    if_collection_t* filters, uint32_t n_packets, const packet_t *packets
+)
+{
+  return input_filtering_input_batch_with_dimension_offset(
+    filters, n_packets, packets, 0, UINT32_MAX
+  );
+}
+
+/* Include the values of a batch of packets in the inputs of all filters
+ * indicated by a (merged) lookup table.  Returns the number of packets which
+ * matched any routing entries.
+ */
+static inline uint32_t input_filtering_input_lookup_batch(
+    if_lookup_t *lookup, uint32_t n_packets, const packet_t *packets
+)
+{
+  return _if_lookup_input_batch(lookup, n_packets, packets, 0, UINT32_MAX);
+}
+
+/* Include the value of a packet in the inputs of all filters indicated by a
+ * (merged) lookup table.  Returns true if the packet matched any routing
+ * entries, otherwise returns false.
+ */
+static inline bool input_filtering_input_lookup(
+    if_lookup_t *lookup, uint32_t key, uint32_t payload
+)
+{
+  // The offsets and ranges stored in the lookup entries are sufficient.
+  return _if_lookup_input(lookup, key, payload, 0, UINT32_MAX);
+}
+
 /* Apply all filter steps but DO NOT accumulate their outputs. */
 static inline void input_filtering_step_no_accumulate(
     if_collection_t *filters)
@@ -213,36 +521,57 @@ static inline void input_filtering_step_no_accumulate(
   {
     // Get the filter and apply the step function
     if_filter_t *filter = &filters->filters[n - 1];
-    _if_filter_step(filter);
+    _if_filter_step(filter, NULL);
   }
 }
 
-/* Apply all filter steps and accumulate their outputs. */
+/* Apply all filter steps and accumulate their outputs.
+ *
+ * The output of the first filter overwrites the accumulated output, rather
+ * than the output being zeroed and then accumulated into, and the outputs of
+ * the remaining filters are added to it.  A collection with no filters
+ * retains the zeroed output it was initialised with.
+ */
 static inline void input_filtering_step(
     if_collection_t *filters)
 {
-  // Zero the accumulator, not using memset as this would entail a further
-  // function call.
+  if (filters->n_filters == 0)
+  {
+    return;
+  }
+
+  // Apply the step function of the first filter and copy its output into the
+  // accumulated output.
+  if_filter_t *first = &filters->filters[filters->n_filters - 1];
+  _if_filter_step(first, NULL);
   for (uint32_t d = filters->output_size; d > 0; d--)
   {
-    filters->output[d - 1] = 0.0k;
+    filters->output[d - 1] = first->output[d - 1];
   }
 
-  // Apply all of the filter step functions and accumulate the outputs of the
-  // filters.
-  for (uint32_t n = filters->n_filters; n > 0; n--)
+  // Apply the remaining filter step functions and accumulate the outputs of
+  // the filters.
+  for (uint32_t n = filters->n_filters - 1; n > 0; n--)
   {
-    // Get the filter and apply the step function
+    // Get the filter
     if_filter_t *filter = &filters->filters[n - 1];
-    _if_filter_step(filter);
 
-    // Get the filter output
-    value_t *output = filters->filters[n - 1].output;
-
-    // Include each dimension in turn
-    for (uint32_t d = filters->output_size; d > 0; d--)
+    if (filter->size == filters->output_size)
     {
-      filters->output[d - 1] += output[d - 1];
+      // Apply the step function, which will include the output of the filter
+      // in the accumulated output as it goes.
+      _if_filter_step(filter, filters->output);
+    }
+    else
+    {
+      // Apply the step function and then include each dimension in turn
+      _if_filter_step(filter, NULL);
+
+      value_t *output = filter->output;
+      for (uint32_t d = filters->output_size; d > 0; d--)
+      {
+        filters->output[d - 1] += output[d - 1];
+      }
     }
   }
 }
@@ -256,6 +585,18 @@ void input_filtering_get_routes(
     if_collection_t *filters,
     uint32_t *routes);
 
+/* Build a lookup table from the routes of several collections.
+ *
+ * Packets dispatched with the resulting table are included in the filters of
+ * every collection with a matching route, after the offset and range given
+ * for the collection have been applied.  The routes and filters of every
+ * collection must already have been loaded.
+ */
+void input_filtering_build_lookup(
+    if_lookup_t *lookup,
+    uint32_t n_sources,
+    const if_lookup_source_t *sources);
+
 /* Copy in a set of filters.
  *
  * The first word of `data` should indicate how many entries there are.  The
@@ -67,4 +67,18 @@ do { \
   } \
 } while (0)
 
+/* Start timer 2 counting down at the CPU clock rate (no clock divider),
+ * unless it is already running.  The profiler, the overrun detection and the
+ * transmit scheduler all measure time with timer 2; restarting it would
+ * corrupt the measurements of the others.
+ */
+static inline void timer2_start(void)
+{
+  if (!(tc[T2_CONTROL] & 0x80))
+  {
+    tc[T2_CONTROL] = 0x82;
+    tc[T2_LOAD] = 0;
+  }
+}
+
 #endif
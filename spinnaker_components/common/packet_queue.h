@@ -1,4 +1,15 @@
 /* Methods and structures required to handle a queue of packets.
+ *
+ * The queue is a single-producer/single-consumer ring buffer.  Packets are
+ * pushed by the multicast packet callback (the producer, which writes only the
+ * head) and popped by the queue processor (the consumer, which writes only the
+ * tail).  As each index is written by only one party neither pushing nor
+ * popping requires interrupts to be disabled, and packets are drained in the
+ * order in which they were received.
+ *
+ * The head and tail are free-running counters which are reduced modulo the
+ * length of the queue when accessing the buffer, consequently the length of
+ * the queue is always a power of two.
  */
 
 #ifndef __PACKET_QUEUE_H__
@@ -8,40 +19,78 @@
 #include <stdint.h>
 #include "nengo-common.h"
 
+// Default length of a packet queue (used if a length of 0 is requested)
 #define __PACKET_QUEUE_LENGTH 1024
 
+// Number of packets which should be popped from a queue at a time
+#define PACKET_QUEUE_BATCH_LENGTH 16
+
+// Prevent the compiler from reordering memory accesses across this point
+#define __packet_queue_barrier() __asm__ __volatile__ ("" ::: "memory")
+
 typedef struct
 {
   uint32_t key;
   uint32_t payload;
 } packet_t;
 
-// Packet queue structure (really a stack)
+// Packet queue structure
 typedef struct
 {
-  unsigned int current;                     // Current position in the queue
-  packet_t packets[__PACKET_QUEUE_LENGTH];  // The queue
+  uint32_t mask;           // Length of the queue less one
+  volatile uint32_t head;  // Count of packets pushed (written by producer)
+  volatile uint32_t tail;  // Count of packets popped (written by consumer)
+  packet_t *packets;       // The queue
 } packet_queue_t;
 
 
-// Create an initialise a packet queue
-static inline void packet_queue_init(packet_queue_t *queue)
+// Create and initialise a packet queue which can hold at least `length`
+// packets.
+static inline void packet_queue_init(packet_queue_t *queue, uint32_t length)
 {
+  // Round the length up to the next power of two
+  if (length == 0)
+  {
+    length = __PACKET_QUEUE_LENGTH;
+  }
+  uint32_t size = 1;
+  while (size < length)
+  {
+    size <<= 1;
+  }
+
+  // Allocate space for the queue
+  MALLOC_OR_DIE(queue->packets, size * sizeof(packet_t));
+  queue->mask = size - 1;
+
   // Store the current position
-  queue->current = 0;
+  queue->head = 0;
+  queue->tail = 0;
+}
+
+
+// Get the number of packets in the queue.
+static inline uint32_t packet_queue_length(const packet_queue_t *queue)
+{
+  return queue->head - queue->tail;
 }
 
 
-// Add a packet to the queue
+// Add a packet to the queue, this should only be called by the producer.
 static inline bool packet_queue_push(packet_queue_t *queue,
                                      uint32_t key, uint32_t payload)
 {
-  if (queue->current < __PACKET_QUEUE_LENGTH)
+  const uint32_t head = queue->head;
+
+  if (head - queue->tail <= queue->mask)
   {
-    // Add the packet to the queue if it isn't full
-    queue->packets[queue->current].key = key;
-    queue->packets[queue->current].payload = payload;
-    queue->current++;
+    // Add the packet to the queue if it isn't full, the packet must be written
+    // before the head is advanced to make it visible to the consumer.
+    packet_t *packet = &queue->packets[head & queue->mask];
+    packet->key = key;
+    packet->payload = payload;
+    __packet_queue_barrier();
+    queue->head = head + 1;
     return true;
   }
   else
@@ -53,17 +102,21 @@ static inline bool packet_queue_push(packet_queue_t *queue,
 
 
 // Pop a packet from the queue, returning true or false to indicate whether
-// this succeeded.
+// this succeeded.  This should only be called by the consumer.
 static inline bool packet_queue_pop(packet_queue_t *queue,
                                     packet_t *dest)
 {
-  if (queue->current > 0)
+  const uint32_t tail = queue->tail;
+
+  if (queue->head != tail)
   {
-    // Decrement the current index and then copy the key and payload to the
-    // destination.
-    queue->current--;
-    dest->key = queue->packets[queue->current].key;
-    dest->payload = queue->packets[queue->current].payload;
+    // Copy the key and payload to the destination and then advance the tail,
+    // the packet must be read before the slot is released to the producer.
+    const packet_t *packet = &queue->packets[tail & queue->mask];
+    dest->key = packet->key;
+    dest->payload = packet->payload;
+    __packet_queue_barrier();
+    queue->tail = tail + 1;
 
     return true;  // Indicate that a packet was popped
   }
@@ -75,10 +128,37 @@ static inline bool packet_queue_pop(packet_queue_t *queue,
 }
 
 
+// Pop up to `max_packets` packets from the queue, returning the number of
+// packets which were popped.  This should only be called by the consumer.
+static inline uint32_t packet_queue_pop_batch(packet_queue_t *queue,
+                                              packet_t *dest,
+                                              uint32_t max_packets)
+{
+  const uint32_t tail = queue->tail;
+
+  // Determine how many packets are available
+  uint32_t n_packets = queue->head - tail;
+  if (n_packets > max_packets)
+  {
+    n_packets = max_packets;
+  }
+
+  // Copy the packets out and then release all of their slots at once
+  for (uint32_t n = 0; n < n_packets; n++)
+  {
+    dest[n] = queue->packets[(tail + n) & queue->mask];
+  }
+  __packet_queue_barrier();
+  queue->tail = tail + n_packets;
+
+  return n_packets;
+}
+
+
 // Query if a queue is empty
 static inline bool packet_queue_not_empty(packet_queue_t *queue)
 {
-  return queue->current > 0;
+  return queue->head != queue->tail;
 }
 
 #endif  // __PACKET_QUEUE_H__
@@ -1,4 +1,50 @@
 #include "profiler.h"
+#include "nengo-common.h"
+
+//---------------------------------------
+// Counters
+//---------------------------------------
+profiler_counters_t profiler_counters;
+uint32_t profiler_counter_entered[PROFILER_N_COUNTERS];
+uint32_t profiler_tick_entered;
+
+static uint32_t *profiler_counters_region = NULL;
+
+//---------------------------------------
+static void profiler_counter_reset(profiler_counter_t *counter)
+{
+  counter->count = 0;
+  counter->min = UINT32_MAX;
+  counter->max = 0;
+  counter->sum_lo = 0;
+  counter->sum_hi = 0;
+}
+//---------------------------------------
+void profiler_counters_init(uint32_t *address)
+{
+  profiler_counters_region = address;
+
+  timer2_start();
+  profiler_counters_reset();
+}
+//---------------------------------------
+void profiler_counters_reset(void)
+{
+  profiler_counters.n_counters = PROFILER_N_COUNTERS;
+  profiler_counters.max_queue_length = 0;
+
+  profiler_counter_reset(&profiler_counters.tick);
+  for (uint32_t n = 0; n < PROFILER_N_COUNTERS; n++)
+  {
+    profiler_counter_reset(&profiler_counters.tags[n]);
+  }
+}
+//---------------------------------------
+void profiler_counters_finalise(void)
+{
+  spin1_memcpy(profiler_counters_region, &profiler_counters,
+               sizeof(profiler_counters_t));
+}
 
 #ifdef PROFILER_ENABLED
 
@@ -32,11 +78,10 @@ void profiler_init(uint32_t num_samples)
   // Initialize number of samples remaining
   profiler_samples_remaining = num_samples;
   
-  // If profiler is turned on, start timer 2 with no clock divider
+  // If profiler is turned on, start timer 2
   if(profiler_samples_remaining > 0)
   {
-    tc[T2_CONTROL] = 0x82;
-    tc[T2_LOAD] = 0;
+    timer2_start();
   }
 }
 
@@ -1,7 +1,9 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include <stdbool.h>
 #include "common-impl.h"
+#include "spin1_api.h"
 
 //---------------------------------------
 // Macros
@@ -10,9 +12,105 @@
 #define PROFILER_ENTER          (1 << 31)
 #define PROFILER_EXIT           0
 
-#ifdef PROFILER_ENABLED
+//---------------------------------------
+// Counters
+//---------------------------------------
+// Lightweight counters which are always available (regardless of whether
+// PROFILER_ENABLED is defined).  The number of T2 cycles spent in each tag
+// is accumulated (count, min, max and sum), as is the time taken to process
+// each timestep and the greatest length of the packet queue.  Overrunning
+// timesteps are counted by `tick_status.h`.  The counters are written to
+// SDRAM by `profiler_counters_finalise`.
 
-#include "spin1_api.h"
+// Number of tags for which counters are kept
+#define PROFILER_N_COUNTERS     8
+
+typedef struct _profiler_counter_t
+{
+  uint32_t count;   // Number of times the tag was exited
+  uint32_t min;     // Minimum cycles spent in the tag
+  uint32_t max;     // Maximum cycles spent in the tag
+  uint32_t sum_lo;  // Total cycles spent in the tag (low word)
+  uint32_t sum_hi;  // Total cycles spent in the tag (high word)
+} profiler_counter_t;
+
+typedef struct _profiler_counters_t
+{
+  uint32_t n_counters;        // Number of tag counters (as below)
+  uint32_t max_queue_length;  // Greatest length of the packet queue
+  profiler_counter_t tick;    // Cycles spent processing each timestep
+  profiler_counter_t tags[PROFILER_N_COUNTERS];
+} profiler_counters_t;
+
+extern profiler_counters_t profiler_counters;
+extern uint32_t profiler_counter_entered[PROFILER_N_COUNTERS];
+extern uint32_t profiler_tick_entered;
+
+// Prepare the counters, recording them into the given SDRAM region, starts
+// timer 2.
+void profiler_counters_init(uint32_t *address);
+
+// Reset the counters for a new period of simulation
+void profiler_counters_reset(void);
+
+// Write the counters into SDRAM
+void profiler_counters_finalise(void);
+
+static inline void _profiler_counter_add(profiler_counter_t *counter,
+                                         uint32_t cycles)
+{
+  counter->count++;
+  counter->min = (cycles < counter->min) ? cycles : counter->min;
+  counter->max = (cycles > counter->max) ? cycles : counter->max;
+
+  const uint32_t sum_lo = counter->sum_lo + cycles;
+  counter->sum_hi += (sum_lo < cycles) ? 1 : 0;  // Carry
+  counter->sum_lo = sum_lo;
+}
+
+// Update the counters on entry to or exit from a tag (T2 counts down)
+static inline void profiler_count_entry(uint32_t tag)
+{
+  const uint32_t now = tc[T2_COUNT];
+  const uint32_t n = tag & ~PROFILER_ENTER;
+
+  if (n < PROFILER_N_COUNTERS)
+  {
+    if (tag & PROFILER_ENTER)
+    {
+      profiler_counter_entered[n] = now;
+    }
+    else
+    {
+      _profiler_counter_add(&profiler_counters.tags[n],
+                            profiler_counter_entered[n] - now);
+    }
+  }
+}
+
+// Indicate that processing of a timestep has begun
+static inline void profiler_count_tick_start(void)
+{
+  profiler_tick_entered = tc[T2_COUNT];
+}
+
+// Indicate that processing of a timestep has been completed
+static inline void profiler_count_tick_end(void)
+{
+  _profiler_counter_add(&profiler_counters.tick,
+                        profiler_tick_entered - tc[T2_COUNT]);
+}
+
+// Count the current length of the packet queue
+static inline void profiler_count_queue_length(uint32_t length)
+{
+  if (length > profiler_counters.max_queue_length)
+  {
+    profiler_counters.max_queue_length = length;
+  }
+}
+
+#ifdef PROFILER_ENABLED
 
 //---------------------------------------
 // Externals
@@ -38,6 +136,8 @@ void profiler_init(uint32_t num_samples);
 //---------------------------------------
 static inline void profiler_write_entry(uint32_t tag)
 {
+  profiler_count_entry(tag);
+
   if(profiler_samples_remaining > 0)
   {
     *profiler_output++ = tc[T2_COUNT];
@@ -65,9 +165,9 @@ static inline void profiler_write_entry_disable_fiq(uint32_t tag)
 #define profiler_read_region(address) nop()
 #define profiler_finalise() nop()
 #define profiler_init(region_size) nop()
-#define profiler_write_entry(tag) nop()
-#define profiler_write_entry_disable_irq_fiq(tag) nop()
-#define profiler_write_entry_disable_fiq(tag) nop()
+#define profiler_write_entry(tag) profiler_count_entry(tag)
+#define profiler_write_entry_disable_irq_fiq(tag) profiler_count_entry(tag)
+#define profiler_write_entry_disable_fiq(tag) profiler_count_entry(tag)
 
 #endif  // PROFILER_ENABLED
 
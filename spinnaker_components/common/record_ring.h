@@ -0,0 +1,83 @@
+/* Circular recording of fixed-size frames which the host drains while the
+ * simulation is running.
+ *
+ * The ring starts with a header (see `record_ring_header_t`) followed by the
+ * frames.  Each frame starts with the index of the sample it contains
+ * (counted from the start of each period of simulation) so that the host can
+ * place the samples correctly even if some were dropped.  Frames are dropped,
+ * and counted, rather than overwriting frames which the host has not yet
+ * read.
+ */
+
+#ifndef __RECORD_RING_H__
+#define __RECORD_RING_H__
+
+#include "nengo-common.h"
+
+typedef struct _record_ring_header_t
+{
+  uint32_t n_frames;     // Number of frames in the ring (written by the host)
+  uint32_t n_written;    // Frames written in total (written by the core)
+  uint32_t n_read;       // Frames read in total (written by the host)
+  uint32_t n_overflows;  // Frames dropped as the ring was full
+} record_ring_header_t;
+
+typedef struct _record_ring_t
+{
+  volatile record_ring_header_t *header;  // Header in SDRAM
+  uint32_t *frames;       // Start of the frames in SDRAM
+  uint32_t frame_words;   // Words of data in each frame (excluding the index)
+
+  uint32_t *_next;        // Next frame to write
+  uint32_t _n_samples;    // Samples taken in this period of simulation
+} record_ring_t;
+
+/* Prepare a ring recording region with frames of the given number of words
+ * of data.
+ */
+static inline void record_ring_initialise(record_ring_t *ring,
+                                          address_t region,
+                                          uint32_t frame_words)
+{
+  ring->header = (volatile record_ring_header_t *) region;
+  ring->frames = region + sizeof(record_ring_header_t) / sizeof(uint32_t);
+  ring->frame_words = frame_words;
+}
+
+/* Prepare the ring for a new period of simulation, the host clears the
+ * header before each period of simulation.
+ */
+static inline void record_ring_reset(record_ring_t *ring)
+{
+  ring->_next = ring->frames;
+  ring->_n_samples = 0;
+}
+
+/* Append a sample to the ring, or drop it if the ring is full.
+ */
+static inline void record_ring_write(record_ring_t *ring, const void *data)
+{
+  const uint32_t sample = ring->_n_samples++;
+  const uint32_t n_written = ring->header->n_written;
+
+  if (n_written - ring->header->n_read >= ring->header->n_frames)
+  {
+    ring->header->n_overflows++;
+    return;
+  }
+
+  // Write the frame, then make it visible to the host
+  ring->_next[0] = sample;
+  spin1_memcpy(&ring->_next[1], data, ring->frame_words * sizeof(uint32_t));
+  ring->header->n_written = n_written + 1;
+
+  // Progress to the next frame, wrapping at the end of the ring
+  ring->_next += 1 + ring->frame_words;
+  if (ring->_next == ring->frames +
+                     ring->header->n_frames * (1 + ring->frame_words))
+  {
+    ring->_next = ring->frames;
+  }
+}
+
+#endif  // __RECORD_RING_H__
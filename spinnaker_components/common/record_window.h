@@ -0,0 +1,66 @@
+/* Window of timesteps in which data is recorded.
+ *
+ * Every recording region starts with a window of three words: the number of
+ * timesteps between samples, the first timestep to sample and the timestep
+ * at which sampling stops (timesteps are counted from the start of each
+ * period of simulation).  Only the sampled timesteps are written into the
+ * recording region.
+ */
+
+#ifndef __RECORD_WINDOW_H__
+#define __RECORD_WINDOW_H__
+
+#include <stdbool.h>
+#include "nengo-common.h"
+
+typedef struct _record_window_t
+{
+  uint32_t sample_period;  // Timesteps between samples
+  uint32_t start;          // First timestep to sample
+  uint32_t stop;           // No timesteps from this one on are sampled
+
+  uint32_t _tick;          // Next timestep to be considered
+  uint32_t _next_sample;   // Next timestep to be sampled
+} record_window_t;
+
+// Number of words of the window at the start of a recording region
+#define RECORD_WINDOW_WORDS 3
+
+/* Copy the window from the start of a recording region, returning the address
+ * of the recorded data which follows it.
+ */
+static inline address_t record_window_initialise(record_window_t *window,
+                                                 address_t region)
+{
+  window->sample_period = region[0];
+  window->start = region[1];
+  window->stop = region[2];
+
+  return region + RECORD_WINDOW_WORDS;
+}
+
+/* Prepare the window for a new period of simulation.
+ */
+static inline void record_window_reset(record_window_t *window)
+{
+  window->_tick = 0;
+  window->_next_sample = window->start;
+}
+
+/* Determine whether the next timestep should be sampled, this must be called
+ * exactly once per timestep.
+ */
+static inline bool record_window_sample(record_window_t *window)
+{
+  const uint32_t tick = window->_tick++;
+
+  if (tick != window->_next_sample || tick >= window->stop)
+  {
+    return false;
+  }
+
+  window->_next_sample += window->sample_period;
+  return true;
+}
+
+#endif  // __RECORD_WINDOW_H__
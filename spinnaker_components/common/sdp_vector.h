@@ -0,0 +1,34 @@
+/* Vectors exchanged with the host over SDP.
+ *
+ * A vector of values which is too large for a single SDP message is split
+ * over several messages.  Each message is a command message in which:
+ *
+ *  - `seq` is the sequence number of the vector, which increments (modulo
+ *    2^16) every time the sender transmits a new vector.
+ *  - `arg1` is the index of the first value contained in the message.
+ *  - `arg2` is the number of values contained in the message.
+ *
+ * Messages may be delayed and reordered by the network, so a receiver should
+ * ignore any part of a vector which is older than the one it last received
+ * (see `sdp_vector_is_newer`).
+ */
+
+#ifndef __SDP_VECTOR_H__
+#define __SDP_VECTOR_H__
+
+#include <stdbool.h>
+#include "spin1_api.h"
+#include "nengo_typedefs.h"
+
+// Greatest number of values which may be carried by a single message
+#define SDP_VECTOR_MAX_VALUES (SDP_BUF_SIZE / sizeof(value_t))
+
+/* Determine whether a sequence number is more recent than another, allowing
+ * for the sequence numbers wrapping around.
+ */
+static inline bool sdp_vector_is_newer(uint16_t seq, uint16_t last)
+{
+  return (int16_t) (seq - last) > 0;
+}
+
+#endif  // __SDP_VECTOR_H__
@@ -1,6 +1,12 @@
+/* Double-buffered slots of data, one slot is consumed while the other is
+ * filled (typically by DMA).
+ */
+
 #ifndef __SLOTS_H__
 #define __SLOTS_H__
 
+#include "nengo-common.h"
+
 typedef struct __slot_t {
   uint* data;
   uint current_pos;
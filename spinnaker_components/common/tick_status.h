@@ -0,0 +1,162 @@
+/* Detection of timesteps which take longer than the machine timestep.
+ *
+ * Executables call `tick_status_start` at the start of each timestep and
+ * `tick_status_end` once the processing of the timestep is complete.  A
+ * timestep overruns if it takes longer than the machine timestep; the number
+ * of overruns and the worst lateness (in T2 cycles) are counted in DTCM and
+ * written into the status region by `tick_status_finalise`.
+ *
+ * The host may select a policy to apply when a timestep begins while the
+ * previous timestep is still being processed, or after it overran:
+ *
+ *  - TICK_POLICY_COUNT: only count overruns.
+ *  - TICK_POLICY_DROP: drop the processing of the new timestep so that the
+ *    executable can catch up (the dropped timesteps are counted).  The input
+ *    received during a dropped timestep is still filtered, so that it is not
+ *    added to the input of the next timestep; only the computation and
+ *    transmission of the output is dropped.  Recording windows still advance
+ *    in dropped timesteps.
+ *  - TICK_POLICY_ABORT: print a diagnostic and abort.
+ *
+ * The status region is a `tick_status_region_t`.
+ */
+
+#ifndef __TICK_STATUS_H__
+#define __TICK_STATUS_H__
+
+#include <stdbool.h>
+#include "nengo-common.h"
+
+typedef enum _tick_policy_t
+{
+  TICK_POLICY_COUNT = 0,
+  TICK_POLICY_DROP = 1,
+  TICK_POLICY_ABORT = 2,
+} tick_policy_t;
+
+typedef struct _tick_status_region_t
+{
+  uint32_t policy;        // Policy to apply (written by the host)
+  uint32_t n_ticks;       // Timesteps started
+  uint32_t n_overruns;    // Timesteps which overran
+  uint32_t max_lateness;  // Greatest time (in cycles) by which a step overran
+  uint32_t n_dropped;     // Timesteps dropped by TICK_POLICY_DROP
+} tick_status_region_t;
+
+typedef struct _tick_status_t
+{
+  tick_status_region_t status;    // Status, copied into SDRAM when finalised
+  tick_status_region_t *region;   // Status region in SDRAM
+  uint32_t budget;                // Cycles in a machine timestep
+
+  uint32_t _start;     // Value of T2 at the start of the current timestep
+  bool _in_progress;   // The current timestep is still being processed
+  bool _behind;        // The previous timestep overran
+} tick_status_t;
+
+/* Prepare to monitor timesteps of the given length (in microseconds), starts
+ * timer 2.
+ */
+static inline void tick_status_initialise(tick_status_t *tick_status,
+                                          address_t region,
+                                          uint32_t machine_timestep)
+{
+  tick_status->region = (tick_status_region_t *) region;
+  tick_status->status.policy = tick_status->region->policy;
+  tick_status->budget = machine_timestep * sv->cpu_clk;
+
+  timer2_start();
+}
+
+/* Reset the status for a new period of simulation.
+ */
+static inline void tick_status_reset(tick_status_t *tick_status)
+{
+  tick_status->status.n_ticks = 0;
+  tick_status->status.n_overruns = 0;
+  tick_status->status.max_lateness = 0;
+  tick_status->status.n_dropped = 0;
+
+  tick_status->_in_progress = false;
+  tick_status->_behind = false;
+}
+
+/* Indicate the start of a timestep, returns false if the processing of the
+ * timestep should be dropped.  `may_drop` should be false if dropping the
+ * processing of the timestep is unsafe (e.g., because other cores would wait
+ * for this one).
+ */
+static inline bool tick_status_start(tick_status_t *tick_status,
+                                     bool may_drop)
+{
+  tick_status->status.n_ticks++;
+
+  if (tick_status->_in_progress || tick_status->_behind)
+  {
+    switch (tick_status->status.policy)
+    {
+      case TICK_POLICY_DROP:
+        if (may_drop)
+        {
+          // Drop this timestep, the executable has caught up if the previous
+          // timestep is complete.
+          tick_status->status.n_dropped++;
+          tick_status->_behind = tick_status->_in_progress;
+          return false;
+        }
+        break;
+
+      case TICK_POLICY_ABORT:
+        io_printf(IO_BUF, "Timestep %u overran (%u cycles late at most)\n",
+                  tick_status->status.n_ticks - 1,
+                  tick_status->status.max_lateness);
+        rt_error(RTE_ABORT);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  tick_status->_start = tc[T2_COUNT];
+  tick_status->_in_progress = true;
+  return true;
+}
+
+/* Determine whether the processing of the current timestep is incomplete.
+ */
+static inline bool tick_status_in_progress(const tick_status_t *tick_status)
+{
+  return tick_status->_in_progress;
+}
+
+/* Indicate that the processing of the current timestep is complete.
+ */
+static inline void tick_status_end(tick_status_t *tick_status)
+{
+  // T2 counts down
+  const uint32_t elapsed = tick_status->_start - tc[T2_COUNT];
+
+  tick_status->_behind = (elapsed > tick_status->budget);
+  if (tick_status->_behind)
+  {
+    const uint32_t lateness = elapsed - tick_status->budget;
+    tick_status->status.n_overruns++;
+    if (lateness > tick_status->status.max_lateness)
+    {
+      tick_status->status.max_lateness = lateness;
+    }
+  }
+
+  tick_status->_in_progress = false;
+}
+
+/* Write the status into SDRAM.
+ */
+static inline void tick_status_finalise(tick_status_t *tick_status)
+{
+  spin1_memcpy(tick_status->region, &tick_status->status,
+               sizeof(tick_status_region_t));
+}
+
+#endif  // __TICK_STATUS_H__
@@ -0,0 +1,170 @@
+/* Pacing of multicast packet transmission.
+ *
+ * Rather than sleeping for a fixed time before (and between) packets, cores
+ * transmit packets through a scheduler which limits the number of packets
+ * sent in each slot of time, measured from the start of the timestep.  The
+ * host chooses the schedule (see `transmit_schedule_t`) from estimates of the
+ * load on the router of the chip on which the core is placed:
+ *
+ *  - `offset` delays the first transmission so that the cores of a chip (and
+ *    of neighbouring chips) start transmitting at different times.
+ *  - `packets_per_slot` packets may be sent in each `slot` following the
+ *    offset.  If `packets_per_slot` is 0 then transmission is not paced, but
+ *    is still delayed by the offset.
+ *
+ * Packets which may not yet be sent are queued in DTCM and are sent by
+ * `transmit_scheduler_poll`, which should be called between units of other
+ * work; `transmit_scheduler_flush` waits until every queued packet has been
+ * sent and so should be called once there is no further work in the
+ * timestep.  As the schedule counts from the start of the timestep any time
+ * spent computing before the offset, or between slots, is not added to the
+ * latency of the packets.
+ */
+
+#ifndef __TRANSMIT_SCHEDULER_H__
+#define __TRANSMIT_SCHEDULER_H__
+
+#include <stdbool.h>
+#include "nengo-common.h"
+#include "packet_queue.h"
+
+typedef struct _transmit_schedule_t
+{
+  uint32_t offset;            // Time before the first slot (microseconds)
+  uint32_t slot;              // Length of a slot (microseconds)
+  uint32_t packets_per_slot;  // Packets which may be sent per slot (0 = any)
+} transmit_schedule_t;
+
+typedef struct _transmit_scheduler_t
+{
+  uint32_t offset;            // Cycles before the first slot
+  uint32_t slot;              // Cycles in a slot
+  uint32_t packets_per_slot;  // Packets which may be sent per slot (0 = any)
+
+  packet_t *pending;          // Packets waiting to be sent
+  uint32_t n_pending;         // Number of packets waiting to be sent
+  uint32_t next_pending;      // Index of the next packet to send
+
+  uint32_t _tick_start;       // Value of T2 at the start of the timestep
+  uint32_t _next_slot;        // Cycles into the timestep of the next slot
+  uint32_t _remaining;        // Packets which may be sent in this slot
+} transmit_scheduler_t;
+
+/* Copy in the schedule, which must be a `transmit_schedule_t`, and prepare
+ * to send at most `max_packets` packets per timestep; starts timer 2.
+ */
+static inline void transmit_scheduler_initialise(
+    transmit_scheduler_t *scheduler, address_t region, uint32_t max_packets)
+{
+  const transmit_schedule_t *schedule = (const transmit_schedule_t *) region;
+  scheduler->offset = schedule->offset * sv->cpu_clk;
+  scheduler->slot = schedule->slot * sv->cpu_clk;
+  scheduler->packets_per_slot = schedule->packets_per_slot;
+
+  scheduler->n_pending = 0;
+  scheduler->next_pending = 0;
+  if ((scheduler->packets_per_slot || scheduler->offset) && max_packets)
+  {
+    MALLOC_OR_DIE(scheduler->pending, max_packets * sizeof(packet_t));
+  }
+
+  timer2_start();
+}
+
+/* Indicate the start of a timestep, from which the schedule is counted.
+ */
+static inline void transmit_scheduler_tick(transmit_scheduler_t *scheduler)
+{
+  scheduler->_tick_start = tc[T2_COUNT];
+  scheduler->_next_slot = scheduler->offset;
+  scheduler->_remaining = 0;
+
+  scheduler->n_pending = 0;
+  scheduler->next_pending = 0;
+}
+
+/* Determine whether a packet may be sent now, this consumes the permission to
+ * send a packet if it is granted.
+ */
+static inline bool _transmit_scheduler_permit(transmit_scheduler_t *scheduler)
+{
+  if (scheduler->_remaining == 0)
+  {
+    // T2 counts down
+    const uint32_t elapsed = scheduler->_tick_start - tc[T2_COUNT];
+    if (elapsed < scheduler->_next_slot)
+    {
+      return false;
+    }
+
+    // Start a new slot; any unused permissions from missed slots are not
+    // carried over so that packets are never sent in a burst.  If
+    // transmission is not paced then the first slot never ends.
+    scheduler->_remaining = scheduler->packets_per_slot ?
+                            scheduler->packets_per_slot : UINT32_MAX;
+    scheduler->_next_slot = elapsed + scheduler->slot;
+  }
+
+  scheduler->_remaining--;
+  return true;
+}
+
+/* Send a packet, retrying until the router accepts it.
+ */
+static inline void _transmit_scheduler_send_now(uint32_t key, uint32_t payload)
+{
+  while (!spin1_send_mc_packet(key, payload, WITH_PAYLOAD))
+  {
+  }
+}
+
+/* Send as many of the queued packets as the schedule allows.
+ */
+static inline void transmit_scheduler_poll(transmit_scheduler_t *scheduler)
+{
+  while (scheduler->next_pending < scheduler->n_pending &&
+         _transmit_scheduler_permit(scheduler))
+  {
+    const packet_t *packet = &scheduler->pending[scheduler->next_pending++];
+    _transmit_scheduler_send_now(packet->key, packet->payload);
+  }
+}
+
+/* Send a packet if the schedule allows, otherwise queue it to be sent later.
+ * Packets are always sent in the order in which they were given.
+ */
+static inline void transmit_scheduler_send(transmit_scheduler_t *scheduler,
+                                           uint32_t key, uint32_t payload)
+{
+  if (scheduler->packets_per_slot == 0 && scheduler->offset == 0)
+  {
+    // Transmission is neither paced nor delayed
+    _transmit_scheduler_send_now(key, payload);
+    return;
+  }
+
+  transmit_scheduler_poll(scheduler);
+  if (scheduler->next_pending == scheduler->n_pending &&
+      _transmit_scheduler_permit(scheduler))
+  {
+    _transmit_scheduler_send_now(key, payload);
+  }
+  else
+  {
+    packet_t *packet = &scheduler->pending[scheduler->n_pending++];
+    packet->key = key;
+    packet->payload = payload;
+  }
+}
+
+/* Wait until every queued packet has been sent.
+ */
+static inline void transmit_scheduler_flush(transmit_scheduler_t *scheduler)
+{
+  while (scheduler->next_pending < scheduler->n_pending)
+  {
+    transmit_scheduler_poll(scheduler);
+  }
+}
+
+#endif  // __TRANSMIT_SCHEDULER_H__
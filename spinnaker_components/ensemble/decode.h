@@ -0,0 +1,83 @@
+// Decoding of spike trains
+//
+// Spike vectors are stored as words in which the most significant bit
+// corresponds to the first neuron of a block of 32 and the neurons of each
+// population start on a new word.
+
+#ifndef __DECODE_H__
+#define __DECODE_H__
+
+#include <stdint.h>
+#include "nengo_typedefs.h"
+
+/*****************************************************************************/
+// Decode a spike train to produce a single value
+static inline value_t decode_spike_train(
+  const uint32_t n_populations,        // Number of populations
+  const uint32_t *population_lengths,  // Length of the populations
+  const value_t *decoder,              // Decoder to use
+  const uint32_t *spikes               // Spike vector
+)
+{
+  // Resultant decoded value
+  value_t output = 0.0k;
+
+  // For each population
+  for (uint32_t p = 0; p < n_populations; p++)
+  {
+    // Get the number of neurons in this population
+    uint32_t pop_length = population_lengths[p];
+
+    // While we have neurons left to process
+    while (pop_length)
+    {
+      // Determine how many neurons are in the next word of the spike vector.
+      uint32_t n = (pop_length > 32) ? 32 : pop_length;
+
+      // Load the next word of the spike vector
+      uint32_t data = *(spikes++);
+
+      // Include the contribution from each neuron
+      while (n)  // While there are still neurons left
+      {
+        // Work out how many neurons we can skip
+        // XXX: The GCC documentation claims that `__builtin_clz(0)` is
+        // undefined, but the ARM instruction it uses is defined such that:
+        // CLZ 0x00000000 is 32
+        uint32_t skip = __builtin_clz(data);
+
+        // If `skip` is NOT less than `n` then there are either no firing
+        // neurons left in the word (`skip` == 32) or the first `1` in the word
+        // is beyond the range of bits we care about anyway.
+        if (skip < n)
+        {
+          // Skip until we reach the next neuron which fired
+          decoder += skip;
+
+          // Decode the given neuron
+          output += *decoder;
+
+          // Prepare to test the neuron after the one we just processed.
+          decoder++;
+          skip++;              // Also skip the neuron we just decoded
+          pop_length -= skip;  // Reduce the number of neurons left
+          n -= skip;           // and the number left in this word.
+          data <<= skip;       // Shift out processed neurons
+        }
+        else
+        {
+          // There are no neurons left in this word
+          decoder += n;     // Point at the decoder for the next neuron
+          pop_length -= n;  // Reduce the number left in the population
+          n = 0;            // No more neurons left to process
+        }
+      }
+    }
+  }
+
+  // Return the decoded value
+  return output;
+}
+/*****************************************************************************/
+
+#endif  // __DECODE_H__
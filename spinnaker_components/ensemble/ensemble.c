@@ -7,15 +7,19 @@
 #include "spin1_api.h"
 
 // Common includes
+#include "barrier.h"
 #include "input_filtering.h"
 #include "nengo-common.h"
 #include "fixed_point.h"
 #include "common-impl.h"
+#include "delta_transmit.h"
+#include "tick_status.h"
+#include "transmit_scheduler.h"
 
 // Ensemble includes
-#include "encoder_recording.h"
+#include "decode.h"
 #include "filtered_activity.h"
-#include "neuron_lif.h"
+#include "neuron_model.h"
 #include "pes.h"
 #include "recording.h"
 #include "voja.h"
@@ -41,9 +45,27 @@ if_collection_t modulatory_filters;
 // Each output is encoded by a seperate encoder so these are also left seperate
 if_collection_t learnt_encoder_filters;
 
+// Merged routing table for all of the above collections, this allows each
+// received packet to be routed with a single lookup.
+if_lookup_t input_lookup;
+
+// Barriers used to synchronise the writing and reading of the shared input and
+// spike vectors between the cores simulating populations of the ensemble.
+barrier_t input_barrier;
+barrier_t spikes_barrier;
+
 value_t **sdram_learnt_input_vector_local;  // Our porrtion of the shared learnt input vector
 value_t *sdram_input_vector_local;          // Our portion of the shared input vector
 uint32_t *sdram_spikes_vector_local;        // Our portion of the shared spike vector
+uint32_t local_spikes_offset;               // Offset of our portion (words)
+uint32_t local_spikes_length;               // Length of our portion (words)
+uint32_t local_neuron_offset;               // Index of our first neuron
+
+// Number of words of the spike vector written to SDRAM at a time while the
+// neurons are being simulated and the number of outstanding spike vector
+// transfers (applies to both WRITE_SPIKE_VECTOR and READ_SPIKE_VECTOR tags).
+uint32_t spike_dma_chunk_words;
+uint32_t spike_dma_pending;
 
 // Index of learnt vector currently being DMAd (applies to both
 // WRITE_FILTERED_LEARNT_VECTOR and READ_WHOLE_LEARNED_VECTOR tags)
@@ -54,12 +76,33 @@ uint32_t dma_learnt_vector = 0;
 value_t **sdram_learnt_input_vector;
 
 
-uint32_t unpadded_spike_vector_size;
-uint spikes_write_size;
+// Recording buffers
+recording_buffer_t record_spikes, record_voltages, record_encoders;
+
+// Detection of timesteps which overrun
+tick_status_t tick_status;
+
+// Priority of the timer tick callback, and the value of its second argument
+// when it is called to start a deferred tick.
+#define TIMER_TICK_PRIORITY 1
+#define DEFERRED_TICK 1
+
+// Priority at which the neurons of a population of a split ensemble are
+// simulated, timer ticks are deferred while the neurons are simulated.
+#define SIMULATE_PRIORITY 1
+
+// Timer ticks which occurred while the previous timestep was still being
+// processed and the number of the earliest of them, deferred ticks are started
+// in order once the timestep is complete.
+uint32_t n_deferred_ticks;
+uint32_t next_deferred_tick;
 
-recording_buffer_t record_spikes, record_voltages;  // Recording buffers
+// Pacing of the transmission of the decoded output
+transmit_scheduler_t transmit_scheduler;
+
+// Suppression of decoded values which have barely changed
+delta_transmit_t delta_transmit;
 
-encoder_recording_buffer_t record_encoders;
 
 /*****************************************************************************/
 
@@ -134,134 +177,315 @@ static inline void read_whole_learned_vector(uint32_t signal)
 }
 /*****************************************************************************/
 
+/*****************************************************************************/
+// Schedule writing a section of the local spike vector into SDRAM, returns
+// false if the transfer could not be queued.  Interrupts are disabled so that
+// the transfer cannot complete before it is counted as pending.
+static inline bool write_spike_words(uint32_t *spikes, uint32_t n_words)
+{
+  uint32_t offset = spikes - &ensemble.spikes[local_spikes_offset];
+
+  uint cpsr = spin1_int_disable();
+  const bool queued = spin1_dma_transfer(
+    WRITE_SPIKE_VECTOR,                    // Tag
+    &sdram_spikes_vector_local[offset],    // SDRAM address
+    spikes,                                // DTCM address
+    DMA_WRITE,                             // Direction
+    n_words * sizeof(uint32_t)             // Size
+  ) != FAILURE;
+  if (queued)
+  {
+    spike_dma_pending++;
+  }
+  spin1_mode_restore(cpsr);
+
+  return queued;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Convert the input vector into pairs of signed 16-bit values with
+// `PACKED_INPUT_FRAC_BITS` fractional bits (rounding to nearest), saturating
+// any values which are out of range.
+static inline void pack_input_vector(ensemble_state_t *ensemble)
+{
+  const value_t *input = ensemble->input;
+  const uint32_t n_dims = ensemble->parameters.n_dims;
+
+  for (uint32_t w = 0; w < ensemble->packed_encoder_words; w++)
+  {
+    uint32_t pair = 0x0;
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+      uint32_t d = 2*w + i;
+      int32_t x = (d < n_dims) ?
+        ((bitsk(input[d]) + (1 << (14 - PACKED_INPUT_FRAC_BITS))) >>
+         (15 - PACKED_INPUT_FRAC_BITS)) : 0;
+
+      if (x > INT16_MAX)
+      {
+        x = INT16_MAX;
+      }
+      else if (x < INT16_MIN)
+      {
+        x = INT16_MIN;
+      }
+
+      pair |= ((uint32_t) x & 0xffff) << (16 * i);
+    }
+
+    ensemble->packed_input[w] = (int32_t) pair;
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Compute the input to a neuron which is not in its refractory period, this
+// is a combination of (a) the bias, (b) the inhibitory input times the gain,
+// (c) the non-learnt encoded input and (d) the input encoded by any learnt
+// encoders.
+static inline value_t neuron_input(
+  const ensemble_state_t *ensemble,  // State of the ensemble
+  const uint32_t n,                  // Index of the neuron
+  const uint32_t packed_shift        // Shift applied to packed products
+)
+{
+  const uint32_t n_dims = ensemble->parameters.n_dims;
+  const uint32_t encoder_width = ensemble->parameters.encoder_width;
+
+  value_t input = ensemble->bias[n];
+  input += ensemble->inhibitory_input * ensemble->gain[n];
+
+  // If there are any static input filters
+  // **YUCK** this potentially massive optimisation
+  // could also extend to memory by not allocating the encoders
+  if (input_filters.n_filters > 0)
+  {
+    if (ensemble->parameters.flags & PACKED_ENCODERS)
+    {
+      const uint32_t n_words = ensemble->packed_encoder_words;
+      int32_t encoded = dot_product_s16_pairs(
+        n_words, &ensemble->packed_encoders[n_words * n],
+        ensemble->packed_input);
+      input += kbits(encoded >> packed_shift);
+    }
+    else
+    {
+      input += dot_product(n_dims, &ensemble->encoders[encoder_width * n],
+                           ensemble->input);
+    }
+  }
+
+  // Apply input encoded by learnt encoders (there are no learnt encoders if
+  // the encoders are packed).
+  for (uint32_t f = 0; f < ensemble->parameters.n_learnt_input_signals; f++)
+  {
+    const value_t *learnt_encoder_vector =
+      &ensemble->encoders[encoder_width * n + n_dims * (f + 1)];
+    input += dot_product(n_dims, learnt_encoder_vector,
+                         ensemble->learnt_input[f]);
+  }
+
+  return input;
+}
+/*****************************************************************************/
+
 /*****************************************************************************/
 // Simulate neurons and slowly dribble a spike vector out into a given array.
-// This function will also apply any encoder learning rules.
+// This function will also apply any encoder learning rules.  If `write_sdram`
+// is set then the spike vector is copied into SDRAM in sections of
+// `spike_dma_chunk_words` as it is produced.
+//
+// Neurons are simulated in blocks of 32 (one word of the spike vector).  The
+// input to every neuron in the block is computed first, the neuron states of
+// the whole block are then updated at once and, finally, any work which
+// depends upon which neurons spiked is performed.
 void simulate_neurons(
   ensemble_state_t *ensemble,  // State of the ensemble
-  uint32_t *spikes             // Spike vector in which to record spikes
+  uint32_t *spikes,            // Spike vector in which to record spikes
+  bool write_sdram             // Copy the spike vector into SDRAM
 )
 {
   profiler_write_entry(PROFILER_ENTER | PROFILER_NEURON_UPDATE);
 
   // Extract parameters
-  value_t *input = ensemble->input;
-  value_t inhib_input = ensemble->inhibitory_input;
-  uint32_t n_dims = ensemble->parameters.n_dims;
-  uint32_t encoder_width = ensemble->parameters.encoder_width;
+  const uint32_t n_neurons = ensemble->parameters.n_neurons;
+  const uint32_t n_dims = ensemble->parameters.n_dims;
+  const uint32_t encoder_width = ensemble->parameters.encoder_width;
+  const uint32_t n_learnt_input_signals =
+    ensemble->parameters.n_learnt_input_signals;
+
+  // If the encoders are packed then the input vector must be packed in the
+  // same way, the product of the two must then be shifted back to S16.15.
+  uint32_t packed_shift = ensemble->parameters.encoder_frac_bits +
+                          PACKED_INPUT_FRAC_BITS - 15;
+  if (ensemble->parameters.flags & PACKED_ENCODERS)
+  {
+    pack_input_vector(ensemble);
+  }
 
-  // Bit to use to indicate that a neuron spiked
-  uint32_t bit = (1 << 31);
+  // Start of the local spike vector and of the section of it not yet written
+  // to SDRAM
+  const uint32_t *local_spikes = spikes;
+  uint32_t *unwritten_spikes = spikes;
 
-  // Cache for local spike vector
-  uint32_t local_spikes = 0x0;
+  // Inputs to each neuron in the current block, only the inputs of neurons
+  // which are not in their refractory period are written.
+  static value_t inputs[32];
 
-  // Update each neuron in turn
-  for (uint32_t n = 0; n < ensemble->parameters.n_neurons; n++)
+  for (uint32_t block = 0; block < n_neurons; block += 32)
   {
-    // Get this neuron's encoder vector
-    value_t *encoder_vector = &ensemble->encoders[encoder_width * n];
-
-    // Is this neuron in its refractory period
-    bool in_refractory_period = neuron_refractory(n, ensemble->state);
+    const uint32_t block_size = (n_neurons - block < 32) ?
+                                n_neurons - block : 32;
 
-    // Loop through learnt input signals and encoder slices
-    uint32_t f = 0;
-    uint32_t e = n_dims;
-    value_t neuron_input = 0.0k;
-    for(; f < ensemble->parameters.n_learnt_input_signals; f++, e += n_dims)
+    // Record learnt encoders, the learnt encoders of each neuron follow its
+    // static encoder.
+    for (uint32_t i = 0; i < block_size && n_learnt_input_signals; i++)
     {
-      // Get encoder vector for this neuron offset for correct learnt encoder
-      const value_t *learnt_encoder_vector = encoder_vector + e;
-
-      // Record learnt encoders
-      // **NOTE** idea here is that by interspersing these between encoding
-      // operations, write buffer should have time to be written out
-      record_learnt_encoders(&record_encoders,
-        n_dims, learnt_encoder_vector);
-
-      // If neuron's not in refractory period,
-      // apply input encoded by learnt encoders
-      if(!in_refractory_period)
-      {
-        neuron_input += dot_product(n_dims, learnt_encoder_vector,
-                                    ensemble->learnt_input[f]);
-      }
+      record_learnt_encoders(
+        &record_encoders, block + i, n_dims * n_learnt_input_signals,
+        &ensemble->encoders[encoder_width * (block + i) + n_dims]);
     }
 
-    // If the neuron's in its refractory period, decrement the refractory counter
-    if (in_refractory_period)
+    // Compute the input to each neuron in the block which is not in its
+    // refractory period, neurons which are refractory are skipped entirely.
+    uint32_t active = neuron_active(block, ensemble->state);
+    if (block_size < 32)
     {
-      neuron_refractory_decrement(n, ensemble->state);
+      active &= ~(UINT32_MAX >> block_size);
     }
-    else
-    {
-      // Compute the neuron input, this is a combination of (a) the bias, (b)
-      // the inhibitory input times the gain and (c) the non-learnt encoded input.
-      neuron_input += ensemble->bias[n];
-      neuron_input += inhib_input * ensemble->gain[n];
-
-      // If there are any static input filters
-      // **YUCK** this potentially massive optimisation
-      // could also extend to memory by not allocating the encoders
-      if(input_filters.n_filters > 0)
-      {
-        neuron_input += dot_product(n_dims, encoder_vector, input);
-      }
-
-      // Perform the neuron update
-      if (neuron_step(n, neuron_input, ensemble->state, &record_voltages))
-      {
-        // The neuron fired, record the fact in the spike vector that we're
-        // constructing.
-        local_spikes |= bit;
-        record_spike(&record_spikes, n);
-
-        // Apply effect of neuron spiking to filtered activities
-        //filtered_activity_neuron_spiked(n);
 
-        // Update non-filtered Voja learning
-        voja_neuron_spiked(encoder_vector, ensemble->gain[n], n_dims,
-                           &modulatory_filters, ensemble->learnt_input);
-      }
+    while (active)
+    {
+      const uint32_t i = __builtin_clz(active);
+      active ^= (1 << 31) >> i;
+      inputs[i] = neuron_input(ensemble, block + i, packed_shift);
     }
 
-    // Rotate the neuron firing bit and progress the spike vector if necessary.
-    bit >>= 1;
-    if (bit == 0)
+    // Update the state of every neuron in the block and store the resulting
+    // spikes in the spike vector.
+    const uint32_t block_spikes = neuron_update(
+      block, block_size, inputs, ensemble->state, &record_voltages);
+    *(spikes++) = block_spikes;
+    record_spikes_word(&record_spikes, block, block_spikes);
+
+    // If a whole section of the spike vector is complete then start copying
+    // it into SDRAM while the next section is computed.  If the DMA queue is
+    // full the section is instead copied with the next one.
+    if (write_sdram &&
+        (uint32_t) (spikes - unwritten_spikes) >= spike_dma_chunk_words &&
+        write_spike_words(unwritten_spikes, spikes - unwritten_spikes))
     {
-      bit = (1 << 31);         // Bit is out of range so reset it
-      *spikes = local_spikes;  // Copy spikes into the spike vector
-      spikes++;                // Point at the next word in the spike vector
-      local_spikes = 0x0;      // Reset the local spike vector
+      unwritten_spikes = spikes;
     }
   }
 
-  // Copy any remaining spikes into the specified spike vector
-  if (ensemble->parameters.n_neurons % 32)
+  // Copy the remainder of the spike vector into SDRAM, waiting for space in
+  // the DMA queue if necessary (this is not called from a DMA callback so
+  // the queue continues to drain).
+  if (write_sdram && spikes != unwritten_spikes)
   {
-    *spikes = local_spikes;  // Copy spikes into the spike vector
+    while (!write_spike_words(unwritten_spikes, spikes - unwritten_spikes))
+    {
+    }
   }
 
+  // Apply encoder learning to the neurons which spiked, this is deferred
+  // until every neuron has been simulated to keep the neuron loop tight.
+  voja_apply(ensemble, &modulatory_filters, local_spikes);
+
   // Finish up the recording
   record_buffer_flush(&record_voltages);
   record_buffer_flush(&record_spikes);
+  record_buffer_flush(&record_encoders);
 
   profiler_write_entry(PROFILER_EXIT | PROFILER_NEURON_UPDATE);
 }
 /*****************************************************************************/
 
 /*****************************************************************************/
-// Decode a spike train to produce a single value
-static value_t decode_spike_train(
+// Decode a spike train to produce a vector of values by including the column
+// of a neuron-major decoder for every neuron which fired into the output.
+// This requires only a single pass over the spike vector regardless of the
+// number of outputs.
+static void decode_spike_train_neuron_major(
+  const uint32_t n_populations,        // Number of populations
+  const uint32_t *population_lengths,  // Length of the populations
+  const value_t *decoder,              // Neuron-major decoder to use
+  const uint32_t n_rows,               // Number of decoder rows
+  const uint32_t *spikes,              // Spike vector
+  value_t *output                      // Decoded vector
+)
+{
+  // For each population
+  for (uint32_t p = 0; p < n_populations; p++)
+  {
+    // Get the number of neurons in this population
+    uint32_t pop_length = population_lengths[p];
+
+    // While we have neurons left to process
+    while (pop_length)
+    {
+      // Determine how many neurons are in the next word of the spike vector.
+      uint32_t n = (pop_length > 32) ? 32 : pop_length;
+
+      // Load the next word of the spike vector
+      uint32_t data = *(spikes++);
+
+      // Include the contribution from each neuron
+      while (n)  // While there are still neurons left
+      {
+        // Work out how many neurons we can skip (see `decode_spike_train`)
+        uint32_t skip = __builtin_clz(data);
+
+        if (skip < n)
+        {
+          // Skip until we reach the next neuron which fired
+          decoder += skip * n_rows;
+
+          // Include the decoder of the given neuron in every output
+          for (uint32_t d = 0; d < n_rows; d++)
+          {
+            output[d] += decoder[d];
+          }
+
+          // Prepare to test the neuron after the one we just processed.
+          decoder += n_rows;
+          skip++;              // Also skip the neuron we just decoded
+          pop_length -= skip;  // Reduce the number of neurons left
+          n -= skip;           // and the number left in this word.
+          data <<= skip;       // Shift out processed neurons
+        }
+        else
+        {
+          // There are no neurons left in this word
+          decoder += n * n_rows;  // Point at the decoder for the next neuron
+          pop_length -= n;        // Reduce the number left in the population
+          n = 0;                  // No more neurons left to process
+        }
+      }
+    }
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Decode a spike train to produce a vector of values by including the
+// non-zero elements of the decoder of every neuron which fired into the
+// output.
+static void decode_spike_train_sparse(
   const uint32_t n_populations,        // Number of populations
   const uint32_t *population_lengths,  // Length of the populations
-  const value_t *decoder,              // Decoder to use
-  const uint32_t *spikes               // Spike vector
+  const sparse_decoders_t *decoders,   // Sparse decoder to use
+  uint32_t neuron,                     // Index of the first neuron
+  const uint32_t *spikes,              // Spike vector
+  value_t *output                      // Decoded vector
 )
 {
-  // Resultant decoded value
-  value_t output = 0.0k;
+  const uint32_t *columns = decoders->columns;
+  const uint16_t *rows = decoders->rows;
+  const value_t *values = decoders->values;
 
   // For each population
   for (uint32_t p = 0; p < n_populations; p++)
@@ -281,25 +505,22 @@ static value_t decode_spike_train(
       // Include the contribution from each neuron
       while (n)  // While there are still neurons left
       {
-        // Work out how many neurons we can skip
-        // XXX: The GCC documentation claims that `__builtin_clz(0)` is
-        // undefined, but the ARM instruction it uses is defined such that:
-        // CLZ 0x00000000 is 32
+        // Work out how many neurons we can skip (see `decode_spike_train`)
         uint32_t skip = __builtin_clz(data);
 
-        // If `skip` is NOT less than `n` then there are either no firing
-        // neurons left in the word (`skip` == 32) or the first `1` in the word
-        // is beyond the range of bits we care about anyway.
         if (skip < n)
         {
           // Skip until we reach the next neuron which fired
-          decoder += skip;
+          neuron += skip;
 
-          // Decode the given neuron
-          output += *decoder;
+          // Include the non-zero elements of the decoder of the neuron
+          for (uint32_t i = columns[neuron]; i < columns[neuron + 1]; i++)
+          {
+            output[rows[i]] += values[i];
+          }
 
           // Prepare to test the neuron after the one we just processed.
-          decoder++;
+          neuron++;
           skip++;              // Also skip the neuron we just decoded
           pop_length -= skip;  // Reduce the number of neurons left
           n -= skip;           // and the number left in this word.
@@ -308,62 +529,415 @@ static value_t decode_spike_train(
         else
         {
           // There are no neurons left in this word
-          decoder += n;     // Point at the decoder for the next neuron
+          neuron += n;      // Point at the next neuron
           pop_length -= n;  // Reduce the number left in the population
           n = 0;            // No more neurons left to process
         }
       }
     }
   }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Zero the decoded output vector
+static inline void decode_output_reset(const ensemble_state_t *ensemble)
+{
+  const ensemble_parameters_t *params = &ensemble->parameters;
+  uint32_t n_decoder_rows = params->n_decoder_rows + params->n_learnt_decoder_rows;
+
+  for (uint32_t d = 0; d < n_decoder_rows; d++)
+  {
+    ensemble->decoded_output[d] = 0.0k;
+  }
 
-  // Return the decoded value
-  return output;
+  // Zero the output of the factored decoders
+  const factored_decoders_t *factored = &ensemble->factored_decoders;
+  for (uint32_t f = 0; f < factored->n_factors; f++)
+  {
+    factored->output[f] = 0.0k;
+  }
 }
 /*****************************************************************************/
 
 /*****************************************************************************/
-// Apply the decoder to a spike vector and transmit multicast packets
-// representing the decoded vector.  This function will also apply any decoder
-// learning rules.
-static inline void decode_output_and_transmit(const ensemble_state_t *ensemble)
+// Apply the decoder to the section of the spike vector belonging to the
+// populations [p_start, p_end) and include the result in the decoded output.
+static void decode_output_populations(const ensemble_state_t *ensemble,
+                                      uint32_t p_start, uint32_t p_end)
 {
-  uint delay = (spin1_get_core_id() - 1) +
-               (spin1_get_chip_id() & 0x1) +
-               ((spin1_get_chip_id() >> 7) & 0x2);
-  spin1_delay_us(5 * delay);
+  if (p_start >= p_end)
+  {
+    return;
+  }
 
   profiler_write_entry(PROFILER_ENTER | PROFILER_DECODE);
 
   // Extract parameters
   const ensemble_parameters_t *params = &ensemble->parameters;
-  uint32_t n_neurons_total = params->n_neurons_total;
-  uint32_t n_populations = params->n_populations;
   uint32_t n_decoder_rows = params->n_decoder_rows + params->n_learnt_decoder_rows;
+  uint32_t first_dense_row = ensemble->first_dense_decoder_row;
+  value_t *output = ensemble->decoded_output;
 
+  // Find the first neuron and spike vector word of the first population
   uint32_t *pop_lengths = ensemble->population_lengths;
-  value_t *decoder = ensemble->decoders;
-  uint32_t *keys = ensemble->keys;
+  uint32_t neuron_offset = 0;
   uint32_t *spike_vector = ensemble->spikes;
+  for (uint32_t p = 0; p < p_start; p++)
+  {
+    neuron_offset += pop_lengths[p];
+    spike_vector += (pop_lengths[p] + 31) / 32;
+  }
 
-  // Apply the decoder and transmit multicast packets.
-  // Each decoder row is applied in turn to get the output value, which is then
-  // transmitted.
-  for (uint32_t d = 0; d < n_decoder_rows; d++)
+  uint32_t n_populations = p_end - p_start;
+  pop_lengths += p_start;
+
+  // Static decoders which are not stored densely have their own kernels
+  if (ensemble->decoder_storage == DECODERS_FACTORED)
+  {
+    // Decode the output of the smaller decoder, the transform is applied once
+    // all populations have been decoded.
+    const factored_decoders_t *factored = &ensemble->factored_decoders;
+    decode_spike_train_neuron_major(
+      n_populations, pop_lengths,
+      &factored->decoders[neuron_offset * factored->n_factors],
+      factored->n_factors, spike_vector, factored->output);
+  }
+  else if (ensemble->decoder_storage == DECODERS_SPARSE)
+  {
+    decode_spike_train_sparse(n_populations, pop_lengths,
+                              &ensemble->sparse_decoders, neuron_offset,
+                              spike_vector, output);
+  }
+
+  // Decode the rows which are stored densely
+  if (first_dense_row == n_decoder_rows)
+  {
+    // No dense rows
+  }
+  else if (ensemble->decoders_neuron_major)
+  {
+    // Decode every output value with a single pass over the spike vector
+    decode_spike_train_neuron_major(
+      n_populations, pop_lengths,
+      ensemble_decoder(ensemble, first_dense_row, neuron_offset),
+      n_decoder_rows - first_dense_row, spike_vector,
+      &output[first_dense_row]);
+  }
+  else
+  {
+    // Each decoder row is applied in turn to get the output value
+    for (uint32_t d = first_dense_row; d < n_decoder_rows; d++)
+    {
+      // Get the row of the decoder
+      value_t *row = ensemble_decoder(ensemble, d, neuron_offset);
+
+      // Compute the decoded value
+      output[d] += decode_spike_train(n_populations, pop_lengths,
+                                      row, spike_vector);
+    }
+  }
+
+  profiler_write_entry(PROFILER_EXIT | PROFILER_DECODE);
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Complete the decoded output once every population has been decoded, this
+// applies the transform to the output of factored decoders.
+static inline void decode_output_complete(const ensemble_state_t *ensemble)
+{
+  if (ensemble->decoder_storage != DECODERS_FACTORED)
   {
-    // Get the row of the decoder
-    value_t *row = &decoder[d * n_neurons_total];
+    return;
+  }
+
+  profiler_write_entry(PROFILER_ENTER | PROFILER_DECODE);
+
+  const factored_decoders_t *factored = &ensemble->factored_decoders;
+  const uint32_t n_factors = factored->n_factors;
+  for (uint32_t d = 0; d < ensemble->parameters.n_decoder_rows; d++)
+  {
+    ensemble->decoded_output[d] = dot_product(
+      n_factors, &factored->transform[d * n_factors], factored->output);
+  }
 
-    // Compute the decoded value
-    value_t output = decode_spike_train(n_populations, pop_lengths,
-                                        row, spike_vector);
+  profiler_write_entry(PROFILER_EXIT | PROFILER_DECODE);
+}
+/*****************************************************************************/
 
-    // Transmit this value (keep trying until it sends)
-    while(!spin1_send_mc_packet(keys[d], bitsk(output), WITH_PAYLOAD))
+/*****************************************************************************/
+// Start the earliest deferred timer tick, if there is one.  The tick is
+// scheduled rather than started immediately so that it is not processed in
+// the DMA callback which may have completed the previous timestep.
+void timer_tick(uint ticks, uint arg1);
+
+static inline void start_deferred_tick(void)
+{
+  if (n_deferred_ticks &&
+      !spin1_schedule_callback(timer_tick, 0, DEFERRED_TICK,
+                               TIMER_TICK_PRIORITY))
+  {
+    // The tick couldn't be scheduled, start it now instead
+    timer_tick(0, DEFERRED_TICK);
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Transmit multicast packets representing the decoded vector.
+static inline void transmit_output(const ensemble_state_t *ensemble)
+{
+  const ensemble_parameters_t *params = &ensemble->parameters;
+  uint32_t n_decoder_rows = params->n_decoder_rows + params->n_learnt_decoder_rows;
+
+  // Transmit the values which have changed as the schedule allows, then wait
+  // until every value has been sent.
+  for (uint32_t d = 0; d < n_decoder_rows; d++)
+  {
+    if (delta_transmit_changed(&delta_transmit, d,
+                               ensemble->decoded_output[d]))
     {
+      transmit_scheduler_send(&transmit_scheduler, ensemble->keys[d],
+                              bitsk(ensemble->decoded_output[d]));
     }
   }
+  delta_transmit_step(&delta_transmit);
+  transmit_scheduler_flush(&transmit_scheduler);
+
+  // Learning rules which use filtered activity are applied once the output
+  // has been transmitted so that they do not delay it; the spikes of every
+  // population are available at this point.
+  filtered_activity_step(ensemble->spikes, params->n_populations,
+                         ensemble->population_lengths);
+  pes_step(ensemble);
+  voja_step(ensemble, local_neuron_offset);
+
+  // This completes the processing of the timestep
+  profiler_count_tick_end();
+  tick_status_end(&tick_status);
+  start_deferred_tick();
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Schedule reading the next block of streamed decoder rows into the free
+// slot.
+static inline void read_decoder_block(streamed_decoders_t *streamed)
+{
+  const uint32_t n_neurons = ensemble.parameters.n_neurons_total;
+  const uint32_t row = streamed->next_row;
+
+  // Determine how many rows to read
+  uint32_t n_rows = ensemble.parameters.n_decoder_rows - row;
+  if (n_rows > streamed->rows_per_block)
+  {
+    n_rows = streamed->rows_per_block;
+  }
+
+  _slot_t *slot = streamed->slots.next;
+  slot->current_pos = row;
+  slot->length = n_rows;
+  streamed->next_row += n_rows;
+
+  spin1_dma_transfer(
+    READ_DECODER_BLOCK,                           // Tag
+    (void *) &streamed->sdram_decoders[row * n_neurons],  // SDRAM address
+    slot->data,                                   // DTCM address
+    DMA_READ,                                     // Direction
+    n_rows * n_neurons * sizeof(value_t)          // Size
+  );
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Called once a block of streamed decoder rows has been read, the next block
+// is read while this one is decoded and the output is transmitted once the
+// final block has been decoded.
+static inline void decoder_block_read(void)
+{
+  streamed_decoders_t *streamed = &ensemble.streamed_decoders;
+  const uint32_t n_neurons = ensemble.parameters.n_neurons_total;
+  const uint32_t n_populations = ensemble.parameters.n_populations;
+
+  // Swap the slots and start reading the next block (if any) into the slot
+  // which was decoded last.
+  slots_progress(&streamed->slots);
+  const _slot_t *block = streamed->slots.current;
+  const bool last_block = (streamed->next_row ==
+                           ensemble.parameters.n_decoder_rows);
+  if (!last_block)
+  {
+    read_decoder_block(streamed);
+  }
+
+  profiler_write_entry(PROFILER_ENTER | PROFILER_DECODE);
+
+  // Spikes from every population are available so decode each row whole
+  const value_t *row = (const value_t *) block->data;
+  for (uint32_t d = block->current_pos;
+       d < block->current_pos + block->length;
+       d++, row += n_neurons)
+  {
+    ensemble.decoded_output[d] = decode_spike_train(
+      n_populations, ensemble.population_lengths, row, ensemble.spikes);
+  }
 
   profiler_write_entry(PROFILER_EXIT | PROFILER_DECODE);
+
+  if (last_block)
+  {
+    transmit_output(&ensemble);
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Complete decoding once the spikes of every population have been decoded
+// with the decoders held in DTCM, and then transmit the output.  Streamed
+// decoders are applied (and the output transmitted) as they are read.
+static inline void complete_and_transmit_output(void)
+{
+  if (ensemble.decoder_storage == DECODERS_STREAMED)
+  {
+    ensemble.streamed_decoders.next_row = 0;
+    read_decoder_block(&ensemble.streamed_decoders);
+  }
+  else
+  {
+    decode_output_complete(&ensemble);
+    transmit_output(&ensemble);
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Schedule reading back the sections of the shared spike vector written by
+// the other populations, returning the number of transfers scheduled.
+static inline uint32_t read_remote_spike_vector()
+{
+  uint32_t *sdram_spike_vector = ensemble.parameters.sdram_spike_vector;
+  uint32_t local_end = local_spikes_offset + local_spikes_length;
+  uint32_t n_transfers = 0;
+
+  // Populations preceding our own
+  if (local_spikes_offset)
+  {
+    n_transfers++;
+    spin1_dma_transfer(
+      READ_SPIKE_VECTOR,                          // Tag
+      sdram_spike_vector,                         // SDRAM address
+      ensemble.spikes,                            // DTCM address
+      DMA_READ,                                   // Direction
+      sizeof(uint32_t) * local_spikes_offset      // Size
+    );
+  }
+
+  // Populations following our own
+  if (local_end < ensemble.sdram_spikes_length)
+  {
+    n_transfers++;
+    spin1_dma_transfer(
+      READ_SPIKE_VECTOR,                          // Tag
+      &sdram_spike_vector[local_end],             // SDRAM address
+      &ensemble.spikes[local_end],                // DTCM address
+      DMA_READ,                                   // Direction
+      sizeof(uint32_t) * (ensemble.sdram_spikes_length - local_end)
+    );
+  }
+
+  return n_transfers;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Apply learning to, and decode, the spikes of all but the local population
+// and then transmit the decoded output.
+static inline void decode_remote_and_transmit()
+{
+  uint32_t pop_id = ensemble.parameters.population_id;
+  uint32_t n_populations = ensemble.parameters.n_populations;
+
+  pes_apply(&ensemble, 0, pop_id);
+  pes_apply(&ensemble, pop_id + 1, n_populations);
+
+  decode_output_populations(&ensemble, 0, pop_id);
+  decode_output_populations(&ensemble, pop_id + 1, n_populations);
+
+  complete_and_transmit_output();
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Called once the whole local spike vector has been written into SDRAM.
+static inline void spike_vector_written()
+{
+  uint32_t pop_id = ensemble.parameters.population_id;
+
+  // While the other cores finish simulating their neurons apply learning to,
+  // and decode, the spikes of the local population.  Learning only modifies
+  // the decoders of neurons which spiked so this may be done a population at
+  // a time.
+  decode_output_reset(&ensemble);
+  pes_apply(&ensemble, pop_id, pop_id + 1);
+  decode_output_populations(&ensemble, pop_id, pop_id + 1);
+
+  // Wait for all cores to have written their spike vectors into SDRAM
+  barrier_wait(&spikes_barrier);
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Simulate the neurons of the local population once the whole input vector
+// has been read, copying the spike vector into SDRAM as it is produced.  The
+// pending count is held at one until simulation is complete so that the spike
+// vector cannot be considered written early.
+void simulate_local_neurons(uint arg0, uint arg1)
+{
+  use(arg0);
+  use(arg1);
+
+  spike_dma_pending = 1;
+  simulate_neurons(&ensemble, &ensemble.spikes[local_spikes_offset], true);
+
+  // The last transfer may complete while the count is being decremented
+  uint cpsr = spin1_int_disable();
+  const bool written = (--spike_dma_pending == 0);
+  spin1_mode_restore(cpsr);
+
+  if (written)
+  {
+    spike_vector_written();
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Called once all cores have written their spike vectors into SDRAM.
+void spike_vector_synchronised(void)
+{
+  // Schedule reading back the spikes of the other populations
+  spike_dma_pending = read_remote_spike_vector();
+  if (spike_dma_pending == 0)
+  {
+    decode_remote_and_transmit();
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Called once all cores have written their input vectors into SDRAM.
+void input_vector_synchronised(void)
+{
+  // If there are any learnt input signals to transfer, start reading of 1st signal
+  if(ensemble.parameters.n_learnt_input_signals > 0)
+  {
+    read_whole_learned_vector(0);
+  }
+  else
+  {
+    read_whole_vector();
+  }
 }
 /*****************************************************************************/
 
@@ -391,45 +965,17 @@ void mcpl_received(uint key, uint payload)
 
 void process_queue()
 {
-  uint32_t offset = ensemble.parameters.input_subspace.offset;
-  uint32_t max_dim_sub_one = ensemble.parameters.input_subspace.n_dims - 1;
-
-  // Continuously remove packets from the queue and include them in filters
-  while (packet_queue_not_empty(&packets))
+  // Continuously remove batches of packets from the queue and include them in
+  // filters.  Popping need not be a critical section as the queue is only
+  // ever popped from here.
+  packet_t batch[PACKET_QUEUE_BATCH_LENGTH];
+  uint32_t n_packets;
+  profiler_count_queue_length(packet_queue_length(&packets));
+  while ((n_packets = packet_queue_pop_batch(&packets, batch,
+                                             PACKET_QUEUE_BATCH_LENGTH)))
   {
-    // Pop a packet from the queue (critical section)
-    packet_t packet;
-    uint cpsr = spin1_fiq_disable();
-    bool packet_is_valid = packet_queue_pop(&packets, &packet);
-    spin1_mode_restore(cpsr);
-
-    // Process the received packet
-    if (packet_is_valid)
-    {
-      uint32_t key = packet.key;
-      uint32_t payload = packet.payload;
-
-      // Standard input
-      input_filtering_input_with_dimension_offset(
-        &input_filters, key, payload, offset, max_dim_sub_one
-      );
-
-      // Learnt encoder input
-      input_filtering_input_with_dimension_offset(
-        &learnt_encoder_filters, key, payload, offset, max_dim_sub_one
-      );
-
-      // Inhibitory
-      input_filtering_input(&inhibition_filters, key, payload);
-
-      // Modulatory
-      input_filtering_input(&modulatory_filters, key, payload);
-    }
-    else
-    {
-      io_printf(IO_BUF, "Popped packet from empty queue.\n");
-      rt_error(RTE_ABORT);
-    }
+    // Standard, learnt encoder, inhibitory and modulatory input
+    input_filtering_input_lookup_batch(&input_lookup, n_packets, batch);
   }
   queue_processing = false;
 }
@@ -449,13 +995,15 @@ void user_event(uint arg0, uint arg1)
 // The action to take when receiving a DMA callback differs depending on the
 // tag.
 //
-// WRITE_FILTERED_VECTOR: Schedule reading the whole vector back from SDRAM.
-// READ_WHOLE_VECTOR:     Simulate the neurons and schedule writing out the
-//                        spike vector.
-// WRITE_SPIKE_VECTOR:    Wait for synchronisation then schedule reading back
-//                        the whole spike vector.
-// READ_SPIKE_VECTOR:     Decode the output using the locally stored rows and
-//                        transmit multicast packets.
+// WRITE_FILTERED_VECTOR: Wait for synchronisation then schedule reading the
+//                        whole vector back from SDRAM.
+// READ_WHOLE_VECTOR:     Schedule simulating the neurons, writing out
+//                        sections of the spike vector as they are completed.
+// WRITE_SPIKE_VECTOR:    Once the whole local spike vector is written decode
+//                        the local spikes, wait for synchronisation then
+//                        schedule reading back the remote spike vector.
+// READ_SPIKE_VECTOR:     Once the remote spike vector is read decode the
+//                        remote spikes and transmit multicast packets.
 void dma_complete(uint transfer_id, uint tag)
 {
   use(transfer_id);  // Unused
@@ -478,19 +1026,9 @@ void dma_complete(uint transfer_id, uint tag)
   }
   else if (tag == WRITE_FILTERED_VECTOR)
   {
-    // Wait for all cores to have written their input vectors into SDRAM
-    sark_sema_lower((uchar *) ensemble.parameters.sema_input);
-    while (*ensemble.parameters.sema_input) ;
-
-    // If there are any learnt input signals to transfer, start reading of 1st signal
-    if(ensemble.parameters.n_learnt_input_signals > 0)
-    {
-      read_whole_learned_vector(0);
-    }
-    else
-    {
-      read_whole_vector();
-    }
+    // Wait for all cores to have written their input vectors into SDRAM,
+    // packets will continue to be processed while waiting.
+    barrier_wait(&input_barrier);
   }
   else if(tag == READ_WHOLE_LEARNED_VECTOR)
   {
@@ -510,45 +1048,67 @@ void dma_complete(uint transfer_id, uint tag)
   }
   else if (tag == READ_WHOLE_VECTOR)
   {
-    // Process the neurons, then copy the spike vector into SDRAM.
-    simulate_neurons(&ensemble, ensemble.spikes);
-
-    // Schedule writing out the spike vector
-    spin1_dma_transfer(
-      WRITE_SPIKE_VECTOR,         // Tag
-      sdram_spikes_vector_local,  // SDRAM address
-      ensemble.spikes,            // DTCM addess
-      DMA_WRITE,                  // Direction
-      spikes_write_size
-    );
+    // Simulate the neurons from a queued callback rather than in this one:
+    // queued DMA transfers are started from the DMA interrupt, so sections of
+    // the spike vector could not be written while the neurons are simulated
+    // if they were simulated here.
+    if (!spin1_schedule_callback(simulate_local_neurons, 0, 0,
+                                 SIMULATE_PRIORITY))
+    {
+      io_printf(IO_BUF, "Could not schedule simulating the neurons\n");
+      rt_error(RTE_ABORT);
+    }
   }
   else if (tag == WRITE_SPIKE_VECTOR)
   {
-    // Wait for all cores to have written their spike vectors into SDRAM
-    sark_sema_lower((uchar *) ensemble.parameters.sema_spikes);
-    while (*ensemble.parameters.sema_spikes) ;
-
-    // Schedule reading back the whole spike vector from SDRAM
-    uint32_t *sdram_spike_vector = ensemble.parameters.sdram_spike_vector;
-    spin1_dma_transfer(
-      READ_SPIKE_VECTOR,                         // Tag
-      sdram_spike_vector,                        // SDRAM address
-      ensemble.spikes,                           // DTCM addess
-      DMA_READ,                                  // Direction
-      sizeof(uint32_t) * ensemble.sdram_spikes_length  // Size
-    );
+    // If this was the last section of the spike vector to be written
+    if (--spike_dma_pending == 0)
+    {
+      spike_vector_written();
+    }
   }
   else if (tag == READ_SPIKE_VECTOR)
   {
-    // Apply PES learning to spike vector
-    pes_apply(&ensemble, &modulatory_filters);
-
-    // Decode and transmit neuron output
-    decode_output_and_transmit(&ensemble);
+    // If this was the last section of the spike vector to be read
+    if (--spike_dma_pending == 0)
+    {
+      decode_remote_and_transmit();
+    }
+  }
+  else if (tag == READ_DECODER_BLOCK)
+  {
+    decoder_block_read();
+  }
+  else if (tag == WRITE_RECORDED_SPIKES)
+  {
+    record_buffer_dma_complete(&record_spikes);
+  }
+  else if (tag == WRITE_RECORDED_VOLTAGES)
+  {
+    record_buffer_dma_complete(&record_voltages);
+  }
+  else if (tag == WRITE_RECORDED_ENCODERS)
+  {
+    record_buffer_dma_complete(&record_encoders);
   }
 }
 /*****************************************************************************/
 
+/*****************************************************************************/
+// Include every received packet in the input filters and apply a step of each
+// filter, this takes (and, for non-latching inputs, clears) the input received
+// during the timestep.
+static inline void filter_input(void)
+{
+  process_queue();
+
+  input_filtering_step(&input_filters);
+  input_filtering_step(&inhibition_filters);
+  input_filtering_step_no_accumulate(&modulatory_filters);
+  input_filtering_step_no_accumulate(&learnt_encoder_filters);
+}
+/*****************************************************************************/
+
 /*****************************************************************************/
 // Timer tick
 
@@ -557,36 +1117,82 @@ void dma_complete(uint transfer_id, uint tag)
 // into the shared input in SDRAM.
 void timer_tick(uint ticks, uint arg1)
 {
-  use(arg1);  // Unused
+  // A tick which occurs while the previous timestep is still being processed
+  // (e.g., while waiting at a barrier, which allows queued callbacks to run)
+  // is deferred until that timestep is complete, starting it would interleave
+  // the processing of the two timesteps.  Later ticks are deferred until every
+  // earlier deferred tick has started so that they are processed in order.
+  // The overrun policy is applied as each deferred tick is started.
+  if (arg1 == DEFERRED_TICK)
+  {
+    n_deferred_ticks--;
+    ticks = next_deferred_tick++;
+  }
+  else
+  {
+    // A DMA callback may complete the current timestep while this runs
+    uint cpsr = spin1_int_disable();
+    const bool defer = (n_deferred_ticks ||
+                        tick_status_in_progress(&tick_status));
+    if (defer && n_deferred_ticks++ == 0)
+    {
+      next_deferred_tick = ticks;
+    }
+    spin1_mode_restore(cpsr);
 
-  // Empty the spike raster
-  memset(ensemble.spikes, 0, unpadded_spike_vector_size);
+    if (defer)
+    {
+      return;
+    }
+  }
 
   // Stop if we've completed sufficient simulation steps
   if (simulation_ticks != UINT32_MAX && ticks > simulation_ticks)
   {
     profiler_finalise();
+    profiler_counters_finalise();
+    tick_status_finalise(&tick_status);
     spin1_exit(0);
     return;
   }
 
+  // Drop this timestep if the previous one overran and the policy requires
+  // it; this is only safe if no other cores are waiting for this one.  The
+  // input received during a dropped timestep is still filtered, otherwise it
+  // would remain in the accumulators and be added to the input of the next
+  // timestep.  Only the neuron update, decoding and transmission are dropped,
+  // so no spikes are recorded and the recorded voltages and encoders are
+  // unchanged.
+  if (!tick_status_start(&tick_status, ensemble.parameters.n_populations == 1))
+  {
+    filter_input();
+    record_buffer_flush_dropped(&record_voltages, false);
+    record_buffer_flush_dropped(&record_spikes, true);
+    record_buffer_flush_dropped(&record_encoders, false);
+    start_deferred_tick();
+    return;
+  }
+  profiler_count_tick_start();
+  transmit_scheduler_tick(&transmit_scheduler);
+
+  // The spike raster is not emptied: every word of it is overwritten, either
+  // by `simulate_neurons` or by reading back the spikes of other populations.
+
   // If there are multiple populations then raise the synchronisation
   // semaphores
   if (ensemble.parameters.n_populations > 1)
   {
-    sark_sema_raise((uchar *) ensemble.parameters.sema_input);
-    sark_sema_raise((uchar *) ensemble.parameters.sema_spikes);
+    barrier_raise(&input_barrier);
+    barrier_raise(&spikes_barrier);
   }
 
   // Apply filtering to the input vector
   profiler_write_entry(PROFILER_ENTER | PROFILER_INPUT_FILTER);
 
-  process_queue();
+  filter_input();
 
-  input_filtering_step(&input_filters);
-  input_filtering_step(&inhibition_filters);
-  input_filtering_step_no_accumulate(&modulatory_filters);
-  input_filtering_step_no_accumulate(&learnt_encoder_filters);
+  // Scale the error signals of the PES learning rules
+  pes_prepare(&modulatory_filters);
 
   profiler_write_entry(PROFILER_EXIT | PROFILER_INPUT_FILTER);
 
@@ -610,17 +1216,164 @@ void timer_tick(uint ticks, uint arg1)
   {
     // Process the neurons, writing the spikes out into DTCM rather than a
     // shared SDRAM vector.
-    simulate_neurons(&ensemble, ensemble.spikes);
+    simulate_neurons(&ensemble, ensemble.spikes, false);
 
     // Apply PES learning to spike vector
-    pes_apply(&ensemble, &modulatory_filters);
-    
+    pes_apply(&ensemble, 0, 1);
+
     // Decode and transmit output
-    decode_output_and_transmit(&ensemble);
+    decode_output_reset(&ensemble);
+    decode_output_populations(&ensemble, 0, 1);
+    complete_and_transmit_output();
   }
 }
 /*****************************************************************************/
 
+/*****************************************************************************/
+// Copy the decoders into DTCM.  The decoder regions start with the format of
+// the decoders and the number of factors, non-zero elements or rows per block
+// they contain.  Static decoders may be factored, sparse or streamed from
+// SDRAM, any which are not are stored with the (dense) learnt decoders.
+static void prepare_decoders(const ensemble_parameters_t *params,
+                             const address_t static_region,
+                             const address_t learnt_region)
+{
+  const uint32_t n_neurons = params->n_neurons_total;
+  const uint32_t n_decoder_rows = params->n_decoder_rows;
+  const uint32_t n_learnt_decoder_rows = params->n_learnt_decoder_rows;
+  const value_t *static_decoders = (value_t *) &static_region[2];
+  const value_t *learnt_decoders = (value_t *) &learnt_region[2];
+
+  ensemble.decoder_storage = static_region[0];
+  if (ensemble.decoder_storage == DECODERS_FACTORED)
+  {
+    // Copy in the smaller (neuron-major) decoder followed by the transform
+    factored_decoders_t *factored = &ensemble.factored_decoders;
+    factored->n_factors = static_region[1];
+
+    const uint32_t decoder_size =
+      n_neurons * factored->n_factors * sizeof(value_t);
+    const uint32_t transform_size =
+      n_decoder_rows * factored->n_factors * sizeof(value_t);
+    MALLOC_OR_DIE(factored->decoders, decoder_size);
+    MALLOC_OR_DIE(factored->transform, transform_size);
+    MALLOC_OR_DIE(factored->output, factored->n_factors * sizeof(value_t));
+
+    spin1_memcpy(factored->decoders, static_decoders, decoder_size);
+    spin1_memcpy(factored->transform,
+                 &static_decoders[n_neurons * factored->n_factors],
+                 transform_size);
+
+    io_printf(IO_BUF, "Decoders factored with %d factors\n",
+              factored->n_factors);
+  }
+  else if (ensemble.decoder_storage == DECODERS_SPARSE)
+  {
+    // Copy in the index of the first element of each column, then the row of
+    // each element (as pairs of 16-bit values) and then the values.
+    sparse_decoders_t *sparse = &ensemble.sparse_decoders;
+    const uint32_t n_elements = static_region[1];
+
+    const uint32_t columns_size = (n_neurons + 1) * sizeof(uint32_t);
+    const uint32_t rows_size = ((n_elements + 1) / 2) * sizeof(uint32_t);
+    const uint32_t values_size = n_elements * sizeof(value_t);
+    MALLOC_OR_DIE(sparse->columns, columns_size);
+    MALLOC_OR_DIE(sparse->rows, rows_size);
+    MALLOC_OR_DIE(sparse->values, values_size);
+
+    const uint32_t *data = &static_region[2];
+    spin1_memcpy(sparse->columns, data, columns_size);
+    data += n_neurons + 1;
+    spin1_memcpy(sparse->rows, data, rows_size);
+    data += (n_elements + 1) / 2;
+    spin1_memcpy(sparse->values, data, values_size);
+
+    io_printf(IO_BUF, "Sparse decoders with %d elements\n", n_elements);
+  }
+  else if (ensemble.decoder_storage == DECODERS_STREAMED)
+  {
+    // The decoders remain in SDRAM, allocate two blocks of rows in DTCM
+    streamed_decoders_t *streamed = &ensemble.streamed_decoders;
+    streamed->sdram_decoders = static_decoders;
+    streamed->rows_per_block = static_region[1];
+    if (!initialise_slots(&streamed->slots, streamed->rows_per_block *
+                                            n_neurons * sizeof(value_t)))
+    {
+      rt_error(RTE_MALLOC);
+    }
+
+    io_printf(IO_BUF, "Streaming decoders in blocks of %d rows\n",
+              streamed->rows_per_block);
+  }
+
+  // Allocate array large enough for the dense static and learnt decoders
+  const uint32_t n_dense_static_rows =
+    (ensemble.decoder_storage == DECODERS_DENSE) ? n_decoder_rows : 0;
+  const uint32_t n_dense_rows = n_dense_static_rows + n_learnt_decoder_rows;
+  ensemble.first_dense_decoder_row = n_decoder_rows - n_dense_static_rows;
+  MALLOC_OR_DIE(ensemble.decoders, n_neurons * n_dense_rows * sizeof(value_t));
+
+  // If there is more than one output then store the decoders neuron-major so
+  // that they may be applied with a single pass over the spike vector,
+  // otherwise the row-major layout in SDRAM can be used directly.
+  ensemble.decoders_neuron_major = (n_dense_rows > 1);
+  if (ensemble.decoders_neuron_major)
+  {
+    ensemble.decoder_row_stride = 1;
+    ensemble.decoder_neuron_stride = n_dense_rows;
+
+    // Transpose the static decoders and then the learnt decoders
+    for (uint32_t d = ensemble.first_dense_decoder_row;
+         d < n_decoder_rows + n_learnt_decoder_rows; d++)
+    {
+      const value_t *row = (d < n_decoder_rows) ?
+        &static_decoders[d * n_neurons] :
+        &learnt_decoders[(d - n_decoder_rows) * n_neurons];
+
+      for (uint32_t n = 0; n < n_neurons; n++)
+      {
+        *ensemble_decoder(&ensemble, d, n) = row[n];
+      }
+    }
+  }
+  else
+  {
+    ensemble.decoder_row_stride = n_neurons;
+    ensemble.decoder_neuron_stride = 1;
+
+    // Copy any static decoders into beginning of this array
+    const uint32_t decoder_words = n_neurons * n_dense_static_rows;
+    spin1_memcpy(ensemble.decoders, static_decoders,
+                 decoder_words * sizeof(value_t));
+
+    // Follow this by learnt decoders
+    spin1_memcpy(ensemble.decoders + decoder_words, learnt_decoders,
+                 n_neurons * n_learnt_decoder_rows * sizeof(value_t));
+  }
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Get the data of a region.  The data is copied into DTCM unless the host
+// marked the region as resident in SDRAM (see `sdram_regions`), in which case
+// it is accessed in place; this allows slices whose data would not fit in
+// DTCM to be simulated, at the cost of slower access to that data.
+static void *region_load(uint32_t region, address_t address, uint32_t size)
+{
+  void *data = region_start(region, address);
+  if (ensemble.parameters.sdram_regions & (1 << region))
+  {
+    io_printf(IO_BUF, "Region %u (%u bytes) left in SDRAM\n", region, size);
+    return data;
+  }
+
+  void *dtcm_data;
+  MALLOC_OR_DIE(dtcm_data, size);
+  spin1_memcpy(dtcm_data, data, size);
+  return dtcm_data;
+}
+/*****************************************************************************/
+
 /*****************************************************************************/
 // Initialisation and setup
 void c_main(void)
@@ -642,8 +1395,10 @@ void c_main(void)
                ((uint8_t*)region_start(ENSEMBLE_REGION, address)) + sizeof(ensemble_parameters_t),
                 sizeof(value_t*) * params->n_learnt_input_signals);
 
-  // Prepare the input vector
+  // Prepare the input vector, it is zeroed here as it is not zeroed before
+  // the input filters are applied (see `input_filtering_step`).
   MALLOC_OR_DIE(ensemble.input, sizeof(value_t) * params->n_dims);
+  memset(ensemble.input, 0, sizeof(value_t) * params->n_dims);
 
   // Store an offset into the input vector
   ensemble.input_local =
@@ -675,13 +1430,21 @@ void c_main(void)
       i, ensemble.learnt_input[i], ensemble.learnt_input_local[i], sdram_learnt_input_vector[i], sdram_learnt_input_vector_local[i]);
   }
 
-  // Compute the spike size for writing into SDRAM
-  spikes_write_size = params->n_neurons / 32;
+  // Compute the spike size for writing into SDRAM and determine how much of
+  // it to write at a time.  Writes are grouped such that there are never more
+  // outstanding than will fit in the DMA queue.
+  local_spikes_length = params->n_neurons / 32;
   if (params->n_neurons % 32)
   {
-    spikes_write_size++;
+    local_spikes_length++;
+  }
+
+  spike_dma_chunk_words = (local_spikes_length + SPIKE_DMA_MAX_CHUNKS - 1) /
+                          SPIKE_DMA_MAX_CHUNKS;
+  if (spike_dma_chunk_words < SPIKE_DMA_CHUNK_WORDS)
+  {
+    spike_dma_chunk_words = SPIKE_DMA_CHUNK_WORDS;
   }
-  spikes_write_size *= sizeof(uint32_t);
 
   // Prepare the filters
   input_filtering_get_filters(&input_filters,
@@ -711,22 +1474,46 @@ void c_main(void)
                               ensemble.learnt_input_local);
   input_filtering_get_routes(&learnt_encoder_filters,
                              region_start(LEARNT_ENCODER_ROUTING_REGION, address));
-  // Copy in encoders
-  uint encoder_size = sizeof(value_t) * params->n_neurons *
-                      params->encoder_width;
-  MALLOC_OR_DIE(ensemble.encoders, encoder_size);
-  spin1_memcpy(ensemble.encoders, region_start(ENCODER_REGION, address),
-               encoder_size);
+
+  // Merge the routing tables of all the input collections.  The standard and
+  // learnt inputs are offset to the input subspace, the inhibitory and
+  // modulatory inputs are not.
+  const uint32_t max_dim_sub_one = params->input_subspace.n_dims - 1;
+  if_lookup_source_t lookup_sources[] = {
+    {&input_filters, params->input_subspace.offset, max_dim_sub_one},
+    {&learnt_encoder_filters, params->input_subspace.offset, max_dim_sub_one},
+    {&inhibition_filters, 0, UINT32_MAX},
+    {&modulatory_filters, 0, UINT32_MAX},
+  };
+  input_filtering_build_lookup(&input_lookup, 4, lookup_sources);
+
+  // Copy in encoders, if the encoders are packed then each row contains pairs
+  // of 16-bit values padded to a whole number of words.
+  if (params->flags & PACKED_ENCODERS)
+  {
+    ensemble.packed_encoder_words = (params->n_dims + 1) / 2;
+    uint encoder_size = sizeof(int32_t) * params->n_neurons *
+                        ensemble.packed_encoder_words;
+    ensemble.encoders = NULL;
+    ensemble.packed_encoders = region_load(ENCODER_REGION, address,
+                                           encoder_size);
+    MALLOC_OR_DIE(ensemble.packed_input,
+                  sizeof(int32_t) * ensemble.packed_encoder_words);
+  }
+  else
+  {
+    uint encoder_size = sizeof(value_t) * params->n_neurons *
+                        params->encoder_width;
+    ensemble.encoders = region_load(ENCODER_REGION, address, encoder_size);
+  }
 
   // Copy in bias
   uint bias_size = sizeof(value_t) * params->n_neurons;
-  MALLOC_OR_DIE(ensemble.bias, bias_size);
-  spin1_memcpy(ensemble.bias, region_start(BIAS_REGION, address), bias_size);
+  ensemble.bias = region_load(BIAS_REGION, address, bias_size);
 
   // Copy in gain
   uint gain_size = sizeof(value_t) * params->n_neurons;
-  MALLOC_OR_DIE(ensemble.gain, gain_size);
-  spin1_memcpy(ensemble.gain, region_start(GAIN_REGION, address), gain_size);
+  ensemble.gain = region_load(GAIN_REGION, address, gain_size);
 
   // Copy in the population lengths
   uint poplength_size = sizeof(uint32_t) * params->n_populations;
@@ -737,16 +1524,20 @@ void c_main(void)
 
   // Prepare the spike vectors
   uint32_t padded_spike_vector_size = 0;
+  uint32_t neuron_offset = 0;
   for (uint p = 0; p < params->n_populations; p++)
   {
     // If this is the population we represent then store the offset
     if (p == params->population_id)
     {
+      local_spikes_offset = padded_spike_vector_size;
+      local_neuron_offset = neuron_offset;
       sdram_spikes_vector_local =
         &params->sdram_spike_vector[padded_spike_vector_size];
     }
 
     // Include this population
+    neuron_offset += ensemble.population_lengths[p];
     padded_spike_vector_size += ensemble.population_lengths[p] / 32;
     if (ensemble.population_lengths[p] % 32)
     {
@@ -758,20 +1549,14 @@ void c_main(void)
   padded_spike_vector_size *= sizeof(uint32_t);
   MALLOC_OR_DIE(ensemble.spikes, padded_spike_vector_size);
 
-  // Allocate array large enough for static and learnt decoders
-  const uint32_t decoder_words = params->n_neurons_total * params->n_decoder_rows;
-  const uint32_t learnt_decoder_words = params->n_neurons_total * params->n_learnt_decoder_rows;
-  MALLOC_OR_DIE(ensemble.decoders,
-                (decoder_words + learnt_decoder_words) * sizeof(value_t));
-
-  // Copy static decoders into beginning of this array
-  spin1_memcpy(ensemble.decoders, region_start(DECODER_REGION, address),
-               decoder_words * sizeof(value_t));
+  // Prepare the static and learnt decoders
+  prepare_decoders(params, region_start(DECODER_REGION, address),
+                   region_start(LEARNT_DECODER_REGION, address));
 
-  // Follow this by learnt decoders
-  spin1_memcpy(ensemble.decoders + decoder_words,
-               region_start(LEARNT_DECODER_REGION, address),
-               learnt_decoder_words * sizeof(value_t));
+  // Allocate the decoded output vector
+  MALLOC_OR_DIE(ensemble.decoded_output,
+                (params->n_decoder_rows + params->n_learnt_decoder_rows) *
+                sizeof(value_t));
 
   // Allocate array large enough for static and learnt keys
   MALLOC_OR_DIE(ensemble.keys,
@@ -788,50 +1573,75 @@ void c_main(void)
                params->n_learnt_decoder_rows * sizeof(uint32_t));
 
   // Prepare the neuron state
-  lif_prepare_state(&ensemble, region_start(NEURON_REGION, address));
+  neuron_prepare_state(&ensemble, region_start(NEURON_REGION, address));
 
   // Initialise learning rule regions
-  if(!pes_initialise(region_start(PES_REGION, address)))
+  if(!pes_initialise(region_start(PES_REGION, address), &ensemble))
   {
     return;
   }
 
-  if(!voja_initialise(region_start(VOJA_REGION, address)))
+  if(!voja_initialise(region_start(VOJA_REGION, address), params->n_dims))
   {
     return;
   }
 
   // Initialise filtered activity region
-  /*if(!filtered_activity_initialise(
-    region_start(FILTERED_ACTIVITY_REGION, address)))
+  if(!filtered_activity_initialise(
+    region_start(FILTERED_ACTIVITY_REGION, address), params->n_neurons_total))
   {
     return;
-  }*/
+  }
+
+  // Prepare the synchronisation barriers
+  barrier_init(&input_barrier, params->sema_input,
+               input_vector_synchronised, PROFILER_BARRIER);
+  barrier_init(&spikes_barrier, params->sema_spikes,
+               spike_vector_synchronised, PROFILER_BARRIER);
 
   // Prepare the profiler
   profiler_read_region(region_start(PROFILER_REGION, address));
   profiler_init(ensemble.parameters.n_profiler_samples);
+  profiler_counters_init(region_start(PROFILER_COUNTERS_REGION, address));
+
+  // Prepare to detect overrunning timesteps
+  tick_status_initialise(&tick_status, region_start(TICK_STATUS_REGION, address),
+                         ensemble.parameters.machine_timestep);
+
+  // Prepare to pace the transmission of the decoded output
+  transmit_scheduler_initialise(
+    &transmit_scheduler, region_start(TRANSMIT_SCHEDULE_REGION, address),
+    ensemble.parameters.n_decoder_rows +
+    ensemble.parameters.n_learnt_decoder_rows);
+
+  // Prepare to suppress the transmission of values which have barely changed
+  delta_transmit_initialise(&delta_transmit,
+                            region_start(TRANSMIT_THRESHOLD_REGION, address));
 
   // Prepare recording regions
   record_voltages.record = ensemble.parameters.flags & RECORD_VOLTAGES;
   if (!record_buffer_initialise_voltages(
         &record_voltages, region_start(REC_VOLTAGES_REGION, address),
-        ensemble.parameters.n_neurons))
+        ensemble.parameters.n_neurons, WRITE_RECORDED_VOLTAGES))
   {
     return;
   }
 
   record_spikes.record = ensemble.parameters.flags & RECORD_SPIKES;
+  record_spikes.compress = ensemble.parameters.flags & COMPRESS_SPIKES;
   if (!record_buffer_initialise_spikes(
         &record_spikes, region_start(REC_SPIKES_REGION, address),
-        ensemble.parameters.n_neurons))
+        ensemble.parameters.n_neurons, WRITE_RECORDED_SPIKES))
   {
     return;
   }
 
   record_encoders.record = ensemble.parameters.flags & RECORD_ENCODERS;
-  if (!record_learnt_encoders_initialise(&record_encoders,
-        region_start(REC_ENCODERS_REGION, address)))
+  if (!record_buffer_initialise_encoders(
+        &record_encoders, region_start(REC_ENCODERS_REGION, address),
+        ensemble.parameters.n_neurons,
+        ensemble.parameters.n_dims * ensemble.parameters.n_learnt_input_signals,
+        WRITE_RECORDED_ENCODERS))
   {
     return;
   }
@@ -841,14 +1651,14 @@ void c_main(void)
   // --------------------------------------------------------------------------
   // Multicast packet queue
   queue_processing = false;
-  packet_queue_init(&packets);
+  packet_queue_init(&packets, params->packet_queue_length);
   queue_overflows = 0;
   // --------------------------------------------------------------------------
 
   // --------------------------------------------------------------------------
   // Prepare callbacks
   spin1_set_timer_tick(ensemble.parameters.machine_timestep);
-  spin1_callback_on(TIMER_TICK, timer_tick, 1);
+  spin1_callback_on(TIMER_TICK, timer_tick, TIMER_TICK_PRIORITY);
   spin1_callback_on(DMA_TRANSFER_DONE, dma_complete, 0);
   spin1_callback_on(MCPL_PACKET_RECEIVED, mcpl_received, -1);
   spin1_callback_on(USER_EVENT, user_event, 1);
@@ -867,6 +1677,13 @@ void c_main(void)
     // Reset the recording regions
     record_buffer_reset(&record_spikes);
     record_buffer_reset(&record_voltages);
+    record_buffer_reset(&record_encoders);
+
+    // Reset the profiler counters and status
+    profiler_counters_reset();
+    tick_status_reset(&tick_status);
+    delta_transmit_reset(&delta_transmit);
+    n_deferred_ticks = 0;
 
     // Check on the status of the packet queue
     if (queue_overflows)
@@ -2,6 +2,7 @@
 #include <stdbool.h>
 
 #include "profiler.h"
+#include "slots.h"
 #include "nengo_typedefs.h"
 
 #ifndef __ENSEMBLE_H__
@@ -34,6 +35,10 @@
 #define REC_SPIKES_REGION             23
 #define REC_VOLTAGES_REGION           24
 #define REC_ENCODERS_REGION           25
+#define PROFILER_COUNTERS_REGION      26
+#define TICK_STATUS_REGION            27
+#define TRANSMIT_SCHEDULE_REGION      28
+#define TRANSMIT_THRESHOLD_REGION     29
 /*****************************************************************************/
 
 /*****************************************************************************/
@@ -43,6 +48,7 @@
 #define PROFILER_DECODE           2
 #define PROFILER_PES              3
 #define PROFILER_VOJA             4
+#define PROFILER_BARRIER          5
 /*****************************************************************************/
 
 /*****************************************************************************/
@@ -52,7 +58,13 @@ enum
   RECORD_SPIKES   = (1 << 0),
   RECORD_VOLTAGES = (1 << 1),
   RECORD_ENCODERS = (1 << 2),
+  PACKED_ENCODERS = (1 << 3),  // Encoders are packed 16-bit pairs
+  COMPRESS_SPIKES = (1 << 4),  // Spike frames are compressed
 } flags;
+
+// Number of fractional bits used to represent the input vector when it is
+// applied to packed encoders.
+#define PACKED_INPUT_FRAC_BITS 11
 /*****************************************************************************/
 
 /*****************************************************************************/
@@ -82,6 +94,9 @@ typedef struct _ensemble_parameters
   uint32_t n_profiler_samples;            // Number of profiler samples
   uint32_t n_learnt_input_signals;        // Number of learnt input signals
   uint32_t flags;                         // Flags as per `flags` enum
+  uint32_t packet_queue_length;           // Length of the packet queue
+  uint32_t encoder_frac_bits;             // Fractional bits of packed encoders
+  uint32_t sdram_regions;                 // Regions left in SDRAM (1 << region)
 
   // Pointers into SDRAM
   value_t *sdram_input_vector;
@@ -91,6 +106,44 @@ typedef struct _ensemble_parameters
   volatile uint8_t *sema_spikes;          // Spike vector synchronisation
 } ensemble_parameters_t;
 
+// Formats in which the static decoders may be stored, the format is given by
+// the first word of the decoder region.
+typedef enum _decoder_storage_t
+{
+  DECODERS_DENSE = 0,     // Full matrix, stored with the learnt decoders
+  DECODERS_FACTORED = 1,  // Transform applied to the output of a smaller decoder
+  DECODERS_SPARSE = 2,    // Non-zero elements of the decoder of each neuron
+  DECODERS_STREAMED = 3,  // Full matrix, read from SDRAM a block at a time
+} decoder_storage_t;
+
+// Static decoders stored as the product of a transform and a decoder with
+// fewer rows.
+typedef struct _factored_decoders_t
+{
+  uint32_t n_factors;                 // Number of rows of the smaller decoder
+  value_t *decoders;                  // Smaller decoder (neuron-major)
+  value_t *transform;                 // Transform (n_decoder_rows x n_factors)
+  value_t *output;                    // Output of the smaller decoder
+} factored_decoders_t;
+
+// Static decoders stored as the non-zero elements of each column
+typedef struct _sparse_decoders_t
+{
+  uint32_t *columns;                  // Index of first element of each column
+  uint16_t *rows;                     // Row of each element
+  value_t *values;                    // Value of each element
+} sparse_decoders_t;
+
+// Static decoders which remain in SDRAM and are read into DTCM a block of
+// rows at a time, the next block is read while the current one is decoded.
+typedef struct _streamed_decoders_t
+{
+  const value_t *sdram_decoders;      // Decoders in SDRAM (row-major)
+  uint32_t rows_per_block;            // Number of rows in each block
+  uint32_t next_row;                  // First row of the next block to read
+  slots_t slots;                      // Blocks (position is the first row)
+} streamed_decoders_t;
+
 typedef struct _ensemble_state
 {
   ensemble_parameters_t parameters;   // Generic parameters
@@ -106,6 +159,10 @@ typedef struct _ensemble_state
   value_t inhibitory_input;           // Globally inhibitory input
 
   value_t *encoders;                  // Encoder matrix
+
+  int32_t *packed_encoders;           // Encoder matrix (of packed 16-bit pairs)
+  int32_t *packed_input;              // Input vector (of packed 16-bit pairs)
+  uint32_t packed_encoder_words;      // Width of packed encoder (words)
   value_t *bias;                      // Neuron biases
   value_t *gain;                      // Neuron gains
 
@@ -113,9 +170,30 @@ typedef struct _ensemble_state
   uint32_t sdram_spikes_length;       // Length of padded spike vector (words)
   uint32_t *spikes;                   // Unpadded spike vector
 
-  value_t *decoders;                  // Rows from the decoder matrix
+  decoder_storage_t decoder_storage;  // Format of the static decoders
+  factored_decoders_t factored_decoders;  // Static decoders (if factored)
+  sparse_decoders_t sparse_decoders;  // Static decoders (if sparse)
+  streamed_decoders_t streamed_decoders;  // Static decoders (if streamed)
+
+  value_t *decoders;                  // Dense rows from the decoder matrix
+  uint32_t first_dense_decoder_row;   // Index of the first dense row
+  bool decoders_neuron_major;         // Decoders are stored neuron-major
+  uint32_t decoder_row_stride;        // Distance between decoder rows
+  uint32_t decoder_neuron_stride;     // Distance between decoder columns
+  value_t *decoded_output;            // Decoded output vector
   uint32_t *keys;                     // Output keys
 } ensemble_state_t;
+
+// Get the decoder element for the given output row and neuron, this is valid
+// for either decoder layout but only for rows which are stored densely (all
+// learnt rows are).
+static inline value_t *ensemble_decoder(const ensemble_state_t *ensemble,
+                                        uint32_t row, uint32_t neuron)
+{
+  row -= ensemble->first_dense_decoder_row;
+  return &ensemble->decoders[row * ensemble->decoder_row_stride +
+                             neuron * ensemble->decoder_neuron_stride];
+}
 /*****************************************************************************/
 
 /*****************************************************************************/
@@ -130,8 +208,17 @@ enum
   READ_WHOLE_LEARNED_VECTOR,    // Read learned vector into DTCM
   WRITE_SPIKE_VECTOR,           // Write spike vector into SDRAM
   READ_SPIKE_VECTOR,            // Read spike vector into DTCM for decoding
+  READ_DECODER_BLOCK,           // Read block of streamed decoders into DTCM
+  WRITE_RECORDED_SPIKES,        // Write recorded spikes into SDRAM
+  WRITE_RECORDED_VOLTAGES,      // Write recorded voltages into SDRAM
+  WRITE_RECORDED_ENCODERS,      // Write recorded learnt encoders into SDRAM
 
 } dma_tag_ops;
+
+// Minimum number of words of the spike vector to write to SDRAM at a time
+// and the maximum number of writes to schedule for a single spike vector.
+#define SPIKE_DMA_CHUNK_WORDS 2
+#define SPIKE_DMA_MAX_CHUNKS  8
 /*****************************************************************************/
 
 #endif  // __ENSEMBLE_H__
@@ -24,7 +24,7 @@
 // Global variables
 //-----------------------------------------------------------------------------
 uint32_t g_num_activity_filters = 0;
-value_t **g_filtered_activities = NULL;
+uint32_t **g_filtered_activities = NULL;
 activity_filter_parameters_t *g_activity_filter_params = NULL;
 
 //-----------------------------------------------------------------------------
@@ -32,11 +32,11 @@ activity_filter_parameters_t *g_activity_filter_params = NULL;
 //-----------------------------------------------------------------------------
 bool filtered_activity_initialise(address_t address, uint32_t n_neurons)
 {
-  // Read number of PES learning rules that are configured
+  // Read number of activity filters that are configured
   g_num_activity_filters = address[0];
-  
+
   io_printf(IO_BUF, "Filtered activity: Num filters:%u\n", g_num_activity_filters);
-  
+
   if(g_num_activity_filters > 0)
   {
     // Allocate memory
@@ -44,37 +44,60 @@ bool filtered_activity_initialise(address_t address, uint32_t n_neurons)
                       g_num_activity_filters * sizeof(activity_filter_parameters_t));
 
     MALLOC_FAIL_FALSE(g_filtered_activities,
-                      g_num_activity_filters * sizeof(value_t*));
+                      g_num_activity_filters * sizeof(uint32_t*));
 
     // Copy propogators from region into new array
     memcpy(g_activity_filter_params, &address[1], g_num_activity_filters * sizeof(activity_filter_parameters_t));
-    
+
     // Loop through filters
     for(uint32_t f = 0; f < g_num_activity_filters; f++)
     {
-      io_printf(IO_BUF, "\tFilter %u, Filter:%k, 1.0 - Filter:%f\n",
-                f, g_activity_filter_params[f].filter, g_activity_filter_params[f].n_filter);
+      io_printf(IO_BUF, "\tFilter %u, Filter:0x%08x, 1.0 - Filter:0x%08x\n",
+                f, g_activity_filter_params[f].filter,
+                g_activity_filter_params[f].n_filter);
 
       // Allocate per-neuron filtered g_filtered_activities
-      MALLOC_FAIL_FALSE(g_filtered_activities[f], n_neurons * sizeof(value_t));
+      MALLOC_FAIL_FALSE(g_filtered_activities[f], n_neurons * sizeof(uint32_t));
 
       // Initially zero all filters
-      memset(g_filtered_activities[f], 0, n_neurons * sizeof(value_t));
+      memset(g_filtered_activities[f], 0, n_neurons * sizeof(uint32_t));
     }
   }
 
   return true;
 }
 //-----------------------------------------------------------------------------
-void filtered_activity_step(uint32_t n_neurons)
+void filtered_activity_step(const uint32_t *spikes, uint32_t n_populations,
+                            const uint32_t *population_lengths)
 {
   // Loop through filters
   for(uint32_t f = 0; f < g_num_activity_filters; f++)
   {
-    // Loop through neurons and apply propogators
-    for(uint32_t n = 0; n < n_neurons; n++)
+    const uint32_t filter = g_activity_filter_params[f].filter;
+    const uint32_t n_filter = g_activity_filter_params[f].n_filter;
+    uint32_t *activity = g_filtered_activities[f];
+    const uint32_t *spike_vector = spikes;
+
+    // Each population starts on a new word of the spike vector
+    for (uint32_t p = 0; p < n_populations; p++)
     {
-      g_filtered_activities[f][n] *= g_activity_filter_params[f].filter;
+      for (uint32_t pop_length = population_lengths[p]; pop_length; )
+      {
+        const uint32_t n = (pop_length > 32) ? 32 : pop_length;
+        uint32_t data = *(spike_vector++);
+        pop_length -= n;
+
+        // Decay the activity of every neuron in the word and add `n_filter`
+        // to the activities of those which spiked (the most significant bit
+        // of the word is the first neuron), without branching.
+        for (uint32_t i = 0; i < n; i++, data <<= 1)
+        {
+          const uint32_t spiked = (uint32_t) ((int32_t) data >> 31);
+          activity[i] = (uint32_t) (((uint64_t) activity[i] * filter) >> 32) +
+                        (spiked & n_filter);
+        }
+        activity += n;
+      }
     }
   }
 }
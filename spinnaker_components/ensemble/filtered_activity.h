@@ -27,36 +27,23 @@
 //-----------------------------------------------------------------------------
 // Structs
 //-----------------------------------------------------------------------------
+// Filtered activities are stored as U0.32 values: a neuron which spiked on
+// every timestep would have an activity approaching (but never reaching) 1.
 typedef struct activity_filter_parameters_t
 {
-  // Filter value, e.g., \f$\exp(-\frac{dt}{\tau})\f$
-  value_t filter;
+  // Filter value, e.g., \f$\exp(-\frac{dt}{\tau})\f$ (U0.32)
+  uint32_t filter;
 
-  // 1 - filter value
-  value_t n_filter;
+  // 1 - filter value, rounded down so that activities cannot overflow (U0.32)
+  uint32_t n_filter;
 } activity_filter_parameters_t;
 
 //-----------------------------------------------------------------------------
 // External variables
 //-----------------------------------------------------------------------------
 extern uint32_t g_num_activity_filters;
-extern value_t **g_filtered_activities;
-activity_filter_parameters_t *g_activity_filter_params;
-
-//----------------------------------
-// Inline functions
-//----------------------------------
-/**
-* \brief apply effect of neuron spiking to all filtered activities
-*/
-static inline void filtered_activity_neuron_spiked(uint32_t n)
-{
-  // Loop through filters and add n_filter to activites
-  for(uint32_t f = 0; f < g_num_activity_filters; f++)
-  {
-    g_filtered_activities[f][n] += g_activity_filter_params[f].n_filter;
-  }
-}
+extern uint32_t **g_filtered_activities;
+extern activity_filter_parameters_t *g_activity_filter_params;
 
 //-----------------------------------------------------------------------------
 // Functions
@@ -64,13 +51,21 @@ static inline void filtered_activity_neuron_spiked(uint32_t n)
 /**
 * \brief Copy in data controlling filtered activities
 * from the filtered activity region of the Ensemble.
+*
+* An activity is maintained for each of the `n_neurons` neurons of every
+* population, so that learning rules may be applied to the decoders of the
+* whole cluster.
 */
 bool filtered_activity_initialise(address_t address, uint32_t n_neurons);
 
 /**
-* \brief Apply decay to all filtered activities
+* \brief Decay all filtered activities and include the effect of the spikes
+* of the populations [0, n_populations).
+*
+* Each word of the spike vector is applied to 32 neurons at once.
 */
-void filtered_activity_step();
+void filtered_activity_step(const uint32_t *spikes, uint32_t n_populations,
+                            const uint32_t *population_lengths);
 
 /** @} */
 
@@ -0,0 +1,31 @@
+#include <string.h>
+
+#include "neuron_adaptive_lif.h"
+#include "nengo-common.h"
+
+/*****************************************************************************/
+// Prepare neuron state
+void adaptive_lif_prepare_state(
+    ensemble_state_t *ensemble, // Generic ensemble state
+    uint32_t *address           // SDRAM address of neuron parameters
+)
+{
+  // Get the number of neurons
+  uint32_t n_neurons = ensemble->parameters.n_neurons;
+
+  // Prepare space for neuron parameters
+  MALLOC_OR_DIE(ensemble->state, sizeof(adaptive_lif_states_t));
+  adaptive_lif_states_t *state = ensemble->state;
+
+  // Prepare the LIF state, the adaptation parameters follow the LIF
+  // parameters.
+  address = lif_initialise_state(&state->lif, n_neurons, address);
+
+  // Allocate space for the adaptation (and zero)
+  MALLOC_OR_DIE(state->adaptation, sizeof(value_t) * n_neurons);
+  memset(state->adaptation, 0, sizeof(value_t) * n_neurons);
+
+  // Copy in adaptation parameters
+  spin1_memcpy(&state->parameters, address, sizeof(adaptive_lif_parameters_t));
+}
+/*****************************************************************************/
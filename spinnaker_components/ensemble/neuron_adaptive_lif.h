@@ -0,0 +1,96 @@
+// Adaptive leaky integrate and fire neurons
+//
+// Each neuron is a LIF neuron whose input is reduced by an adaptation term
+// which increases every time the neuron spikes and otherwise decays.
+
+#ifndef __NEURON_ADAPTIVE_LIF_H__
+#define __NEURON_ADAPTIVE_LIF_H__
+
+#include "ensemble.h"
+#include "fixed_point.h"
+#include "neuron_lif.h"
+#include "recording.h"
+
+/*****************************************************************************/
+// State variables for an ensemble of adaptive LIF neurons
+typedef struct adaptive_lif_parameters
+{
+  int32_t dt_over_tau_n;        // Decay of adaptation (S0.31)
+  value_t inc_n_over_tau_n;     // Increase of adaptation per spike
+} adaptive_lif_parameters_t;
+
+typedef struct adaptive_lif_states
+{
+  lif_states_t lif;                       // LIF neuron states
+  adaptive_lif_parameters_t parameters;   // Adaptation parameters
+  value_t *adaptation;                    // Adaptation of each neuron
+} adaptive_lif_states_t;
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Prepare neuron state
+void adaptive_lif_prepare_state(
+    ensemble_state_t *ensemble, // Generic ensemble state
+    uint32_t *address           // SDRAM address of neuron parameters
+);
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Get a word indicating which neurons in a block of 32 are not in their
+// refractory period.
+static inline uint32_t adaptive_lif_active(
+  const uint32_t first_neuron,  // Index of the first neuron in the block
+  const void *state             // Pointer to neuron state(s)
+)
+{
+  // Cast the state to adaptive LIF state type
+  adaptive_lif_states_t *alif_state = (adaptive_lif_states_t *) state;
+
+  return lif_active(first_neuron, &alif_state->lif);
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Update the state of a block of (at most 32) neurons, returning a word in
+// which the most significant bit indicates whether the first neuron in the
+// block spiked.
+static inline uint32_t adaptive_lif_update(
+  const uint32_t first_neuron,      // Index of the first neuron in the block
+  const uint32_t n_neurons,         // Number of neurons in the block
+  const value_t *inputs,            // Input to each neuron in the block
+  const void *state,                // Pointer to neuron state(s)
+  recording_buffer_t *rec_voltages  // Pointer to voltage recording
+)
+{
+  // Cast the state to adaptive LIF state type
+  adaptive_lif_states_t *alif_state = (adaptive_lif_states_t *) state;
+  value_t *adaptation = &alif_state->adaptation[first_neuron];
+
+  const int32_t dt_over_tau_n = alif_state->parameters.dt_over_tau_n;
+  const value_t inc_n_over_tau_n = alif_state->parameters.inc_n_over_tau_n;
+
+  // Reduce the input to each neuron by its adaptation and then update the
+  // LIF neurons.
+  value_t adapted_inputs[32];
+  for (uint32_t i = 0; i < n_neurons; i++)
+  {
+    adapted_inputs[i] = inputs[i] - adaptation[i];
+  }
+
+  uint32_t spikes = lif_update(first_neuron, n_neurons, adapted_inputs,
+                               &alif_state->lif, rec_voltages);
+
+  // Decay the adaptation of every neuron and increase the adaptation of those
+  // neurons which spiked.
+  for (uint32_t i = 0; i < n_neurons; i++)
+  {
+    const int32_t spiked = -(int32_t) ((spikes >> (31 - i)) & 0x1);
+    adaptation[i] += kbits(spiked & bitsk(inc_n_over_tau_n)) -
+                     mul_s16_15_s0_31(adaptation[i], dt_over_tau_n);
+  }
+
+  return spikes;
+}
+/*****************************************************************************/
+
+#endif  // __NEURON_ADAPTIVE_LIF_H__
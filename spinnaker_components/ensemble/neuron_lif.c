@@ -10,13 +10,21 @@ void lif_prepare_state(
     uint32_t *address           // SDRAM address of neuron parameters
 )
 {
-  // Get the number of neurons
-  uint32_t n_neurons = ensemble->parameters.n_neurons;
-
   // Prepare space for neuron parameters
   MALLOC_OR_DIE(ensemble->state, sizeof(lif_states_t));
-  lif_states_t *state = ensemble->state;
+  lif_initialise_state(ensemble->state, ensemble->parameters.n_neurons,
+                       address);
+}
+/*****************************************************************************/
 
+/*****************************************************************************/
+// Initialise the state of a number of LIF neurons
+uint32_t *lif_initialise_state(
+    lif_states_t *state,        // State to initialise
+    uint32_t n_neurons,         // Number of neurons
+    uint32_t *address           // SDRAM address of LIF parameters
+)
+{
   // Allocate space for voltages (and zero)
   MALLOC_OR_DIE(state->voltages, sizeof(value_t) * n_neurons);
   memset(state->voltages, 0, sizeof(value_t) * n_neurons);
@@ -25,7 +33,13 @@ void lif_prepare_state(
   MALLOC_OR_DIE(state->refractory, sizeof(uint32_t) * n_neurons);
   memset(state->refractory, 0, sizeof(uint32_t) * n_neurons);
 
+  // Allocate space for the bitmap of refractory neurons
+  uint32_t mask_size = sizeof(uint32_t) * ((n_neurons + 31) / 32);
+  MALLOC_OR_DIE(state->refractory_mask, mask_size);
+  memset(state->refractory_mask, 0, mask_size);
+
   // Copy in LIF parameters
   spin1_memcpy(&state->parameters, address, sizeof(lif_parameters_t));
+  return address + sizeof(lif_parameters_t) / sizeof(uint32_t);
 }
 /*****************************************************************************/
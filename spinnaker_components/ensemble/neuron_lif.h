@@ -19,6 +19,7 @@ typedef struct lif_states
   lif_parameters_t parameters;  // Neuron parameters
   value_t *voltages;            // Neuron voltages
   uint8_t *refractory;          // Refractory counters
+  uint32_t *refractory_mask;    // Bitmap of neurons with non-zero counters
 } lif_states_t;
 /*****************************************************************************/
 
@@ -28,89 +29,101 @@ void lif_prepare_state(
     ensemble_state_t *ensemble, // Generic ensemble state
     uint32_t *address           // SDRAM address of neuron parameters
 );
-/*****************************************************************************/
-
-/*****************************************************************************/
-// Get the refractory counter for a given neuron
-static inline uint8_t neuron_refractory(
-  const uint32_t neuron,  // Index of the neuron to simulate
-  const void *state       // Pointer to neuron state(s)
-)
-{
-  // Cast the state to LIF state type
-  lif_states_t *lif_state = (lif_states_t *) state;
 
-  // Return the refractory state for the given neuron
-  return lif_state->refractory[neuron];
-}
+// Initialise the state of a number of LIF neurons, returning a pointer to the
+// word following the LIF parameters.
+uint32_t *lif_initialise_state(
+    lif_states_t *state,        // State to initialise
+    uint32_t n_neurons,         // Number of neurons
+    uint32_t *address           // SDRAM address of LIF parameters
+);
 /*****************************************************************************/
 
 /*****************************************************************************/
-// Decrement the refractory counter for a given neuron
-static inline void neuron_refractory_decrement(
-  const uint32_t neuron,  // Index of the neuron to simulate
-  const void *state       // Pointer to neuron state(s)
+// Get a word indicating which neurons in a block of 32 are not in their
+// refractory period, the most significant bit corresponds to the first neuron
+// in the block.  Bits corresponding to neurons beyond the end of the ensemble
+// are undefined.
+static inline uint32_t lif_active(
+  const uint32_t first_neuron,  // Index of the first neuron in the block
+  const void *state             // Pointer to neuron state(s)
 )
 {
   // Cast the state to LIF state type
   lif_states_t *lif_state = (lif_states_t *) state;
 
-  // Decrement the refractory state for the given neuron
-  lif_state->refractory[neuron]--;
+  return ~lif_state->refractory_mask[first_neuron >> 5];
 }
 /*****************************************************************************/
 
 /*****************************************************************************/
-// Perform a single neuron step
-static inline bool neuron_step(
-  const uint32_t neuron,            // Index of the neuron to simulate
-  const value_t input,              // Input to the neuron
+// Update the state of a block of (at most 32) neurons, returning a word in
+// which the most significant bit indicates whether the first neuron in the
+// block spiked.  Neurons which are in their refractory period have their
+// refractory counters decremented and are otherwise unaffected (their input
+// is ignored).  The first neuron must be a multiple of 32.
+//
+// All neurons are treated identically so that the update may be performed
+// with conditional execution rather than branches.
+static inline uint32_t lif_update(
+  const uint32_t first_neuron,      // Index of the first neuron in the block
+  const uint32_t n_neurons,         // Number of neurons in the block
+  const value_t *inputs,            // Input to each neuron in the block
   const void *state,                // Pointer to neuron state(s)
   recording_buffer_t *rec_voltages  // Pointer to voltage recording
 )
 {
   // Cast the state to LIF state type
   lif_states_t *lif_state = (lif_states_t *) state;
+  value_t *voltages = &lif_state->voltages[first_neuron];
+  uint8_t *refractory = &lif_state->refractory[first_neuron];
 
-  // Compute the change in voltage
-  value_t voltage = lif_state->voltages[neuron];
-  value_t delta_v = (input - voltage) *
-                    lif_state->parameters.exp_dt_over_tau_rc;
-
-  // Update the voltage, but clip it to 0.0
-  voltage += delta_v;
-  if (bitsk(voltage) < bitsk(0.0k))
-  {
-    voltage = 0.0k;
-  }
-
-  // If the neuron hasn't fired then simply store the voltage and return false
-  // to indicate that no spike was produced.
-  if (bitsk(voltage) <= bitsk(1.0k))
-  {
-    lif_state->voltages[neuron] = voltage;
-    record_voltage(rec_voltages, neuron, voltage);
-    return false;
-  }
+  const value_t exp_dt_over_tau_rc = lif_state->parameters.exp_dt_over_tau_rc;
+  const uint8_t tau_ref = (uint8_t) lif_state->parameters.tau_ref;
 
-  // The neuron has spiked, so we prepare to set the voltage and refractory
-  // period for the next simulation period.
-  uint8_t tau_ref = (uint8_t) lif_state->parameters.tau_ref;
-  voltage -= 1.0k;
+  uint32_t spikes = 0x0;
+  uint32_t refractory_mask = 0x0;
 
-  // If the overshoot was particularly big further decrease the neuron voltage
-  // and refractory period.
-  if (bitsk(voltage) > bitsk(2.0k))
+  for (uint32_t i = 0; i < n_neurons; i++)
   {
-    tau_ref--;
-    voltage -= delta_v;
+    const value_t voltage = voltages[i];
+    const uint8_t counter = refractory[i];
+    const bool active = (counter == 0);
+
+    // Compute the change in voltage and update the voltage, but clip it to
+    // 0.0.
+    const value_t delta_v = (inputs[i] - voltage) * exp_dt_over_tau_rc;
+    int32_t v = bitsk(voltage + delta_v);
+    v &= ~(v >> 31);
+
+    // Determine whether the neuron fired, if it did then the voltage is reduced
+    // and the neuron enters its refractory period.  If the overshoot was
+    // particularly big further decrease the neuron voltage and refractory
+    // period.
+    const bool fired = active && (v > bitsk(1.0k));
+    const int32_t v_fired = v - bitsk(1.0k);
+    const bool overshoot = (v_fired > bitsk(2.0k));
+
+    // Store the new voltage and refractory counter, neurons which didn't fire
+    // have their voltage recorded.
+    const int32_t v_next = fired ?
+      (overshoot ? v_fired - bitsk(delta_v) : v_fired) :
+      (active ? v : bitsk(voltage));
+    const uint8_t counter_next = fired ? (uint8_t) (tau_ref - overshoot) :
+                                         (uint8_t) (counter - !active);
+    voltages[i] = kbits(v_next);
+    refractory[i] = counter_next;
+    record_voltage(rec_voltages, first_neuron + i,
+                   kbits((active && !fired) ? v : 0));
+
+    // Include the spike in the spike word and note whether the neuron will be
+    // in its refractory period on the next step.
+    spikes |= (uint32_t) fired << (31 - i);
+    refractory_mask |= (uint32_t) (counter_next != 0) << (31 - i);
   }
 
-  // Store the refractory period and voltage, return true to indicate that a
-  // spike occurred.
-  lif_state->refractory[neuron] = tau_ref;
-  lif_state->voltages[neuron] = voltage;
-  return true;
+  lif_state->refractory_mask[first_neuron >> 5] = refractory_mask;
+  return spikes;
 }
 /*****************************************************************************/
 
@@ -0,0 +1,39 @@
+// Neuron model used by the ensemble
+//
+// The ensemble is built as a separate executable for each neuron model so that
+// the neuron update can be inlined into the simulation loop.  The model is
+// selected by defining one of the macros below, LIF neurons are used if none is
+// defined.  Every model provides:
+//
+//  - `neuron_prepare_state(ensemble, address)` which allocates and initialises
+//    the neuron state from the neuron region of SDRAM.
+//  - `neuron_active(first_neuron, state)` which returns a word indicating
+//    which neurons in a block of 32 require their input to be computed.
+//  - `neuron_update(first_neuron, n_neurons, inputs, state, rec_voltages)`
+//    which updates a block of (at most 32) neurons and returns a word
+//    indicating which neurons in the block spiked.
+//
+// In each case the most significant bit of a word corresponds to the first
+// neuron in the block.
+
+#ifndef __NEURON_MODEL_H__
+#define __NEURON_MODEL_H__
+
+#if defined(NEURON_ADAPTIVE_LIF)
+  #include "neuron_adaptive_lif.h"
+  #define neuron_prepare_state adaptive_lif_prepare_state
+  #define neuron_active adaptive_lif_active
+  #define neuron_update adaptive_lif_update
+#elif defined(NEURON_RECTIFIED_LINEAR)
+  #include "neuron_rectified_linear.h"
+  #define neuron_prepare_state rectified_linear_prepare_state
+  #define neuron_active rectified_linear_active
+  #define neuron_update rectified_linear_update
+#else
+  #include "neuron_lif.h"
+  #define neuron_prepare_state lif_prepare_state
+  #define neuron_active lif_active
+  #define neuron_update lif_update
+#endif
+
+#endif  // __NEURON_MODEL_H__
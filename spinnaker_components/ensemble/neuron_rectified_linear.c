@@ -0,0 +1,28 @@
+#include <string.h>
+
+#include "neuron_rectified_linear.h"
+#include "nengo-common.h"
+
+/*****************************************************************************/
+// Prepare neuron state
+void rectified_linear_prepare_state(
+    ensemble_state_t *ensemble, // Generic ensemble state
+    uint32_t *address           // SDRAM address of neuron parameters
+)
+{
+  // Get the number of neurons
+  uint32_t n_neurons = ensemble->parameters.n_neurons;
+
+  // Prepare space for neuron parameters
+  MALLOC_OR_DIE(ensemble->state, sizeof(rectified_linear_states_t));
+  rectified_linear_states_t *state = ensemble->state;
+
+  // Allocate space for voltages (and zero)
+  MALLOC_OR_DIE(state->voltages, sizeof(value_t) * n_neurons);
+  memset(state->voltages, 0, sizeof(value_t) * n_neurons);
+
+  // Copy in parameters
+  spin1_memcpy(&state->parameters, address,
+               sizeof(rectified_linear_parameters_t));
+}
+/*****************************************************************************/
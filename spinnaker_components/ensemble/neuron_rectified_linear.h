@@ -0,0 +1,93 @@
+// Rectified linear neurons
+//
+// Each neuron integrates its (rectified) input without leak and spikes on
+// reaching threshold, the firing rate is consequently a rectified linear
+// function of the input.
+
+#ifndef __NEURON_RECTIFIED_LINEAR_H__
+#define __NEURON_RECTIFIED_LINEAR_H__
+
+#include "ensemble.h"
+#include "fixed_point.h"
+#include "recording.h"
+
+/*****************************************************************************/
+// State variables for an ensemble of rectified linear neurons
+typedef struct rectified_linear_parameters
+{
+  int32_t dt;                   // Simulation timestep (S0.31)
+} rectified_linear_parameters_t;
+
+typedef struct rectified_linear_states
+{
+  rectified_linear_parameters_t parameters;  // Neuron parameters
+  value_t *voltages;                         // Neuron voltages
+} rectified_linear_states_t;
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Prepare neuron state
+void rectified_linear_prepare_state(
+    ensemble_state_t *ensemble, // Generic ensemble state
+    uint32_t *address           // SDRAM address of neuron parameters
+);
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Get a word indicating which neurons in a block of 32 require their input to
+// be computed, rectified linear neurons are never refractory.
+static inline uint32_t rectified_linear_active(
+  const uint32_t first_neuron,  // Index of the first neuron in the block
+  const void *state             // Pointer to neuron state(s)
+)
+{
+  use(first_neuron);
+  use(state);
+
+  return UINT32_MAX;
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Update the state of a block of (at most 32) neurons, returning a word in
+// which the most significant bit indicates whether the first neuron in the
+// block spiked.
+static inline uint32_t rectified_linear_update(
+  const uint32_t first_neuron,      // Index of the first neuron in the block
+  const uint32_t n_neurons,         // Number of neurons in the block
+  const value_t *inputs,            // Input to each neuron in the block
+  const void *state,                // Pointer to neuron state(s)
+  recording_buffer_t *rec_voltages  // Pointer to voltage recording
+)
+{
+  // Cast the state to rectified linear state type
+  rectified_linear_states_t *rl_state = (rectified_linear_states_t *) state;
+  value_t *voltages = &rl_state->voltages[first_neuron];
+  const int32_t dt = rl_state->parameters.dt;
+
+  uint32_t spikes = 0x0;
+
+  for (uint32_t i = 0; i < n_neurons; i++)
+  {
+    // Rectify the input and integrate it
+    int32_t input = bitsk(inputs[i]);
+    input &= ~(input >> 31);
+    int32_t v = bitsk(voltages[i] + mul_s16_15_s0_31(kbits(input), dt));
+
+    // If the neuron reached threshold then it spikes and the threshold is
+    // subtracted from its voltage.
+    const bool fired = (v > bitsk(1.0k));
+    v -= fired ? bitsk(1.0k) : 0;
+
+    voltages[i] = kbits(v);
+    record_voltage(rec_voltages, first_neuron + i, kbits(v));
+
+    // Include the spike in the spike word
+    spikes |= (uint32_t) fired << (31 - i);
+  }
+
+  return spikes;
+}
+/*****************************************************************************/
+
+#endif  // __NEURON_RECTIFIED_LINEAR_H__
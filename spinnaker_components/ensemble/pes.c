@@ -14,6 +14,7 @@
 
 #include "pes.h"
 #include "filtered_activity.h"
+#include "fixed_point.h"
 
 #include <string.h>
 
@@ -47,92 +48,121 @@ typedef struct pes_parameters_t
 static uint32_t g_num_pes_learning_rules = 0;
 static pes_parameters_t *g_pes_learning_rules = NULL;
 
+// Error signal of every learning rule scaled by its learning rate, computed
+// once per timestep.  The errors of the rules which operate on unfiltered
+// activity come first so that they may be applied together whenever a neuron
+// spikes; `g_pes_error_offsets` is the start of the error of each rule.
+static value_t *g_pes_scaled_errors = NULL;
+static uint32_t *g_pes_error_offsets = NULL;
+
+// Number of decoder elements of a neuron modified when it spikes (the total
+// number of dimensions of the rules which operate on unfiltered activity) and
+// the offset of each element from the first decoder element of the neuron.
+static uint32_t g_num_pes_spike_updates = 0;
+static uint32_t *g_pes_spike_offsets = NULL;
+
 //-----------------------------------------------------------------------------
 // Global functions
 //-----------------------------------------------------------------------------
-void pes_apply(const ensemble_state_t *ensemble, const if_collection_t *modulatory_filters)
+void pes_prepare(const if_collection_t *modulatory_filters)
+{
+  // Loop through all the learning rules
+  for(uint32_t l = 0; l < g_num_pes_learning_rules; l++)
+  {
+    // Extract input signal from filter's output
+    const pes_parameters_t *params = &g_pes_learning_rules[l];
+    const if_filter_t *error_sig = &modulatory_filters->filters[params->error_sig_index];
+    const value_t *error_val = &error_sig->output[params->error_start_dim];
+
+    // Scale the error by the learning rate
+    value_t *scaled_error = &g_pes_scaled_errors[g_pes_error_offsets[l]];
+    const uint32_t n_dims = params->error_end_dim - params->error_start_dim;
+    for(uint32_t d = 0; d < n_dims; d++)
+    {
+      scaled_error[d] = params->learning_rate * error_val[d];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void pes_apply(const ensemble_state_t *ensemble,
+               uint32_t p_start, uint32_t p_end)
 {
+  // If no rules operate on unfiltered activity then there is nothing to do
+  const uint32_t n_updates = g_num_pes_spike_updates;
+  if(n_updates == 0)
+  {
+    return;
+  }
+
   profiler_write_entry(PROFILER_ENTER | PROFILER_PES);
 
   // Extract parameters
-  const ensemble_parameters_t *params = &ensemble->parameters;
-  uint32_t n_neurons_total = params->n_neurons_total;
-  uint32_t n_populations = params->n_populations;
   const uint32_t *pop_lengths = ensemble->population_lengths;
-  value_t *decoder = ensemble->decoders;
+  const uint32_t neuron_stride = ensemble->decoder_neuron_stride;
+
+  // Find the first neuron and spike vector word of the first population
+  uint32_t decoder_col = 0;
   const uint32_t *spike_vector = ensemble->spikes;
+  for (uint32_t p = 0; p < p_start; p++)
+  {
+    decoder_col += pop_lengths[p];
+    spike_vector += (pop_lengths[p] + 31) / 32;
+  }
 
-  // Loop through all the learning rules
-  for(uint32_t l = 0; l < g_num_pes_learning_rules; l++)
+  // Apply every learning rule to each neuron which spiked in a single pass
+  // over the spike vector.
+  for (uint32_t p = p_start; p < p_end; p++)
   {
-    // If this learning rule operates on un-filtered activity and should, therefore be updated here
-    const pes_parameters_t *params = &g_pes_learning_rules[l];
-    if(params->activity_filter_index == -1)
+    // Get the number of neurons in this population
+    uint32_t pop_length = pop_lengths[p];
+
+    // While we have neurons left to process
+    while (pop_length)
     {
-      // Extract input signal from filter's output
-      const if_filter_t *error_sig = &modulatory_filters->filters[params->error_sig_index];
-      const value_t *error_val = error_sig->output;
+      // Determine how many neurons are in the next word of the spike vector.
+      uint32_t n = (pop_length > 32) ? 32 : pop_length;
 
-      // Get pointer to first row of decoder matrix that this learning rule modifies
-      value_t *rule_decoder = &decoder[params->decoder_row * n_neurons_total];
+      // Load the next word of the spike vector
+      uint32_t data = *(spike_vector++);
 
-      // For each population
-      uint32_t decoder_col = 0;
-      for (uint32_t p = 0; p < n_populations; p++)
+      // Include the contribution from each neuron
+      while (n)  // While there are still neurons left
       {
-        // Get the number of neurons in this population
-        uint32_t pop_length = pop_lengths[p];
+        // Work out how many neurons we can skip
+        // XXX: The GCC documentation claims that `__builtin_clz(0)` is
+        // undefined, but the ARM instruction it uses is defined such that:
+        // CLZ 0x00000000 is 32
+        uint32_t skip = __builtin_clz(data);
 
-        // While we have neurons left to process
-        while (pop_length)
+        // If `skip` is NOT less than `n` then there are either no firing
+        // neurons left in the word (`skip` == 32) or the first `1` in the word
+        // is beyond the range of bits we care about anyway.
+        if (skip < n)
         {
-          // Determine how many neurons are in the next word of the spike vector.
-          uint32_t n = (pop_length > 32) ? 32 : pop_length;
+          // Skip until we reach the next neuron which fired
+          decoder_col += skip;
 
-          // Load the next word of the spike vector
-          uint32_t data = *(spike_vector++);
-
-          // Include the contribution from each neuron
-          while (n)  // While there are still neurons left
+          // Subtract the scaled errors from the decoder of the neuron, the
+          // elements are contiguous if the decoders are neuron-major.
+          value_t *neuron_decoder = &ensemble->decoders[decoder_col * neuron_stride];
+          for(uint32_t u = 0; u < n_updates; u++)
           {
-            // Work out how many neurons we can skip
-            // XXX: The GCC documentation claims that `__builtin_clz(0)` is
-            // undefined, but the ARM instruction it uses is defined such that:
-            // CLZ 0x00000000 is 32
-            uint32_t skip = __builtin_clz(data);
-
-            // If `skip` is NOT less than `n` then there are either no firing
-            // neurons left in the word (`skip` == 32) or the first `1` in the word
-            // is beyond the range of bits we care about anyway.
-            if (skip < n)
-            {
-              // Skip until we reach the next neuron which fired
-              decoder_col += skip;
-
-              // Loop through output dimensions and apply PES learning
-              value_t *neuron_decoder = &rule_decoder[decoder_col];
-              for(uint d = params->error_start_dim;
-                  d < params->error_end_dim;
-                  d++, neuron_decoder += n_neurons_total)
-              {
-                *neuron_decoder -= (params->learning_rate * error_val[d]);
-              }
-
-              // Prepare to test the neuron after the one we just processed.
-              decoder_col++;
-              skip++;              // Also skip the neuron we just decoded
-              pop_length -= skip;  // Reduce the number of neurons left
-              n -= skip;           // and the number left in this word.
-              data <<= skip;       // Shift out processed neurons
-            }
-            // Otherwise, if there are no neurons left in this word
-            else
-            {
-              decoder_col += n; // Point at the decoder for the next neuron
-              pop_length -= n;  // Reduce the number left in the population
-              n = 0;            // No more neurons left to process
-            }
+            neuron_decoder[g_pes_spike_offsets[u]] -= g_pes_scaled_errors[u];
           }
+
+          // Prepare to test the neuron after the one we just processed.
+          decoder_col++;
+          skip++;              // Also skip the neuron we just decoded
+          pop_length -= skip;  // Reduce the number of neurons left
+          n -= skip;           // and the number left in this word.
+          data <<= skip;       // Shift out processed neurons
+        }
+        // Otherwise, if there are no neurons left in this word
+        else
+        {
+          decoder_col += n; // Point at the decoder for the next neuron
+          pop_length -= n;  // Reduce the number left in the population
+          n = 0;            // No more neurons left to process
         }
       }
     }
@@ -141,7 +171,7 @@ void pes_apply(const ensemble_state_t *ensemble, const if_collection_t *modulato
   profiler_write_entry(PROFILER_EXIT | PROFILER_PES);
 }
 //-----------------------------------------------------------------------------
-bool pes_initialise(address_t address)
+bool pes_initialise(address_t address, const ensemble_state_t *ensemble)
 {
   // Read number of PES learning rules that are configured
   g_num_pes_learning_rules = address[0];
@@ -153,11 +183,15 @@ bool pes_initialise(address_t address)
     // Allocate memory
     MALLOC_FAIL_FALSE(g_pes_learning_rules,
                       g_num_pes_learning_rules * sizeof(pes_parameters_t));
+    MALLOC_FAIL_FALSE(g_pes_error_offsets,
+                      g_num_pes_learning_rules * sizeof(uint32_t));
     
     // Copy learning rules from region into new array
     memcpy(g_pes_learning_rules, &address[1], g_num_pes_learning_rules * sizeof(pes_parameters_t));
     
-    // Display debug
+    // Display debug and count the dimensions of the rules which operate on
+    // unfiltered and filtered activity.
+    uint32_t n_filtered_dims = 0;
     for(uint32_t l = 0; l < g_num_pes_learning_rules; l++)
     {
       const pes_parameters_t *parameters = &g_pes_learning_rules[l];
@@ -167,41 +201,113 @@ bool pes_initialise(address_t address)
                 l, parameters->learning_rate, parameters->error_sig_index,
                 parameters->error_start_dim, parameters->error_end_dim,
                 parameters->decoder_row, parameters->activity_filter_index);
+
+      const uint32_t n_dims = parameters->error_end_dim -
+                              parameters->error_start_dim;
+      if(parameters->activity_filter_index == -1)
+      {
+        g_num_pes_spike_updates += n_dims;
+      }
+      else
+      {
+        n_filtered_dims += n_dims;
+      }
+    }
+
+    // Allocate space for the scaled errors of every rule
+    const uint32_t n_dims_total = g_num_pes_spike_updates + n_filtered_dims;
+    if(n_dims_total > 0)
+    {
+      MALLOC_FAIL_FALSE(g_pes_scaled_errors, n_dims_total * sizeof(value_t));
+    }
+    if(g_num_pes_spike_updates > 0)
+    {
+      MALLOC_FAIL_FALSE(g_pes_spike_offsets,
+                        g_num_pes_spike_updates * sizeof(uint32_t));
+    }
+
+    // Lay out the scaled errors, rules using unfiltered activity first, and
+    // determine which decoder elements are modified when a neuron spikes.
+    // Decoder rows are numbered across the whole decoder but only the dense
+    // rows (which include all learnt rows) are stored in `decoders`.
+    uint32_t spike_offset = 0;
+    uint32_t filtered_offset = g_num_pes_spike_updates;
+    for(uint32_t l = 0; l < g_num_pes_learning_rules; l++)
+    {
+      const pes_parameters_t *parameters = &g_pes_learning_rules[l];
+      const uint32_t n_dims = parameters->error_end_dim -
+                              parameters->error_start_dim;
+      if(parameters->activity_filter_index == -1)
+      {
+        g_pes_error_offsets[l] = spike_offset;
+        for(uint32_t d = 0; d < n_dims; d++)
+        {
+          g_pes_spike_offsets[spike_offset++] =
+            (parameters->decoder_row - ensemble->first_dense_decoder_row + d) *
+            ensemble->decoder_row_stride;
+        }
+      }
+      else
+      {
+        g_pes_error_offsets[l] = filtered_offset;
+        filtered_offset += n_dims;
+      }
     }
   }
   return true;
 }
 //-----------------------------------------------------------------------------
-/*void pes_step(const if_collection_t *modulatory_filters)
+void pes_step(const ensemble_state_t *ensemble)
 {
+  // Strides through the decoder, decoders are contiguous across output
+  // dimensions if they are stored neuron-major.
+  const uint32_t n_neurons = ensemble->parameters.n_neurons_total;
+  const uint32_t row_stride = ensemble->decoder_row_stride;
+  const uint32_t neuron_stride = ensemble->decoder_neuron_stride;
+
   // Loop through all the learning rules
   for(uint32_t l = 0; l < g_num_pes_learning_rules; l++)
   {
-    // Extract filtered error signal vector indexed by learning rule
-    const pes_parameters_t *parameters = &g_pes_learning_rules[l];
-
     // If this learning rule operates on filtered activity and should, therefore be updated here
-    if(parameters->activity_filter_index != -1)
+    const pes_parameters_t *params = &g_pes_learning_rules[l];
+    if(params->activity_filter_index == -1)
     {
-      // Extract input signal from filter's output
-      const if_filter_t *filtered_input = &modulatory_filters->filters[parameters->error_signal_filter_index];
-      const value_t *filtered_error_signal = filtered_input->output;
+      continue;
+    }
+
+    profiler_write_entry(PROFILER_ENTER | PROFILER_PES);
+
+    // The decoder update is the outer product of the scaled error and the
+    // filtered activities.
+    const value_t *scaled_error = &g_pes_scaled_errors[g_pes_error_offsets[l]];
+    const uint32_t n_dims = params->error_end_dim - params->error_start_dim;
 
-      // Extract filtered activity vector indexed by learning rule
-      const value_t *filtered_activity = g_filtered_activities[parameters->activity_filter_index];
+    // Extract filtered activity vector indexed by learning rule
+    const uint32_t *filtered_activity =
+      g_filtered_activities[params->activity_filter_index];
 
-      // Loop through neurons
-      for(uint n = 0; n < g_ensemble.n_neurons; n++)
+    // Get pointer to first row of decoder matrix that this learning rule modifies
+    value_t *rule_decoder = ensemble_decoder(ensemble, params->decoder_row, 0);
+
+    // Loop through neurons, skipping those which have not spiked recently
+    for (uint32_t n = 0; n < n_neurons; n++)
+    {
+      const uint32_t activity = filtered_activity[n];
+      if (activity == 0)
       {
-        // Get this neuron's decoder vector
-        value_t *decoder_vector = neuron_decoder_vector(n);
+        continue;
+      }
 
-        // Loop through output dimensions and apply PES to decoder values offset by output offset
-        for(uint d = 0; d < filtered_input->size; d++)
-        {
-          decoder_vector[d + parameters->decoder_output_offset] -= (parameters->learning_rate * filtered_activity[n] * filtered_error_signal[d]);
-        }
+      // Convert the U0.32 activity to S0.31 and apply the update to the
+      // decoder of the neuron for each output dimension.
+      const int32_t activity_s0_31 = (int32_t) (activity >> 1);
+      value_t *neuron_decoder = &rule_decoder[n * neuron_stride];
+      for (uint32_t d = 0; d < n_dims; d++, neuron_decoder += row_stride)
+      {
+        *neuron_decoder -= mul_s16_15_s0_31(scaled_error[d], activity_s0_31);
       }
     }
+
+    profiler_write_entry(PROFILER_EXIT | PROFILER_PES);
   }
-}*/
\ No newline at end of file
+}
@@ -27,9 +27,20 @@
 // Inline functions
 //----------------------------------
 /**
-* \brief When using non-filtered activity, applies PES to a spike vector
+* \brief Scale the error signal of every learning rule by its learning rate,
+* this should be called once per timestep after the modulatory filters have
+* been applied.
 */
-void pes_apply(const ensemble_state_t *ensemble, const if_collection_t *modulatory_filters);
+void pes_prepare(const if_collection_t *modulatory_filters);
+
+/**
+* \brief When using non-filtered activity, applies PES to the section of the
+* spike vector belonging to the populations [p_start, p_end)
+*
+* Every such learning rule is applied in a single pass over the spike vector.
+*/
+void pes_apply(const ensemble_state_t *ensemble,
+               uint32_t p_start, uint32_t p_end);
 
 //----------------------------------
 // Functions
@@ -37,11 +48,17 @@ void pes_apply(const ensemble_state_t *ensemble, const if_collection_t *modulato
 /**
 * \brief Copy in data controlling the PES learning 
 * rule from the PES region of the Ensemble.
+*
+* The decoders of the ensemble must already have been prepared.
 */
-bool pes_initialise(address_t address);
+bool pes_initialise(address_t address, const ensemble_state_t *ensemble);
 
-
-//void pes_step(const if_collection_t *modulatory_filters);
+/**
+* \brief When using filtered activity, applies PES to the decoders of every
+* neuron; this should be called once the filtered activities have been
+* updated with the spikes of every population.
+*/
+void pes_step(const ensemble_state_t *ensemble);
 
 /** @} */
 
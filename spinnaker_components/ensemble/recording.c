@@ -1,28 +1,68 @@
 #include "recording.h"
 
 // Generic buffer initialisation
-bool record_buffer_initialise(recording_buffer_t *buffer, address_t region,
-                              uint32_t block_length_words)
+static bool record_buffer_initialise(recording_buffer_t *buffer,
+                                     address_t region,
+                                     uint32_t block_length_words,
+                                     uint32_t dma_tag)
 {
   // Store buffer parameters
   buffer->block_length_words = block_length_words;
+  buffer->_dma_tag = dma_tag;
+
+  // Every region starts with the window in which to record, in compressed
+  // regions this is followed by the header of the recorded frames.
+  region = record_window_initialise(&buffer->window, region);
+  if (buffer->compress)
+  {
+    buffer->_header = (record_header_t *) region;
+    region += sizeof(record_header_t) / sizeof(uint32_t);
+  }
   buffer->_sdram_start = (uint32_t *) region;
   record_buffer_reset(buffer);
 
-  // Create the local buffer
-  MALLOC_FAIL_FALSE(buffer->buffer,
-                    buffer->block_length_words * sizeof(uint32_t));
+  // Create the local frames, the second frame is only required if the data
+  // is to be written into SDRAM.  Compressed frames are preceded by a header.
+  const uint32_t size = buffer->block_length_words * sizeof(uint32_t);
+  const uint32_t header_size = buffer->compress ? sizeof(uint32_t) : 0;
+  MALLOC_FAIL_FALSE(buffer->_buffers[0], header_size + size);
+  if (buffer->record)
+  {
+    MALLOC_FAIL_FALSE(buffer->_buffers[1], header_size + size);
+  }
+  buffer->_current = 0;
+  buffer->buffer = buffer->_buffers[0] + (buffer->compress ? 1 : 0);
+  buffer->_latest = buffer->buffer;
 
-  // Zero the local buffers
-  memset(buffer->buffer, 0x0, buffer->block_length_words * sizeof(uint32_t));
+  // Zero the local frames once; they are not emptied between timesteps as
+  // every recorded value overwrites the value from the previous frame, so
+  // this only ensures that any padding is zero.
+  memset(buffer->_buffers[0], 0x0, header_size + size);
+  if (buffer->record)
+  {
+    memset(buffer->_buffers[1], 0x0, header_size + size);
+  }
 
   return true;
 }
 
 void record_buffer_reset(recording_buffer_t *buffer)
 {
-  // Reset the position of the recording region
+  // Reset the position of the recording region; any DMA from the previous
+  // period of simulation will have completed.
   buffer->_sdram_current = buffer->_sdram_start;
+  buffer->_dma_pending = false;
+
+  // Empty the compressed recording region
+  if (buffer->compress)
+  {
+    buffer->_header->n_words = 0;
+    buffer->_header->n_dropped = 0;
+  }
+
+  // Determine whether the first timestep is to be recorded
+  record_window_reset(&buffer->window);
+  buffer->_sampling = buffer->record && record_window_sample(&buffer->window);
 }
 
 /*****************************************************************************/
@@ -34,17 +74,69 @@ void record_buffer_reset(recording_buffer_t *buffer)
 bool record_buffer_initialise_spikes(
   recording_buffer_t *buffer,
   address_t region,
-  uint n_neurons
+  uint n_neurons,
+  uint32_t dma_tag
 )
 {
   // Compute the block length (an integral number of words allowing for 1 bit
   // per neuron).
   uint32_t block_length_words = (n_neurons / 32) + (n_neurons % 32 ? 1 : 0);
 
+  // A list of indices is only smaller than the bitmap if it contains fewer
+  // than two indices per word of the bitmap, allocate scratch space for that
+  // many to compress frames.
+  if (buffer->compress && block_length_words > 1)
+  {
+    MALLOC_FAIL_FALSE(buffer->_indices,
+                      (block_length_words - 1) * sizeof(uint32_t));
+  }
+
   // Use this to create the recording buffer
-  return record_buffer_initialise(buffer, region, block_length_words);
+  return record_buffer_initialise(buffer, region, block_length_words, dma_tag);
 };
 
+uint32_t record_buffer_compress_spikes(recording_buffer_t *buffer)
+{
+  uint32_t *frame = buffer->_buffers[buffer->_current];
+  const uint32_t *spikes = &frame[1];
+  const uint32_t n_words = buffer->block_length_words;
+
+  // Build the list of indices of neurons which spiked, stopping (and using
+  // the bitmap) if the list would be no smaller than the bitmap.
+  const uint32_t max_spikes = 2 * (n_words - 1);
+  uint32_t n_spikes = 0;
+  for (uint32_t w = 0; w < n_words; w++)
+  {
+    for (uint32_t data = spikes[w]; data; )
+    {
+      if (n_spikes == max_spikes)
+      {
+        frame[0] = RECORD_FRAME_BITMAP;
+        return 1 + n_words;
+      }
+
+      const uint32_t i = 31 - __builtin_clz(data);
+      data ^= 1 << i;
+      buffer->_indices[n_spikes++] = 32*w + i;
+    }
+  }
+
+  // Replace the bitmap with the list of indices, padded to a whole number of
+  // words.
+  frame[0] = n_spikes;
+  uint16_t *indices = (uint16_t *) &frame[1];
+  for (uint32_t n = 0; n < n_spikes; n++)
+  {
+    indices[n] = buffer->_indices[n];
+  }
+  if (n_spikes & 1)
+  {
+    indices[n_spikes] = 0;
+  }
+
+  return 1 + (n_spikes + 1) / 2;
+}
+
 /*****************************************************************************/
 /* Voltage specific functions.
  *
@@ -58,7 +150,8 @@ bool record_buffer_initialise_spikes(
 bool record_buffer_initialise_voltages(
   recording_buffer_t *buffer,
   address_t region,
-  uint n_neurons
+  uint n_neurons,
+  uint32_t dma_tag
 )
 {
   // Compute the block length. We allow for 1 short per neuron and then round
@@ -66,5 +159,27 @@ bool record_buffer_initialise_voltages(
   uint32_t block_length_words = (n_neurons / 2) + (n_neurons % 2);
 
   // Use this to create the recording buffer
-  return record_buffer_initialise(buffer, region, block_length_words);
+  return record_buffer_initialise(buffer, region, block_length_words, dma_tag);
+}
+
+/*****************************************************************************/
+/* Learnt encoder specific functions.
+ */
+
+/*!\brief Initialise a new recording buffer for recording learnt encoders
+ */
+bool record_buffer_initialise_encoders(
+  recording_buffer_t *buffer,
+  address_t region,
+  uint n_neurons,
+  uint n_learnt_dims,
+  uint32_t dma_tag
+)
+{
+  // Allow for 1 word per learnt dimension per neuron; no buffer is required
+  // if the encoders are not recorded as nothing is written to it.
+  uint32_t block_length_words = buffer->record ? n_neurons * n_learnt_dims : 0;
+
+  // Use this to create the recording buffer
+  return record_buffer_initialise(buffer, region, block_length_words, dma_tag);
 }
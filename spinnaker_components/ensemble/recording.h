@@ -1,5 +1,14 @@
 /*!
- * \brief Spike recording
+ * \brief Spike, voltage and encoder recording
+ *
+ * Data is recorded into one of a pair of buffers in DTCM; when a buffer is
+ * flushed it is written into SDRAM by DMA while the other buffer is filled.
+ * Only the timesteps within the window at the start of the recording region
+ * are written (see record_window.h).
+ *
+ * Spikes may be recorded compressed, each frame then starts with a header
+ * word and contains either the indices of the neurons which spiked or the
+ * spike bitmap (whichever is smaller).
  *
  * \author Andrew Mundy <mundya@cs.man.ac.uk>
  *
@@ -17,19 +26,55 @@
 #include "common-typedefs.h"
 #include "nengo_typedefs.h"
 #include "nengo-common.h"
+#include "record_window.h"
 #include <string.h>
 
+/*!\brief Header word of a compressed frame which contains the bitmap, the
+ * header of any other compressed frame is the number of neuron indices it
+ * contains.
+ */
+#define RECORD_FRAME_BITMAP (1u << 31)
+
+/*!\brief Header of a recording region which contains compressed frames.
+ *
+ * The capacity is written by the host, the rest by the executable.
+ */
+typedef struct _record_header_t
+{
+  uint32_t capacity_words;  //!< Words available for frames
+  uint32_t n_words;         //!< Words of frames which have been written
+  uint32_t n_dropped;       //!< Frames dropped because the region was full
+} record_header_t;
+
 typedef struct _recording_buffer_t
 {
   uint32_t *buffer;             //!< The buffer to write to
   uint32_t block_length_words;  //!< Size of 1 block of the buffer
 
-  bool record;  //!< Whether or not to record the data in the buffer
+  bool record;    //!< Whether or not to record the data in the buffer
+  bool compress;  //!< Whether or not to compress frames (spikes only)
+
+  record_window_t window;       //!< Timesteps in which to record
+  bool _sampling;               //!< The current timestep is to be recorded
+
+  uint32_t *_buffers[2];        //!< The pair of frames in DTCM
+  uint32_t _current;            //!< Index of the frame being filled
+  uint32_t *_latest;            //!< Data of the frame flushed most recently
+  volatile bool _dma_pending;   //!< A frame is being written into SDRAM
+  uint32_t _dma_tag;            //!< Tag used for DMAs of this buffer
+
+  uint16_t *_indices;           //!< Scratch space used to compress frames
+  record_header_t *_header;     //!< Header of a compressed recording region
 
   uint32_t *_sdram_start;    //!< Start of the buffer in SDRAM
   uint32_t *_sdram_current;  //!< Current location in the SDRAM buffer
 } recording_buffer_t;
 
+/*!\brief Compress the current frame of a spike recording buffer, returning
+ * the number of words in the compressed frame.
+ */
+uint32_t record_buffer_compress_spikes(recording_buffer_t *buffer);
+
 /*!\brief Reset the recording region for a new period of simulation.
  */
 void record_buffer_reset(recording_buffer_t *buffer);
@@ -37,22 +82,106 @@ void record_buffer_reset(recording_buffer_t *buffer);
 /*!\brief Flush the current buffer.
  *
  * The contents of the buffer will be appended to the recording region in
- * SDRAM, but only if recording is in use.
+ * SDRAM, but only if recording is in use and the current timestep is within
+ * the recording window.  This must be called exactly once per timestep.  The
+ * buffer is written by DMA while recording continues into the other buffer of
+ * the pair, if the other buffer is still being written then the current
+ * buffer is copied synchronously.
  */
 static inline void record_buffer_flush(recording_buffer_t *buffer)
 {
-  // Copy the current buffer into SDRAM
-  if (buffer->record)
+  buffer->_latest = buffer->buffer;
+
+  if (buffer->_sampling)
+  {
+    // Get the frame to write; compressed frames are dropped (and counted) if
+    // they would not fit in the recording region.  Once a frame has been
+    // dropped every later frame is also dropped, so the frames in the region
+    // are always those of the first samples and may be decoded in order.
+    uint32_t *frame = buffer->_buffers[buffer->_current];
+    uint32_t frame_words = buffer->block_length_words;
+    if (buffer->compress)
+    {
+      record_header_t *header = buffer->_header;
+      if (header->n_dropped == 0)
+      {
+        frame_words = record_buffer_compress_spikes(buffer);
+      }
+
+      if (header->n_dropped ||
+          header->n_words + frame_words > header->capacity_words)
+      {
+        header->n_dropped++;
+        frame_words = 0;
+      }
+      else
+      {
+        header->n_words += frame_words;
+      }
+    }
+
+    if (frame_words &&
+        !buffer->_dma_pending &&
+        spin1_dma_transfer(buffer->_dma_tag, buffer->_sdram_current,
+                           frame, DMA_WRITE, frame_words * sizeof(uint32_t)))
+    {
+      // Swap to the other frame while this one is written into SDRAM
+      buffer->_dma_pending = true;
+      buffer->_current ^= 1;
+      buffer->buffer = buffer->_buffers[buffer->_current] +
+                       (buffer->compress ? 1 : 0);
+    }
+    else
+    {
+      // Copy the current frame into SDRAM
+      spin1_memcpy(buffer->_sdram_current, frame,
+                   frame_words * sizeof(uint32_t));
+    }
+
+    // Progress the pointer
+    buffer->_sdram_current += frame_words;
+  }
+
+  // The buffer is not emptied: spikes, voltages and learnt encoders are
+  // written as whole words (or halfwords) which overwrite the previous frame.
+
+  // Determine whether the next timestep is to be recorded
+  buffer->_sampling = buffer->record && record_window_sample(&buffer->window);
+}
+
+/*!\brief Flush the buffer for a timestep whose processing was dropped.
+ *
+ * Nothing is simulated in a dropped timestep, so the frame is either emptied
+ * (`empty`, e.g. for spikes) or made a copy of the frame flushed most recently
+ * (e.g. for voltages) before it is flushed.  This keeps later frames at the
+ * correct timesteps.
+ */
+static inline void record_buffer_flush_dropped(recording_buffer_t *buffer,
+                                               bool empty)
+{
+  if (buffer->_sampling)
   {
-    spin1_memcpy(buffer->_sdram_current, buffer->buffer,
-                 buffer->block_length_words * sizeof(uint32_t));
+    const uint32_t size = buffer->block_length_words * sizeof(uint32_t);
+    if (empty)
+    {
+      memset(buffer->buffer, 0x0, size);
+    }
+    else if (buffer->_latest != buffer->buffer)
+    {
+      spin1_memcpy(buffer->buffer, buffer->_latest, size);
+    }
   }
 
-  // Empty the buffer
-  memset(buffer->buffer, 0x0, buffer->block_length_words * sizeof(uint32_t));
+  record_buffer_flush(buffer);
+}
 
-  // Progress the pointer
-  buffer->_sdram_current += buffer->block_length_words;
+/*!\brief Indicate that the DMA started by flushing the buffer has completed.
+ *
+ * This should be called on completion of any DMA with the tag of the buffer.
+ */
+static inline void record_buffer_dma_complete(recording_buffer_t *buffer)
+{
+  buffer->_dma_pending = false;
 }
 
 /*****************************************************************************/
@@ -64,17 +193,30 @@ static inline void record_buffer_flush(recording_buffer_t *buffer)
 bool record_buffer_initialise_spikes(
   recording_buffer_t *buffer,
   address_t region,
-  uint n_neurons
+  uint n_neurons,
+  uint32_t dma_tag
 );
 
-/*!\brief Record a spike for the given neuron.
+/*!\brief Record the spikes of a block of 32 neurons.
+ *
+ * `spikes` is a word of the spike vector (the first neuron of the block is
+ * the most significant bit), in the recording the first neuron is the least
+ * significant bit.  Every word of the frame is written on every timestep, so
+ * the frame need not be emptied between timesteps.  We write to the buffer
+ * regardless of whether recording is desired or not in order to reduce
+ * branching.
  */
-static inline void record_spike(recording_buffer_t *buffer, uint32_t n_neuron)
+static inline void record_spikes_word(recording_buffer_t *buffer,
+                                      uint32_t first_neuron, uint32_t spikes)
 {
-  // Get the offset within the current buffer, and the specific bit to set
-  // We write to the buffer regardless of whether recording is desired or not
-  // in order to reduce branching.
-  buffer->buffer[n_neuron >> 5] |= 1 << (n_neuron & 0x1f);
+  // Reverse the order of the bits of the word
+  spikes = ((spikes >> 1) & 0x55555555) | ((spikes & 0x55555555) << 1);
+  spikes = ((spikes >> 2) & 0x33333333) | ((spikes & 0x33333333) << 2);
+  spikes = ((spikes >> 4) & 0x0f0f0f0f) | ((spikes & 0x0f0f0f0f) << 4);
+  spikes = ((spikes >> 8) & 0x00ff00ff) | ((spikes & 0x00ff00ff) << 8);
+  spikes = (spikes >> 16) | (spikes << 16);
+
+  buffer->buffer[first_neuron >> 5] = spikes;
 }
 
 /*****************************************************************************/
@@ -90,7 +232,8 @@ static inline void record_spike(recording_buffer_t *buffer, uint32_t n_neuron)
 bool record_buffer_initialise_voltages(
   recording_buffer_t *buffer,
   address_t region,
-  uint n_neurons
+  uint n_neurons,
+  uint32_t dma_tag
 );
 
 /*!\brief Record a voltage for the given neuron.
@@ -108,4 +251,38 @@ static inline void record_voltage(
   data[n_neuron] = (value.bits).lo;
 }
 
+/*****************************************************************************/
+/* Learnt encoder specific functions.
+ *
+ * The learnt encoders of every neuron are recorded on every timestep.
+ */
+
+/*!\brief Initialise a new recording buffer for recording learnt encoders
+ */
+bool record_buffer_initialise_encoders(
+  recording_buffer_t *buffer,
+  address_t region,
+  uint n_neurons,
+  uint n_learnt_dims,
+  uint32_t dma_tag
+);
+
+/*!\brief Record the learnt encoders (all learnt dimensions) of the given
+ * neuron.
+ */
+static inline void record_learnt_encoders(
+    recording_buffer_t *buffer, uint32_t n_neuron, uint32_t n_learnt_dims,
+    const value_t *learnt_encoders
+)
+{
+  if (buffer->_sampling)
+  {
+    value_t *data = (value_t *) &buffer->buffer[n_neuron * n_learnt_dims];
+    for (uint32_t d = 0; d < n_learnt_dims; d++)
+    {
+      data[d] = learnt_encoders[d];
+    }
+  }
+}
+
 #endif
@@ -14,6 +14,7 @@
 
 #include "voja.h"
 #include "filtered_activity.h"
+#include "fixed_point.h"
 
 #include <string.h>
 
@@ -24,14 +25,24 @@ uint32_t g_num_voja_learning_rules = 0;
 voja_parameters_t *g_voja_learning_rules = NULL;
 value_t g_voja_one_over_radius = 1.0k;
 
+// Learning rate of every rule for the current timestep
+static value_t *g_voja_learning_rates = NULL;
+
+// For rules which operate on unfiltered activity, the decoded input scaled by
+// the learning rate and one over the radius for the current timestep (this
+// must be further scaled by the gain of each neuron).
+static uint32_t g_voja_n_dims = 0;
+static value_t *g_voja_scaled_inputs = NULL;
+
 //-----------------------------------------------------------------------------
 // Global functions
 //-----------------------------------------------------------------------------
-bool voja_initialise(address_t address)
+bool voja_initialise(address_t address, uint32_t n_dims)
 {
   // Read number of Voja learning rules that are configured and the scaling factor
   g_num_voja_learning_rules = address[0];
   g_voja_one_over_radius = kbits(address[1]);
+  g_voja_n_dims = n_dims;
 
   io_printf(IO_BUF, "Voja learning: Num rules:%u, One over radius:%k\n",
             g_num_voja_learning_rules, g_voja_one_over_radius);
@@ -41,6 +52,10 @@ bool voja_initialise(address_t address)
     // Allocate memory
     MALLOC_FAIL_FALSE(g_voja_learning_rules,
                       g_num_voja_learning_rules * sizeof(voja_parameters_t));
+    MALLOC_FAIL_FALSE(g_voja_learning_rates,
+                      g_num_voja_learning_rules * sizeof(value_t));
+    MALLOC_FAIL_FALSE(g_voja_scaled_inputs,
+                      g_num_voja_learning_rules * n_dims * sizeof(value_t));
     
     // Copy learning rules from region into new array
     memcpy(g_voja_learning_rules, &address[2], g_num_voja_learning_rules * sizeof(voja_parameters_t));
@@ -56,42 +71,143 @@ bool voja_initialise(address_t address)
   return true;
 }
 //-----------------------------------------------------------------------------
-/*void voja_step(const if_collection_t *modulatory_filters,
-               const if_collection_t *learnt_encoder_filters)
+void voja_apply(const ensemble_state_t *ensemble,
+                const if_collection_t *modulatory_filters,
+                const uint32_t *spikes)
 {
-  // Loop through all the learning rules
+  if(g_num_voja_learning_rules == 0)
+  {
+    return;
+  }
+
+  profiler_write_entry(PROFILER_ENTER | PROFILER_VOJA);
+
+  const uint32_t n_neurons = ensemble->parameters.n_neurons;
+  const uint32_t encoder_width = ensemble->parameters.encoder_width;
+  const uint32_t n_dims = g_voja_n_dims;
+
+  // Determine the learning rate of every rule and scale the decoded inputs
+  // of those which operate on unfiltered activity.
+  bool any_unfiltered = false;
   for(uint32_t l = 0; l < g_num_voja_learning_rules; l++)
   {
-    // If this learning rule operates on filtered activity and should, therefore be updated here
     const voja_parameters_t *parameters = &g_voja_learning_rules[l];
-    if(parameters->activity_filter_index != -1)
+    const value_t learning_rate = voja_get_learning_rate(parameters, modulatory_filters);
+    g_voja_learning_rates[l] = learning_rate;
+
+    if(parameters->activity_filter_index == -1)
     {
-      // Get learning rate
-      const value_t learning_rate = voja_get_learning_rate(parameters, modulatory_filters);
+      any_unfiltered = true;
 
-      // Extract decoded input signal from filter
-      const if_filter_t *decoded_input = &learnt_encoder_filters->filters[parameters->decoded_input_filter_index];
-      const value_t *decoded_input_signal = decoded_input->output;
+      const value_t *decoded_input_signal =
+        ensemble->learnt_input[parameters->decoded_input_filter_index];
+      const value_t input_scale = learning_rate * g_voja_one_over_radius;
+      value_t *scaled_input = &g_voja_scaled_inputs[l * n_dims];
+      for(uint32_t d = 0; d < n_dims; d++)
+      {
+        scaled_input[d] = input_scale * decoded_input_signal[d];
+      }
+    }
+  }
+
+  // Apply the rules which operate on unfiltered activity to the encoders of
+  // each neuron which spiked.
+  for(uint32_t block = 0; block < n_neurons && any_unfiltered; block += 32)
+  {
+    for(uint32_t data = *(spikes++); data; )
+    {
+      const uint32_t i = __builtin_clz(data);
+      const uint32_t n = block + i;
+      data ^= (1 << 31) >> i;
 
-      // Extract filtered activity vector indexed by learning rule
-      const value_t *filtered_activity = g_filtered_activities[parameters->activity_filter_index];
+      value_t *encoder_vector = &ensemble->encoders[encoder_width * n];
+      const value_t gain = ensemble->gain[n];
 
-      // Loop through neurons
-      for(uint n = 0; n < g_ensemble.n_neurons; n++)
+      for(uint32_t l = 0; l < g_num_voja_learning_rules; l++)
       {
-        // Get this neuron's encoder vector, offset by the encoder offset
-        value_t *encoder_vector = neuron_encoder_vector(n) + parameters->encoder_offset;
+        const voja_parameters_t *parameters = &g_voja_learning_rules[l];
+        if(parameters->activity_filter_index != -1)
+        {
+          continue;
+        }
 
-        // Calculate scaling factors for the two terms
-        const value_t encoder_scale = learning_rate * filtered_activity[n];
-        const value_t input_scale = encoder_scale * g_ensemble.gain[n] * g_voja_one_over_radius;
+        // Get this neuron's encoder vector, offset by the encoder offset
+        value_t *learnt_encoder_vector = encoder_vector + parameters->encoder_offset;
+        const value_t learning_rate = g_voja_learning_rates[l];
+        const value_t *scaled_input = &g_voja_scaled_inputs[l * n_dims];
 
         // Loop through input dimensions
-        for(uint d = 0; d < decoded_input->size; d++)
+        for(uint32_t d = 0; d < n_dims; d++)
         {
-          encoder_vector[d] += (input_scale * decoded_input_signal[d]) - (encoder_scale * encoder_vector[d]);
+          learnt_encoder_vector[d] += (gain * scaled_input[d]) -
+                                      (learning_rate * learnt_encoder_vector[d]);
         }
       }
     }
   }
-}*/
\ No newline at end of file
+
+  profiler_write_entry(PROFILER_EXIT | PROFILER_VOJA);
+}
+//-----------------------------------------------------------------------------
+void voja_step(const ensemble_state_t *ensemble, uint32_t neuron_offset)
+{
+  const uint32_t n_neurons = ensemble->parameters.n_neurons;
+  const uint32_t n_dims = g_voja_n_dims;
+  const uint32_t encoder_width = ensemble->parameters.encoder_width;
+
+  // Loop through all the learning rules
+  for(uint32_t l = 0; l < g_num_voja_learning_rules; l++)
+  {
+    // If this learning rule operates on filtered activity and should, therefore be updated here
+    const voja_parameters_t *parameters = &g_voja_learning_rules[l];
+    if(parameters->activity_filter_index == -1)
+    {
+      continue;
+    }
+
+    profiler_write_entry(PROFILER_ENTER | PROFILER_VOJA);
+
+    // Get learning rate
+    const value_t learning_rate = g_voja_learning_rates[l];
+
+    // Get correct signal from learnt input
+    const value_t *decoded_input_signal =
+      ensemble->learnt_input[parameters->decoded_input_filter_index];
+
+    // Extract filtered activity of the neurons simulated on this core
+    const uint32_t *filtered_activity =
+      &g_filtered_activities[parameters->activity_filter_index][neuron_offset];
+
+    // Loop through neurons, skipping those which have not spiked recently
+    for(uint32_t n = 0; n < n_neurons; n++)
+    {
+      const uint32_t activity = filtered_activity[n];
+      if (activity == 0)
+      {
+        continue;
+      }
+
+      // Get this neuron's encoder vector, offset by the encoder offset
+      value_t *learnt_encoder_vector = &ensemble->encoders[encoder_width * n] +
+                                       parameters->encoder_offset;
+
+      // The update is the product of the learning rate, the activity and the
+      // difference between the scaled input and the encoder.  The learning
+      // rate and (U0.32) activity are combined as a S0.31 value as their
+      // product is typically too small to be represented in S16.15.
+      const int32_t encoder_scale = (int32_t) (
+        ((int64_t) bitsk(learning_rate) * activity) >> 16);
+      const value_t input_scale = ensemble->gain[n] * g_voja_one_over_radius;
+
+      // Loop through input dimensions
+      for(uint32_t d = 0; d < n_dims; d++)
+      {
+        learnt_encoder_vector[d] += mul_s16_15_s0_31(
+          (input_scale * decoded_input_signal[d]) - learnt_encoder_vector[d],
+          encoder_scale);
+      }
+    }
+
+    profiler_write_entry(PROFILER_EXIT | PROFILER_VOJA);
+  }
+}
@@ -81,60 +81,39 @@ static inline value_t voja_get_learning_rate(const voja_parameters_t *parameters
     }
 }
 
-/**
-* \brief When using non-filtered activity, applies Voja when neuron spikes
-*/
-static inline void voja_neuron_spiked(value_t *encoder_vector, value_t gain, uint32_t n_dims,
-                                      const if_collection_t *modulatory_filters,
-                                      const value_t **learnt_input)
-{
-  profiler_write_entry(PROFILER_ENTER | PROFILER_VOJA);
-
-  // Loop through all the learning rules
-  for(uint32_t l = 0; l < g_num_voja_learning_rules; l++)
-  {
-    // If this learning rule operates on un-filtered activity and should, therefore be updated here
-    const voja_parameters_t *parameters = &g_voja_learning_rules[l];
-    if(parameters->activity_filter_index == -1)
-    {
-      // Get learning rate
-      const value_t learning_rate = voja_get_learning_rate(parameters, modulatory_filters);
-
-      // Get correct signal from learnt input
-      const value_t *decoded_input_signal = learnt_input[parameters->decoded_input_filter_index];
-
-      // Get this neuron's encoder vector, offset by the encoder offset
-      value_t *learnt_encoder_vector = encoder_vector + parameters->encoder_offset;
-
-      // Calculate scaling factor for input
-      const value_t input_scale = learning_rate * gain * g_voja_one_over_radius;
-
-      // Loop through input dimensions
-      for(uint d = 0; d < n_dims; d++)
-      {
-        learnt_encoder_vector[d] += (input_scale * decoded_input_signal[d]) - (learning_rate * learnt_encoder_vector[d]);
-      }
-    }
-  }
-
-  profiler_write_entry(PROFILER_EXIT | PROFILER_VOJA);
-}
-
 //----------------------------------
 // Functions
 //----------------------------------
 /**
 * \brief Copy in data controlling the Voja learning
 * rule from the Voja region of the Ensemble.
+*
+* `n_dims` is the number of dimensions of the input to the learnt encoders.
+*/
+bool voja_initialise(address_t address, uint32_t n_dims);
+
+/**
+* \brief Determine the learning rate of every learning rule for this timestep
+* and, when using non-filtered activity, apply Voja to the encoders of the
+* neurons which spiked.
+*
+* `spikes` is the section of the spike vector for the neurons simulated on
+* this core.  The learning rates and scaled inputs are computed once per
+* rule, so the cost of the encoder updates depends only on the number of
+* spikes.  This must be called once per timestep, after the neurons have been
+* simulated.
 */
-bool voja_initialise(address_t address);
+void voja_apply(const ensemble_state_t *ensemble,
+                const if_collection_t *modulatory_filters,
+                const uint32_t *spikes);
 
 /**
-* \brief Apply voja learning to encoders
+* \brief When using filtered activity, applies Voja to the encoders of the
+* neurons simulated on this core, the first of which is the
+* `neuron_offset`th neuron of the cluster.  This uses the learning rates
+* determined by `voja_apply`.
 */
-//void voja_step(const if_collection_t *modulatory_filters,
-//               const if_collection_t *learnt_encoder_filters,
-//               const value_t *gain);
+void voja_step(const ensemble_state_t *ensemble, uint32_t neuron_offset);
 
 /** @} */
 
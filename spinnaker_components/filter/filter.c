@@ -17,7 +17,10 @@
  *  2. Output keys
  *  3. Filter parameters
  *  4. Filter routes
- *  5. Transform
+ *  5. Transform (see `transform_format_t`)
+ *  6. Status (see `tick_status.h`)
+ *  7. Transmit schedule (see `transmit_scheduler.h`)
+ *  8. Transmit thresholds (see `delta_transmit.h`)
  *
  * ---
  */
@@ -30,6 +33,9 @@
 #include "input_filtering.h"
 #include "common-impl.h"
 #include "packet_queue.h"
+#include "delta_transmit.h"
+#include "tick_status.h"
+#include "transmit_scheduler.h"
 
 /*****************************************************************************/
 // Global variables
@@ -40,16 +46,50 @@ typedef struct filter_parameters
   uint32_t input_size;        // Number of columns
   uint32_t input_offset;      // Offset input subspace
   uint32_t output_size;       // Number of rows
+  uint32_t packet_queue_length;  // Length of the multicast packet queue
+  uint32_t transform_format;  // Format of the transform (transform_format_t)
 } filter_parameters_t;
 
+// Formats of the transform
+typedef enum _transform_format_t
+{
+  TRANSFORM_DENSE = 0,     // Row-major matrix
+  TRANSFORM_DIAGONAL = 1,  // Column and value of the only element of each row
+  TRANSFORM_SPARSE = 2,    // Compressed sparse rows
+} transform_format_t;
+
+// Transform, the row starts and columns are only used by some formats
+typedef struct _filter_transform_t
+{
+  uint32_t *row_starts;  // Index of the first element of each row (sparse)
+  uint32_t *columns;     // Column of each element (diagonal and sparse)
+  value_t *values;       // Value of each element
+} filter_transform_t;
+
 static filter_parameters_t params;
-static if_collection_t filters;  // Locally applied filters
-static value_t *transform;       // Transform matrix
-uint32_t *keys;                  // Multicast keys
+static if_collection_t filters;      // Locally applied filters
+static filter_transform_t transform; // Transform matrix
+uint32_t *keys;                      // Multicast keys
 
 static packet_queue_t packets;  // Queued multicast packets
 static bool queue_processing;   // Indicate if the queue is being handled
 static unsigned int queue_overflows;
+
+static tick_status_t tick_status;  // Detection of overrunning timesteps
+static transmit_scheduler_t transmit_scheduler;  // Pacing of output packets
+static delta_transmit_t delta_transmit;  // Suppression of unchanged outputs
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Transmit an output value, unless it has barely changed since it was last
+// sent.
+static inline void transmit_output(unsigned int i, value_t output)
+{
+  if (delta_transmit_changed(&delta_transmit, i, output))
+  {
+    transmit_scheduler_send(&transmit_scheduler, keys[i], bitsk(output));
+  }
+}
 /*****************************************************************************/
 
 /*****************************************************************************/
@@ -76,32 +116,19 @@ void multicast_packet_payload(uint key, uint payload)
 
 void process_queue()
 {
-  // Continuously remove packets from the queue and include them in filters
-  while (packet_queue_not_empty(&packets))
+  // Continuously remove batches of packets from the queue and include them in
+  // filters.  Popping need not be a critical section as the queue is only
+  // ever popped from here.
+  packet_t batch[PACKET_QUEUE_BATCH_LENGTH];
+  uint32_t n_packets;
+  while ((n_packets = packet_queue_pop_batch(&packets, batch,
+                                             PACKET_QUEUE_BATCH_LENGTH)))
   {
-    // Pop a packet from the queue (critical section)
-    packet_t packet;
-    uint cpsr = spin1_fiq_disable();
-    bool packet_is_valid = packet_queue_pop(&packets, &packet);
-    spin1_mode_restore(cpsr);
-
-    // Process the received packet
-    if (packet_is_valid)
-    {
-      uint32_t key = packet.key;
-      uint32_t payload = packet.payload;
-
-      input_filtering_input_with_dimension_offset(
-        &filters, key, payload,
-        params.input_offset,   // Offset for all packets
-        params.input_size - 1  // Max expected dimension
-      );
-    }
-    else
-    {
-      io_printf(IO_BUF, "Popped packet from empty queue.\n");
-      rt_error(RTE_ABORT);
-    }
+    input_filtering_input_batch_with_dimension_offset(
+      &filters, n_packets, batch,
+      params.input_offset,   // Offset for all packets
+      params.input_size - 1  // Max expected dimension
+    );
   }
   queue_processing = false;
 }
@@ -122,34 +149,118 @@ void timer_tick(uint ticks, uint arg1)
   use(arg1);
   if (simulation_ticks != UINT32_MAX && ticks >= simulation_ticks)
   {
+    tick_status_finalise(&tick_status);
     spin1_exit(0);
     return;
   }
 
+  // Drop this timestep if the previous one overran and the policy requires.
+  // The input is filtered even if the timestep is dropped, otherwise it would
+  // remain in the accumulators and be added to the input of the next
+  // timestep; only the transform and transmission are dropped.
+  const bool process = tick_status_start(&tick_status, true);
+
   // Process any remaining unprocessed packets
   process_queue();
 
   // Update the filters
   input_filtering_step(&filters);
 
-  spin1_delay_us(3 * (spin1_get_core_id() - 1));
+  if (!process)
+  {
+    return;
+  }
+  transmit_scheduler_tick(&transmit_scheduler);
 
-  // Perform the matrix multiply, transmitting each output value as it is
-  // computed.
-  for (unsigned int i = 0; i < params.output_size; i++)
+  // Apply the transform, transmitting each output value as it is computed
+  // (or queuing it until the schedule allows it to be sent) and then wait for
+  // any queued values to be sent.
+  const value_t *input = filters.output;
+  switch (params.transform_format)
   {
-    // Get the desired row of the matrix
-    value_t *row = transform + i*params.input_size;
+    case TRANSFORM_DIAGONAL:
+      // Scale the single input of each row
+      for (unsigned int i = 0; i < params.output_size; i++)
+      {
+        value_t output = kbits(convert_s32_30_s16_15(
+          __smull(bitsk(transform.values[i]),
+                  bitsk(input[transform.columns[i]]))));
 
-    // Get the output key
-    uint32_t key = keys[i];
+        transmit_output(i, output);
+      }
+      break;
 
-    // Perform the dot-product and transmit the packet
-    value_t output = dot_product(params.input_size, row, filters.output);
+    case TRANSFORM_SPARSE:
+      // Compute the dot-product with the non-zero elements of each row
+      for (unsigned int i = 0; i < params.output_size; i++)
+      {
+        const uint32_t start = transform.row_starts[i];
+        value_t output = sparse_dot_product(
+          transform.row_starts[i + 1] - start, &transform.columns[start],
+          &transform.values[start], input);
 
-    while (!spin1_send_mc_packet(key, bitsk(output), WITH_PAYLOAD))
-    {
-    }
+        transmit_output(i, output);
+      }
+      break;
+
+    default:
+      // Compute the dot-product with each row of the matrix
+      for (unsigned int i = 0; i < params.output_size; i++)
+      {
+        const value_t *row = transform.values + i*params.input_size;
+        value_t output = dot_product(params.input_size, row, input);
+
+        transmit_output(i, output);
+      }
+      break;
+  }
+  delta_transmit_step(&delta_transmit);
+  transmit_scheduler_flush(&transmit_scheduler);
+
+  tick_status_end(&tick_status);
+}
+/*****************************************************************************/
+
+/*****************************************************************************/
+// Copy in the transform from the given region
+static void copy_in_transform(address_t region)
+{
+  const uint32_t n_rows = params.output_size;
+
+  if (params.transform_format == TRANSFORM_DIAGONAL)
+  {
+    // The column of each row and then the value of each row
+    MALLOC_OR_DIE(transform.columns, n_rows * sizeof(uint32_t));
+    MALLOC_OR_DIE(transform.values, n_rows * sizeof(value_t));
+    spin1_memcpy(transform.columns, region, n_rows * sizeof(uint32_t));
+    spin1_memcpy(transform.values, region + n_rows, n_rows * sizeof(value_t));
+
+    io_printf(IO_BUF, "Diagonal transform\n");
+  }
+  else if (params.transform_format == TRANSFORM_SPARSE)
+  {
+    // The index of the first element of each row (and of the end of the last
+    // row), then the column of each element and then the values.
+    const uint32_t row_starts_size = (n_rows + 1) * sizeof(uint32_t);
+    MALLOC_OR_DIE(transform.row_starts, row_starts_size);
+    spin1_memcpy(transform.row_starts, region, row_starts_size);
+
+    const uint32_t n_elements = transform.row_starts[n_rows];
+    MALLOC_OR_DIE(transform.columns, n_elements * sizeof(uint32_t));
+    MALLOC_OR_DIE(transform.values, n_elements * sizeof(value_t));
+
+    const uint32_t *data = region + n_rows + 1;
+    spin1_memcpy(transform.columns, data, n_elements * sizeof(uint32_t));
+    data += n_elements;
+    spin1_memcpy(transform.values, data, n_elements * sizeof(value_t));
+
+    io_printf(IO_BUF, "Sparse transform with %d elements\n", n_elements);
+  }
+  else
+  {
+    uint matrix_size = params.input_size * n_rows * sizeof(value_t);
+    MALLOC_OR_DIE(transform.values, matrix_size);
+    spin1_memcpy(transform.values, region, matrix_size);
   }
 }
 /*****************************************************************************/
@@ -170,18 +281,27 @@ void c_main(void)
   spin1_memcpy(keys, region_start(2, address), key_size);
 
   // Copy in the transform
-  uint matrix_size = params.input_size * params.output_size * sizeof(value_t);
-  MALLOC_OR_DIE(transform, matrix_size);
-  spin1_memcpy(transform, region_start(5, address), matrix_size);
+  copy_in_transform(region_start(5, address));
 
   // Prepare the filters for receiving packets
   input_filtering_get_filters(&filters, region_start(3, address), NULL);
   input_filtering_get_routes(&filters, region_start(4, address));
   input_filtering_initialise_output(&filters, params.input_size);
 
+  // Prepare to detect overrunning timesteps
+  tick_status_initialise(&tick_status, region_start(6, address),
+                         params.machine_timestep);
+
+  // Prepare to pace the transmission of output packets
+  transmit_scheduler_initialise(&transmit_scheduler, region_start(7, address),
+                                params.output_size);
+
+  // Prepare to suppress the transmission of outputs which have barely changed
+  delta_transmit_initialise(&delta_transmit, region_start(8, address));
+
   // Multicast packet queue
   queue_processing = false;
-  packet_queue_init(&packets);
+  packet_queue_init(&packets, params.packet_queue_length);
   queue_overflows = 0;
 
   // Register callbacks, and set the timer up to be out of phase with other
@@ -199,6 +319,8 @@ void c_main(void)
 
     // Determine how long to simulate for
     config_get_n_ticks();
+    tick_status_reset(&tick_status);
+    delta_transmit_reset(&delta_transmit);
 
     // Check on the status of the packet queue
     if (queue_overflows)
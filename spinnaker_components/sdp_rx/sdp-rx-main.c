@@ -11,30 +11,47 @@ void sdp_rx_tick(uint ticks, uint arg1) {
     return;
   }
 
+  // Transmit the fresh values, unless they have barely changed since they
+  // were last sent
   for (uint d = 0; d < g_sdp_rx.n_dimensions; d++) {
     if (g_sdp_rx.fresh[d]) {
-      spin1_send_mc_packet(g_sdp_rx.keys[d],
-                           bitsk(g_sdp_rx.output[d]),
-                           WITH_PAYLOAD);
       g_sdp_rx.fresh[d] = false;
 
-      spin1_delay_us(1);
+      if (delta_transmit_changed(&g_sdp_rx.delta_transmit, d,
+                                 g_sdp_rx.output[d])) {
+        spin1_send_mc_packet(g_sdp_rx.keys[d],
+                             bitsk(g_sdp_rx.output[d]),
+                             WITH_PAYLOAD);
+        spin1_delay_us(1);
+      }
     }
   }
+  delta_transmit_step(&g_sdp_rx.delta_transmit);
 }
 
-/** \brief Receive packed data packed in SDP message
+/** \brief Receive a part of the output vector packed in an SDP message
  */
 void sdp_received(uint mailbox, uint port) {
   use(port);
   sdp_msg_t *message = (sdp_msg_t*) mailbox;
 
-  // Copy the data into the output buffer
-  // Mark values as being fresh
-  value_t * data = (value_t*) message->data;
-  for (uint d = 0; d < g_sdp_rx.n_dimensions; d++) {
-    g_sdp_rx.output[d] = data[d];
-    g_sdp_rx.fresh[d] = true;
+  // Ignore messages which lie outside the vector and parts of the vector
+  // which are older than those already received.
+  const uint offset = message->arg1;
+  const uint n_values = message->arg2;
+  const uint chunk = offset / SDP_VECTOR_MAX_VALUES;
+  if (n_values <= SDP_VECTOR_MAX_VALUES &&
+      offset + n_values <= g_sdp_rx.n_dimensions &&
+      sdp_vector_is_newer(message->seq, g_sdp_rx.last_seq[chunk])) {
+    g_sdp_rx.last_seq[chunk] = message->seq;
+
+    // Copy the data into the output buffer
+    // Mark values as being fresh
+    value_t * data = (value_t*) message->data;
+    for (uint d = 0; d < n_values; d++) {
+      g_sdp_rx.output[offset + d] = data[d];
+      g_sdp_rx.fresh[offset + d] = true;
+    }
   }
   spin1_msg_free(message);
 }
@@ -53,6 +70,15 @@ bool data_system(address_t addr) {
   MALLOC_FAIL_FALSE(g_sdp_rx.fresh, g_sdp_rx.n_dimensions * sizeof(bool));
   MALLOC_FAIL_FALSE(g_sdp_rx.keys, g_sdp_rx.n_dimensions * sizeof(uint));
 
+  // The host numbers vectors from 0, so that the first part of each vector
+  // is always accepted.
+  g_sdp_rx.n_chunks = (g_sdp_rx.n_dimensions + SDP_VECTOR_MAX_VALUES - 1) /
+                      SDP_VECTOR_MAX_VALUES;
+  MALLOC_FAIL_FALSE(g_sdp_rx.last_seq, g_sdp_rx.n_chunks * sizeof(uint16_t));
+  for (uint c = 0; c < g_sdp_rx.n_chunks; c++) {
+    g_sdp_rx.last_seq[c] = UINT16_MAX;
+  }
+
   return true;
 }
 
@@ -76,6 +102,8 @@ void c_main(void) {
   }
 
   data_get_keys(region_start(2, address));
+  delta_transmit_initialise(&g_sdp_rx.delta_transmit,
+                            region_start(3, address));
 
   g_sdp_rx.current_dimension = 0;
 
@@ -96,6 +124,7 @@ void c_main(void) {
 
     // Determine how long to simulate for
     config_get_n_ticks();
+    delta_transmit_reset(&g_sdp_rx.delta_transmit);
 
     // Perform the simulation
     spin1_start(SYNC_WAIT);
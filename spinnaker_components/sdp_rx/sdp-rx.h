@@ -18,6 +18,8 @@
 #include "common-impl.h"
 #include "nengo-common.h"
 #include "nengo_typedefs.h"
+#include "sdp_vector.h"
+#include "delta_transmit.h"
 
 /** \brief Shared Rx parameters.
  */
@@ -30,6 +32,11 @@ typedef struct sdp_rx_parameters {
   value_t *output;          //!< Currently cached output value
   bool *fresh;              //!< Freshness of output
   uint *keys;               //!< Output keys
+
+  uint n_chunks;            //!< Number of messages required for a vector
+  uint16_t *last_seq;       //!< Sequence number last received for each part
+
+  delta_transmit_t delta_transmit;  //!< Suppression of unchanged values
 } sdp_rx_parameters_t;
 extern sdp_rx_parameters_t g_sdp_rx; //!< Global parameters
 
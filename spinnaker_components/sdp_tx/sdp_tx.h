@@ -15,6 +15,7 @@
 
 #include "spin1_api.h"
 #include "input_filtering.h"
+#include "sdp_vector.h"
 
 #include "common-impl.h"
 
@@ -28,6 +29,8 @@ typedef struct sdp_tx_parameters {
 
   value_t *input;          //!< Input buffer
   uint *keys;              //!< Output keys
+
+  uint16_t sequence;       //!< Sequence number of the next vector
 } sdp_tx_parameters_t;
 extern sdp_tx_parameters_t g_sdp_tx; //!< Global parameters
 
@@ -1,25 +1,39 @@
 #include "sdp_tx.h"
+#include "tick_status.h"
 
 sdp_tx_parameters_t g_sdp_tx;
 uint delay_remaining;
 if_collection_t g_input;
+tick_status_t tick_status;
 
 void sdp_tx_update(uint ticks, uint arg1) {
   use(arg1);
   if (simulation_ticks != UINT32_MAX && ticks >= simulation_ticks) {
+    tick_status_finalise(&tick_status);
     spin1_exit(0);
     return;
   }
 
+  // Drop this timestep if the previous one overran and the policy requires.
+  // The input is filtered even if the timestep is dropped, otherwise it would
+  // remain in the accumulators and be added to the input of the next
+  // timestep; only the transmission is dropped.
+  const bool process = tick_status_start(&tick_status, true);
+
   // Update the filters
   input_filtering_step(&g_input);
 
+  if (!process) {
+    return;
+  }
+
   // Increment the counter and transmit if necessary
   delay_remaining--;
   if(delay_remaining == 0) {
     delay_remaining = g_sdp_tx.transmission_delay;
 
-    // Construct and transmit the SDP Message
+    // Construct and transmit the SDP Message(s), vectors which are too large
+    // for a single message are split over several.
     sdp_msg_t message;
     message.dest_addr = 0x0000;        // (0, 0)
     message.dest_port = 0xff;
@@ -29,14 +43,28 @@ void sdp_tx_update(uint ticks, uint arg1) {
     message.tag = 1;                   // Send to IPtag 1
 
     message.cmd_rc = 1;
-    spin1_memcpy(
-      message.data, g_sdp_tx.input, g_sdp_tx.n_dimensions * sizeof(value_t));
-
-    message.length = sizeof(sdp_hdr_t) + sizeof(cmd_hdr_t) + 
-                     g_sdp_tx.n_dimensions * sizeof(value_t);
-
-    spin1_send_sdp_msg(&message, 100);
+    message.seq = g_sdp_tx.sequence++;
+    message.arg3 = 0;
+    for (uint offset = 0; offset < g_sdp_tx.n_dimensions;
+         offset += SDP_VECTOR_MAX_VALUES) {
+      uint n_values = g_sdp_tx.n_dimensions - offset;
+      if (n_values > SDP_VECTOR_MAX_VALUES) {
+        n_values = SDP_VECTOR_MAX_VALUES;
+      }
+
+      message.arg1 = offset;
+      message.arg2 = n_values;
+      spin1_memcpy(message.data, &g_sdp_tx.input[offset],
+                   n_values * sizeof(value_t));
+
+      message.length = sizeof(sdp_hdr_t) + sizeof(cmd_hdr_t) +
+                       n_values * sizeof(value_t);
+
+      spin1_send_sdp_msg(&message, 100);
+    }
   }
+
+  tick_status_end(&tick_status);
 }
 
 bool data_system(address_t addr) {
@@ -45,6 +73,7 @@ bool data_system(address_t addr) {
   g_sdp_tx.transmission_delay = addr[2];
 
   delay_remaining = g_sdp_tx.transmission_delay;
+  g_sdp_tx.sequence = 0;
   io_printf(IO_BUF, "[SDP Tx] Tick period = %d microseconds\n",
             g_sdp_tx.machine_timestep);
   io_printf(IO_BUF, "[SDP Tx] transmission delay = %d\n", delay_remaining);
@@ -71,6 +100,10 @@ void c_main(void) {
     return;
   }
 
+  // Prepare to detect overrunning timesteps
+  tick_status_initialise(&tick_status, region_start(4, address),
+                         g_sdp_tx.machine_timestep);
+
   // Setup timer tick, start
   spin1_set_timer_tick(g_sdp_tx.machine_timestep);
   spin1_callback_on(MCPL_PACKET_RECEIVED, mcpl_callback, -1);
@@ -83,6 +116,7 @@ void c_main(void) {
 
     // Determine how long to simulate for
     config_get_n_ticks();
+    tick_status_reset(&tick_status);
 
     // Perform the simulation
     spin1_start(SYNC_WAIT);
@@ -3,16 +3,31 @@
 #include "common-impl.h"
 #include "input_filtering.h"
 #include "packet_queue.h"
+#include "record_ring.h"
+#include "record_window.h"
+#include "tick_status.h"
+
+// Flags
+enum
+{
+  RECORD_RING = (1 << 0),  // Record into a ring which the host drains
+};
 
 typedef struct _region_system_t
 {
   uint32_t timestep;
   uint32_t input_size;
   uint32_t input_offset;
+  uint32_t packet_queue_length;
+  uint32_t flags;
 } region_system_t;
 region_system_t params;
 
 address_t rec_start, rec_curr;
+record_window_t rec_window;
+record_ring_t rec_ring;
+
+tick_status_t tick_status;  // Detection of overrunning timesteps
 
 if_collection_t filters;
 
@@ -42,32 +57,19 @@ void mcpl_callback(uint key, uint payload)
 
 void process_queue()
 {
-  // Continuously remove packets from the queue and include them in filters
-  while (packet_queue_not_empty(&packets))
+  // Continuously remove batches of packets from the queue and include them in
+  // filters.  Popping need not be a critical section as the queue is only
+  // ever popped from here.
+  packet_t batch[PACKET_QUEUE_BATCH_LENGTH];
+  uint32_t n_packets;
+  while ((n_packets = packet_queue_pop_batch(&packets, batch,
+                                             PACKET_QUEUE_BATCH_LENGTH)))
   {
-    // Pop a packet from the queue (critical section)
-    packet_t packet;
-    uint cpsr = spin1_fiq_disable();
-    bool packet_is_valid = packet_queue_pop(&packets, &packet);
-    spin1_mode_restore(cpsr);
-
-    // Process the received packet
-    if (packet_is_valid)
-    {
-      uint32_t key = packet.key;
-      uint32_t payload = packet.payload;
-
-      input_filtering_input_with_dimension_offset(
-        &filters, key, payload,
-        params.input_offset,   // Offset for all packets
-        params.input_size - 1  // Max expected dimension
-      );
-    }
-    else
-    {
-      io_printf(IO_BUF, "Popped packet from empty queue.\n");
-      rt_error(RTE_ABORT);
-    }
+    input_filtering_input_batch_with_dimension_offset(
+      &filters, n_packets, batch,
+      params.input_offset,   // Offset for all packets
+      params.input_size - 1  // Max expected dimension
+    );
   }
   queue_processing = false;
 }
@@ -85,17 +87,42 @@ void sink_update(uint ticks, uint arg1)
   use(arg1);
   if (simulation_ticks != UINT32_MAX && ticks > simulation_ticks)
   {
+    tick_status_finalise(&tick_status);
     spin1_exit(0);
     return;
   }
 
+  // Count this timestep as dropped if the previous one overran and the
+  // policy requires it.  The input is filtered and recorded even in a dropped
+  // timestep: input left in the accumulators would otherwise be added to the
+  // input of the next timestep.
+  const bool process = tick_status_start(&tick_status, true);
+
   // Process any remaining unprocessed packets
   process_queue();
 
-  // Filter inputs, write the latest value to SRAM
+  // Filter inputs
   input_filtering_step(&filters);
-  spin1_memcpy(rec_curr, filters.output, params.input_size * sizeof(value_t));
-  rec_curr = &rec_curr[params.input_size];
+
+  // Write the latest value to SRAM if this timestep is to be recorded
+  if (record_window_sample(&rec_window))
+  {
+    if (params.flags & RECORD_RING)
+    {
+      record_ring_write(&rec_ring, filters.output);
+    }
+    else
+    {
+      spin1_memcpy(rec_curr, filters.output,
+                   params.input_size * sizeof(value_t));
+      rec_curr = &rec_curr[params.input_size];
+    }
+  }
+
+  if (process)
+  {
+    tick_status_end(&tick_status);
+  }
 }
 
 void c_main(void)
@@ -111,11 +138,16 @@ void c_main(void)
   input_filtering_get_routes(&filters, region_start(3, address));
 
   // Retrieve the recording region
-  rec_start = region_start(15, address);
+  rec_start = record_window_initialise(&rec_window, region_start(15, address));
+  record_ring_initialise(&rec_ring, rec_start, params.input_size);
+
+  // Prepare to detect overrunning timesteps
+  tick_status_initialise(&tick_status, region_start(4, address),
+                         params.timestep);
 
   // Multicast packet queue
   queue_processing = false;
-  packet_queue_init(&packets);
+  packet_queue_init(&packets, params.packet_queue_length);
   queue_overflows = 0;
 
   // Set up callbacks, start
@@ -134,6 +166,9 @@ void c_main(void)
 
     // Reset the recording region location
     rec_curr = rec_start;
+    record_window_reset(&rec_window);
+    record_ring_reset(&rec_ring);
+    tick_status_reset(&tick_status);
 
     // Check on the status of the packet queue
     if (queue_overflows)
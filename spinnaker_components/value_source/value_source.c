@@ -1,5 +1,6 @@
 #include "value_source.h"
 #include "slots.h"
+#include "transmit_scheduler.h"
 
 slots_t slots;            // Slots for output data
 uint* keys;               // Output keys
@@ -8,62 +9,75 @@ uint n_blocks;            // Number of blocks (in total)
 uint current_block;       // Current block
 value_t* blocks;             // Location of blocks in DRAM
 
-uint us_delay;
+volatile bool dma_pending;  // The next block is still being read into its slot
+uint n_late_blocks;         // Number of times the next block was not ready
+
+transmit_scheduler_t transmit_scheduler;  // Pacing of output packets
+
+// Get the number of frames in a block
+static inline uint block_length(uint block) {
+  return (block < pars.n_blocks) ? pars.block_length : pars.partial_block;
+}
+
+// Get the index of the block which follows the current block, or n_blocks if
+// there is no following block.
+static inline uint get_next_block(void) {
+  uint next = current_block + 1;
+  if (next == n_blocks && (pars.flags & 0x1)) {
+    // We are wrapping, so next block is the FIRST block
+    next = 0;
+  }
+  return next;
+}
+
+// Start reading a block into the next slot
+static inline void fetch_block(uint block) {
+  slots.next->length = block_length(block);
+  dma_pending = true;
+  spin1_dma_transfer(0, &blocks[block * pars.block_length * pars.n_dims],
+                     slots.next->data, DMA_READ,
+                     slots.next->length * pars.n_dims * sizeof(value_t));
+}
+
+void dma_complete(uint unused0, uint unused1) {
+  use(unused0);
+  use(unused1);
+
+  dma_pending = false;
+}
 
 void valsource_tick(uint ticks, uint arg1) {
   use(arg1);
   if (simulation_ticks != UINT32_MAX && ticks > simulation_ticks) {
+    if (n_late_blocks) {
+      io_printf(IO_BUF, "[Value Source] %u late blocks\n", n_late_blocks);
+    }
     spin1_exit(0);
     return;
   }
 
-  // Insert a short delay so that packet transmission occurs some time after
-  // the timer tick.  For shorter simulations this will hide the effect of
-  // clock drift for a short period.
-  spin1_delay_us(100);
-
-  // Transmit a MC packet for each value in the current frame
+  // Transmit a MC packet for each value in the current frame, the host
+  // schedules transmission to occur some time after the timer tick (for
+  // shorter simulations this will hide the effect of clock drift for a short
+  // period) and to be spread out over the timestep.
+  transmit_scheduler_tick(&transmit_scheduler);
   for (uint d = 0; d < pars.n_dims; d++) {
-    while(!spin1_send_mc_packet(
-        keys[d],
-        slots.current->data[slots.current->current_pos*pars.n_dims + d],
-        WITH_PAYLOAD))
-    {
-      spin1_delay_us(1);
-    }
-
-    spin1_delay_us(us_delay);
+    transmit_scheduler_send(
+        &transmit_scheduler, keys[d],
+        slots.current->data[slots.current->current_pos*pars.n_dims + d]);
   }
 
-  // Copy in the next block
-  if (slots.current->current_pos == 0) {
-    if (n_blocks > 1) {
-      // More than one block, need to copy in subsequent block
-      value_t *s_addr = &blocks[(current_block + 1) * pars.block_length *
-                                pars.n_dims];
-
-      if (current_block == pars.n_blocks - 1) {
-        // Subsequent block is the LAST block
-        spin1_dma_transfer(0, s_addr, slots.next->data, DMA_READ,
-                           pars.partial_block * pars.n_dims * sizeof(value_t));
-        slots.next->length = pars.partial_block;
-      } else if (current_block == pars.n_blocks) {
-        // Current block is the LAST block
-        if (pars.flags & 0x1) {
-          // We are wrapping, so next block is the FIRST block
-          spin1_dma_transfer(0, blocks, slots.next->data, DMA_READ,
-                             pars.block_length * pars.n_dims * sizeof(value_t));
-          slots.next->length = pars.block_length;
-        }
-      } else {
-        // Nothing special about subsequent block
-        spin1_dma_transfer(0, s_addr, slots.next->data, DMA_READ,
-                           pars.block_length * pars.n_dims * sizeof(value_t));
-        slots.next->length = pars.block_length;
-      }
-    }
+  // Start reading in the next block (if there is one) as soon as the current
+  // block is entered.
+  const uint next_block = get_next_block();
+  if (slots.current->current_pos == 0 && n_blocks > 1 &&
+      next_block < n_blocks) {
+    fetch_block(next_block);
   }
 
+  // Wait for the frame to be transmitted
+  transmit_scheduler_flush(&transmit_scheduler);
+
   // Switch blocks if necessary
   slots.current->current_pos++;
   if (slots.current->current_pos == slots.current->length) {
@@ -77,20 +91,18 @@ void valsource_tick(uint ticks, uint arg1) {
         // Function is not periodic: exit
         spin1_exit(0);
       }
+    } else if (next_block == n_blocks) {
+      // Last block, aperiodic: exit
+      spin1_exit(0);
+    } else if (dma_pending) {
+      // The next block has not yet been read, repeat the last frame of the
+      // current block until it is ready.
+      slots.current->current_pos--;
+      n_late_blocks++;
     } else {
-      // Multiple blocks: next, wrap or exit
-      if (current_block == n_blocks - 1 && !(pars.flags & 0x1)) {
-        // Last block, aperiodic: exit
-        spin1_exit(0);
-      } else {
-        // Not last block, or periodic: next
-        slots_progress(&slots);
-        current_block++;
-
-        // Wrap if necessary
-        if (current_block == n_blocks)
-          current_block = 0;
-      }
+      // Not last block, or periodic: next
+      slots_progress(&slots);
+      current_block = next_block;
     }
   }
 }
@@ -112,14 +124,21 @@ void c_main(void) {
   }
   spin1_memcpy(keys, region_start(2, address), pars.n_dims * sizeof(uint));
 
-  // Initialise the slots with 20KB buffer space
-  if (!initialise_slots(&slots, 20*1024)) {
+  // Initialise the slots with space for a full block each, the host chooses
+  // the length of the blocks such that they fit in DTCM.
+  if (!initialise_slots(&slots,
+                        pars.block_length * pars.n_dims * sizeof(value_t))) {
     return;
   }
 
+  // Prepare to pace the transmission of output packets
+  transmit_scheduler_initialise(&transmit_scheduler, region_start(4, address),
+                                pars.n_dims);
+
   // Set up callbacks, wait for synchronisation
   spin1_set_timer_tick(pars.time_step);
   spin1_callback_on(TIMER_TICK, valsource_tick, 0);
+  spin1_callback_on(DMA_TRANSFER_DONE, dma_complete, 1);
 
   while (true)
   {
@@ -129,29 +148,21 @@ void c_main(void) {
     // Determine how long to simulate for
     config_get_n_ticks();
 
-    // Update the system region
+    // Update the system region, the length of a block is fixed so the slots
+    // need not be reallocated.
     spin1_memcpy(&pars, region_start(1, address), sizeof(system_parameters_t));
     n_blocks = pars.n_blocks + (pars.partial_block > 0 ? 1 : 0);
     current_block = 0;
+    dma_pending = false;
+    n_late_blocks = 0;
 
-    // Copy in the first block of data
+    // Copy in the first block of data while waiting for synchronisation, the
+    // following block is read by DMA as soon as the simulation starts.
     slots_progress(&slots);
-    if(n_blocks > 1)
-    {
-      spin1_memcpy(slots.current->data, region_start(3, address),
-                   pars.n_dims * pars.block_length * sizeof(value_t));
-      slots.current->length = pars.block_length;
-    }
-    else
-    {
-      spin1_memcpy(slots.current->data, region_start(3, address),
-                   pars.n_dims * pars.partial_block * sizeof(value_t));
-      slots.current->length = pars.partial_block;
-    }
-
-    // Compute the us delay between packets, spread the packets out over around
-    // half the timestep.
-    us_delay = (pars.time_step - 100) / (pars.n_dims * 2);
+    slots.current->current_pos = 0;
+    slots.current->length = block_length(0);
+    spin1_memcpy(slots.current->data, blocks,
+                 pars.n_dims * slots.current->length * sizeof(value_t));
 
     // Perform the simulation
     spin1_start(SYNC_WAIT);
@@ -13,6 +13,7 @@ from nengo_spinnaker.builder.model import SignalParameters
 from nengo_spinnaker.builder.netlist import netlistspec
 from nengo_spinnaker.netlist import Vertex, VertexSlice
 from nengo_spinnaker import operators
+from nengo_spinnaker.utils.cost_model import CostModel
 
 
 # used for testing _make_signal_parameters
@@ -40,6 +41,9 @@ def test_model_init():
     assert isinstance(model.decoder_cache, NoDecoderCache)
     assert len(model.keyspaces) == 1
 
+    assert model.cost_model == CostModel()
+    assert model.cpu_target == 0.4
+
 
 def test_model_init_with_keyspaces():
     """Test initialising a model, should be completely empty."""
@@ -412,6 +416,20 @@ class TestMakeSignalParameters(object):
         sig_pars = _make_signal_parameters(a_spec, b_spec, DummyConnection())
         assert sig_pars.latching is latching
 
+    def test_threshold(self):
+        """Test that signals with thresholds are latching."""
+        a_spec = spec(None)
+        b_spec = spec(None)
+
+        sig_pars = _make_signal_parameters(a_spec, b_spec, DummyConnection())
+        assert sig_pars.threshold is None
+        assert not sig_pars.latching
+
+        sig_pars = _make_signal_parameters(a_spec, b_spec, DummyConnection(),
+                                           threshold=0.05)
+        assert sig_pars.threshold == 0.05
+        assert sig_pars.latching
+
     @pytest.mark.parametrize("source_weight, sink_weight",
                              [(4, 7), (5, 2), (2, 2)])
     def test_weight(self, source_weight, sink_weight):
@@ -523,6 +541,45 @@ class TestMakeNetlist(object):
         assert netlist.before_simulation_functions == [pre_fn_a]
         assert netlist.after_simulation_functions == [post_fn_a]
 
+    def test_signal_targets(self):
+        """Test that the filters targeted by signals are collected from the
+        operators and included in the netlist.
+        """
+        # Create the operators, the second receives the signal
+        operator_a = mock.Mock(name="operator A", spec_set=["make_vertices"])
+        operator_a.make_vertices.return_value = \
+            netlistspec((mock.Mock(name="vertex A"), ))
+
+        operator_b = mock.Mock(name="operator B",
+                               spec_set=["make_vertices",
+                                         "get_signal_constraints",
+                                         "get_signal_targets"])
+        operator_b.make_vertices.return_value = \
+            netlistspec((mock.Mock(name="vertex B"), ))
+        operator_b.get_signal_constraints.return_value = {}
+
+        # Create a signal between the operators
+        signal_ab_parameters = SignalParameters(weight=3)
+        operator_b.get_signal_targets.return_value = {
+            id(signal_ab_parameters): {1, 2}
+        }
+
+        # Create the model and generate the netlist
+        model = Model()
+        model.object_operators[mock.Mock()] = operator_a
+        model.object_operators[mock.Mock()] = operator_b
+        model.connection_map.add_connection(
+            operator_a, None, signal_ab_parameters, None,
+            operator_b, None, None
+        )
+        netlist = model.make_netlist()
+
+        # The targets should be given with the operator which reported them
+        signal = next(iter(netlist.nets))
+        assert netlist.signal_targets == {
+            signal: {(operator_b, 1), (operator_b, 2)}
+        }
+
     def test_extra_operators_and_signals(self):
         """Test the operators in the extra_operators list are included when
         building netlists.
@@ -28,6 +28,7 @@ class TestSignalParameters(object):
                   (True, 5, ks(x=2)),
                   (False, 4, ks(x=2)),
                   (False, 5, ks(x=3)),
+                  (True, 5, ks(x=2), 0.1),
                   )
 
         tps = tuple(model.SignalParameters(*args) for args in params)
@@ -55,6 +56,15 @@ class TestSignalParameters(object):
         combined_sps = sps1.concat(sps2)
         assert combined_sps.weight == sps2.weight
 
+    def test_combine_sig_pars_last_threshold(self):
+        """Check that the threshold of the last signal parameters is used."""
+        sps1 = model.SignalParameters(threshold=0.5)
+        sps2 = model.SignalParameters(threshold=0.1)
+        sps3 = model.SignalParameters()
+
+        assert sps1.concat(sps2).threshold == 0.1
+        assert sps1.concat(sps3).threshold is None
+
     @pytest.mark.parametrize(
         "latching_a, latching_b", [(True, True), (False, True), (True, False),
                                    (False, False)])
@@ -687,6 +697,90 @@ class TestConnectionMap(object):
             for s in sinks:
                 assert s.sink_object is sink
 
+    def test_insert_interposers_fuses_chain(self):
+        """Test that a chain of passthrough nodes which would each merit an
+        interposer is simulated by a single interposer with the combined
+        transform and with the synapses along the chain combined.
+        """
+        cm = model.ConnectionMap()
+
+        node = object()
+        ptn1 = model.PassthroughNode()
+        ptn2 = model.PassthroughNode()
+        ptn3 = model.PassthroughNode()
+        sink = object()
+
+        f1 = nengo.synapses.LinearFilter([1], [1, 2])
+        f2 = nengo.synapses.LinearFilter([2], [1, 3])
+        f3 = nengo.synapses.LinearFilter([3], [1, 4])
+
+        # Add connections, each transform between passthrough nodes is dense
+        # enough to merit an interposer.
+        cm.add_connection(
+            node, OutputPort.standard, model.SignalParameters(),
+            NodeTransmissionParameters(Transform(128, 128, 1)),
+            ptn1, InputPort.standard,
+            model.ReceptionParameters(None, 128, None)
+        )
+        cm.add_connection(
+            ptn1, OutputPort.standard, model.SignalParameters(),
+            PassthroughNodeTransmissionParameters(
+                Transform(128, 128, np.ones((128, 128)))
+            ),
+            ptn2, InputPort.standard,
+            model.ReceptionParameters(f1, 128, None)
+        )
+        cm.add_connection(
+            ptn2, OutputPort.standard, model.SignalParameters(),
+            PassthroughNodeTransmissionParameters(
+                Transform(128, 128, 2 * np.ones((128, 128)))
+            ),
+            ptn3, InputPort.standard,
+            model.ReceptionParameters(f2, 128, None)
+        )
+        cm.add_connection(
+            ptn3, OutputPort.standard, model.SignalParameters(),
+            PassthroughNodeTransmissionParameters(
+                Transform(128, 4, np.ones((4, 128)))
+            ),
+            sink, InputPort.standard,
+            model.ReceptionParameters(f3, 4, None)
+        )
+
+        # Only one interposer should be included
+        interposers, new_cm = cm.insert_and_stack_interposers()
+        assert len(interposers) == 1
+        interposer = interposers[0]
+
+        # The node connects to the interposer directly
+        from_node = new_cm._connections[node][OutputPort.standard]
+        for _, sinks in iteritems(from_node):
+            assert [s.sink_object for s in sinks] == [interposer]
+
+        # The interposer applies the combined transform of the chain and the
+        # sink applies the combination of the synapses along the chain.
+        from_interposer = new_cm._connections[interposer][OutputPort.standard]
+        assert len(from_interposer) == 1
+        for (_, transmission_pars), sinks in iteritems(from_interposer):
+            expected = (np.ones((4, 128)).dot(2 * np.ones((128, 128))).dot(
+                np.ones((128, 128))))
+            assert np.array_equal(
+                transmission_pars.full_transform(False, False), expected)
+
+            assert len(sinks) == 1
+            for s in sinks:
+                assert s.sink_object is sink
+
+                rp = s.reception_parameters
+                expected_filter = f1
+                for f in (f2, f3):
+                    expected_filter = nengo.synapses.LinearFilter(
+                        np.polymul(expected_filter.num, f.num),
+                        np.polymul(expected_filter.den, f.den)
+                    )
+                assert np.array_equal(rp.filter.num, expected_filter.num)
+                assert np.array_equal(rp.filter.den, expected_filter.den)
+
     def test_insert_interposer_after_ensemble(self):
         """Test that an interposer can be inserted after a connection from an
         ensemble.
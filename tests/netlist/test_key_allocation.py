@@ -1,11 +1,14 @@
+import mock
 import pytest
 from rig.place_and_route.routing_tree import RoutingTree
 from rig.routing_table import Routes
 from six import iteritems
 
+from nengo_spinnaker.netlist import key_allocation
 from nengo_spinnaker.netlist.key_allocation import (
     build_mn_net_graph, colour_graph, assign_mn_net_ids,
-    build_cluster_graph
+    build_cluster_graph, get_mn_nets_digest, NetIdCache,
+    allocate_signal_keyspaces, order_net_ids
 )
 
 
@@ -199,6 +202,31 @@ def test_colour_graph():
             assert colours[net] != colours[other]
 
 
+def test_colour_graph_disconnected():
+    """Test colouring the graph of disconnected cliques given as an example in
+    the docstring of `colour_graph`.
+    """
+    graph = {
+        'a': {'b'},
+        'b': {'a', 'c', 'd', 'e'},
+        'c': {'b'},
+        'd': {'b'},
+        'e': {'b'},
+        'f': {'g', 'h'},
+        'g': {'f', 'h'},
+        'h': {'f', 'g'},
+        'i': set(),
+    }
+    colours = colour_graph(graph)
+
+    # The greatest degree node is coloured first, each clique reuses the
+    # colours of the others.
+    assert colours['b'] == 0
+    assert all(colours[n] == 1 for n in "acde")
+    assert sorted(colours[n] for n in "fgh") == [0, 1, 2]
+    assert colours['i'] == 0
+
+
 @pytest.mark.parametrize(
     "prior_constraints",
     [{},  # No constraints
@@ -370,3 +398,163 @@ def test_build_cluster_graph_some_edges():
         (1, 0): {(0, 0)},
         (0, 1): set(),  # Every cluster should be in the graph
     }
+
+
+def test_order_net_ids():
+    """Nets which share routes should be assigned identifiers which differ in
+    few bits.
+    """
+    # Nets (a) and (c) take the same route from (0, 0), (b) and (d) take the
+    # same route from (1, 1) and all the nets take the same route from (2, 2).
+    # Nets (a) and (e) share an identifier.
+    def tree(chip, route):
+        return RoutingTree(chip, [(route, object())])
+
+    nets_routes = {
+        'a': [tree((0, 0), Routes.core(1)), tree((2, 2), Routes.east)],
+        'b': [tree((1, 1), Routes.core(1)), tree((2, 2), Routes.east)],
+        'c': [tree((0, 0), Routes.core(1)), tree((2, 2), Routes.east)],
+        'd': [tree((1, 1), Routes.core(1)), tree((2, 2), Routes.east)],
+        'e': [tree((3, 3), Routes.core(2))],
+    }
+    net_ids = {'a': 0, 'b': 1, 'c': 2, 'd': 3, 'e': 0}
+
+    new_ids = order_net_ids(net_ids, nets_routes)
+
+    # Every identifier should be used, nets which shared an identifier should
+    # still do so.
+    assert set(new_ids.values()) == {0, 1, 2, 3}
+    assert new_ids['a'] == new_ids['e']
+
+    # The nets which share routes should differ only in the lowest bit
+    assert new_ids['a'] ^ new_ids['c'] == 1
+    assert new_ids['b'] ^ new_ids['d'] == 1
+
+
+def test_order_net_ids_targets_and_padding():
+    """Nets which target the same filters should be assigned identifiers which
+    differ in few bits, the number of bits used should not be increased.
+    """
+    nets_routes = {n: [RoutingTree((i, 0), [(Routes.core(1), object())])]
+                   for i, n in enumerate("abc")}
+    net_ids = {'a': 0, 'b': 1, 'c': 2}
+    nets_targets = {'a': {("filter", 1)}, 'c': {("filter", 1)},
+                    'b': {("filter", 2)}}
+
+    new_ids = order_net_ids(net_ids, nets_routes, nets_targets)
+
+    assert len(set(new_ids.values())) == 3
+    assert all(0 <= i < 4 for i in new_ids.values())
+    assert new_ids['a'] ^ new_ids['c'] == 1
+
+
+@pytest.mark.skipif(not key_allocation.USE_CFFI,
+                    reason="rig_cpp_key_allocation not installed")
+def test_cffi_assign_cluster_ids():
+    """Test that cluster IDs assigned using rig_cpp_key_allocation respect the
+    same constraints as the graph built by `build_cluster_graph`.
+    """
+    a = object()
+    b = object()
+
+    # The two clusters of the first signal take different routes from (0, 0),
+    # the routes taken by the other signal should not matter.
+    tree_a10 = RoutingTree((1, 0), [(Routes.core(1), b)])
+    tree_a00 = RoutingTree((0, 0), [(Routes.east, tree_a10)])
+    tree_b00 = RoutingTree((0, 0), [(Routes.core(1), a)])
+    tree_b10 = RoutingTree((1, 0), [(Routes.west, tree_b00)])
+    tree_c01 = RoutingTree((0, 1), [(Routes.south, tree_b00)])
+
+    signal_routes = {object(): [tree_a00, tree_b10], object(): [tree_c01]}
+    ids = key_allocation.cffi_assign_cluster_ids(signal_routes)
+
+    assert set(ids) == {(0, 0), (1, 0), (0, 1)}
+    assert ids[(0, 0)] != ids[(1, 0)]
+
+
+def test_get_mn_nets_digest():
+    """The digest should depend upon the routes and constraints of the nets
+    but not on the order in which the nets are given.
+    """
+    tree_a = RoutingTree((0, 0), [(Routes.core(1), object())])
+    tree_b = RoutingTree((0, 0), [(Routes.core(2), object())])
+    tree_c = RoutingTree((1, 0), [(Routes.core(2), object())])
+
+    digest, nets = get_mn_nets_digest({'a': [tree_a], 'b': [tree_b]})
+    assert nets == ['a', 'b']
+
+    # Changing the order or names of the nets should not matter; but the nets
+    # should be returned in the order of their routes.
+    other_digest, nets = get_mn_nets_digest({'y': [tree_b], 'x': [tree_a]})
+    assert digest == other_digest
+    assert nets == ['x', 'y']
+
+    # Changing the routes or constraints should change the digest
+    assert get_mn_nets_digest({'a': [tree_a], 'b': [tree_c]})[0] != digest
+    assert get_mn_nets_digest({'a': [tree_a], 'b': [tree_b]},
+                              {'a': {'b'}})[0] != digest
+
+
+def test_get_mn_nets_digest_targets():
+    """The digest should depend upon which nets share targets but not on the
+    targets themselves.
+    """
+    tree_a = RoutingTree((0, 0), [(Routes.core(1), object())])
+    tree_b = RoutingTree((0, 0), [(Routes.core(2), object())])
+    nets_routes = {'a': [tree_a], 'b': [tree_b]}
+
+    digest, _ = get_mn_nets_digest(nets_routes)
+    separate, _ = get_mn_nets_digest(nets_routes, None,
+                                     {'a': {'t0'}, 'b': {'t1'}})
+    shared, _ = get_mn_nets_digest(nets_routes, None,
+                                   {'a': {'t0'}, 'b': {'t0'}})
+    assert len({digest, separate, shared}) == 3
+
+    # Renaming the targets should not change the digest
+    assert get_mn_nets_digest(nets_routes, None,
+                              {'a': {'t2'}, 'b': {'t2'}})[0] == shared
+
+
+def test_net_id_cache(tmpdir):
+    cache = NetIdCache(str(tmpdir.join("ids")), max_entries=2)
+
+    # Nothing should be returned before the IDs are stored
+    assert cache.get("a", 3) is None
+
+    cache.put("a", [0, 1, 0])
+    assert cache.get("a", 3) == [0, 1, 0]
+
+    # The wrong number of IDs should not be returned
+    assert cache.get("a", 2) is None
+
+    # Storing more entries should remove the oldest entry
+    cache.put("b", [1])
+    tmpdir.join("ids", "a.json").setmtime(0)
+    cache.put("c", [2])
+    assert cache.get("a", 3) is None
+    assert cache.get("b", 1) == [1]
+    assert cache.get("c", 1) == [2]
+
+
+def test_allocate_signal_keyspaces_uses_cache(tmpdir):
+    """Signals which are routed in the same way as those of an earlier model
+    should be assigned the cached IDs.
+    """
+    tree_a = RoutingTree((0, 0), [(Routes.core(1), object())])
+    tree_b = RoutingTree((0, 0), [(Routes.core(2), object())])
+
+    signal_a = mock.Mock(keyspace=None, width=1)
+    signal_b = mock.Mock(keyspace=None, width=1)
+    signal_routes = {signal_a: [tree_a], signal_b: [tree_b]}
+
+    # Store IDs which would not have been chosen by colouring the graph
+    cache = NetIdCache(str(tmpdir))
+    digest, signals = get_mn_nets_digest(signal_routes)
+    cache.put(digest, [3, 5])
+
+    keyspaces = {"nengo": lambda connection_id: mock.Mock(
+        connection_id=connection_id)}
+    allocate_signal_keyspaces(signal_routes, {}, keyspaces, cache)
+
+    assert signals[0].keyspace.connection_id == 3
+    assert signals[1].keyspace.connection_id == 5
@@ -4,8 +4,11 @@ from rig.bitfield import BitField
 from rig.place_and_route import Cores, SDRAM
 from rig.place_and_route.constraints import (ReserveResourceConstraint,
                                              LocationConstraint)
+from rig.place_and_route.routing_tree import RoutingTree
+from rig.routing_table import Routes
 
 from nengo_spinnaker import netlist
+from nengo_spinnaker.utils.keyspaces import KeyspaceContainer
 from nengo_spinnaker.utils.itertools import flatten
 
 
@@ -65,3 +68,26 @@ def test_after_simulation():
 
     after_a.assert_called_once_with(model, simulator, 100)
     after_b.assert_called_once_with(model, simulator, 100)
+
+
+def test_build_routing_tables():
+    """Test that nets which take the same route and have keys which differ in
+    a single bit are merged into a single routing table entry.
+    """
+    ksc = KeyspaceContainer()
+    model = netlist.Netlist(nets={}, operator_vertices={}, keyspaces=ksc)
+
+    # Nets 0 and 1 are routed to core 1, nets 2 and 3 to core 2
+    for i in range(4):
+        net = mock.Mock(name="net {}".format(i))
+        model.net_keyspaces[net] = ksc["nengo"](connection_id=i, cluster=0,
+                                                index=0)
+        model.routes[net] = RoutingTree(
+            (0, 0), [(Routes.core(1 + i // 2), object())])
+    ksc.assign_fields()
+
+    tables = model.build_routing_tables()
+    assert list(tables) == [(0, 0)]
+    assert len(tables[(0, 0)]) == 2
+    assert ({frozenset(e.route) for e in tables[(0, 0)]} ==
+            {frozenset([Routes.core(1)]), frozenset([Routes.core(2)])})
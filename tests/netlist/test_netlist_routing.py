@@ -0,0 +1,75 @@
+import mock
+from rig.netlist import Net
+from rig.place_and_route import Cores, Machine, route
+from rig.place_and_route.constraints import RouteEndpointConstraint
+from rig.place_and_route.routing_tree import RoutingTree
+from rig.routing_table import Routes
+
+from nengo_spinnaker.netlist.routing import route_in_parallel
+
+
+class UnpicklableVertex(object):
+    def __init__(self):
+        self.fn = lambda: None  # Prevents the vertex from being pickled
+
+
+def get_tree_description(tree):
+    """Get the chips, routes and leaves of a routing tree."""
+    description = list()
+    for _, chip, routes in tree.traverse():
+        description.append((chip, sorted(routes)))
+
+    to_visit = [tree]
+    while to_visit:
+        node = to_visit.pop()
+        for direction, child in node.children:
+            if isinstance(child, RoutingTree):
+                to_visit.append(child)
+            else:
+                description.append((direction, id(child)))
+
+    return sorted(description)
+
+
+def test_route_in_parallel_small_netlist():
+    """Netlists with few nets should be routed in the current process."""
+    router = mock.Mock()
+    nets = [mock.Mock()]
+
+    assert (route_in_parallel({}, nets, "machine", [], {}, {}, route=router,
+                              n_processes=2, radius=10) is
+            router.return_value)
+    router.assert_called_once_with({}, nets, "machine", [], {}, {},
+                                   core_resource=Cores, radius=10)
+
+
+def test_route_in_parallel():
+    """Routing in several processes should produce the same routes as routing
+    in a single process.
+    """
+    machine = Machine(4, 4)
+
+    # Create some vertices across the machine, one of which is an external
+    # device.
+    vertices = [UnpicklableVertex() for _ in range(9)]
+    placements = {v: (i % 3, i // 3) for i, v in enumerate(vertices)}
+    allocations = {v: {Cores: slice(1, 2)} for v in vertices[:-1]}
+    allocations[vertices[-1]] = {}
+    vertices_resources = {v: {Cores: 1} for v in vertices[:-1]}
+    vertices_resources[vertices[-1]] = {}
+    constraints = [RouteEndpointConstraint(vertices[-1], Routes.west)]
+
+    # Connect every vertex to several of the others
+    nets = [Net(v, [vertices[(i + j) % len(vertices)] for j in (1, 3, 8)])
+            for i, v in enumerate(vertices[:-1])]
+
+    expected = route(vertices_resources, nets, machine, constraints,
+                     placements, allocations)
+    routes = route_in_parallel(vertices_resources, nets, machine, constraints,
+                               placements, allocations, n_processes=3,
+                               min_nets_per_process=1)
+
+    assert set(routes) == set(nets)
+    for net in nets:
+        assert (get_tree_description(routes[net]) ==
+                get_tree_description(expected[net]))
@@ -1,5 +1,8 @@
 import pytest
+import rig.netlist
 from rig.place_and_route import Cores
+from rig.place_and_route.routing_tree import RoutingTree
+from rig.routing_table import Routes
 
 from nengo_spinnaker.builder.model import Signal, SignalParameters
 from nengo_spinnaker.utils.keyspaces import KeyspaceContainer
@@ -135,6 +138,28 @@ def test_get_nets_for_routing():
         assert extended_allocations[v] == allocations[v]
 
 
+def test_get_router_loads():
+    """Test that the load on each router is the sum of the weights of the nets
+    which pass through it.
+    """
+    # Net a goes from (0, 0) to (1, 0) and on to (1, 1), net b remains on
+    # (1, 0).
+    tree_a_11 = RoutingTree((1, 1), [(Routes.core(1), object())])
+    tree_a = RoutingTree((0, 0), [
+        (Routes.east, RoutingTree((1, 0), [(Routes.north, tree_a_11)]))
+    ])
+    tree_b = RoutingTree((1, 0), [(Routes.core(2), object())])
+
+    net_a = rig.netlist.Net(object(), object(), 3)
+    net_b = rig.netlist.Net(object(), object(), 5)
+
+    assert utils.get_router_loads({net_a: tree_a, net_b: tree_b}) == {
+        (0, 0): 3,
+        (1, 0): 8,
+        (1, 1): 3,
+    }
+
+
 def test_get_net_keyspaces():
     """Test the correct specification of keyspaces for nets."""
     # Create the vertices
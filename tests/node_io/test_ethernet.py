@@ -1,10 +1,14 @@
+import mock
 import nengo
+import numpy as np
 import pytest
+from rig.machine_control.packets import SCPPacket
 
 from nengo_spinnaker.builder import Model
 from nengo_spinnaker.builder.ports import OutputPort, InputPort
 from nengo_spinnaker.node_io import ethernet as ethernet_io
 from nengo_spinnaker.operators import SDPReceiver, SDPTransmitter
+from nengo_spinnaker.utils import type_casts as tp
 
 
 @pytest.mark.parametrize("transmission_period", [0.001, 0.002])
@@ -106,3 +110,73 @@ def test_get_spinnaker_sink_for_node_repeated():
 
     assert spec0.target.obj is spec1.target.obj
     assert model.extra_operators == [spec0.target.obj]
+
+
+def test_set_node_output_splits_vectors():
+    """Check that Node outputs are split over as many packets as required,
+    numbered with the sequence number of the vector and queued to be sent.
+    """
+    io = ethernet_io.Ethernet()
+    node = mock.Mock(name="node")
+    io._node_outgoing[node].append(
+        ((slice(None), None, np.eye(100)), (1, 2, 3)))
+
+    # Set the output of the Node, this should queue two packets
+    value = np.linspace(-1.0, 1.0, 100)
+    for seq in range(2):
+        io.set_node_output(node, value)
+    packets = sorted((SCPPacket.from_bytestring(p) for p in
+                      io.get_pending_packets()), key=lambda p: p.arg1)
+    assert io.get_pending_packets() == list()
+
+    # Only the most recent vector should have been kept
+    assert [(p.arg1, p.arg2, p.seq) for p in packets] == [(0, 64, 1),
+                                                          (64, 36, 1)]
+    for p in packets:
+        assert (p.dest_x, p.dest_y, p.dest_cpu, p.dest_port) == (1, 2, 3, 1)
+
+    data = np.hstack([np.frombuffer(p.data, dtype=np.int32)
+                      for p in packets])
+    assert np.all(data == tp.np_to_fix(value))
+    io.close()
+
+
+def test_EthernetThread_receive():
+    """Check that vectors received in several packets are reassembled, and
+    that parts of vectors older than those already received are ignored.
+    """
+    io = ethernet_io.Ethernet()
+    node = mock.Mock(name="node", size_in=70)
+    io._node_incoming[(1, 2, 3)] = node
+
+    def make_packet(seq, offset, values):
+        return SCPPacket(dest_port=0xff, dest_cpu=0, dest_x=0, dest_y=0,
+                         src_port=4, src_cpu=3, src_x=1, src_y=2, cmd_rc=1,
+                         seq=seq, arg1=offset, arg2=len(values), arg3=0,
+                         data=bytes(tp.np_to_fix(values).data)).bytestring
+
+    thread = ethernet_io.EthernetThread(io)
+    thread.in_sock = mock.Mock()
+    thread.in_sock.recv.side_effect = [
+        make_packet(1, 0, np.ones(64)),
+        make_packet(1, 64, np.ones(6) * 0.5),
+        make_packet(0, 64, np.ones(6) * -0.5),  # Old, should be ignored
+        make_packet(0xffff, 0, np.zeros(64)),  # Old, should be ignored
+        IOError(),
+    ]
+    thread.receive()
+
+    with io.node_input_lock:
+        assert np.all(io.node_input[node][:64] == 1.0)
+        assert np.all(io.node_input[node][64:] == 0.5)
+
+    # The sequence numbers should wrap around
+    for seq, value in ((0x7000, 0.25), (0xe000, -0.25), (0x0000, 0.75)):
+        thread.in_sock.recv.side_effect = [
+            make_packet(seq, 64, np.ones(6) * value), IOError()
+        ]
+        thread.receive()
+
+    with io.node_input_lock:
+        assert np.all(io.node_input[node][64:] == 0.75)
+    io.close()
@@ -1,11 +1,16 @@
 import numpy as np
 import pytest
 from rig.place_and_route import Cores
+import struct
+import tempfile
 
 from nengo_spinnaker.builder import Model
 from nengo_spinnaker.builder.model import SignalParameters
 from nengo_spinnaker.builder.ports import OutputPort
 from nengo_spinnaker.operators.filter import (Filter, Regions,
+                                              TransformFormat,
+                                              TransformRegion,
+                                              divide_rows_by_cost,
                                               get_transforms_and_keys)
 from nengo_spinnaker.builder.node import (
     PassthroughNodeTransmissionParameters, Transform)
@@ -81,6 +86,101 @@ class TestFilter(object):
 
             assert vx.regions[Regions.transform].matrix.shape == (32*3, 3)
 
+    def test_make_vertices_identity_transform_fewer_cores(self):
+        """Test that an identity transform is applied by fewer cores than a
+        dense transform of the same size.
+        """
+        filter_op = Filter(128)
+
+        m = Model()
+        signal_parameters = SignalParameters(False, 128, m.keyspaces["nengo"])
+        transmission_parameters = PassthroughNodeTransmissionParameters(
+                Transform(size_in=128, size_out=128, transform=np.eye(128))
+        )
+        m.connection_map.add_connection(
+            filter_op, OutputPort.standard, signal_parameters,
+            transmission_parameters, None, None, None
+        )
+
+        # A dense transform would require 2 cores
+        netlistspec = filter_op.make_vertices(m, 10000)
+        assert len(netlistspec.vertices) == 1
+
+        vx = netlistspec.vertices[0]
+        assert vx.regions[Regions.transform].format is \
+            TransformFormat.diagonal
+        assert (vx.regions[Regions.system].transform_format ==
+                TransformFormat.diagonal)
+
+
+class TestTransformRegion(object):
+    def test_dense(self):
+        matrix = np.arange(1, 7, dtype=np.int32).reshape(3, 2)
+        region = TransformRegion(matrix)
+        assert region.format is TransformFormat.dense
+        assert list(region.row_costs()) == [3, 3, 3]
+
+        sl = slice(1, 3)
+        assert region.sizeof(sl) == 4 * 4
+
+        fp = tempfile.TemporaryFile()
+        region.write_subregion_to_file(fp, sl)
+        fp.seek(0)
+        assert struct.unpack("<4i", fp.read()) == (3, 4, 5, 6)
+
+    def test_diagonal(self):
+        matrix = np.array([[0, 7, 0],
+                           [0, 0, 0],
+                           [-2, 0, 0],
+                           [0, 0, 5]], dtype=np.int32)
+        region = TransformRegion(matrix)
+        assert region.format is TransformFormat.diagonal
+        assert list(region.row_costs()) == [2, 2, 2, 2]
+
+        sl = slice(0, 3)
+        assert region.sizeof(sl) == 3 * 8
+
+        # Columns and then values
+        fp = tempfile.TemporaryFile()
+        region.write_subregion_to_file(fp, sl)
+        fp.seek(0)
+        assert struct.unpack("<3I3i", fp.read()) == (1, 0, 0, 7, 0, -2)
+
+    def test_sparse(self):
+        matrix = np.zeros((4, 8), dtype=np.int32)
+        matrix[0, [1, 6]] = (3, 4)
+        matrix[2, [0, 2, 7]] = (5, -6, 7)
+        matrix[3, [3, 4]] = (8, 9)
+        region = TransformRegion(matrix)
+        assert region.format is TransformFormat.sparse
+        assert list(region.row_costs()) == [5, 1, 7, 5]
+
+        sl = slice(1, 4)
+        assert region.sizeof(sl) == 4 * 4 + 8 * 5
+
+        # Row pointers, columns and then values
+        fp = tempfile.TemporaryFile()
+        region.write_subregion_to_file(fp, sl)
+        fp.seek(0)
+        assert struct.unpack("<4I5I5i", fp.read()) == (
+            0, 0, 3, 5,
+            0, 2, 7, 3, 4,
+            5, -6, 7, 8, 9
+        )
+
+
+@pytest.mark.parametrize(
+    "costs, n_slices, slices",
+    [([1] * 6, 2, [slice(0, 3), slice(3, 6)]),
+     ([1] * 5, 1, [slice(0, 5)]),
+     ([9, 1, 1, 1, 1, 1, 1, 1, 1, 1], 2, [slice(0, 1), slice(1, 10)]),
+     ([1, 1, 1, 9], 4, [slice(0, 1), slice(1, 2), slice(2, 3),
+                        slice(3, 4)]),
+     ]
+)
+def test_divide_rows_by_cost(costs, n_slices, slices):
+    assert list(divide_rows_by_cost(np.array(costs), n_slices)) == slices
+
 
 def test_get_transforms_and_keys():
     """Test that the complete transform matrix is constructed correctly and
@@ -1,4 +1,6 @@
 import itertools
+import math
+import mock
 import nengo
 import numpy as np
 import pytest
@@ -6,6 +8,7 @@ import struct
 import tempfile
 
 from nengo_spinnaker.operators import lif
+from nengo_spinnaker.regions.filters import FilterRegion, LowpassFilter
 from nengo_spinnaker.utils import type_casts as tp
 
 
@@ -38,6 +41,12 @@ class TestEnsembleLIF(object):
 @pytest.mark.parametrize("record_spikes", (True, False))
 @pytest.mark.parametrize("record_voltages", (True, False))
 @pytest.mark.parametrize("record_encoders", (True, False))
+@pytest.mark.parametrize("packed_encoders, encoder_frac_bits",
+                         ((False, 0), (True, 12)))
+@pytest.mark.parametrize("compress_spikes", (True, False))
+@pytest.mark.parametrize("sdram_regions, sdram_mask",
+                         (((), 0x0),
+                          ((lif.Regions.bias, lif.Regions.gain), 0x30)))
 def test_EnsembleRegion(machine_timestep, size_in, encoder_width,
                         n_populations, n_neurons_in_population, population_id,
                         n_learnt_input_signals,
@@ -46,19 +55,23 @@ def test_EnsembleRegion(machine_timestep, size_in, encoder_width,
                         shared_learnt_input_vector, shared_spike_vector,
                         sema_input, sema_spikes,
                         n_profiler_samples, record_spikes, record_voltages,
-                        record_encoders):
+                        record_encoders, packed_encoders, encoder_frac_bits,
+                        compress_spikes, sdram_regions, sdram_mask):
     # Create the region
     region = lif.EnsembleRegion(machine_timestep, size_in, encoder_width,
                                 n_learnt_input_signals,
                                 record_spikes=record_spikes,
                                 record_voltages=record_voltages,
-                                record_encoders=record_encoders)
+                                record_encoders=record_encoders,
+                                packed_encoders=packed_encoders,
+                                encoder_frac_bits=encoder_frac_bits,
+                                compress_spikes=compress_spikes)
 
     # Update the region
     region.n_profiler_samples = n_profiler_samples
 
     # Check that the size is reported correctly
-    assert region.sizeof() == (18 + n_learnt_input_signals) * 4
+    assert region.sizeof() == (21 + n_learnt_input_signals) * 4
 
     # Check that the region is written out correctly
     fp = tempfile.TemporaryFile()
@@ -66,7 +79,7 @@ def test_EnsembleRegion(machine_timestep, size_in, encoder_width,
         fp, n_populations, population_id, n_neurons_in_population, input_slice,
         neuron_slice, output_slice, learnt_output_slice, shared_input_vector,
         shared_learnt_input_vector, shared_spike_vector,
-        sema_input, sema_spikes
+        sema_input, sema_spikes, sdram_regions
     )
 
     # Check that the correct amount of data was written
@@ -82,11 +95,15 @@ def test_EnsembleRegion(machine_timestep, size_in, encoder_width,
         flags |= 1 << 1
     if record_encoders:
         flags |= 1 << 2
+    if packed_encoders:
+        flags |= 1 << 3
+    if compress_spikes:
+        flags |= 1 << 4
 
     # Check that the data was correct
-    unpacked = struct.unpack("<%uI" % (18 + n_learnt_input_signals), data)
+    unpacked = struct.unpack("<%uI" % (21 + n_learnt_input_signals), data)
 
-    assert unpacked[:18] == (
+    assert unpacked[:21] == (
         machine_timestep,
         neuron_slice.stop - neuron_slice.start,
         size_in,
@@ -101,12 +118,83 @@ def test_EnsembleRegion(machine_timestep, size_in, encoder_width,
         n_profiler_samples,
         n_learnt_input_signals,
         flags,
+        1024,
+        encoder_frac_bits,
+        sdram_mask,
         shared_input_vector,
         shared_spike_vector,
         sema_input,
         sema_spikes)
 
-    assert list(unpacked[18:18 + n_learnt_input_signals]) == shared_learnt_input_vector
+    assert list(unpacked[21:21 + n_learnt_input_signals]) == shared_learnt_input_vector
+
+
+def test_get_sdram_resident_regions():
+    sizes = {lif.Regions.bias: 400, lif.Regions.gain: 400}
+
+    # Everything fits in DTCM
+    assert lif.get_sdram_resident_regions(5000, sizes, 5000) == []
+
+    # The coldest regions are left in SDRAM first
+    assert (lif.get_sdram_resident_regions(5200, sizes, 5000) ==
+            [lif.Regions.bias])
+    assert (lif.get_sdram_resident_regions(5500, sizes, 5000) ==
+            [lif.Regions.bias, lif.Regions.gain])
+
+    # Only regions with a size may be left in SDRAM
+    assert (lif.get_sdram_resident_regions(
+        5200, {lif.Regions.gain: 400}, 5000) == [lif.Regions.gain])
+
+    # The encoders are never left in SDRAM
+    sizes[lif.Regions.encoders] = 4000
+    assert (lif.get_sdram_resident_regions(9000, sizes, 5000) ==
+            [lif.Regions.bias, lif.Regions.gain])
+
+
+def test_min_dtcm_usage():
+    """The DTCM used when the bias and gain are left in SDRAM should be that
+    of the remaining data, partitioning against this ensures that every slice
+    fits once the candidate regions are left in SDRAM.
+    """
+    core_usage = lif.CoreResouceUsage(4, 100)
+    slices = (slice(0, 4), slice(0, 50), slice(0, 0), slice(0, 0))
+    assert (core_usage.dtcm_usage(*slices) -
+            core_usage.min_dtcm_usage(*slices) == 50 * 2 * 4)
+
+    cluster_usage = lif.ClusterResourceUsage(4, 0, 0, n_cores=2)
+    assert (cluster_usage.dtcm_usage(slice(0, 100)) -
+            cluster_usage.min_dtcm_usage(slice(0, 100)) == 50 * 2 * 4)
+
+
+@pytest.mark.parametrize("size_in", (1, 4, 5))
+def test_get_packed_encoders(size_in):
+    """Test that encoders are packed into pairs of 16-bit values with as many
+    fractional bits as possible.
+    """
+    encoders = np.random.uniform(-1.0, 1.0, size=(10, size_in))
+    encoders[0, 0] = 3.0  # Largest value requires 2 integer bits
+
+    packed, frac_bits = lif.get_packed_encoders(encoders, 2.0)
+    assert frac_bits == 13
+    assert packed.dtype == np.int16
+    assert packed.shape == (10, size_in + size_in % 2)
+    assert np.all(packed[:, size_in:] == 0)
+    assert np.allclose(packed[:, :size_in] / 2.0**frac_bits, encoders,
+                       atol=2.0**-frac_bits)
+
+
+def test_get_packed_encoders_fails():
+    """Test that encoders are not packed if the input range is too large or
+    the quantisation error would be too large.
+    """
+    encoders = np.random.uniform(-1.0, 1.0, size=(10, 4))
+    assert lif.get_packed_encoders(encoders, 100.0) is None
+
+    # Large encoder values leave few fractional bits for small ones
+    encoders[0, 0] = 1000.0
+    encoders[1, 0] = 0.001
+    assert lif.get_packed_encoders(encoders, 2.0, max_error=2.0**-20) is None
+    assert lif.get_packed_encoders(encoders, 2.0, max_error=None) is not None
 
 
 @pytest.mark.parametrize(
@@ -135,6 +223,201 @@ def test_LIFRegion(dt, tau_rc, tau_ref):
     assert (tp.value_to_fix(-np.expm1(-dt / tau_rc)) * 0.9 < dt_over_t_rc <
             tp.value_to_fix(-np.expm1(-dt / tau_rc)) * 1.1)
 
+
+@pytest.mark.parametrize("tau_n, inc_n", [(1.0, 0.01), (0.1, 0.5)])
+def test_AdaptiveLIFRegion(tau_n, inc_n):
+    """Test region specific to adaptive LIF neurons."""
+    dt, tau_rc, tau_ref = 0.001, 0.02, 0.002
+    region = lif.AdaptiveLIFRegion(dt, tau_rc, tau_ref, tau_n, inc_n)
+    assert region.application == "ensemble_adaptive_lif"
+
+    # Check that the size is reported correctly
+    assert region.sizeof() == 4*4  # 4 words
+
+    # Write the region out
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    values = fp.read()
+    assert len(values) == region.sizeof()
+
+    # The LIF parameters should be written first
+    lif_fp = tempfile.TemporaryFile()
+    lif.LIFRegion(dt, tau_rc, tau_ref).write_subregion_to_file(lif_fp)
+    lif_fp.seek(0)
+    assert values[:8] == lif_fp.read()
+
+    # Followed by the adaptation parameters
+    dt_over_tau_n, inc_n_over_tau_n = struct.unpack("<Ii", values[8:])
+    assert dt_over_tau_n == int(round(dt / tau_n * 2**31))
+    assert inc_n_over_tau_n == tp.value_to_fix(inc_n / tau_n)
+
+
+@pytest.mark.parametrize("tau_n", [0.001, 0.0005])
+def test_AdaptiveLIFRegion_fails_tau_n_too_small(tau_n):
+    """The adaptation time constant must be greater than the timestep."""
+    with pytest.raises(ValueError) as excinfo:
+        lif.AdaptiveLIFRegion(0.001, 0.02, 0.002, tau_n, 0.01)
+    assert "tau_n" in str(excinfo.value)
+
+
+@pytest.mark.parametrize("dt", [0.001, 0.0001])
+def test_RectifiedLinearRegion(dt):
+    """Test region specific to rectified linear neurons."""
+    region = lif.RectifiedLinearRegion(dt)
+    assert region.application == "ensemble_rectified_linear"
+    assert region.sizeof() == 4
+
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    assert struct.unpack("<I", fp.read()) == (int(round(dt * 2**31)), )
+
+
+@pytest.mark.parametrize(
+    "neuron_type, region_type",
+    [(nengo.neurons.LIF(), lif.LIFRegion),
+     (nengo.neurons.AdaptiveLIF(), lif.AdaptiveLIFRegion),
+     (nengo.neurons.RectifiedLinear(), lif.RectifiedLinearRegion)]
+)
+def test_make_neuron_region(neuron_type, region_type):
+    region = lif.make_neuron_region(neuron_type, 0.001)
+    assert type(region) is region_type
+
+
+def test_make_neuron_region_unsupported():
+    with pytest.raises(NotImplementedError):
+        lif.make_neuron_region(nengo.neurons.Sigmoid(), 0.001)
+
+
+def _read_decoder_region(region, output_slice, neuron_slice):
+    """Write a slice of a decoder region and return the header and data."""
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp, output_slice, neuron_slice)
+    fp.seek(0)
+    data = fp.read()
+    assert len(data) == region.sizeof(output_slice, neuron_slice)
+
+    storage, n = struct.unpack_from("<2I", data)
+    return storage, n, data[8:]
+
+
+def test_DecoderRegion_dense():
+    decoders = np.random.uniform(-1.0, 1.0, size=(5, 20))
+    region = lif.DecoderRegion(decoders)
+    assert region.storage is lif.DecoderStorage.dense
+
+    storage, n, data = _read_decoder_region(region, slice(1, 3), slice(4, 9))
+    assert storage == lif.DecoderStorage.dense
+    assert n == 0
+    assert np.array_equal(np.frombuffer(data, dtype=np.int32),
+                          tp.np_to_fix(decoders[1:3, 4:9]).flatten())
+
+
+def test_DecoderRegion_factored():
+    # Construct a low-rank decoder matrix
+    transform = np.random.uniform(-1.0, 1.0, size=(10, 2))
+    factors = np.random.uniform(-1.0, 1.0, size=(2, 50))
+    decoders = np.dot(transform, factors)
+    region = lif.DecoderRegion(decoders, lif.DecoderStorage.factored)
+
+    # Slices with many rows should be factored
+    storage, n, data = _read_decoder_region(region, slice(1, 9), slice(0, 40))
+    assert storage == lif.DecoderStorage.factored
+    assert n == 2
+
+    # Multiplying the factors out should give the original decoders
+    values = tp.fix_to_np(np.frombuffer(data, dtype=np.int32))
+    factored = values[:40 * 2].reshape(40, 2).T
+    transform = values[40 * 2:].reshape(8, 2)
+    assert np.allclose(np.dot(transform, factored), decoders[1:9, 0:40],
+                       atol=2**-10)
+
+    # A slice with a single row requires less memory if stored densely
+    storage, n, _ = _read_decoder_region(region, slice(0, 1), slice(0, 40))
+    assert storage == lif.DecoderStorage.dense
+
+
+def test_DecoderRegion_sparse():
+    decoders = np.zeros((4, 10))
+    decoders[0, 1] = 1.0
+    decoders[3, 1] = 2.0
+    decoders[2, 7] = -1.0
+    region = lif.DecoderRegion(decoders, lif.DecoderStorage.sparse)
+
+    storage, n, data = _read_decoder_region(region, slice(0, 4), slice(1, 9))
+    assert storage == lif.DecoderStorage.sparse
+    assert n == 3
+
+    # Index of the first element of each column
+    columns = np.frombuffer(data[:9 * 4], dtype=np.uint32)
+    assert list(columns) == [0, 2, 2, 2, 2, 2, 2, 3, 3]
+
+    # Rows (padded to a whole number of words) and then values
+    rows = np.frombuffer(data[9 * 4:9 * 4 + 8], dtype=np.uint16)
+    assert list(rows[:3]) == [0, 3, 2]
+    values = np.frombuffer(data[9 * 4 + 8:], dtype=np.int32)
+    assert list(values) == [tp.value_to_fix(1.0), tp.value_to_fix(2.0),
+                            tp.value_to_fix(-1.0)]
+
+
+def test_DecoderRegion_streamed():
+    decoders = np.random.uniform(-1.0, 1.0, size=(5, 300))
+    region = lif.DecoderRegion(decoders, lif.DecoderStorage.streamed)
+
+    # The full matrix is written, preceded by the number of rows per block
+    storage, n, data = _read_decoder_region(region, slice(0, 5), slice(0, 300))
+    assert storage == lif.DecoderStorage.streamed
+    assert n == 3
+    assert np.array_equal(np.frombuffer(data, dtype=np.int32),
+                          tp.np_to_fix(decoders).flatten())
+
+    # Only two blocks are held in DTCM
+    assert region.estimate_words(5, 300) == 2 * 3 * 300
+
+
+@pytest.mark.parametrize(
+    "n_rows, n_neurons, rows_per_block",
+    [(10, 100, 10), (10, 200, 5), (3, 5000, 1), (0, 100, 1)]
+)
+def test_get_rows_per_block(n_rows, n_neurons, rows_per_block):
+    assert lif.get_rows_per_block(n_rows, n_neurons) == rows_per_block
+
+
+def test_DecoderRegion_chooses_storage():
+    # Sparse decoders
+    decoders = np.zeros((8, 100))
+    decoders[np.arange(8), np.arange(8)] = 1.0
+    assert lif.DecoderRegion(decoders, None).storage is \
+        lif.DecoderStorage.sparse
+
+    # Low rank decoders
+    decoders = np.dot(np.random.uniform(-1.0, 1.0, size=(8, 1)),
+                      np.random.uniform(-1.0, 1.0, size=(1, 100)))
+    assert lif.DecoderRegion(decoders, None).storage is \
+        lif.DecoderStorage.factored
+
+    # Full rank, dense decoders
+    decoders = np.random.uniform(-1.0, 1.0, size=(8, 100))
+    assert lif.DecoderRegion(decoders, None).storage is \
+        lif.DecoderStorage.dense
+
+
+def test_DecoderRegion_empty():
+    region = lif.DecoderRegion(np.array([]))
+    storage, n, data = _read_decoder_region(region, slice(0, 0), slice(0, 10))
+    assert storage == lif.DecoderStorage.dense
+    assert data == b""
+
+
+def test_get_factored_decoders():
+    decoders = np.dot(np.random.uniform(-1.0, 1.0, size=(6, 3)),
+                      np.random.uniform(-1.0, 1.0, size=(3, 30)))
+    transform, factored = lif.get_factored_decoders(decoders)
+    assert transform.shape == (6, 3)
+    assert factored.shape == (3, 30)
+
+
 @pytest.mark.parametrize(
     "num_learning_rules",
     [0, 1, 2])
@@ -162,6 +445,35 @@ def test_VojaRegion(num_learning_rules):
     assert len(values) == region.sizeof()
 
 
+def test_FilteredActivityRegion():
+    """Test region specific to filtered activity."""
+    region = lif.FilteredActivityRegion(0.001)
+
+    # Time constants which are absent or shorter than dt need no filter
+    assert region.add_get_filter(None) == -1
+    assert region.add_get_filter(0.0005) == -1
+
+    # Filters with the same time constants are shared
+    assert region.add_get_filter(0.005) == 0
+    assert region.add_get_filter(0.01) == 1
+    assert region.add_get_filter(0.005) == 0
+
+    assert region.sizeof() == 4 + 2*8
+
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    values = fp.read()
+    assert len(values) == region.sizeof()
+
+    # Check the number of filters and each filter (as U0.32)
+    assert struct.unpack_from("<I", values)[0] == 2
+    for i, tau in enumerate((0.005, 0.01)):
+        f, n_f = struct.unpack_from("<2I", values, 4 + 8*i)
+        assert abs(f / 2.0**32 - math.exp(-0.001 / tau)) < 2**-31
+        assert f + n_f == 2**32 - 1
+
+
 @pytest.mark.parametrize(
     "output_slice, learnt_output_slice, learning_rules",
     [(slice(0, 4), slice(0, 2), [(slice(0, 2), slice(0, 2), 4)]),
@@ -250,11 +562,60 @@ def test_get_basic_region_arguments(neuron_slice, out_slice, learnt_out_slice,
               lif.Regions.encoder_recording):
         assert region_args[r] == lif.Args(neuron_slice)
 
-    for r in (lif.Regions.decoders, lif.Regions.keys):
-        assert region_args[r] == lif.Args(out_slice)
+    assert region_args[lif.Regions.keys] == lif.Args(out_slice)
+    assert region_args[lif.Regions.learnt_keys] == lif.Args(learnt_out_slice)
 
-    for r in (lif.Regions.learnt_decoders, lif.Regions.learnt_keys):
-        assert region_args[r] == lif.Args(learnt_out_slice)
+    # Decoders are sliced by output and by the neurons in the cluster
+    cluster_neurons = slice(0, sum(cluster_lengths))
+    assert (region_args[lif.Regions.decoders] ==
+            lif.Args(out_slice, cluster_neurons))
+    assert (region_args[lif.Regions.learnt_decoders] ==
+            lif.Args(learnt_out_slice, cluster_neurons))
 
     assert region_args[lif.Regions.population_length] == \
         lif.Args(cluster_lengths)
+
+
+def test_get_filter_order():
+    region = FilterRegion([LowpassFilter(1, False, 0.05),
+                           mock.Mock(spec_set=["order"], order=3)], 0.001)
+    assert lif.get_filter_order(region) == 4
+    assert lif.get_filter_order(FilterRegion([], 0.001)) == 0
+
+
+def test_resource_usage_cost_model():
+    """The cycles used by cores should be estimated with the given cost
+    model.
+    """
+    cost_model = mock.Mock(spec_set=["core_cycles"])
+    cost_model.core_cycles.return_value = 1234
+
+    # The most heavily loaded core of a cluster of 16 cores
+    cluster = lif.ClusterResourceUsage(20, 33, 0, cost_model=cost_model,
+                                       filter_order=2, n_routes=5)
+    assert cluster.cpu_usage(slice(0, 320)) == 1234
+    cost_model.core_cycles.assert_called_once_with(lif.CoreLoad(
+        size_in=20, filtered_dims=2, filter_order=2, n_routes=5,
+        n_neurons=20, n_neurons_in_cluster=320, size_out=3,
+        size_learnt_out=0
+    ))
+
+    # A single core
+    cost_model.core_cycles.reset_mock()
+    core = lif.CoreResouceUsage(20, 320, cost_model=cost_model,
+                                filter_order=2, n_routes=5)
+    assert core.cpu_usage(slice(0, 4), slice(0, 20), slice(3, 6),
+                          slice(0, 1)) == 1234
+    cost_model.core_cycles.assert_called_once_with(lif.CoreLoad(
+        size_in=20, filtered_dims=4, filter_order=2, n_routes=5,
+        n_neurons=20, n_neurons_in_cluster=320, size_out=3,
+        size_learnt_out=1
+    ))
+
+    # By default the original estimates are used
+    core = lif.CoreResouceUsage(20, 320)
+    assert core.cpu_usage(slice(0, 4), slice(0, 20), slice(3, 6),
+                          slice(0, 0)) == (
+        (39*4 + 135) + (9*20*20 + 61*20 + 174) +
+        (2*320*3 + 143*3 + 173) + 173
+    )
@@ -5,7 +5,8 @@ import struct
 import tempfile
 
 from nengo_spinnaker.operators import ValueSink
-from nengo_spinnaker.operators.value_sink import SystemRegion
+from nengo_spinnaker.operators.value_sink import (RecordingDrainThread,
+                                              SystemRegion)
 
 
 def test_value_sink_init():
@@ -19,24 +20,66 @@ def test_value_sink_init():
     assert v.sample_every == 4
 
 
-@pytest.mark.parametrize("timestep, input_slice", [(1000, slice(0, 10)),
-                                                   (2000, slice(10, 100))])
-def test_system_region(timestep, input_slice):
+@pytest.mark.parametrize("timestep, input_slice, packet_queue_length",
+                         [(1000, slice(0, 10), 1024),
+                          (2000, slice(10, 100), 4096)])
+@pytest.mark.parametrize("record_ring", (False, True))
+def test_system_region(timestep, input_slice, packet_queue_length,
+                       record_ring):
     """Create a system region, check that the size is reported correctly and
     that the values are written out correctly.
     """
-    region = SystemRegion(timestep, input_slice)
+    region = SystemRegion(timestep, input_slice, packet_queue_length,
+                          record_ring)
 
-    # This region should always require 12 bytes
-    assert region.sizeof() == 12
+    # This region should always require 20 bytes
+    assert region.sizeof() == 20
 
     # Determine what we expect the system region to work out as.
-    expected_data = struct.pack("<3I", timestep,
+    expected_data = struct.pack("<5I", timestep,
                                 input_slice.stop - input_slice.start,
-                                input_slice.start)
+                                input_slice.start, packet_queue_length,
+                                0x1 if record_ring else 0x0)
 
     fp = tempfile.TemporaryFile()
     region.write_subregion_to_file(fp)
     fp.seek(0)
 
     assert fp.read() == expected_data
+
+
+def test_recording_drain_thread_reports_errors():
+    """The drain thread should be a daemon and should warn about, and stop
+    after, any error which occurs while draining.
+    """
+    vertex = mock.Mock()
+    vertex.drain_recording.side_effect = IOError("Lost connection")
+
+    thread = RecordingDrainThread([vertex], 0.001)
+    assert thread.daemon
+
+    with pytest.warns(UserWarning) as record:
+        thread.start()
+        thread.join(1.0)
+    assert not thread.is_alive()
+    assert "Lost connection" in str(record[0].message)
+    vertex.drain_recording.assert_called_once_with()
+
+
+def test_value_sink_close_stops_drain_thread():
+    probe = mock.Mock(size_in=1, sample_every=None)
+    v = ValueSink(probe, 0.001)
+    v.ring_frames = 10
+    v.vertices = [mock.Mock()]
+
+    # Start draining, closing should stop the thread
+    v.before_simulation(None, None, 100)
+    thread = v._drain_thread
+    assert thread.is_alive()
+
+    v.close()
+    assert not thread.is_alive()
+    assert v._drain_thread is None
+
+    # Closing again should do nothing
+    v.close()
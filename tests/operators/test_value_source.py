@@ -65,3 +65,23 @@ class TestSystemRegion(object):
             timestep, vertex_slice.stop - vertex_slice.start,
             0x1 if periodic else 0x0, n_blocks, block_length, last_block_length
         )
+
+    @pytest.mark.parametrize(
+        "slot_bytes, vertex_slice, block_length",
+        [(400, slice(0, 10), 10),
+         (16, slice(0, 10), 1),  # A block always contains at least one frame
+         ]
+    )
+    def test_write_subregion_to_file_slot_bytes(self, slot_bytes,
+                                                vertex_slice, block_length):
+        # Create the region
+        sr = SystemRegion(1000, False, 100, slot_bytes=slot_bytes)
+
+        # Write to file
+        fp = tempfile.TemporaryFile()
+        sr.write_subregion_to_file(fp, vertex_slice)
+
+        fp.seek(0)
+        assert struct.unpack("<6I", fp.read())[3:] == (
+            100 // block_length, block_length, 100 % block_length
+        )
@@ -407,6 +407,29 @@ def test_filter_routing_region_get_signal_constraints():
     }
 
 
+def test_filter_routing_region_get_signal_targets():
+    """Test the reporting of which filters each signal without a keyspace
+    targets.
+    """
+    # Define some signals, one of which already has a keyspace
+    ksc = KeyspaceContainer()
+    sig_a = SignalParameters()
+    sig_b = SignalParameters()
+    sig_c = SignalParameters(keyspace=ksc["nengo"](connection_id=3))
+
+    # Define the filter routes, these map a keyspace to an integer
+    signal_routes = [(sig_a, 12), (sig_b, 12), (sig_b, 17), (sig_c, 17)]
+
+    # Create the region
+    filter_region = FilterRoutingRegion(signal_routes)
+
+    # Extract the targets of each signal
+    assert filter_region.get_signal_targets() == {
+        id(sig_a): {12},
+        id(sig_b): {12, 17},
+    }
+
+
 class TestMakeFilterRegions(object):
     """Test the helper for constructing these regions."""
     @pytest.mark.parametrize("minimise", [True, False])
@@ -503,6 +526,34 @@ class TestMakeFilterRegions(object):
         else:
             assert (signal_b, 0) in routing_region.signal_routes
 
+    def test_latching_filters_of_different_signals(self):
+        """Latching filters hold the last value they received, equivalent
+        latching filters must therefore not be shared by different signals or
+        their values would not be summed.
+        """
+        signal_a = SignalParameters(latching=True, threshold=0.01)
+        signal_b = SignalParameters(latching=True, threshold=0.01)
+        signal_c = SignalParameters(latching=False)
+        signal_d = SignalParameters(latching=False)
+
+        rp = ReceptionParameters(nengo.Lowpass(0.01), 3, None)
+        specs = [ReceptionSpec(s, rp)
+                 for s in (signal_a, signal_b, signal_a, signal_c, signal_d)]
+
+        # Create the regions, with minimisation
+        filter_region, routing_region = make_filter_regions(
+            specs, 0.001, minimise=True)
+
+        # Each latching signal has a filter (shared only by the routes of that
+        # signal) while the non-latching signals share a filter.
+        assert filter_region.filters == [LowpassFilter(3, True, 0.01),
+                                         LowpassFilter(3, True, 0.01),
+                                         LowpassFilter(3, False, 0.01)]
+        assert routing_region.signal_routes == [
+            (signal_a, 0), (signal_b, 1), (signal_a, 0),
+            (signal_c, 2), (signal_d, 2)
+        ]
+
     def test_forced_filter_width(self):
         """Test construction of filter regions from signals and keyspaces."""
         # Create two keyspaces, two signals and two connections with equivalent
@@ -2,12 +2,89 @@ import mock
 import numpy as np
 import pytest
 import struct
+import tempfile
 
 from rig.type_casts import NumpyFloatToFixConverter, NumpyFixToFloatConverter
 
 from nengo_spinnaker.regions import recording as rr
 
 
+@pytest.mark.parametrize(
+    "sample_every, record_start, record_stop, window",
+    [(None, None, None, (1, 0, None)),
+     (0.005, None, None, (5, 0, None)),
+     (0.002, 0.1, 0.2, (2, 100, 200)),
+     ]
+)
+def test_get_probe_window(sample_every, record_start, record_stop, window):
+    probe = mock.Mock(name="Probe", spec_set=["sample_every"])
+    probe.sample_every = sample_every
+
+    config = mock.MagicMock(name="Config")
+    config[probe].record_start = record_start
+    config[probe].record_stop = record_stop
+
+    assert rr.get_probe_window(probe, 0.001, config) == window
+
+
+def test_get_probe_window_no_config():
+    probe = mock.Mock(name="Probe", spec_set=["sample_every"])
+    probe.sample_every = 0.01
+
+    assert rr.get_probe_window(probe, 0.001) == (10, 0, None)
+
+
+@pytest.mark.parametrize(
+    "windows, combined",
+    [([], (1, 0, None)),
+     ([(4, 10, None)], (4, 10, None)),
+     ([(4, 10, 100), (6, 10, 200)], (2, 10, 200)),
+     ([(4, 10, 100), (4, 13, 50)], (1, 10, 100)),
+     ([(4, 10, 100), (4, 0, None)], (2, 0, None)),
+     ]
+)
+def test_combine_windows(windows, combined):
+    assert rr.combine_windows(windows) == combined
+
+
+@pytest.mark.parametrize(
+    "window, recorded_window, samples",
+    [((1, 0, None), (1, 0, None), slice(0, None, 1)),
+     ((6, 4, 20), (2, 0, None), slice(2, 10, 3)),
+     ((6, 4, 21), (2, 0, 30), slice(2, 11, 3)),
+     ]
+)
+def test_get_window_slice(window, recorded_window, samples):
+    assert rr.get_window_slice(window, recorded_window) == samples
+
+
+class TestRecordingRegion(object):
+    @pytest.mark.parametrize(
+        "n_steps, sample_every, start, stop, n_samples",
+        [(100, 1, 0, None, 100),
+         (100, 3, 0, None, 34),
+         (100, 3, 10, 20, 4),
+         (100, 3, 10, 200, 30),
+         (100, 1, 200, None, 0),
+         ]
+    )
+    def test_get_n_samples(self, n_steps, sample_every, start, stop,
+                           n_samples):
+        sr = rr.WordRecordingRegion(n_steps, sample_every, start, stop)
+        assert sr.get_n_samples(n_steps) == n_samples
+        assert sr.sizeof(slice(0, 2)) == 12 + 8 * n_samples
+
+    def test_write_subregion_to_file(self):
+        sr = rr.WordRecordingRegion(100, 3, 10, 200)
+
+        # The window should be written with the stop clipped to the end of
+        # the simulation.
+        fp = tempfile.TemporaryFile()
+        sr.write_subregion_to_file(fp, slice(0, 2))
+        fp.seek(0)
+        assert struct.unpack("<3I", fp.read()) == (3, 10, 100)
+
+
 class TestWordRecordingRegion(object):
     @pytest.mark.parametrize(
         "n_steps, vertex_slice, words_per_frame",
@@ -21,7 +98,57 @@ class TestWordRecordingRegion(object):
         sr = rr.WordRecordingRegion(n_steps)
 
         # Check that the size is reported correctly
-        assert sr.sizeof(vertex_slice) == 4 * words_per_frame * n_steps
+        assert sr.sizeof(vertex_slice) == 12 + 4 * words_per_frame * n_steps
+
+
+class TestRingRecordingRegion(object):
+    def test_sizeof(self):
+        # Window, header and 10 frames of 1 + 3 words
+        sr = rr.RingRecordingRegion(1000, 10)
+        assert sr.sizeof(slice(0, 3)) == 12 + 16 + 10 * 4 * 4
+
+    def test_write_subregion_to_file(self):
+        sr = rr.RingRecordingRegion(1000, 10, 2)
+
+        fp = tempfile.TemporaryFile()
+        sr.write_subregion_to_file(fp, slice(0, 3))
+        fp.seek(0)
+        assert struct.unpack("<7I", fp.read()) == (2, 0, 1000, 10, 0, 0, 0)
+
+    def test_drain(self):
+        """Check that unread frames are read, wrapping around the end of the
+        ring, and marked as read.
+        """
+        sr = rr.RingRecordingRegion(1000, 3)
+
+        # Create a ring of 3 frames of 2 values, the host has read 2 frames
+        # and 2 more have been written (the second into the first frame).
+        float_to_s16_15 = NumpyFloatToFixConverter(True, 32, 15)
+        values = float_to_s16_15(np.array([[0.0, 0.0], [0.5, -1.0],
+                                           [2.0, 0.25]]))
+        frames = [(5, values[2]), (0, values[0]), (4, values[1])]
+
+        fp = tempfile.TemporaryFile()
+        fp.write(struct.pack("<3I", 1, 0, 1000))
+        fp.write(struct.pack("<4I", 3, 4, 2, 7))
+        for sample, value in frames:
+            fp.write(struct.pack("<I", sample))
+            fp.write(value.tostring())
+
+        # Drain the ring
+        samples, data, n_overflows = sr.drain(fp, slice(0, 2))
+        assert np.all(samples == [4, 5])
+        assert np.all(data == NumpyFixToFloatConverter(15)(values[1:]))
+        assert n_overflows == 7
+
+        # Check that the frames were marked as read
+        fp.seek(12)
+        assert struct.unpack("<4I", fp.read(16)) == (3, 4, 4, 7)
+
+        # Draining again reads nothing
+        samples, data, _ = sr.drain(fp, slice(0, 2))
+        assert samples.size == 0
+        assert data.shape == (0, 2)
 
 
 class TestSpikeRegion(object):
@@ -40,7 +167,7 @@ class TestSpikeRegion(object):
         sr = rr.SpikeRecordingRegion(n_steps)
 
         # Check that the size is reported correctly
-        assert sr.sizeof(vertex_slice) == 4 * words_per_frame * n_steps
+        assert sr.sizeof(vertex_slice) == 12 + 4 * words_per_frame * n_steps
 
     def test_to_array(self):
         """Check that data can be read back from a memory."""
@@ -62,7 +189,7 @@ class TestSpikeRegion(object):
         array = sr.to_array(mem, slice(0, 37), 2)
 
         # Check that an appropriate read was made
-        mem.seek.assert_called_once_with(0)
+        mem.seek.assert_called_once_with(12)
         mem.read.assert_called_once_with(16)
 
         # Check that the return array is of an appropriate shape
@@ -78,6 +205,114 @@ class TestSpikeRegion(object):
         assert np.all(array == expected)
 
 
+class TestCompressedSpikeRegion(object):
+    """Compressed spike regions contain a header followed by frames of either
+    neuron indices or spike bitmaps.
+    """
+    @pytest.mark.parametrize(
+        "n_steps, vertex_slice, rate, words_per_frame",
+        [(100, slice(0, 100), 10.0, 2),   # 2 expected spikes -> 1 word
+         (100, slice(0, 100), 100.0, 11),  # 20 expected spikes -> 10 words
+         (100, slice(0, 100), 1000.0, 5),  # More spikes than the bitmap
+         (10, slice(0, 0), 10.0, 1),
+         ]
+    )
+    def test_sizeof(self, n_steps, vertex_slice, rate, words_per_frame):
+        # Create the region
+        sr = rr.CompressedSpikeRecordingRegion(n_steps, rate, 0.001)
+
+        # Check that the size is reported correctly
+        assert sr.sizeof(vertex_slice) == 4 * (6 + words_per_frame * n_steps)
+
+    def test_write_subregion_to_file(self):
+        sr = rr.CompressedSpikeRecordingRegion(100, 10.0, 0.001)
+
+        # Check that the header is written out
+        fp = tempfile.TemporaryFile()
+        sr.write_subregion_to_file(fp, slice(0, 100))
+        fp.seek(0)
+        assert struct.unpack("<6I", fp.read()) == (1, 0, 100, 200, 0, 0)
+
+    def test_to_array(self):
+        """Check that data can be read back from a memory."""
+        # Data to reconstruct; this is three frames for 37 neurons, the first
+        # has 3 spikes, the second is a bitmap and the third has no spikes.
+        header = struct.pack("<3I", 100, 7, 0)
+        data = struct.pack(
+            "<7I",
+            3, 1 | (32 << 16), 36,
+            rr.CompressedSpikeRecordingRegion.FRAME_BITMAP,
+            0b11111111111111111111111111111110,
+            0b11111111111111111111111111100101,  # Ignore 27MSB
+            0
+        )
+
+        # Construct a memory to read from
+        mem = mock.Mock()
+        mem.read.side_effect = [header, data]
+
+        # Get the array
+        sr = rr.CompressedSpikeRecordingRegion(100, 10.0, 0.001)
+        array = sr.to_array(mem, slice(5, 5 + 37), 3)
+
+        # Check that appropriate reads were made
+        mem.seek.assert_called_once_with(12)
+        assert mem.read.call_args_list == [mock.call(12), mock.call(28)]
+
+        # Check that the right neurons have fired
+        expected = np.zeros((3, 37), dtype=np.bool)
+        expected[0][[1, 32, 36]] = True
+        expected[1][1:32] = True
+        expected[1][[32, 34]] = True
+
+        assert array.shape == (3, 37)
+        assert np.all(array == expected)
+
+    def test_to_array_dropped_frames(self):
+        """Check that dropped frames are empty and are warned about."""
+        header = struct.pack("<3I", 2, 2, 1)
+        data = struct.pack("<2I", 1, 4)
+
+        # Construct a memory to read from
+        mem = mock.Mock()
+        mem.read.side_effect = [header, data]
+
+        # Get the array
+        sr = rr.CompressedSpikeRecordingRegion(2, 10.0, 0.001)
+        with pytest.warns(UserWarning):
+            array = sr.to_array(mem, slice(0, 10), 2)
+
+        # Check that the right neurons have fired
+        expected = np.zeros((2, 10), dtype=np.bool)
+        expected[0][4] = True
+        assert np.all(array == expected)
+
+    def test_to_array_dropped_frames_mid_run(self):
+        """Check that the frames recorded before a frame was dropped are
+        decoded at the correct samples and later samples are empty.
+        """
+        # Frames for the first two of four samples, the third frame did not
+        # fit and so neither did the fourth.
+        header = struct.pack("<3I", 4, 4, 2)
+        data = struct.pack("<4I", 1, 3, 2, 1 | (7 << 16))
+
+        # Construct a memory to read from
+        mem = mock.Mock()
+        mem.read.side_effect = [header, data]
+
+        # Get the array
+        sr = rr.CompressedSpikeRecordingRegion(4, 10.0, 0.001)
+        with pytest.warns(UserWarning) as record:
+            array = sr.to_array(mem, slice(0, 10), 4)
+        assert "from sample 2" in str(record[0].message)
+
+        # Check that the right neurons have fired
+        expected = np.zeros((4, 10), dtype=np.bool)
+        expected[0][3] = True
+        expected[1][[1, 7]] = True
+        assert np.all(array == expected)
+
+
 class TestVoltageRegion(object):
     """Voltage regions use 1 short per neuron per timestep but pad each frame
     to a multiple of words.
@@ -94,7 +329,7 @@ class TestVoltageRegion(object):
         sr = rr.VoltageRecordingRegion(n_steps)
 
         # Check that the size is reported correctly
-        assert sr.sizeof(vertex_slice) == 4 * words_per_frame * n_steps
+        assert sr.sizeof(vertex_slice) == 12 + 4 * words_per_frame * n_steps
 
     def test_to_array(self):
         """Check that the data can be read back from a memory."""
@@ -113,7 +348,7 @@ class TestVoltageRegion(object):
         array = vr.to_array(mem, slice(5, 5 + 37), 3)
 
         # Check that an appropriate read was made
-        mem.seek.assert_called_once_with(0)
+        mem.seek.assert_called_once_with(12)
         mem.read.assert_called_once_with(19*4*3)
 
         # Check that the return array is of an appropriate shape
@@ -137,7 +372,7 @@ class TestEncoderRegion(object):
         sr = rr.EncoderRecordingRegion(n_steps, n_dimensions)
 
         # Check that the size is reported correctly
-        assert sr.sizeof(vertex_slice) == 4 * n_steps * n_dimensions *\
+        assert sr.sizeof(vertex_slice) == 12 + 4 * n_steps * n_dimensions *\
             (vertex_slice.stop - vertex_slice.start)
 
     def test_to_array(self):
@@ -162,7 +397,7 @@ class TestEncoderRegion(object):
         array = er.to_array(mem, slice(0, n_neurons), n_steps)
 
         # Check that an appropriate read was made
-        mem.seek.assert_called_once_with(0)
+        mem.seek.assert_called_once_with(12)
         mem.read.assert_called_once_with(n_words * 4)
 
         # Check that the return array is of an appropriate shape
@@ -0,0 +1,42 @@
+import pytest
+import struct
+import tempfile
+
+from nengo_spinnaker.regions.profiler import MS_SCALE
+from nengo_spinnaker.regions.tick_status import (TickOverrunPolicy,
+                                                 TickStatusRegion)
+
+
+@pytest.mark.parametrize(
+    "policy, value",
+    [(TickOverrunPolicy.count, 0),
+     (TickOverrunPolicy.drop, 1),
+     ("abort", 2),
+     ]
+)
+def test_tick_status_region_write(policy, value):
+    if isinstance(policy, str):
+        policy = TickOverrunPolicy[policy]
+    region = TickStatusRegion(policy)
+    assert region.sizeof() == 20
+
+    # The policy should be written followed by zeroed status
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    assert struct.unpack("<5I", fp.read()) == (value, 0, 0, 0, 0)
+
+
+def test_tick_status_region_read():
+    region = TickStatusRegion()
+    assert region.policy is TickOverrunPolicy.count
+
+    fp = tempfile.TemporaryFile()
+    fp.write(struct.pack("<5I", 1, 1000, 7, 20000, 3))
+    fp.seek(0)
+
+    status = region.read_from_mem(fp)
+    assert status["ticks"] == 1000
+    assert status["overruns"] == 7
+    assert status["max lateness"] == 20000 * MS_SCALE
+    assert status["dropped"] == 3
@@ -0,0 +1,79 @@
+import mock
+import pytest
+from rig.place_and_route import Cores
+import struct
+import tempfile
+
+from nengo_spinnaker.regions.transmit_schedule import (
+    TransmitScheduleRegion, get_transmit_schedule)
+
+
+def test_transmit_schedule_region():
+    region = TransmitScheduleRegion()
+    assert region.sizeof() == 12
+
+    # By default transmission is not paced
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    assert struct.unpack("<3I", fp.read()) == (0, 0, 0)
+
+    # Otherwise the schedule is written
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp, slice(0, 1), offset=20, slot=10,
+                                   packets_per_slot=4)
+    fp.seek(0)
+    assert struct.unpack("<3I", fp.read()) == (20, 10, 4)
+
+
+def make_netlist(vertex, placement, core, router_load):
+    netlist = mock.Mock(spec_set=["placements", "allocations",
+                                  "router_loads"])
+    netlist.placements = {vertex: placement}
+    netlist.allocations = {vertex: {Cores: slice(core, core + 1)}}
+    netlist.router_loads = {placement: router_load}
+    return netlist
+
+
+@pytest.mark.parametrize(
+    "placement, core, offset",
+    [((0, 0), 1, 0),
+     ((0, 0), 3, 10),
+     ((0, 1), 1, 5),
+     ((1, 0), 2, 15),
+     ((1, 1), 1, 15),
+     ]
+)
+def test_get_transmit_schedule_stagger(placement, core, offset):
+    vertex = object()
+    netlist = make_netlist(vertex, placement, core, 4)
+
+    # The router is not congested so no pacing is required
+    assert get_transmit_schedule(netlist, vertex, 4, 1000) == {
+        "offset": offset, "slot": 10, "packets_per_slot": 0}
+
+
+def test_get_transmit_schedule_min_offset():
+    vertex = object()
+    netlist = make_netlist(vertex, (0, 0), 2, 0)
+
+    schedule = get_transmit_schedule(netlist, vertex, 4, 1000, stagger=3,
+                                     min_offset=100)
+    assert schedule["offset"] == 103
+
+
+@pytest.mark.parametrize(
+    "n_packets, router_load, packets_per_slot",
+    [(16, 32, 5),  # Given a share of the router
+     (16, 1000, 1),
+     (256, 1000, 6),  # Must complete in half the timestep
+     (8, 8, 0),  # Not congested
+     ]
+)
+def test_get_transmit_schedule_paced(n_packets, router_load,
+                                     packets_per_slot):
+    vertex = object()
+    netlist = make_netlist(vertex, (0, 0), 1, router_load)
+
+    schedule = get_transmit_schedule(netlist, vertex, n_packets, 1000)
+    assert schedule["packets_per_slot"] == packets_per_slot
@@ -0,0 +1,57 @@
+import mock
+import pytest
+import struct
+import tempfile
+
+from nengo_spinnaker.regions.transmit_threshold import (
+    TransmitThresholdRegion, get_transmit_refresh_period,
+    get_transmit_thresholds)
+
+
+def test_transmit_threshold_region_disabled():
+    """If no value has a threshold the region should describe no values."""
+    region = TransmitThresholdRegion([None, None, None], refresh_period=50)
+    assert region.sizeof(slice(None)) == 8
+
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp, slice(None))
+    fp.seek(0)
+    assert struct.unpack("<2I", fp.read()) == (0, 50)
+
+
+@pytest.mark.parametrize(
+    "vertex_slice, expected",
+    [(slice(None), (0, -1, 0x4000, -1)),
+     (slice(1, 3), (-1, 0x4000)),
+     (slice(0, 2), (0, -1)),
+     (slice(3, 4), ()),  # No thresholds in this slice
+     ])
+def test_transmit_threshold_region(vertex_slice, expected):
+    region = TransmitThresholdRegion([0.0, None, 0.5, None])
+    assert region.sizeof(vertex_slice) == 8 + 4 * len(expected)
+
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp, vertex_slice)
+    fp.seek(0)
+    assert struct.unpack("<2I{}i".format(len(expected)), fp.read()) == (
+        (len(expected), region.refresh_period) + expected)
+
+
+def test_get_transmit_thresholds():
+    sig_a = mock.Mock(threshold=None)
+    sig_b = mock.Mock(threshold=0.1)
+    keys = [(sig_a, {"index": 0}), (sig_b, {"index": 0}),
+            (sig_b, {"index": 1})]
+
+    assert get_transmit_thresholds(keys) == [None, 0.1, 0.1]
+
+
+@pytest.mark.parametrize(
+    "refresh_time, dt, expected",
+    [(None, 0.001, 0),  # Never refreshed
+     (0.1, 0.001, 100),
+     (0.1, 0.01, 10),
+     (0.0001, 0.001, 1),  # Refreshed at most every timestep
+     ])
+def test_get_transmit_refresh_period(refresh_time, dt, expected):
+    assert get_transmit_refresh_period(refresh_time, dt) == expected
@@ -239,3 +239,82 @@ def test_sizeof_regions(vertex_slice, include_app_ptr):
     assert (utils.sizeof_regions(regions, vertex_slice, include_app_ptr) ==
             37*4 + (len(regions)*4 + 4 if include_app_ptr else 0))
     assert all(r.called for r in regions if r is not None)
+
+
+class PiecewiseRegion(Region):
+    """Region which is written as one short write per word."""
+    def __init__(self, words):
+        self.words = words
+
+    def sizeof(self, *args, **kwargs):
+        return len(self.words) * 4
+
+    def write_subregion_to_file(self, fp, vertex_slice=None, offset=0):
+        for w in self.words[vertex_slice]:
+            fp.write(struct.pack("<I", w + offset))
+
+
+def test_write_region():
+    """Test that regions are written with a single write."""
+    region = PiecewiseRegion([1, 2, 3, 4])
+    fp = mock.Mock()
+
+    data = utils.write_region(fp, region, slice(1, 3), offset=1)
+    assert data == struct.pack("<2I", 3, 4)
+    fp.write.assert_called_once_with(data)
+
+
+def test_write_regions_named():
+    """Test writing a group of named regions into their views of memory."""
+    class RegionNames(enum.IntEnum):
+        a = 1
+        b = 2
+
+    regions = {RegionNames.a: PiecewiseRegion([1, 2]),
+               RegionNames.b: PiecewiseRegion([3, 4, 5])}
+    region_args = {RegionNames.a: utils.Args(slice(0, 1)),
+                   RegionNames.b: utils.Args(slice(1, 3), offset=2)}
+    region_memory = {k: mock.Mock() for k in RegionNames}
+
+    utils.write_regions_named(region_memory, regions, region_args)
+    region_memory[RegionNames.a].write.assert_called_once_with(
+        struct.pack("<I", 1))
+    region_memory[RegionNames.b].write.assert_called_once_with(
+        struct.pack("<2I", 6, 7))
+
+
+def test_region_write_cache():
+    """Test that regions are only rewritten when their data changes."""
+    region = PiecewiseRegion([1, 2, 3])
+    fp_a = mock.Mock()
+    fp_b = mock.Mock()
+    cache = utils.RegionWriteCache()
+
+    # The first write into each view of memory is always made
+    assert cache.write(fp_a, region, slice(None))
+    assert cache.write(fp_b, region, slice(None))
+    fp_a.seek.assert_called_once_with(0)
+    fp_a.write.assert_called_once_with(struct.pack("<3I", 1, 2, 3))
+    assert fp_b.write.call_count == 1
+
+    # Writing the same data again is skipped
+    assert not cache.write(fp_a, region, slice(None))
+    assert fp_a.write.call_count == 1
+
+    # Changing the data causes the region to be written
+    region.words[1] = 5
+    assert cache.write(fp_a, region, slice(None))
+    fp_a.write.assert_called_with(struct.pack("<3I", 1, 5, 3))
+    assert fp_a.write.call_count == 2
+
+    # As do different arguments
+    assert cache.write(fp_a, region, slice(None), offset=1)
+    assert fp_a.write.call_count == 3
+
+    # Invalidating the cache forces the write to be made
+    assert cache.write(fp_b, region, slice(None), offset=1)
+    assert not cache.write(fp_b, region, slice(None), offset=1)
+    cache.invalidate(fp_b)
+    assert cache.write(fp_b, region, slice(None), offset=1)
+    cache.invalidate()
+    assert cache.write(fp_a, region, slice(None), offset=1)
@@ -0,0 +1,20 @@
+from nengo_spinnaker.scripts.nengo_spinnaker_benchmark import get_cases
+from nengo_spinnaker.utils.benchmark import BenchmarkCase, Kernels
+
+
+def test_get_cases_defaults():
+    cases = get_cases([Kernels.lti_filter_step])
+    assert len(cases) == 16
+    assert all(c.kernel is Kernels.lti_filter_step for c in cases)
+    assert BenchmarkCase(Kernels.lti_filter_step, 64, 3) in cases
+
+
+def test_get_cases_given_sizes():
+    cases = get_cases([Kernels.dot_product, Kernels.neuron_update],
+                      sizes=[32, 64], params=[0], n_repeats=7)
+    assert cases == [
+        BenchmarkCase(Kernels.dot_product, 32, 0, 7),
+        BenchmarkCase(Kernels.dot_product, 64, 0, 7),
+        BenchmarkCase(Kernels.neuron_update, 32, 0, 7),
+        BenchmarkCase(Kernels.neuron_update, 64, 0, 7),
+    ]
@@ -4,8 +4,9 @@ import pytest
 from rig import place_and_route as par
 
 from nengo_spinnaker import Simulator, add_spinnaker_params
-from nengo_spinnaker.config import CallableParameter
+from nengo_spinnaker.config import CallableParameter, ChoiceParameter
 from nengo_spinnaker import node_io
+from nengo_spinnaker.utils.paths import net_id_cache_dir
 
 
 def test_add_spinnaker_params():
@@ -39,8 +40,14 @@ def test_add_spinnaker_params():
             ("allocater_kwargs", {}),
             ("router", lambda r, n, m, c, p, a: None),
             ("router_kwargs", {}),
+            ("router_processes", 2),
+            ("net_id_cache_dir", None),
             ("node_io", None),
             ("node_io_kwargs", {}),
+            ("tick_overrun_policy", "drop"),
+            ("cost_model", None),
+            ("cpu_target", 0.5),
+            ("transmit_refresh_time", 0.2),
             ]:
         with pytest.raises(ConfigError) as excinfo:
             setattr(net.config[Simulator], param, value)
@@ -53,15 +60,40 @@ def test_add_spinnaker_params():
     assert net.config[nengo.Node].function_of_time_period is None
     assert net.config[nengo.Node].optimize_out is None
 
+    assert net.config[nengo.Ensemble].packed_encoders is False
+    assert net.config[nengo.Ensemble].decoder_storage is None
+    assert net.config[nengo.Ensemble].spike_recording_rate is None
+
+    assert net.config[nengo.Probe].record_start is None
+    assert net.config[nengo.Probe].record_stop is None
+    assert net.config[nengo.Probe].record_ring_frames is None
+
     assert net.config[Simulator].placer is par.place
     assert net.config[Simulator].placer_kwargs == {}
     assert net.config[Simulator].allocator is par.allocate
     assert net.config[Simulator].allocator_kwargs == {}
     assert net.config[Simulator].router is par.route
     assert net.config[Simulator].router_kwargs == {}
+    assert net.config[Simulator].router_processes is None
+    assert net.config[Simulator].net_id_cache_dir == net_id_cache_dir
 
     assert net.config[Simulator].node_io is node_io.Ethernet
     assert net.config[Simulator].node_io_kwargs == {}
+    assert net.config[Simulator].tick_overrun_policy == "count"
+    assert net.config[Simulator].cost_model is None
+    assert net.config[Simulator].cpu_target == 0.4
+    assert net.config[Simulator].transmit_refresh_time == 0.1
+
+    # Unknown overrun policies should be rejected when they are set
+    with pytest.raises(ValueError) as excinfo:
+        net.config[Simulator].tick_overrun_policy = "skip"
+    assert "'drop'" in str(excinfo.value)
+
+    # As should unknown decoder storage formats
+    net.config[nengo.Ensemble].decoder_storage = "factored"
+    with pytest.raises(ValueError) as excinfo:
+        net.config[nengo.Ensemble].decoder_storage = "compressed"
+    assert "'streamed'" in str(excinfo.value)
 
 
 def test_callable_parameter_validate():
@@ -77,6 +109,19 @@ def test_callable_parameter_validate():
     cp.validate(None, lambda x: None)
 
 
+def test_choice_parameter_validate():
+    """Test that the choice parameter fails to validate if passed something
+    other than one of its values.
+    """
+    cp = ChoiceParameter("test", values=("a", "b"))
+
+    with pytest.raises(ValueError) as excinfo:
+        cp.validate(None, "c")
+    assert "must be one of 'a', 'b'" in str(excinfo.value)
+
+    cp.validate(None, "b")
+
+
 @pytest.mark.xfail(reason="Problems with Parameters")
 def test_function_of_time_node():
     # Test that function of time can't be marked on Nodes unless they have size
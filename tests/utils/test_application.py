@@ -1,3 +1,4 @@
+import hashlib
 import mock
 import pytest
 
@@ -15,3 +16,93 @@ def test_get_application(app_name):
     pkg_resources.resource_filename.assert_called_once_with(
         "nengo_spinnaker", "binaries/nengo_{}.aplx".format(app_name)
     )
+
+
+@pytest.fixture
+def sources_and_binaries(tmpdir):
+    """Create a tree of C sources and a directory of executables built from
+    them.
+    """
+    sources = tmpdir.mkdir("spinnaker_components")
+    sources.mkdir("common").join("common.h").write("#define A 1\n")
+    sources.mkdir("ensemble").join("ensemble.c").write("int main;\n")
+    sources.join("ensemble").join("ensemble.o").write("not a source")
+
+    binaries = tmpdir.mkdir("binaries")
+    binaries.join("nengo_ensemble.aplx").write("")
+    binaries.join(application.SOURCES_DIGEST_FILENAME).write(
+        "{}  -\n".format(application.get_sources_digest(str(sources))))
+
+    return sources, binaries
+
+
+def test_get_sources_digest(sources_and_binaries):
+    """The digest should be that of the sources concatenated in order of
+    their paths, as computed by the Makefile.
+    """
+    sources, _ = sources_and_binaries
+    assert (application.get_sources_digest(str(sources)) ==
+            hashlib.sha1(b"#define A 1\nint main;\n").hexdigest())
+
+
+def test_check_application(sources_and_binaries):
+    sources, binaries = sources_and_binaries
+    filename = str(binaries.join("nengo_ensemble.aplx"))
+
+    # Executables built from the sources are accepted
+    application.check_application(filename, str(sources))
+
+
+def test_check_application_missing(sources_and_binaries):
+    sources, binaries = sources_and_binaries
+    filename = str(binaries.join("nengo_filter.aplx"))
+
+    with pytest.raises(application.ApplicationError) as excinfo:
+        application.check_application(filename, str(sources))
+    assert "does not exist" in str(excinfo.value)
+    assert "make -C spinnaker_components" in str(excinfo.value)
+
+
+@pytest.mark.parametrize("digest", [None, "", "0123456789abcdef  -\n"])
+def test_check_application_out_of_date(sources_and_binaries, digest):
+    """Executables should be rejected if the sources have changed since they
+    were built or if it is not known which sources they were built from.
+    """
+    sources, binaries = sources_and_binaries
+    filename = str(binaries.join("nengo_ensemble.aplx"))
+
+    digest_file = binaries.join(application.SOURCES_DIGEST_FILENAME)
+    if digest is None:
+        digest_file.remove()
+    else:
+        digest_file.write(digest)
+
+    with pytest.raises(application.ApplicationError) as excinfo:
+        application.check_application(filename, str(sources))
+    assert "out of date" in str(excinfo.value)
+
+
+def test_check_application_modified_sources(sources_and_binaries):
+    sources, binaries = sources_and_binaries
+    filename = str(binaries.join("nengo_ensemble.aplx"))
+
+    sources.join("ensemble").join("ensemble.c").write("int main();\n")
+    with pytest.raises(application.ApplicationError):
+        application.check_application(filename, str(sources))
+
+
+def test_check_application_no_sources(sources_and_binaries):
+    """If the sources are not available only the existence of the executable
+    may be checked.
+    """
+    _, binaries = sources_and_binaries
+    binaries.join(application.SOURCES_DIGEST_FILENAME).remove()
+
+    with mock.patch.object(application, "get_sources_dir",
+                           return_value=None):
+        application.check_application(
+            str(binaries.join("nengo_ensemble.aplx")))
+
+        with pytest.raises(application.ApplicationError):
+            application.check_application(
+                str(binaries.join("nengo_filter.aplx")))
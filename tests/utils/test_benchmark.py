@@ -0,0 +1,154 @@
+import mock
+import pytest
+from rig.machine_control.consts import AppState
+import struct
+
+from nengo_spinnaker.utils import benchmark
+
+
+class Memory(object):
+    """File-like view of a bytearray which may be sliced into smaller views,
+    as the file-likes returned by `sdram_alloc_as_filelike` may.
+    """
+    def __init__(self, data, start=0, stop=None):
+        self.data = data
+        self.start = start
+        self.stop = len(data) if stop is None else stop
+        self.offset = 0
+
+    def __getitem__(self, sl):
+        return Memory(self.data, self.start + sl.start, self.start + sl.stop)
+
+    def seek(self, offset):
+        self.offset = offset
+
+    def read(self, n_bytes):
+        start = self.start + self.offset
+        self.offset += n_bytes
+        return bytes(self.data[start:start + n_bytes])
+
+    def write(self, data):
+        start = self.start + self.offset
+        assert start + len(data) <= self.stop
+        self.data[start:start + len(data)] = data
+        self.offset += len(data)
+
+
+@pytest.mark.parametrize("kernel", ["dot_product", 0,
+                                    benchmark.Kernels.dot_product])
+def test_benchmark_case_kernel(kernel):
+    case = benchmark.BenchmarkCase(kernel, 16)
+    assert case.kernel is benchmark.Kernels.dot_product
+    assert case.param == 0
+    assert case.n_repeats == 100
+
+
+@pytest.mark.parametrize(
+    "kernel, size, param, n_repeats",
+    [(benchmark.Kernels.dot_product, 0, 0, 1),
+     (benchmark.Kernels.dot_product, 1, 0, 0),
+     (benchmark.Kernels.lti_filter_step, 1, 0, 1),
+     (benchmark.Kernels.input_filtering_input, 1, 0, 1),
+     (benchmark.Kernels.input_filtering_input, 1, 257, 1)]
+)
+def test_benchmark_case_invalid(kernel, size, param, n_repeats):
+    with pytest.raises(ValueError):
+        benchmark.BenchmarkCase(kernel, size, param, n_repeats)
+
+
+def test_run_benchmarks():
+    cases = [benchmark.BenchmarkCase("neuron_update", 32),
+             benchmark.BenchmarkCase("lti_filter_step", 4, 2, 10),
+             benchmark.BenchmarkCase("decode_spike_train", 64, 3, 5)]
+
+    # Create a controller which allocates memory and, when the benchmarks
+    # are loaded, writes the results a core would
+    memory = dict()
+
+    def sdram_alloc_as_filelike(size, tag, x, y):
+        memory[tag] = Memory(bytearray(size))
+        return memory[tag]
+
+    def load_application(app, targets):
+        for p in targets[(0, 1)]:
+            mem = memory[p]
+            mem.seek(0)
+            case_ptr, results_ptr = struct.unpack("<3I", mem.read(12))[1:]
+
+            mem.seek(case_ptr)
+            kernel, size, param, n_repeats = struct.unpack("<4I",
+                                                           mem.read(16))
+            mem.seek(results_ptr)
+            mem.write(struct.pack("<3I", kernel, size, param))
+
+    controller = mock.MagicMock(spec_set=[
+        "application", "sdram_alloc_as_filelike", "load_application",
+        "wait_for_cores_to_reach_state", "send_signal",
+    ])
+    controller.sdram_alloc_as_filelike.side_effect = sdram_alloc_as_filelike
+    controller.load_application.side_effect = load_application
+    controller.wait_for_cores_to_reach_state.side_effect = \
+        lambda state, n, timeout: n
+
+    # Run the cases on two cores, there should be two batches.  The
+    # executable is not checked as it need not have been built.
+    with mock.patch.object(benchmark, "check_application"):
+        results = benchmark.run_benchmarks(controller, cases, x=0, y=1,
+                                           cores=[3, 4])
+    assert results == [(3, 32, 0), (1, 4, 2), (2, 64, 3)]
+    assert controller.load_application.call_count == 2
+    assert (controller.load_application.call_args_list[0][0][1] ==
+            {(0, 1): {3, 4}})
+    assert (controller.load_application.call_args_list[1][0][1] ==
+            {(0, 1): {3}})
+    controller.wait_for_cores_to_reach_state.assert_called_with(
+        AppState.exit, 1, timeout=10.0)
+
+
+def test_run_benchmarks_fails():
+    controller = mock.MagicMock()
+    controller.sdram_alloc_as_filelike.side_effect = \
+        lambda size, tag, x, y: Memory(bytearray(size))
+    controller.wait_for_cores_to_reach_state.return_value = 0
+    controller.get_processor_status.return_value.cpu_state = \
+        AppState.runtime_exception
+
+    with pytest.raises(Exception):
+        benchmark.run_benchmarks(
+            controller, [benchmark.BenchmarkCase("dot_product", 4)])
+
+
+def test_format_table():
+    cases = [benchmark.BenchmarkCase("dot_product", 16, 0, 10),
+             benchmark.BenchmarkCase("input_filtering_input", 4, 16, 10)]
+    results = [benchmark.BenchmarkResult(100, 140, 120),
+               benchmark.BenchmarkResult(50, 60, 56)]
+
+    lines = benchmark.format_table(cases, results, 200).split("\n")
+    assert len(lines) == 4
+    assert lines[0].split() == ["kernel", "size", "param", "repeats", "min",
+                                "mean", "max", "mean/size", "mean", "(us)"]
+    assert set(lines[1]) == {"-", " "}
+    assert lines[2].split() == ["dot_product", "16", "0", "10", "100", "120",
+                                "140", "7.50", "0.60"]
+    assert lines[3].split() == ["input_filtering_input", "4", "16", "10",
+                                "50", "56", "60", "14.00", "0.28"]
+
+    # All the lines should be aligned
+    assert len(set(len(l) for l in lines)) == 1
+
+
+def test_group_results():
+    cases = [benchmark.BenchmarkCase("dot_product", 16),
+             benchmark.BenchmarkCase("neuron_update", 32),
+             benchmark.BenchmarkCase("dot_product", 4)]
+    results = [benchmark.BenchmarkResult(1, 2, 3),
+               benchmark.BenchmarkResult(4, 5, 6),
+               benchmark.BenchmarkResult(7, 8, 9)]
+
+    groups = benchmark.group_results(cases, results)
+    assert groups == {
+        benchmark.Kernels.dot_product: [(cases[2], results[2]),
+                                        (cases[0], results[0])],
+        benchmark.Kernels.neuron_update: [(cases[1], results[1])],
+    }
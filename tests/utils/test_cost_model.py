@@ -0,0 +1,169 @@
+import mock
+import numpy as np
+from six import StringIO
+
+from nengo_spinnaker.regions.profiler import MS_SCALE
+from nengo_spinnaker.utils.benchmark import (BenchmarkCase, BenchmarkResult,
+                                             Kernels)
+from nengo_spinnaker.utils.cost_model import (CoreLoad, CostModel,
+                                              get_profiler_samples)
+
+
+def test_default_core_cycles():
+    """The default model should be the original hand-profiled estimate."""
+    load = CoreLoad(size_in=4, filtered_dims=2, filter_order=1, n_routes=3,
+                    n_neurons=50, n_neurons_in_cluster=100, size_out=3,
+                    size_learnt_out=0)
+    assert CostModel().core_cycles(load) == (
+        (39*2 + 135) +
+        (9*50*4 + 61*50 + 174) +
+        (2*100*3 + 143*3 + 173) +
+        173
+    )
+
+
+def test_core_cycles():
+    model = CostModel(encode_per_neuron_dimension=1, neuron=2,
+                      neuron_constant=3, filter_per_dimension_order=4,
+                      filter_constant=5, packet_per_route=6,
+                      packet_constant=7, decode_per_row_neuron=8,
+                      decode_per_row=9, decode_constant=10,
+                      transmit_per_row=11)
+    load = CoreLoad(size_in=4, filtered_dims=2, filter_order=3, n_routes=5,
+                    n_neurons=10, n_neurons_in_cluster=20, size_out=3,
+                    size_learnt_out=1)
+    assert model.core_cycles(load) == (
+        (4*2*3 + 5) +
+        2 * (6*5 + 7) +
+        (1*10*4 + 2*10 + 3) +
+        (8*20*3 + 9*3 + 10 + 11*3) +
+        (8*20*1 + 9*1 + 10 + 11*1)
+    )
+
+    # Filters without an order are treated as first order
+    assert (model.core_cycles(load._replace(filter_order=0)) ==
+            model.core_cycles(load._replace(filter_order=1)))
+
+
+def test_copy_save_and_load():
+    model = CostModel().copy(neuron=70, packet_per_route=1.5)
+    assert model.neuron == 70
+    assert model.packet_per_route == 1.5
+    assert model.filter_constant == CostModel().filter_constant
+    assert model != CostModel()
+
+    fp = StringIO()
+    model.save(fp)
+    fp.seek(0)
+    assert CostModel.load(fp) == model
+
+
+def test_from_benchmarks():
+    # Construct results which are linear in the size of each kernel
+    costs = {
+        Kernels.dot_product: (3, 20),
+        Kernels.neuron_update: (50, 100),
+        Kernels.lti_filter_step: (12, 40),
+        Kernels.input_filtering_input: (2, 30),
+        Kernels.decode_spike_train: (4, 10),
+    }
+    cases, results = list(), list()
+    for kernel, (per_unit, constant) in costs.items():
+        for size in (8, 16, 32):
+            case = BenchmarkCase(kernel, size, 2)
+            work = size * (2 if kernel is Kernels.lti_filter_step else 1)
+            mean = per_unit * work + constant
+
+            cases.append(case)
+            results.append(BenchmarkResult(mean, mean, mean))
+
+    base = CostModel()
+    model = CostModel.from_benchmarks(cases, results, base)
+
+    assert np.isclose(model.encode_per_neuron_dimension, 3)
+    assert np.isclose(model.neuron, 50 + 20)
+    assert np.isclose(model.filter_per_dimension_order, 12)
+    assert np.isclose(model.packet_per_route, 2)
+    assert np.isclose(model.packet_constant, 30)
+    assert np.isclose(model.decode_per_row_neuron, 4)
+
+    # Constant costs should not have been changed
+    assert model.neuron_constant == base.neuron_constant
+    assert model.filter_constant == base.filter_constant
+    assert model.decode_per_row == base.decode_per_row
+    assert model.decode_constant == base.decode_constant
+    assert model.transmit_per_row == base.transmit_per_row
+
+
+def test_from_benchmarks_single_size():
+    """Kernels benchmarked with a single size cannot be fitted."""
+    cases = [BenchmarkCase(Kernels.dot_product, 16)] * 2
+    results = [BenchmarkResult(100, 100, 100)] * 2
+    assert CostModel.from_benchmarks(cases, results) == CostModel()
+
+
+def test_from_profiler_counters():
+    expected = CostModel(encode_per_neuron_dimension=7, neuron=40,
+                         neuron_constant=200, filter_per_dimension_order=30,
+                         filter_constant=100, decode_per_row_neuron=3,
+                         decode_per_row=120, decode_constant=150,
+                         transmit_per_row=20)
+
+    # Construct the counters that would be recorded over 100 timesteps by
+    # cores under the expected model.  The decode tag is entered three times
+    # in each timestep, and each timestep includes 50 cycles of other work.
+    n_ticks = 100
+    samples = list()
+    for size_in, n_neurons, size_out, order in [(1, 100, 1, 1),
+                                                (2, 50, 3, 2),
+                                                (4, 200, 2, 1),
+                                                (8, 30, 8, 3)]:
+        load = CoreLoad(size_in=size_in, filtered_dims=size_in,
+                        filter_order=order, n_routes=1, n_neurons=n_neurons,
+                        n_neurons_in_cluster=2*n_neurons, size_out=size_out,
+                        size_learnt_out=0)
+        cycles = {
+            "Input filter": (expected.input_filtering_cycles(size_in, order),
+                             1),
+            "Neuron update": (expected.neuron_update_cycles(size_in,
+                                                            n_neurons), 1),
+            "Decode output": ((expected.decode_cycles(2*n_neurons, size_out) +
+                               expected.decode_cycles(2*n_neurons, 0)), 3),
+        }
+        cycles["Timestep"] = (sum(c for c, _ in cycles.values()) +
+                              expected.transmit_cycles(size_out) + 50, 1)
+
+        counters = {k: {"count": n_ticks * n, "mean": c * MS_SCALE / n}
+                    for k, (c, n) in cycles.items()}
+        samples.append((load, counters))
+
+    model = CostModel.from_profiler_counters(samples)
+    for c in CostModel.coefficients:
+        assert np.isclose(getattr(model, c), getattr(expected, c))
+
+    # Transmission can't be fitted from cores which learn
+    for _, counters in samples:
+        counters["PES"] = {"count": n_ticks, "mean": 10 * MS_SCALE}
+    model = CostModel.from_profiler_counters(samples)
+    assert model.transmit_per_row == CostModel().transmit_per_row
+    assert np.isclose(model.decode_per_row, expected.decode_per_row)
+
+    # With too few samples nothing can be fitted
+    assert CostModel.from_profiler_counters(samples[:1]) == CostModel()
+
+
+def test_get_profiler_samples():
+    # Construct a simulator with a single ensemble of two cores
+    vertices = [mock.Mock(neuron_slice=slice(0, 10)),
+                mock.Mock(neuron_slice=slice(10, 20))]
+    for i, v in enumerate(vertices):
+        v.get_core_load.return_value = i
+
+    ens = mock.Mock()
+    simulator = mock.Mock()
+    simulator.model.object_operators = {
+        ens: mock.Mock(clusters=[mock.Mock(vertices=vertices)])
+    }
+    simulator.profiler_counters = {ens: {(0, 10): "A", (10, 20): "B"}}
+
+    assert get_profiler_samples(simulator) == [(0, "A"), (1, "B")]
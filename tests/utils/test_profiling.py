@@ -0,0 +1,42 @@
+import numpy as np
+import tempfile
+
+from nengo_spinnaker.regions.profiler import MS_SCALE, ProfilerCounters
+from nengo_spinnaker.utils import profiling
+
+
+def test_profiler_counters_region():
+    region = ProfilerCounters()
+    assert region.sizeof() == 4 * (2 + 5 * 9)
+
+    # The region should be written out as zeros
+    fp = tempfile.TemporaryFile()
+    region.write_subregion_to_file(fp)
+    fp.seek(0)
+    assert fp.read() == b"\x00" * region.sizeof()
+
+
+def test_decode_counters():
+    # Construct the counters, timestep counter then 8 tag counters
+    words = np.zeros(2 + 5 * 9, dtype=np.uint32)
+    words[:2] = (8, 17)
+    words[2:7] = (10, 100, 300, 2000, 0)  # Timestep
+    words[12:17] = (2, 5, 2**32 - 1, 4, 1)  # Tag 1
+    words[42:47] = (1, 7, 7, 7, 0)  # Tag 7 (has no name)
+
+    data = profiling.decode_counters(words, {0: "A", 1: "B", 2: "C"})
+
+    assert data["max queue length"] == 17
+
+    assert data["Timestep"]["count"] == 10
+    assert data["Timestep"]["min"] == 100 * MS_SCALE
+    assert data["Timestep"]["max"] == 300 * MS_SCALE
+    assert np.isclose(data["Timestep"]["mean"], 200 * MS_SCALE)
+
+    # Tags which were never exited aren't included
+    assert "A" not in data
+    assert "C" not in data
+
+    # The 64-bit sum should be reconstructed
+    assert data["B"]["count"] == 2
+    assert np.isclose(data["B"]["mean"], (2**32 + 4) * MS_SCALE / 2)